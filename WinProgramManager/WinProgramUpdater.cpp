@@ -1,4 +1,13 @@
 #include "WinProgramUpdater.h"
+#include "winget_table.h"
+#include "process_runner.h"
+#include "winget_index.h"
+#include "fetch_pool.h"
+#include "icon_store.h"
+#include "icon_decoder.h"
+#include "tag_correlation.h"
+#include "schema.h"
+#include "package_refresh.h"
 #include <windows.h>
 #include <shlobj.h>
 #include <sqlite3.h>
@@ -10,13 +19,12 @@
 #include <iomanip>
 #include <ctime>
 #include <algorithm>
-#include <unordered_set>
 
 WinProgramUpdater::WinProgramUpdater(const std::wstring& dbPath)
     : db_(nullptr), searchDb_(nullptr), dbPath_(dbPath),
       logCallback_(nullptr), logUserData_(nullptr),
       statsCallback_(nullptr), statsUserData_(nullptr),
-      cancelFlag_(nullptr) {
+      cancelFlag_(nullptr), fetchWorkers_(4) {
     // Set search database path in same directory as main database
     size_t lastSlash = dbPath.find_last_of(L"\\/");
     if (lastSlash != std::wstring::npos) {
@@ -48,6 +56,14 @@ void WinProgramUpdater::SetCancelFlag(std::atomic<bool>* flag) {
     cancelFlag_ = flag;
 }
 
+bool WinProgramUpdater::IsCancelled() const {
+    return cancelFlag_ && cancelFlag_->load();
+}
+
+void WinProgramUpdater::SetFetchConcurrency(int workers) {
+    fetchWorkers_ = workers < 1 ? 1 : workers;
+}
+
 // ========== Logging Function ==========
 
 void WinProgramUpdater::Log(const std::string& message) {
@@ -81,67 +97,7 @@ void WinProgramUpdater::Log(const std::string& message) {
 }
 
 void WinProgramUpdater::InitializeTagPatterns() {
-    // Technology/Hardware
-    tagPatterns_["USB"] = "usb";
-    tagPatterns_["Bluetooth"] = "bluetooth";
-    tagPatterns_["WiFi|Wi-Fi"] = "wifi";
-    tagPatterns_["HDMI"] = "hdmi";
-    tagPatterns_["GPU"] = "gpu";
-    tagPatterns_["CPU"] = "cpu";
-    
-    // Application types
-    tagPatterns_["Browser"] = "browser";
-    tagPatterns_["Client"] = "client";
-    tagPatterns_["Server"] = "server";
-    tagPatterns_["Manager"] = "manager";
-    tagPatterns_["Viewer"] = "viewer";
-    tagPatterns_["Editor"] = "editor";
-    tagPatterns_["Player"] = "player";
-    tagPatterns_["Launcher"] = "launcher";
-    tagPatterns_["Download"] = "download";
-    
-    // Functions
-    tagPatterns_["Emulator"] = "emulator";
-    tagPatterns_["Driver"] = "driver";
-    tagPatterns_["Manual"] = "manual";
-    tagPatterns_["Toolkit"] = "toolkit";
-    tagPatterns_["SDK"] = "development";
-    tagPatterns_["CLI|Command.?Line"] = "cli";
-    tagPatterns_["Mock"] = "testing";
-    tagPatterns_["Test"] = "testing";
-    tagPatterns_["Debug"] = "development";
-    tagPatterns_["Simulator"] = "emulator";
-    
-    // File formats/protocols
-    tagPatterns_["INI"] = "configuration";
-    tagPatterns_["JSON"] = "data";
-    tagPatterns_["XML"] = "data";
-    tagPatterns_["YAML"] = "configuration";
-    tagPatterns_["CSV"] = "data";
-    tagPatterns_["SQL"] = "database";
-    tagPatterns_["HTML"] = "web";
-    tagPatterns_["FTP"] = "network";
-    tagPatterns_["HTTP"] = "web";
-    tagPatterns_["ODBC"] = "database";
-    tagPatterns_["API"] = "development";
-    
-    // Media
-    tagPatterns_["Video"] = "video";
-    tagPatterns_["Audio"] = "audio";
-    tagPatterns_["Image"] = "graphics";
-    tagPatterns_["Photo"] = "graphics";
-    tagPatterns_["Music"] = "audio";
-    tagPatterns_["PDF"] = "document";
-    
-    // Categories
-    tagPatterns_["Game"] = "gaming";
-    tagPatterns_["Utility"] = "utilities";
-    tagPatterns_["Security"] = "security";
-    tagPatterns_["Password"] = "security";
-    tagPatterns_["Recovery"] = "utilities";
-    tagPatterns_["Backup"] = "backup";
-    tagPatterns_["Chocolatey"] = "package-manager";
-    tagPatterns_["Winget"] = "winget";
+    tagMatcher_.Build(NameTagPatterns());
 }
 
 bool WinProgramUpdater::OpenDatabase() {
@@ -151,11 +107,27 @@ bool WinProgramUpdater::OpenDatabase() {
         CloseDatabase();
         return false;
     }
+    // Icons live in their own table, keyed by content
+    if (MigrateIconStore(db_) < 0) {
+        Log("WARNING: Could not move inline icons into the icons table\n");
+    }
+    if (MigrateSchema(db_) < 0) {
+        Log("WARNING: Could not bring the database schema up to date\n");
+    }
+    // Icons stored as the site served them become icon bitmaps (once)
+    int transcodedIcons = TranscodeStoredIcons(db_);
+    if (transcodedIcons < 0) {
+        Log("WARNING: Could not transcode stored icons\n");
+    } else if (transcodedIcons > 0) {
+        Log("Transcoded " + std::to_string(transcodedIcons) + " stored icons.\n");
+    }
+    store_.Attach(db_);
     
     return true;
 }
 
 void WinProgramUpdater::CloseDatabase() {
+    store_.Detach();
     if (db_) {
         sqlite3_close(db_);
         db_ = nullptr;
@@ -170,10 +142,17 @@ bool WinProgramUpdater::OpenSearchDatabase() {
         return false;
     }
     
-    // Create table if not exists
+    // A cache left by a build without the version column is dropped
+    if (sqlite3_exec(searchDb_, "SELECT version FROM search_results LIMIT 0;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(searchDb_, "DROP TABLE IF EXISTS search_results;", nullptr, nullptr, nullptr);
+    }
+    
+    // Create table if not exists; version is the latest one winget lists
+    // (empty when the listing cut it short)
     const char* createTable = 
         "CREATE TABLE IF NOT EXISTS search_results ("
-        "package_id TEXT PRIMARY KEY COLLATE NOCASE"
+        "package_id TEXT PRIMARY KEY COLLATE NOCASE, "
+        "version TEXT"
         ");";
     
     return ExecuteSQLSearch(createTable);
@@ -230,120 +209,28 @@ std::vector<std::string> WinProgramUpdater::QueryPackageIds() {
 bool WinProgramUpdater::HasTags(const std::string& packageId) {
     int dbId = GetPackageDbId(packageId);
     if (dbId <= 0) return false;
-    
-    std::string sql = "SELECT COUNT(*) FROM app_categories WHERE app_id = " + std::to_string(dbId) + ";";
-    sqlite3_stmt* stmt;
-    int count = 0;
-    
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            count = sqlite3_column_int(stmt, 0);
-        }
-        sqlite3_finalize(stmt);
-    }
-    return count > 0;
+    return store_.HasCategories(dbId);
 }
 
 int WinProgramUpdater::GetPackageDbId(const std::string& packageId) {
-    std::string sql = "SELECT id FROM apps WHERE package_id = ? COLLATE NOCASE;";
-    sqlite3_stmt* stmt;
-    int id = -1;
-    
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, packageId.c_str(), -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            id = sqlite3_column_int(stmt, 0);
-        }
-        sqlite3_finalize(stmt);
-    }
-    return id;
+    return store_.PackageId(packageId);
 }
 
 int WinProgramUpdater::GetCategoryId(const std::string& category) {
-    std::string sql = "SELECT id FROM categories WHERE category_name = ? COLLATE NOCASE;";
-    sqlite3_stmt* stmt;
-    int id = -1;
-    
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, category.c_str(), -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            id = sqlite3_column_int(stmt, 0);
-        }
-        sqlite3_finalize(stmt);
-    }
-    
-    // Create if doesn't exist
-    if (id == -1) {
-        std::string insertSql = "INSERT INTO categories (category_name) VALUES (?);";
-        if (sqlite3_prepare_v2(db_, insertSql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, category.c_str(), -1, SQLITE_STATIC);
-            if (sqlite3_step(stmt) == SQLITE_DONE) {
-                id = static_cast<int>(sqlite3_last_insert_rowid(db_));
-            }
-            sqlite3_finalize(stmt);
-        }
-    }
-    return id;
+    return store_.CategoryId(category);
 }
 
-void WinProgramUpdater::AddPackage(const PackageInfo& pkg) {
-    // Validate package has a name (allow all characters including international ones)
-    if (pkg.name.empty()) {
-        // Skip packages with missing names
-        return;
-    }
-    
-    std::string sql = "INSERT OR REPLACE INTO apps (package_id, name, version, publisher, description, "
-                      "homepage, publisher_url, publisher_support_url, author, license, license_url, "
-                      "privacy_url, copyright, copyright_url, release_notes_url, moniker, release_date, "
-                      "icon_data, icon_type, source, installer_type, architecture, documentation_url, "
-                      "installer_url, installer_sha256, offline_distribution_supported, commands) "
-                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, pkg.packageId.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, pkg.name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, pkg.version.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, pkg.publisher.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 5, pkg.description.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 6, pkg.homepage.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 7, pkg.publisherUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 8, pkg.publisherSupportUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 9, pkg.author.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 10, pkg.license.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 11, pkg.licenseUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 12, pkg.privacyUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 13, pkg.copyright.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 14, pkg.copyrightUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 15, pkg.releaseNotesUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 16, pkg.moniker.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 17, pkg.releaseDate.c_str(), -1, SQLITE_STATIC);
-        
-        if (!pkg.iconData.empty()) {
-            sqlite3_bind_blob(stmt, 18, pkg.iconData.data(), pkg.iconData.size(), SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 19, pkg.iconType.c_str(), -1, SQLITE_STATIC);
-        } else {
-            sqlite3_bind_null(stmt, 18);
-            sqlite3_bind_null(stmt, 19);
-        }
-        
-        sqlite3_bind_text(stmt, 20, pkg.source.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 21, pkg.installerType.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 22, pkg.architecture.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 23, pkg.documentationUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 24, pkg.installerUrl.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 25, pkg.installerSha256.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 26, pkg.offlineDistributionSupported.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 27, pkg.commands.c_str(), -1, SQLITE_STATIC);
-        
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+void WinProgramUpdater::AddPackage(const PackageInfo& pkg, bool refresh) {
+    // The write itself is shared with CheckPackageRefresh (package_refresh.h)
+    std::string iconHash;
+    if (refresh) {
+        RefreshPackage(store_, pkg, &iconHash);
+    } else {
+        WritePackage(store_, pkg, &iconHash);
     }
-    
-    // Add tags
-    for (const auto& tag : pkg.tags) {
-        AddTag(pkg.packageId, tag);
+    // The next run revalidates this copy instead of downloading it again
+    if (!iconHash.empty() && !pkg.iconUrl.empty()) {
+        iconFetcher_.Stored(pkg.iconUrl, iconHash);
     }
 }
 
@@ -352,9 +239,14 @@ void WinProgramUpdater::RemovePackage(const std::string& packageId) {
     if (dbId <= 0) return;
     
     // Remove tags first
-    ExecuteSQL("DELETE FROM app_categories WHERE app_id = " + std::to_string(dbId) + ";");
+    store_.ClearCategoryLinks(dbId);
     // Remove package
-    ExecuteSQL("DELETE FROM apps WHERE id = " + std::to_string(dbId) + ";");
+    if (sqlite3_stmt* stmt = store_.Statement("DELETE FROM apps WHERE id = ?;")) {
+        sqlite3_bind_int(stmt, 1, dbId);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    store_.ForgetPackage(packageId);
 }
 
 void WinProgramUpdater::AddTag(const std::string& packageId, const std::string& tag) {
@@ -364,69 +256,60 @@ void WinProgramUpdater::AddTag(const std::string& packageId, const std::string&
     int categoryId = GetCategoryId(tag);
     if (categoryId <= 0) return;
     
-    std::string sql = "INSERT OR IGNORE INTO app_categories (app_id, category_id) VALUES (?, ?);";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_int(stmt, 1, dbId);
-        sqlite3_bind_int(stmt, 2, categoryId);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-    }
+    store_.AddCategoryLink(dbId, categoryId);
 }
 
 std::string WinProgramUpdater::ExecuteWingetCommand(const std::string& command) {
-    // Use temp file to avoid pipe buffering issues with winget
-    char tempPath[MAX_PATH];
-    GetTempPathA(MAX_PATH, tempPath);
-    std::string tempFile = std::string(tempPath) + "winget_output_" + std::to_string(GetTickCount()) + ".txt";
-    
-    // Redirect winget output to temp file using cmd.exe
-    std::string fullCmd = "cmd.exe /c \"winget " + command + " --accept-source-agreements --disable-interactivity > \"" + tempFile + "\" 2>&1\"";
-    
-    STARTUPINFOA si = {};
-    si.cb = sizeof(STARTUPINFOA);
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
-    
-    PROCESS_INFORMATION pi = {};
-    
-    if (CreateProcessA(nullptr, const_cast<char*>(fullCmd.c_str()), nullptr, nullptr, 
-                       FALSE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
-        // Wait up to 2 minutes for regional latency
-        DWORD waitResult = WaitForSingleObject(pi.hProcess, 120000);
-        
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        
-        if (waitResult == WAIT_TIMEOUT) {
-            // Timeout - delete temp file and return empty
-            DeleteFileA(tempFile.c_str());
-            return "";
+    // Read winget's output through the shared pipe-draining runner: no temp
+    // file, no cmd.exe, and a stuck winget is killed instead of left behind.
+    ProcessOptions opts;
+    opts.timeoutMs = 120000;  // up to 2 minutes for regional latency
+    opts.cancel = cancelFlag_;
+    ProcessResult r = RunProcess("winget " + command + " --accept-source-agreements --disable-interactivity", opts);
+    if (!r.started() || r.timedOut() || r.cancelled()) return "";
+    return std::move(r.output);
+}
+
+// Package IDs look like Publisher.Package: alphanumeric start, only [A-Za-z0-9_.+-],
+// at least one dot with something after it, and not purely numeric.
+static bool IsValidPackageId(std::string_view id) {
+    if (id.empty() || !isalnum(static_cast<unsigned char>(id[0]))) return false;
+    size_t dot = std::string_view::npos;
+    bool nonNumeric = false;
+    for (size_t i = 0; i < id.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(id[i]);
+        if (!isalnum(c) && c != '_' && c != '.' && c != '+' && c != '-') return false;
+        if (c == '.' && dot == std::string_view::npos && i > 0) dot = i;
+        if (!isdigit(c) && c != '.' && c != '-') nonNumeric = true;
+    }
+    return dot != std::string_view::npos && dot + 1 < id.size() && nonNumeric;
+}
+
+std::vector<WingetIndexRecord> WinProgramUpdater::GetWingetPackages() {
+    std::vector<WingetIndexRecord> packages;
+
+    // Fast path: read winget's own source index instead of scraping its table
+    std::string indexPath = WingetIndexReader::FindInstalledIndex();
+    if (!indexPath.empty()) {
+        WingetIndexReader index;
+        auto start = std::chrono::steady_clock::now();
+        if (index.Open(indexPath)) {
+            int count = index.ForEachPackage([&](const WingetIndexRecord& rec) {
+                if (IsValidPackageId(rec.id)) packages.push_back(rec);
+                return !IsCancelled();
+            }, false);
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            if (count > 0) {
+                Log("Read " + std::to_string(packages.size()) + " packages from winget source index (schema " +
+                    std::to_string(index.SchemaMajor()) + ") in " + std::to_string(ms) + " ms.\n");
+                return packages;
+            }
+            packages.clear();
         }
-        
-        // Give file system a moment to flush
-        Sleep(100);
-    } else {
-        return "";
+        Log("Could not read winget source index (" + (index.LastError().empty() ? indexPath : index.LastError()) + ").\n");
     }
-    
-    // Read output from temp file
-    std::string result;
-    std::ifstream file(tempFile, std::ios::binary);
-    if (file.is_open()) {
-        // Read entire file into string
-        result = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        file.close();
-    }
-    
-    // Clean up temp file
-    DeleteFileA(tempFile.c_str());
-    
-    return result;
-}
+    Log("Falling back to 'winget search'...\n");
 
-std::vector<std::string> WinProgramUpdater::GetWingetPackages() {
-    std::vector<std::string> packages;
     std::string output = ExecuteWingetCommand("search \"\" --source winget");
     
 #ifdef _CONSOLE
@@ -437,67 +320,23 @@ std::vector<std::string> WinProgramUpdater::GetWingetPackages() {
         return packages;  // Return empty if command failed
     }
     
-    std::istringstream stream(output);
-    std::string line;
-    bool inResults = false;
-    int lineCount = 0;
-    
-    // Regex to split on 2+ spaces
-    std::regex splitRegex("\\s{2,}");
-    
-    // Regex to validate package ID: alphanumeric with dots/dashes/plus signs, must contain non-numeric chars
-    std::regex idRegex("^[A-Za-z0-9][\\w.+_-]*\\.[\\w.+_-]+$");
-    
-    while (std::getline(stream, line)) {
-        lineCount++;
-        
-        // Skip progress indicators (single character lines or spinner)
-        if (line.length() <= 2) continue;
-        
-        // Look for separator line (dashes)
-        if (line.find("---") != std::string::npos && line.length() > 10) {
-            inResults = true;
-            continue;
-        }
-        
-        if (!inResults) continue;
-        if (line.empty() || line.length() < 10) continue;
-        
-        // Skip lines that are just whitespace
-        if (line.find_first_not_of(" \t\r\n") == std::string::npos) continue;
-        
-        // Split line on 2+ spaces to get columns
-        // Format: Name   PackageId   Version   Source
-        std::vector<std::string> columns;
-        std::sregex_token_iterator iter(line.begin(), line.end(), splitRegex, -1);
-        std::sregex_token_iterator end;
-        
-        for (; iter != end; ++iter) {
-            std::string col = Trim(iter->str());
-            if (!col.empty()) {
-                columns.push_back(col);
-            }
-        }
-        
-        // Second column should be PackageID
-        if (columns.size() >= 2) {
-            std::string packageId = columns[1];
-            
-            // Validate package ID format
-            if (std::regex_match(packageId, idRegex)) {
-                // Additional check: ensure it's not pure numeric (like version numbers)
-                if (packageId.find_first_not_of("0123456789.-") != std::string::npos) {
-                    packages.push_back(packageId);
+    // Slice each row by the column offsets of the header (Name  Id  Version  [Match]  Source)
+    ForEachWingetRow(output, [&](const WingetTableRow& row) {
+        // Truncated IDs ("Publisher.Pack…") cannot be queried later
+        if (row.IsTruncated(WCOL_ID) || !IsValidPackageId(row.id())) return true;
+        WingetIndexRecord rec;
+        rec.id = std::string(row.id());
+        // A truncated version is no version: the package is not refreshed
+        if (!row.IsTruncated(WCOL_VERSION)) rec.version = std::string(row.version());
+        packages.push_back(std::move(rec));
 #ifdef _CONSOLE
-                    // Show first few IDs for verification
-                    if (packages.size() <= 5) {
-                        std::wcout << L"  ID " << packages.size() << L": " << StringToWString(packageId) << std::endl;
-                    }
-#endif
-                }
-            }
+        // Show first few IDs for verification
+        if (packages.size() <= 5) {
+            std::wcout << L"  ID " << packages.size() << L": " << StringToWString(packages.back().id) << std::endl;
         }
-    }
+#endif
+        return true;
+    });
     
     return packages;
 }
@@ -518,18 +357,21 @@ void WinProgramUpdater::PopulateSearchDatabase() {
     std::wcout << L"Populating search database..." << std::endl;
 #endif
     
-    // Insert all packages into search database
+    // Insert all packages into search database (one statement, one transaction)
     sqlite3_stmt* stmt;
-    const char* sql = "INSERT OR IGNORE INTO search_results (package_id) VALUES (?);";
+    const char* sql = "INSERT OR IGNORE INTO search_results (package_id, version) VALUES (?, ?);";
     
-    for (const auto& pkg : packages) {
-        if (IsNumericOnly(pkg)) continue;
-        
-        if (sqlite3_prepare_v2(searchDb_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, pkg.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_prepare_v2(searchDb_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        ExecuteSQLSearch("BEGIN TRANSACTION;");
+        for (const auto& pkg : packages) {
+            if (IsNumericOnly(pkg.id)) continue;
+            sqlite3_bind_text(stmt, 1, pkg.id.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, pkg.version.c_str(), -1, SQLITE_STATIC);
             sqlite3_step(stmt);
-            sqlite3_finalize(stmt);
+            sqlite3_reset(stmt);
         }
+        ExecuteSQLSearch("COMMIT;");
+        sqlite3_finalize(stmt);
     }
     
 #ifdef _CONSOLE
@@ -549,13 +391,10 @@ void WinProgramUpdater::PopulateSearchDatabase() {
 std::vector<std::string> WinProgramUpdater::GetNewPackages() {
     std::vector<std::string> newPackages;
     
-    // Find packages in search DB but not in main DB
-    const char* sql = 
-        "SELECT package_id FROM search_results "
-        "WHERE package_id NOT IN (SELECT package_id FROM apps);";
-    
+    // Find packages in search DB but not in main DB. apps is only visible from
+    // db_, with the search database attached as search_db
     sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(searchDb_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (sqlite3_prepare_v2(db_, kNewPackagesSql, -1, &stmt, nullptr) == SQLITE_OK) {
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             const unsigned char* text = sqlite3_column_text(stmt, 0);
             if (text) {
@@ -568,85 +407,56 @@ std::vector<std::string> WinProgramUpdater::GetNewPackages() {
     return newPackages;
 }
 
-std::vector<std::string> WinProgramUpdater::GetDeletedPackages() {
-    std::vector<std::string> deletedPackages;
-    
-    // Step 3.1: Run comprehensive winget search to get ALL available packages
-    std::string searchOutput = ExecuteWingetCommand("search .");
-    
-    // Step 3.2: Parse all package IDs from the comprehensive search
-    std::unordered_set<std::string> availablePackageIds;
-    std::istringstream stream(searchOutput);
-    std::string line;
-    bool inResultsSection = false;
+void WinProgramUpdater::RefreshChangedPackages(UpdateStats& stats) {
+    std::vector<ChangedPackage> changed = FindChangedPackages(db_);
+    Log("Found " + std::to_string(changed.size()) + " packages with a new version.\n");
+#ifdef _CONSOLE
+    std::wcout << L"Found " << changed.size() << L" packages with a new version" << std::endl;
+#endif
+    if (changed.empty()) return;
     
-    while (std::getline(stream, line)) {
-        // Skip until we find the header line with "Name" and "Id"
-        if (!inResultsSection) {
-            if (line.find("Name") != std::string::npos && line.find("Id") != std::string::npos) {
-                inResultsSection = true;
-                std::getline(stream, line); // Skip the separator line (dashes)
-            }
-            continue;
-        }
-        
-        // Skip empty lines and progress indicators
-        if (line.empty() || line.length() <= 2) continue;
-        if (line.find_first_not_of(" \t\r\n-\\/|") == std::string::npos) continue;
-        
-        // Parse line using right-to-left tokenization
-        // Format: Name [spaces] Id [spaces] Version [spaces] Source
-        std::vector<std::string> tokens;
-        std::string token;
-        bool inToken = false;
-        
-        // Right-to-left parsing
-        for (int i = line.length() - 1; i >= 0; i--) {
-            char c = line[i];
-            if (c == ' ' || c == '\t') {
-                if (inToken) {
-                    std::reverse(token.begin(), token.end());
-                    tokens.push_back(token);
-                    token.clear();
-                    inToken = false;
-                    if (tokens.size() >= 3) break; // Got Source, Version, and Id
-                }
-            } else {
-                token += c;
-                inToken = true;
-            }
-        }
-        
-        // Package ID is the 3rd token from the right (Source, Version, Id)
-        if (tokens.size() >= 3) {
-            std::string packageId = tokens[2]; // 0=Source, 1=Version, 2=Id
-            if (!packageId.empty()) {
-                availablePackageIds.insert(packageId);
-            }
-        }
+    std::vector<std::string> packageIds;
+    std::map<std::string, std::string> storedVersions;
+    for (const ChangedPackage& package : changed) {
+        packageIds.push_back(package.packageId);
+        storedVersions[package.packageId] = package.storedVersion;
     }
     
-    // Step 3.3: Find packages in DB that are NOT available AND NOT installed
-    const char* sql = 
-        "SELECT package_id FROM apps "
-        "WHERE package_id NOT IN (SELECT package_id FROM installed_apps);";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            const unsigned char* text = sqlite3_column_text(stmt, 0);
-            if (text) {
-                std::string packageId = reinterpret_cast<const char*>(text);
-                // Only mark for deletion if NOT in comprehensive available list
-                if (availablePackageIds.find(packageId) == availablePackageIds.end()) {
-                    deletedPackages.push_back(packageId);
-                }
-            }
+    int processedCount = 0;
+    FetchPackageInfos(packageIds, [&](const PackageInfo& info) {
+        processedCount++;
+        std::string progressMsg = "[" + std::to_string(processedCount) + "/" + std::to_string(packageIds.size()) + "] ";
+        // A failed or cancelled fetch keeps the stored row; the next run tries again
+        if (info.name.empty()) {
+            Log(progressMsg + "Skipped (no package info available): " + info.packageId + "\n");
+            return;
         }
-        sqlite3_finalize(stmt);
+        // New categories from winget's tags, and tags_updated set
+        AddPackage(info, true);
+        stats.packagesUpdated++;
+        stats.tagsFromWinget += info.tags.size();
+        Log(progressMsg + "Updated: " + info.packageId + " " + storedVersions[info.packageId] + " -> " + info.version + "\n");
+#ifdef _CONSOLE
+        std::wcout << L"  Updated: " << StringToWString(info.packageId) << std::endl;
+#endif
+    });
+}
+
+bool WinProgramUpdater::RemoveDeletedPackages(UpdateStats& stats) {
+    PackageRemoval removal;
+    if (!::RemoveDeletedPackages(store_, removal)) {
+        if (removal.listed == 0) {
+            Log("Step 1 listed no packages; skipping the removal check.\n");
+        } else if (removal.heldBack) {
+            Log("Not removing " + std::to_string(removal.packageIds.size()) + " of " +
+                std::to_string(removal.stored) + " packages: more than " +
+                std::to_string((int)(kMaxRemovedFraction * 100)) + "% looks like an incomplete winget list.\n");
+        }
+        return false;
     }
-    
-    return deletedPackages;
+    for (const std::string& packageId : removal.packageIds) Log("  Removed: " + packageId + "\n");
+    stats.packagesRemoved += (int)removal.packageIds.size();
+    return true;
 }
 
 PackageInfo WinProgramUpdater::GetPackageInfo(const std::string& packageId, int attempt) {
@@ -655,7 +465,7 @@ PackageInfo WinProgramUpdater::GetPackageInfo(const std::string& packageId, int
     
     std::string output = ExecuteWingetCommand("show \"" + packageId + "\"");
     
-    if (output.empty() && attempt < MAX_RETRIES) {
+    if (output.empty() && attempt < MAX_RETRIES && !IsCancelled()) {
         Sleep(1000 * attempt);  // Exponential backoff
         return GetPackageInfo(packageId, attempt + 1);
     }
@@ -778,160 +588,61 @@ PackageInfo WinProgramUpdater::GetPackageInfo(const std::string& packageId, int
         info.architecture = "x64";
     }
     
-    // Fetch icon from homepage if available
+    // Fetch icon from homepage if available, and store it ready to show:
+    // decoded once here rather than on every start of the main window
     if (!info.homepage.empty()) {
-        FetchIconFromHomepage(info.homepage, info.iconData, info.iconType);
+        FetchedIcon icon = iconFetcher_.Fetch(info.homepage);
+        info.iconUrl = icon.url;
+        std::vector<unsigned char> bitmap;
+        if (!icon.storedHash.empty()) {
+            // Unchanged since an earlier run stored it
+            info.iconHash = icon.storedHash;
+        } else if (!icon.data.empty() && TranscodeIcon(icon.data.data(), icon.data.size(), bitmap)) {
+            info.iconData.swap(bitmap);
+            info.iconType = kIconBitmapType;
+        }
+        // Otherwise not an image we can show (HTML error page, JPEG, SVG, corrupt or huge)
     }
     
     return info;
 }
 
-void WinProgramUpdater::FetchIconFromHomepage(const std::string& homepage, std::vector<unsigned char>& iconData, std::string& iconType) {
-    if (homepage.empty()) return;
-    
-    // Use PowerShell to fetch the homepage HTML, find icon URL, and download it
-    std::string psScript = 
-        "$url = '" + homepage + "'; "
-        "try { "
-        "$response = Invoke-WebRequest -Uri $url -TimeoutSec 5 -UseBasicParsing -ErrorAction Stop; "
-        "$html = $response.Content; "
-        
-        // Look for various icon patterns
-        "if ($html -match '<link[^>]*rel=[\"''](?:icon|shortcut icon)[\"''][^>]*href=[\"'']([^\"'']+)[\"'']') { "
-        "  $icon = $Matches[1]; "
-        "} elseif ($html -match '<link[^>]*href=[\"'']([^\"'']+)[\"''][^>]*rel=[\"''](?:icon|shortcut icon)[\"'']') { "
-        "  $icon = $Matches[1]; "
-        "} else { "
-        "  $icon = '/favicon.ico'; "
-        "} "
-        
-        // Convert relative URL to absolute
-        "if ($icon -notmatch '^https?://') { "
-        "  $uri = [System.Uri]$url; "
-        "  if ($icon -match '^//') { "
-        "    $icon = $uri.Scheme + ':' + $icon; "
-        "  } elseif ($icon -match '^/') { "
-        "    $icon = $uri.Scheme + '://' + $uri.Host + $icon; "
-        "  } else { "
-        "    $icon = $uri.Scheme + '://' + $uri.Host + '/' + $icon; "
-        "  } "
-        "} "
-        
-        // Download the icon
-        "try { "
-        "  $iconResponse = Invoke-WebRequest -Uri $icon -TimeoutSec 5 -UseBasicParsing -ErrorAction Stop; "
-        "  $tempFile = [System.IO.Path]::GetTempFileName(); "
-        "  [System.IO.File]::WriteAllBytes($tempFile, $iconResponse.Content); "
-        "  Write-Output $tempFile; "
-        "  Write-Output $icon; "
-        "} catch { Write-Output ''; } "
-        "} catch { Write-Output ''; }";
-    
-    std::string command = "powershell -NoProfile -Command \"" + psScript + "\"";
-    
-    SECURITY_ATTRIBUTES sa = {sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
-    HANDLE hRead, hWrite;
-    if (!CreatePipe(&hRead, &hWrite, &sa, 0)) {
-        return;
-    }
-    
-    STARTUPINFOA si = {};
-    si.cb = sizeof(STARTUPINFOA);
-    si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
-    si.hStdOutput = hWrite;
-    si.hStdError = hWrite;
-    si.wShowWindow = SW_HIDE;
-    
-    PROCESS_INFORMATION pi;
-    if (!CreateProcessA(nullptr, const_cast<char*>(command.c_str()), 
-                        nullptr, nullptr, TRUE, 0, nullptr, nullptr, &si, &pi)) {
-        CloseHandle(hRead);
-        CloseHandle(hWrite);
-        return;
-    }
-    
-    CloseHandle(hWrite);
-    
-    std::string output;
-    char buffer[4096];
-    DWORD bytesRead;
-    while (ReadFile(hRead, buffer, sizeof(buffer) - 1, &bytesRead, nullptr) && bytesRead > 0) {
-        buffer[bytesRead] = '\0';
-        output += buffer;
-    }
-    
-    WaitForSingleObject(pi.hProcess, 15000); // 15 second timeout
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-    CloseHandle(hRead);
-    
-    // Parse output: first line is temp file path, second line is icon URL
-    std::istringstream stream(output);
-    std::string tempFile, iconUrl;
-    std::getline(stream, tempFile);
-    std::getline(stream, iconUrl);
-    
-    tempFile = Trim(tempFile);
-    iconUrl = Trim(iconUrl);
-    
-    if (!tempFile.empty() && !iconUrl.empty()) {
-        // Read the icon file
-        std::ifstream file(tempFile, std::ios::binary | std::ios::ate);
-        if (file.is_open()) {
-            std::streamsize size = file.tellg();
-            file.seekg(0, std::ios::beg);
-            
-            iconData.resize(size);
-            if (file.read(reinterpret_cast<char*>(iconData.data()), size)) {
-                // Determine icon type from URL
-                if (iconUrl.find(".png") != std::string::npos) {
-                    iconType = "png";
-                } else if (iconUrl.find(".jpg") != std::string::npos || iconUrl.find(".jpeg") != std::string::npos) {
-                    iconType = "jpg";
-                } else {
-                    iconType = "ico";
-                }
+void WinProgramUpdater::FetchPackageInfos(const std::vector<std::string>& packageIds,
+                                          const std::function<void(const PackageInfo&)>& store) {
+    // GetPackageInfo only runs winget and parses its output, so it is safe on
+    // the pool threads; every database write stays on this thread.
+    RunFetchPool(packageIds, fetchWorkers_, cancelFlag_,
+        [this](const std::string& packageId) { return GetPackageInfo(packageId); },
+        [&](std::vector<PackageInfo>& batch) {
+            store_.BeginBatch();
+            for (const auto& info : batch) {
+                store(info);
+                store_.Wrote();
             }
-            file.close();
-        }
-        
-        // Clean up temp file
-        DeleteFileA(tempFile.c_str());
-    }
+            // Commit at the end of each drained batch too, so progress is kept
+            // even though fetches are far slower than the writes
+            store_.EndBatch();
+        });
 }
 
 std::vector<std::string> WinProgramUpdater::ExtractTagsFromText(const std::string& name,
                                                                   const std::string& packageId,
                                                                   const std::string& moniker) {
-    std::vector<std::string> tags;
-    
-    for (const auto& pattern : tagPatterns_) {
-        std::regex re(pattern.first, std::regex_constants::icase);
-        
-        if (std::regex_search(name, re) || 
-            std::regex_search(packageId, re) ||
-            (!moniker.empty() && std::regex_search(moniker, re))) {
-            
-            // Avoid duplicates
-            if (std::find(tags.begin(), tags.end(), pattern.second) == tags.end()) {
-                tags.push_back(pattern.second);
-            }
-        }
-    }
-    
-    return tags;
+    return tagMatcher_.Match({name, packageId, moniker});
 }
 
 bool WinProgramUpdater::IsNumericOnly(const std::string& packageId) {
-    return std::regex_match(packageId, std::regex("^[0-9.]+$"));
+    if (packageId.empty()) return false;
+    for (char c : packageId) {
+        if ((c < '0' || c > '9') && c != '.') return false;
+    }
+    return true;
 }
 
 void WinProgramUpdater::ApplyNameBasedInference(UpdateStats& stats) {
     sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, package_id, name, moniker FROM apps "
-                      "WHERE id NOT IN (SELECT DISTINCT app_id FROM app_categories);";
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (sqlite3_prepare_v2(db_, kUncategorizedAppsSql, -1, &stmt, nullptr) == SQLITE_OK) {
+        store_.BeginBatch();
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             std::string packageId = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
             std::string name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
@@ -943,99 +654,35 @@ void WinProgramUpdater::ApplyNameBasedInference(UpdateStats& stats) {
                 AddTag(packageId, tag);
                 stats.tagsFromInference++;
             }
+            store_.Wrote();
         }
         sqlite3_finalize(stmt);
+        store_.EndBatch();
     }
 }
 
 void WinProgramUpdater::ApplyCorrelationAnalysis(UpdateStats& stats) {
-    // Build co-occurrence matrix
-    std::map<std::string, std::map<std::string, int>> coOccurrence;
-    std::map<std::string, int> tagCounts;
-    
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT app_id FROM app_categories GROUP BY app_id HAVING COUNT(*) > 1;";
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            int appId = sqlite3_column_int(stmt, 0);
-            
-            // Get all tags for this app
-            std::vector<std::string> appTags;
-            sqlite3_stmt* tagStmt;
-            std::string tagSql = "SELECT c.category_name FROM categories c "
-                                "JOIN app_categories ac ON c.id = ac.category_id "
-                                "WHERE ac.app_id = " + std::to_string(appId) + ";";
-            
-            if (sqlite3_prepare_v2(db_, tagSql.c_str(), -1, &tagStmt, nullptr) == SQLITE_OK) {
-                while (sqlite3_step(tagStmt) == SQLITE_ROW) {
-                    std::string tag = reinterpret_cast<const char*>(sqlite3_column_text(tagStmt, 0));
-                    appTags.push_back(tag);
-                    tagCounts[tag]++;
-                }
-                sqlite3_finalize(tagStmt);
-            }
-            
-            // Build co-occurrence for each pair
-            for (size_t i = 0; i < appTags.size(); i++) {
-                for (size_t j = 0; j < appTags.size(); j++) {
-                    if (i != j) {
-                        coOccurrence[appTags[i]][appTags[j]]++;
-                    }
-                }
-            }
-        }
-        sqlite3_finalize(stmt);
-    }
-    
-    // Apply correlation rules (66.67% threshold, min 6 samples)
-    const double CORRELATION_THRESHOLD = 0.6667;
-    const int MIN_SAMPLES = 6;
-    
-    for (const auto& source : coOccurrence) {
-        if (tagCounts[source.first] < MIN_SAMPLES) continue;
-        
-        for (const auto& target : source.second) {
-            double correlation = static_cast<double>(target.second) / tagCounts[source.first];
-            
-            if (correlation >= CORRELATION_THRESHOLD) {
-                // Apply inference rule: packages with source tag should have target tag
-                std::string applySql = 
-                    "INSERT OR IGNORE INTO app_categories (app_id, category_id) "
-                    "SELECT ac.app_id, (SELECT id FROM categories WHERE category_name = ?) "
-                    "FROM app_categories ac "
-                    "JOIN categories c ON ac.category_id = c.id "
-                    "WHERE c.category_name = ? "
-                    "AND ac.app_id NOT IN ("
-                    "  SELECT app_id FROM app_categories "
-                    "  WHERE category_id = (SELECT id FROM categories WHERE category_name = ?)"
-                    ");";
-                
-                sqlite3_stmt* applyStmt;
-                if (sqlite3_prepare_v2(db_, applySql.c_str(), -1, &applyStmt, nullptr) == SQLITE_OK) {
-                    sqlite3_bind_text(applyStmt, 1, target.first.c_str(), -1, SQLITE_STATIC);
-                    sqlite3_bind_text(applyStmt, 2, source.first.c_str(), -1, SQLITE_STATIC);
-                    sqlite3_bind_text(applyStmt, 3, target.first.c_str(), -1, SQLITE_STATIC);
-                    
-                    if (sqlite3_step(applyStmt) == SQLITE_DONE) {
-                        stats.tagsFromCorrelation += sqlite3_changes(db_);
-                    }
-                    sqlite3_finalize(applyStmt);
-                }
-            }
+    // Rules and the rows they add are worked out in memory; write them in one batch
+    std::vector<AppCategory> inferred = InferCorrelatedCategories(db_);
+    store_.BeginBatch();
+    for (const AppCategory& row : inferred) {
+        if (store_.AddCategoryLink(row.appId, row.categoryId)) {
+            stats.tagsFromCorrelation += sqlite3_changes(db_);
         }
+        store_.Wrote();
     }
+    store_.EndBatch();
 }
 
 void WinProgramUpdater::TagUncategorized(UpdateStats& stats) {
     int categoryId = GetCategoryId("uncategorized");
     
-    std::string sql = "INSERT INTO app_categories (app_id, category_id) "
-                      "SELECT id, " + std::to_string(categoryId) + " "
-                      "FROM apps WHERE id NOT IN (SELECT DISTINCT app_id FROM app_categories);";
-    
-    if (ExecuteSQL(sql)) {
-        stats.uncategorized = sqlite3_changes(db_);
+    sqlite3_stmt* stmt = store_.Statement(kTagUncategorizedSql);
+    if (stmt) {
+        sqlite3_bind_int(stmt, 1, categoryId);
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            stats.uncategorized = sqlite3_changes(db_);
+        }
     }
 }
 
@@ -1062,10 +709,15 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
         return false;
     }
     
+    // Icon URLs of earlier runs, so stored icons are only revalidated
+    if (LoadIconSources(db_, iconFetcher_) < 0) {
+        Log("WARNING: Could not load icon sources\n");
+    }
+    
     // BEGIN: Step 1 - Query winget for available packages
     // Step 1: Populate search database with winget search results
     Log("=== Step 1: Query winget ===\n");
-    Log("Executing 'winget search .' to enumerate all available packages...\n");
+    Log("Enumerating all available packages from winget's source index...\n");
 #ifdef _CONSOLE
     std::wcout << L"\n=== Step 1: Query winget ===" << std::endl;
     auto stepStart = std::chrono::high_resolution_clock::now();
@@ -1125,14 +777,13 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
     
     // Add new packages
     int processedCount = 0;
-    for (const auto& packageId : newPackages) {
+    FetchPackageInfos(newPackages, [&](const PackageInfo& info) {
         processedCount++;
         std::string progressMsg = "[" + std::to_string(processedCount) + "/" + std::to_string(newPackages.size()) + "] ";
-        Log(progressMsg + "Processing: " + packageId + "...\n");
+        Log(progressMsg + "Processed: " + info.packageId + "\n");
 #ifdef _CONSOLE
-        std::wcout << L"  Processing: " << StringToWString(packageId) << L"..." << std::flush;
+        std::wcout << L"  Processed: " << StringToWString(info.packageId) << L"..." << std::flush;
 #endif
-        PackageInfo info = GetPackageInfo(packageId);
         if (!info.name.empty()) {
             AddPackage(info);
             stats.packagesAdded++;
@@ -1148,7 +799,12 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
             std::wcout << L" ✗ Skipped (no info)" << std::endl;
 #endif
         }
-    }
+    });
+    
+    // Step 2 (continued): Re-fetch packages winget lists at a new version,
+    // so stored versions, descriptions and installers follow the catalog
+    Log("Comparing stored versions with the versions winget lists...\n");
+    RefreshChangedPackages(stats);
     
     // Step 2 (continued): Cross-reference with installed packages
     Log("Cross-referencing with installed packages...\n");
@@ -1169,7 +825,7 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
         "SELECT DISTINCT sr.package_id "
         "FROM search_db.search_results sr "
         "INNER JOIN installed_apps ia ON sr.package_id = ia.package_id "
-        "WHERE sr.package_id NOT IN (SELECT package_id FROM apps);";
+        "WHERE NOT EXISTS (SELECT 1 FROM apps a WHERE a.package_id = sr.package_id);";
     
     sqlite3_stmt* stmtMissing;
     std::vector<std::string> missingInstalledPackages;
@@ -1190,9 +846,8 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
         Log(foundMsg);
         
         int addedFromInstalled = 0;
-        for (const auto& packageId : missingInstalledPackages) {
-            Log("  Adding package: " + packageId + "...\n");
-            PackageInfo info = GetPackageInfo(packageId);
+        FetchPackageInfos(missingInstalledPackages, [&](const PackageInfo& info) {
+            Log("  Adding package: " + info.packageId + "...\n");
             if (!info.name.empty()) {
                 AddPackage(info);
                 stats.packagesAdded++;
@@ -1202,10 +857,7 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
             } else {
                 Log("   ✗ Could not retrieve package info\n");
             }
-            
-            // Add delay between winget calls to prevent overwhelming the system
-            Sleep(300);
-        }
+        });
         
         std::string resultMsg = "Added " + std::to_string(addedFromInstalled) + 
                                 " package(s) to database.\n";
@@ -1214,80 +866,32 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
         Log("All packages are already in database.\n");
     }
     
-    std::string step2Summary = "\nStep 2 Summary: Added " + std::to_string(stats.packagesAdded) + " new packages with " + 
+    std::string step2Summary = "\nStep 2 Summary: Added " + std::to_string(stats.packagesAdded) + " new and updated " +
+                                std::to_string(stats.packagesUpdated) + " changed packages with " +
                                 std::to_string(stats.tagsFromWinget) + " tags from winget.\n";
     Log(step2Summary);
     // END: Step 2
     
     // BEGIN: Step 3 - Find and remove packages deleted from winget
-    // Step 3: Find and remove deleted packages (comprehensive check)
-    // Run "winget search ." to get ALL available packages, then safely delete
-    // packages that are NOT available AND NOT installed
+    // Step 3: Remove packages that are NOT in Step 1's list AND NOT installed
     Log("\n=== Step 3: Find deleted packages ===\n");
-    Log("Running comprehensive winget search to identify obsolete packages...\n");
+    Log("Comparing the database with the packages winget lists to identify obsolete packages...\n");
     Log("This step ensures packages no longer in winget (and not installed) are removed.\n");
 #ifdef _CONSOLE
-    std::wcout << L"\n=== Step 3: Find deleted packages (comprehensive) ===" << std::endl;
+    std::wcout << L"\n=== Step 3: Find deleted packages ===" << std::endl;
 #endif
     
-    // Get executable directory for script path
-    char exePath[MAX_PATH];
-    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
-    std::string exeDir = std::string(exePath);
-    size_t lastSlash = exeDir.find_last_of("\\/");
-    if (lastSlash != std::string::npos) {
-        exeDir = exeDir.substr(0, lastSlash);
-    }
-    
-    // Convert database path to UTF-8
-    std::wstring wDbPath = dbPath_;
-    std::string dbPathUtf8;
-    int size = WideCharToMultiByte(CP_UTF8, 0, wDbPath.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (size > 0) {
-        dbPathUtf8.resize(size - 1);
-        WideCharToMultiByte(CP_UTF8, 0, wDbPath.c_str(), -1, &dbPathUtf8[0], size, nullptr, nullptr);
-    }
-    
-    // Use PowerShell script for comprehensive check via "winget search ."
-    // This ensures we only delete packages that are truly gone from winget
-    std::string checkScript = exeDir + "\\scripts\\check_deleted_packages.ps1";
-    std::string checkCommand = "powershell.exe -ExecutionPolicy Bypass -NoProfile -File \"" + 
-                               checkScript + "\" -DatabasePath \"" + dbPathUtf8 + "\"";
-    
-    STARTUPINFOA checkSi = {};
-    PROCESS_INFORMATION checkPi = {};
-    checkSi.cb = sizeof(checkSi);
-    checkSi.dwFlags = STARTF_USESHOWWINDOW;
-    checkSi.wShowWindow = SW_HIDE;
-    
-    if (CreateProcessA(nullptr, const_cast<char*>(checkCommand.c_str()), nullptr, nullptr, 
-                       FALSE, CREATE_NO_WINDOW, nullptr, nullptr, &checkSi, &checkPi)) {
-        WaitForSingleObject(checkPi.hProcess, 600000); // 10 minute timeout for comprehensive search
-        
-        DWORD checkExitCode = 0;
-        GetExitCodeProcess(checkPi.hProcess, &checkExitCode);
-        
-        CloseHandle(checkPi.hProcess);
-        CloseHandle(checkPi.hThread);
-        
-#ifdef _CONSOLE
-        if (checkExitCode == 0) {
-            std::wcout << L"Cleanup completed successfully" << std::endl;
-        } else {
-            std::wcout << L"Cleanup script exited with code: " << checkExitCode << std::endl;
-        }
-#endif
-        if (checkExitCode == 0) {
-            Log("Step 3 complete! Obsolete packages have been removed.\n\n");
+    if (RemoveDeletedPackages(stats)) {
+        if (stats.packagesRemoved > 0) {
+            Log("Step 3 complete! Removed " + std::to_string(stats.packagesRemoved) + " obsolete package(s).\n\n");
         } else {
-            std::string errMsg = "Step 3 warning: Cleanup script exited with code " + std::to_string(checkExitCode) + "\n\n";
-            Log(errMsg);
+            Log("Step 3 complete! No obsolete packages found.\n\n");
         }
-    } else {
-        Log("ERROR: Failed to execute cleanup script!\n\n");
 #ifdef _CONSOLE
-        std::wcout << L"Failed to execute cleanup script" << std::endl;
+        std::wcout << L"Removed " << stats.packagesRemoved << L" obsolete packages" << std::endl;
 #endif
+    } else {
+        Log("Step 3 warning: Obsolete packages were not removed.\n\n");
     }
     // END: Step 3
     
@@ -1300,9 +904,7 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
 #endif
     
     sqlite3_stmt* stmt;
-    const char* sql = "SELECT package_id FROM apps WHERE tags_updated = 0 AND id NOT IN (SELECT DISTINCT app_id FROM app_categories);";
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (sqlite3_prepare_v2(db_, kUncheckedUntaggedAppsSql, -1, &stmt, nullptr) == SQLITE_OK) {
         std::vector<std::string> zeroTagPackages;
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             zeroTagPackages.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
@@ -1316,14 +918,16 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
 #endif
         
         int step4Count = 0;
-        for (const auto& packageId : zeroTagPackages) {
+        FetchPackageInfos(zeroTagPackages, [&](const PackageInfo& info) {
+            const std::string& packageId = info.packageId;
+            // A fetch cut short by cancellation must not mark the package as checked
+            if (info.version.empty() && IsCancelled()) return;
             step4Count++;
             std::string progressMsg = "[" + std::to_string(step4Count) + "/" + std::to_string(zeroTagPackages.size()) + "] ";
             Log(progressMsg + "Updating: " + packageId + "...\n");
 #ifdef _CONSOLE
             std::wcout << L"  Updating tags for: " << StringToWString(packageId) << L"..." << std::flush;
 #endif
-            PackageInfo info = GetPackageInfo(packageId);
             int addedTags = 0;
             for (const auto& tag : info.tags) {
                 AddTag(packageId, tag);
@@ -1332,12 +936,10 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
             }
             
             // Mark this package as checked (whether tags were found or not)
-            std::string updateSql = "UPDATE apps SET tags_updated = 1 WHERE package_id = ?;";
-            sqlite3_stmt* updateStmt;
-            if (sqlite3_prepare_v2(db_, updateSql.c_str(), -1, &updateStmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_stmt* updateStmt = store_.Statement("UPDATE apps SET tags_updated = 1 WHERE package_id = ?;")) {
                 sqlite3_bind_text(updateStmt, 1, packageId.c_str(), -1, SQLITE_STATIC);
                 sqlite3_step(updateStmt);
-                sqlite3_finalize(updateStmt);
+                sqlite3_reset(updateStmt);
             }
             
             if (addedTags > 0) {
@@ -1353,7 +955,7 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
                 std::wcout << L" (no tags found)" << std::endl;
             }
 #endif
-        }
+        });
         Log("\nStep 4 complete! All zero-tag packages have been checked.\n\n");
     }
     // END: Step 4
@@ -1376,8 +978,11 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
 #ifdef _CONSOLE
     std::wcout << L"\n=== Step 6: Apply correlation analysis ===" << std::endl;
 #endif
+    auto correlationStart = std::chrono::steady_clock::now();
     ApplyCorrelationAnalysis(stats);
-    Log("Step 6 complete! Correlation analysis applied.\n\n");
+    auto correlationMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - correlationStart).count();
+    Log("Step 6 complete! Correlation analysis added " + std::to_string(stats.tagsFromCorrelation) + " tags in " +
+        std::to_string(correlationMs) + " ms.\n\n");
     // END: Step 6
     
     // BEGIN: Step 7 - Tag remaining uncategorized packages
@@ -1393,6 +998,20 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
     
     stats.tagsAdded = stats.tagsFromWinget + stats.tagsFromInference + stats.tagsFromCorrelation;
     
+    // Validators of the icon URLs fetched this run, for the next one
+    if (SaveIconSources(db_, iconFetcher_) < 0) {
+        Log("WARNING: Could not save icon sources\n");
+    }
+    Log("Icons: " + std::to_string(iconFetcher_.Requests()) + " requests, " +
+        std::to_string(iconFetcher_.CacheHits()) + " answered from this run's cache, " +
+        std::to_string(iconFetcher_.Revalidated()) + " stored icons unchanged.\n");
+    
+    // Icons only removed or replaced packages used
+    int prunedIcons = PruneIcons(db_);
+    if (prunedIcons > 0) {
+        Log("Removed " + std::to_string(prunedIcons) + " unused icons.\n");
+    }
+    
     // Detach search database
     ExecuteSQL("DETACH DATABASE search_db;");
     
@@ -1417,6 +1036,7 @@ bool WinProgramUpdater::UpdateDatabase(UpdateStats& stats) {
     std::string completionMsg = "\n=== Update Complete ===\n";
     completionMsg += "Time elapsed: " + durationStr.str() + "\n";
     completionMsg += "Packages added: " + std::to_string(stats.packagesAdded) + "\n";
+    completionMsg += "Packages updated: " + std::to_string(stats.packagesUpdated) + "\n";
     completionMsg += "Total tags added: " + std::to_string(stats.tagsAdded) + "\n";
     completionMsg += "  - From winget: " + std::to_string(stats.tagsFromWinget) + "\n";
     completionMsg += "  - From inference: " + std::to_string(stats.tagsFromInference) + "\n";
@@ -1603,28 +1223,7 @@ bool WinProgramUpdater::SyncInstalledApps() {
         return false;
     }
     
-    // Create installed_apps table if it doesn't exist
-    const char* createTableSql = 
-        "CREATE TABLE IF NOT EXISTS installed_apps ("
-        "    package_id TEXT PRIMARY KEY,"
-        "    installed_date TEXT,"
-        "    last_seen TEXT,"
-        "    installed_version TEXT,"
-        "    source TEXT,"
-        "    FOREIGN KEY (package_id) REFERENCES apps(package_id)"
-        ");"
-        "CREATE INDEX IF NOT EXISTS idx_installed_last_seen ON installed_apps(last_seen);";
-    
-    if (!ExecuteSQL(createTableSql)) {
-        std::ofstream debugLog3(debugPath, std::ios::app);
-        debugLog3 << "ERROR: Failed to create table!\n";
-        debugLog3.close();
-        return false;
-    }
-    
-    std::ofstream debugLog3b(debugPath, std::ios::app);
-    debugLog3b << "Table created successfully\n";
-    debugLog3b.close();
+    // installed_apps is created by MigrateSchema when the database is opened
     
     // Get current timestamp
     auto now = std::chrono::system_clock::now();
@@ -1780,17 +1379,16 @@ bool WinProgramUpdater::SyncInstalledApps() {
     std::wcout << L"   Found " << installedPackages.size() << L" installed packages" << std::endl;
 #endif
     
+    store_.BeginBatch();
     for (const auto& pkg : installedPackages) {
         std::string id = std::get<0>(pkg);
         std::string version = std::get<1>(pkg);
         std::string source = std::get<2>(pkg);
         
         // Check if already exists
-        std::string checkSql = "SELECT installed_date FROM installed_apps WHERE package_id = ?;";
-        sqlite3_stmt* stmt;
         std::string installedDate = timestamp;
         
-        if (sqlite3_prepare_v2(db_, checkSql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_stmt* stmt = store_.Statement("SELECT installed_date FROM installed_apps WHERE package_id = ?;")) {
             sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_STATIC);
             if (sqlite3_step(stmt) == SQLITE_ROW) {
                 // Package exists, keep original install date
@@ -1799,24 +1397,26 @@ bool WinProgramUpdater::SyncInstalledApps() {
                     installedDate = reinterpret_cast<const char*>(date);
                 }
             }
-            sqlite3_finalize(stmt);
+            sqlite3_reset(stmt);
         }
         
         // Insert or update
-        std::string upsertSql = 
+        const char* upsertSql = 
             "INSERT OR REPLACE INTO installed_apps (package_id, installed_date, last_seen, installed_version, source) "
             "VALUES (?, ?, ?, ?, ?);";
         
-        if (sqlite3_prepare_v2(db_, upsertSql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_stmt* stmt = store_.Statement(upsertSql)) {
             sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_STATIC);
             sqlite3_bind_text(stmt, 2, installedDate.c_str(), -1, SQLITE_STATIC);
             sqlite3_bind_text(stmt, 3, timestamp, -1, SQLITE_STATIC);
             sqlite3_bind_text(stmt, 4, version.c_str(), -1, SQLITE_STATIC);
             sqlite3_bind_text(stmt, 5, source.c_str(), -1, SQLITE_STATIC);
             sqlite3_step(stmt);
-            sqlite3_finalize(stmt);
+            sqlite3_reset(stmt);
         }
+        store_.Wrote();
     }
+    store_.EndBatch();
     
     // Remove packages that are no longer installed (not seen in this sync)
     std::string deleteSql = "DELETE FROM installed_apps WHERE last_seen != ?;";
@@ -3,44 +3,17 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <atomic>
+#include <functional>
+#include "updater_store.h"
+#include "tag_matcher.h"
+#include "icon_fetcher.h"
+#include "winget_index.h"
+#include "package_refresh.h"
 
 // Forward declaration for SQLite
 typedef struct sqlite3 sqlite3;
 
-struct PackageInfo {
-    std::string packageId;
-    std::string name;
-    std::string version;
-    std::string publisher;
-    std::string moniker;
-    std::string description;
-    std::string shortDescription;
-    std::string homepage;
-    std::string license;
-    std::string author;
-    std::string copyright;
-    std::string licenseUrl;
-    std::string privacyUrl;
-    std::string packageUrl;
-    std::vector<unsigned char> iconData;
-    std::string iconType;
-    std::vector<std::string> tags;
-    // Additional metadata fields
-    std::string publisherUrl;
-    std::string publisherSupportUrl;
-    std::string copyrightUrl;
-    std::string releaseNotesUrl;
-    std::string releaseDate;
-    std::string source;
-    std::string installerType;
-    std::string architecture;
-    std::string documentationUrl;
-    std::string installerUrl;
-    std::string installerSha256;
-    std::string offlineDistributionSupported;
-    std::string commands;
-};
-
 struct UpdateStats {
     int packagesAdded = 0;
     int packagesRemoved = 0;
@@ -69,6 +42,8 @@ public:
     void SetLogCallback(LogCallbackFunc callback, void* userData);
     void SetStatsCallback(StatsCallbackFunc callback, void* userData);
     void SetCancelFlag(std::atomic<bool>* flag);
+    // Number of concurrent `winget show` fetches (default 4)
+    void SetFetchConcurrency(int workers);
 
     // Logging
     void WriteAppDataLog(const UpdateStats& stats, const std::string& duration);
@@ -86,7 +61,8 @@ private:
     bool ExecuteSQLSearch(const std::string& sql);
     std::vector<std::string> QueryPackageIds();
     bool HasTags(const std::string& packageId);
-    void AddPackage(const PackageInfo& pkg);
+    // WritePackage, or RefreshPackage for Step 2's re-fetch of a stored package
+    void AddPackage(const PackageInfo& pkg, bool refresh = false);
     void RemovePackage(const std::string& packageId);
     void AddTag(const std::string& packageId, const std::string& tag);
     int GetCategoryId(const std::string& category);
@@ -95,11 +71,19 @@ private:
     // Winget operations
     void PopulateSearchDatabase();
     std::vector<std::string> GetNewPackages();
-    std::vector<std::string> GetDeletedPackages();
-    std::vector<std::string> GetWingetPackages();
+    // Step 2: re-fetch the packages Step 1 lists at another version than the
+    // stored one and update their rows in place
+    void RefreshChangedPackages(UpdateStats& stats);
+    // Step 3: delete the apps neither in Step 1's list nor installed, in one
+    // transaction; false if skipped (no list, implausibly many) or failed
+    bool RemoveDeletedPackages(UpdateStats& stats);
+    // id and latest version of every package winget lists
+    std::vector<WingetIndexRecord> GetWingetPackages();
     PackageInfo GetPackageInfo(const std::string& packageId, int attempt = 1);
+    // Fetch packages concurrently; store() runs on this thread, one transaction per batch
+    void FetchPackageInfos(const std::vector<std::string>& packageIds,
+                           const std::function<void(const PackageInfo&)>& store);
     std::string ExecuteWingetCommand(const std::string& command);
-    void FetchIconFromHomepage(const std::string& homepage, std::vector<unsigned char>& iconData, std::string& iconType);
 
     // Tag inference
     void ApplyNameBasedInference(UpdateStats& stats);
@@ -121,12 +105,13 @@ private:
     bool IsCancelled() const;
     void NotifyStats(int found, int added, int deleted);
 
-    // Tag pattern mappings
+    // Tag pattern mappings, compiled once
     void InitializeTagPatterns();
-    std::map<std::string, std::string> tagPatterns_;
+    TagMatcher tagMatcher_;
 
     // Database
     sqlite3* db_;
+    UpdaterStore store_;   // cached statements, id maps and write batches for db_
     sqlite3* searchDb_;
     std::wstring dbPath_;
     std::wstring searchDbPath_;
@@ -137,6 +122,8 @@ private:
     StatsCallbackFunc statsCallback_;
     void* statsUserData_;
     std::atomic<bool>* cancelFlag_;
+    int fetchWorkers_;
+    IconFetcher iconFetcher_;   // homepage favicons, shared by the fetch threads
 
     // Constants
     static constexpr int MAX_RETRIES = 3;
@@ -0,0 +1,26 @@
+#include "app_bitset.h"
+
+AppBitset::AppBitset(size_t size, bool value)
+    : size_(size), words_((size + 63) / 64, value ? ~uint64_t(0) : 0) {
+    if (value && (size & 63)) words_.back() = (uint64_t(1) << (size & 63)) - 1;
+}
+
+size_t AppBitset::Count() const {
+    size_t count = 0;
+    for (uint64_t word : words_) count += PopCount64(word);
+    return count;
+}
+
+size_t AppBitset::CountAnd(const AppBitset& other) const {
+    size_t count = 0;
+    const size_t words = words_.size() < other.words_.size() ? words_.size() : other.words_.size();
+    for (size_t w = 0; w < words; ++w) count += PopCount64(words_[w] & other.words_[w]);
+    return count;
+}
+
+AppBitset& AppBitset::operator&=(const AppBitset& other) {
+    const size_t words = words_.size() < other.words_.size() ? words_.size() : other.words_.size();
+    for (size_t w = 0; w < words; ++w) words_[w] &= other.words_[w];
+    for (size_t w = words; w < words_.size(); ++w) words_[w] = 0;
+    return *this;
+}
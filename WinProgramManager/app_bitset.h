@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Bits set in `word`.
+inline int PopCount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// Index of the lowest set bit of `word`, which must not be 0.
+inline int LowestBit64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    int index = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// Set of app indexes of an AppCatalog (0..Size()-1), one bit per app.
+//
+// Filters of the main window (a category, the installed apps, the matches of a
+// search) are combined by AND-ing them 64 apps at a time and counted with one
+// popcount per word, so no combination walks app by app.
+class AppBitset {
+public:
+    AppBitset() = default;
+    explicit AppBitset(size_t size, bool value = false);
+
+    size_t Size() const { return size_; }
+    bool Test(size_t app) const { return (words_[app >> 6] >> (app & 63)) & 1; }
+    void Set(size_t app) { words_[app >> 6] |= uint64_t(1) << (app & 63); }
+    void Reset(size_t app) { words_[app >> 6] &= ~(uint64_t(1) << (app & 63)); }
+
+    // Number of apps in the set.
+    size_t Count() const;
+    // Number of apps in both this set and `other` (same Size()).
+    size_t CountAnd(const AppBitset& other) const;
+    AppBitset& operator&=(const AppBitset& other);
+
+    // Call f(app) for every app in the set, ascending.
+    template <typename F>
+    void ForEach(F f) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            for (uint64_t word = words_[w]; word; word &= word - 1) f((w << 6) + (size_t)LowestBit64(word));
+        }
+    }
+
+    size_t MemoryBytes() const { return words_.capacity() * sizeof(uint64_t); }
+
+private:
+    size_t size_ = 0;
+    std::vector<uint64_t> words_;  // bits past size_ are always 0
+};
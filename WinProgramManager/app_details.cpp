@@ -3,6 +3,7 @@
 #include "spinner_dialog.h"
 #include "install_dialog.h"
 #include "installed_apps.h"
+#include "schema.h"
 #include <sqlite3.h>
 #include <commctrl.h>
 #include <sstream>
@@ -76,10 +77,11 @@ bool LoadAppDetails(sqlite3* db, const std::wstring& packageId, AppDetailsData&
         SELECT 
             a.package_id, a.name, a.version, a.publisher,
             a.description, a.homepage, a.license,
-            a.icon_data, a.icon_type,
+            ic.data, ic.type,
             a.source, a.installer_type, a.architecture,
             i.installed_version, i.package_id
         FROM apps a
+        LEFT JOIN icons ic ON ic.hash = a.icon_hash
         LEFT JOIN installed_apps i ON a.package_id = i.package_id
         WHERE a.package_id = ?
     )";
@@ -147,15 +149,7 @@ bool LoadAppDetails(sqlite3* db, const std::wstring& packageId, AppDetailsData&
     
     // Load tags
     // Load tags/categories via proper join
-    const char* tagSql = R"(
-        SELECT c.category_name 
-        FROM categories c
-        JOIN app_categories ac ON c.id = ac.category_id
-        JOIN apps a ON a.id = ac.app_id
-        WHERE a.package_id = ?
-        ORDER BY c.category_name
-    )";
-    rc = sqlite3_prepare_v2(db, tagSql, -1, &stmt, nullptr);
+    rc = sqlite3_prepare_v2(db, kAppCategoriesSql, -1, &stmt, nullptr);
     if (rc == SQLITE_OK) {
         sqlite3_bind_text(stmt, 1, packageIdUtf8.c_str(), -1, SQLITE_TRANSIENT);
         
@@ -695,17 +689,6 @@ INT_PTR CALLBACK AppDetailsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LP
                                          // Sync installed apps after installation completes
                                          AppDetailsData* pData = pDataPtr;
                                          if (db) {
-                                             // Ensure table exists
-                                             const char* createTableSql = 
-                                                 "CREATE TABLE IF NOT EXISTS installed_apps ("
-                                                 "    package_id TEXT PRIMARY KEY,"
-                                                 "    installed_date TEXT,"
-                                                 "    last_seen TEXT,"
-                                                 "    installed_version TEXT,"
-                                                 "    source TEXT"
-                                                 ");";
-                                             sqlite3_exec(db, createTableSql, nullptr, nullptr, nullptr);
-                                             
                                              // Add this package to installed_apps
                                              int size = WideCharToMultiByte(CP_UTF8, 0, pkgId.c_str(), -1, NULL, 0, NULL, NULL);
                                              if (size > 0) {
@@ -793,17 +776,6 @@ INT_PTR CALLBACK AppDetailsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LP
                                          [db, pkgId, hDialog, pDataPtr = pData]() {
                                              // Callback after uninstall completes
                                              if (db) {
-                                                 // Ensure table exists
-                                                 const char* createTableSql = 
-                                                     "CREATE TABLE IF NOT EXISTS installed_apps ("
-                                                     "    package_id TEXT PRIMARY KEY,"
-                                                     "    installed_date TEXT,"
-                                                     "    last_seen TEXT,"
-                                                     "    installed_version TEXT,"
-                                                     "    source TEXT"
-                                                     ");";
-                                                 sqlite3_exec(db, createTableSql, nullptr, nullptr, nullptr);
-
                                                  // Remove this package from installed_apps
                                                  int sz = WideCharToMultiByte(CP_UTF8, 0, pkgId.c_str(), -1, NULL, 0, NULL, NULL);
                                                  if (sz > 0) {
@@ -910,17 +882,6 @@ INT_PTR CALLBACK AppDetailsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LP
                                              // Callback executed after reinstall completes
                                              // Sync installed apps after reinstallation completes
                                              if (db) {
-                                                 // Ensure table exists
-                                                 const char* createTableSql = 
-                                                     "CREATE TABLE IF NOT EXISTS installed_apps ("
-                                                     "    package_id TEXT PRIMARY KEY,"
-                                                     "    installed_date TEXT,"
-                                                     "    last_seen TEXT,"
-                                                     "    installed_version TEXT,"
-                                                     "    source TEXT"
-                                                     ");";
-                                                 sqlite3_exec(db, createTableSql, nullptr, nullptr, nullptr);
-                                                 
                                                  // Update this package in installed_apps
                                                  int size = WideCharToMultiByte(CP_UTF8, 0, pkgId.c_str(), -1, NULL, 0, NULL, NULL);
                                                  if (size > 0) {
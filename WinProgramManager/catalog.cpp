@@ -0,0 +1,310 @@
+#include "catalog.h"
+#include "schema.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cwctype>
+#include <unordered_map>
+#include <utility>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// UTF-8 column text to wide string; text that is not valid UTF-8 is read in
+// the ANSI code page, as the main window always did.
+static std::wstring Utf8ToWide(const char* utf8) {
+    if (!utf8 || !utf8[0]) return L"";
+#ifdef _WIN32
+    int wsize = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8, -1, nullptr, 0);
+    if (wsize == 0) {
+        wsize = MultiByteToWideChar(CP_ACP, 0, utf8, -1, nullptr, 0);
+        if (wsize == 0) return L"";
+        std::wstring result(wsize - 1, 0);
+        MultiByteToWideChar(CP_ACP, 0, utf8, -1, &result[0], wsize);
+        return result;
+    }
+    std::wstring result(wsize - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, utf8, -1, &result[0], wsize);
+    return result;
+#else
+    // Portable decoder for the tests; invalid bytes are taken as Latin-1
+    std::wstring result;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(utf8);
+    while (*p) {
+        unsigned c = *p;
+        int extra = c >= 0xF0 && c < 0xF8 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        if (c >= 0x80 && extra == 0) extra = -1;
+        bool valid = extra >= 0;
+        for (int i = 1; valid && i <= extra; ++i) valid = (p[i] & 0xC0) == 0x80;
+        if (!valid) {
+            result += static_cast<wchar_t>(c);
+            ++p;
+            continue;
+        }
+        unsigned cp = extra == 0 ? c : c & (0x3F >> extra);
+        for (int i = 1; i <= extra; ++i) cp = (cp << 6) | (p[i] & 0x3F);
+        result += static_cast<wchar_t>(cp);
+        p += extra + 1;
+    }
+    return result;
+#endif
+}
+
+std::wstring ColumnToWide(const char* utf8) {
+    return Utf8ToWide(utf8);
+}
+
+// Category names are shown trimmed and with a capital first letter; names that
+// only differ in that are one category.
+static std::wstring NormalizeCategory(const std::wstring& name) {
+    size_t first = name.find_first_not_of(L" \t\r\n");
+    if (first == std::wstring::npos) return L"";
+    size_t last = name.find_last_not_of(L" \t\r\n");
+    std::wstring result = name.substr(first, last - first + 1);
+    result[0] = static_cast<wchar_t>(std::towupper(result[0]));
+    return result;
+}
+
+void AppCatalog::Clear() {
+    *this = AppCatalog();
+}
+
+bool AppCatalog::Load(sqlite3* db) {
+    Clear();
+    if (!db) return false;
+
+    // Apps (icons are decoded separately, on demand)
+    sqlite3_stmt* stmt;
+    // A database the icon store has not been migrated into yet shows no icons
+    const char* sqlWithoutIcons = "SELECT id, package_id, name, version, publisher, homepage, 0 FROM apps "
+                                  "WHERE name IS NOT NULL AND TRIM(name) != '' ORDER BY name;";
+    if (sqlite3_prepare_v2(db, kCatalogAppsSql, -1, &stmt, nullptr) != SQLITE_OK &&
+        sqlite3_prepare_v2(db, sqlWithoutIcons, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+
+    std::unordered_map<std::wstring, uint32_t> publisherIndex;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ids_.push_back(sqlite3_column_int(stmt, 0));
+        packageIds_.push_back(Utf8ToWide((const char*)sqlite3_column_text(stmt, 1)));
+        names_.push_back(Utf8ToWide((const char*)sqlite3_column_text(stmt, 2)));
+        versions_.push_back(Utf8ToWide((const char*)sqlite3_column_text(stmt, 3)));
+        std::wstring publisher = Utf8ToWide((const char*)sqlite3_column_text(stmt, 4));
+        auto inserted = publisherIndex.emplace(std::move(publisher), (uint32_t)publishers_.size());
+        if (inserted.second) publishers_.push_back(inserted.first->first);
+        publisherOf_.push_back(inserted.first->second);
+        homepages_.push_back(Utf8ToWide((const char*)sqlite3_column_text(stmt, 5)));
+        iconIds_.push_back(sqlite3_column_int(stmt, 6));
+    }
+    sqlite3_finalize(stmt);
+
+    const size_t appCount = ids_.size();
+    installed_ = AppBitset(appCount);
+
+    if (appCount > 0) {
+        auto range = std::minmax_element(ids_.begin(), ids_.end());
+        minId_ = *range.first;
+        idToIndex_.assign((size_t)(*range.second - minId_) + 1, -1);
+        for (size_t i = 0; i < appCount; ++i) idToIndex_[ids_[i] - minId_] = (int32_t)i;
+    }
+
+    // Categories: convert each name once, then merge names that normalize alike
+    std::unordered_map<int, std::wstring> categoryById;
+    if (sqlite3_prepare_v2(db, "SELECT id, category_name FROM categories;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::wstring name = NormalizeCategory(Utf8ToWide((const char*)sqlite3_column_text(stmt, 1)));
+            if (!name.empty()) categoryById.emplace(sqlite3_column_int(stmt, 0), std::move(name));
+        }
+        sqlite3_finalize(stmt);
+    }
+    std::vector<std::wstring> names;
+    names.reserve(categoryById.size());
+    for (const auto& entry : categoryById) names.push_back(entry.second);
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    std::unordered_map<int, uint32_t> categoryIndexById;
+    for (const auto& entry : categoryById) {
+        categoryIndexById[entry.first] =
+            (uint32_t)(std::lower_bound(names.begin(), names.end(), entry.second) - names.begin());
+    }
+
+    // Links as (category, app) index pairs, sorted and without duplicates
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    if (sqlite3_prepare_v2(db, "SELECT category_id, app_id FROM app_categories;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            auto category = categoryIndexById.find(sqlite3_column_int(stmt, 0));
+            int app = IndexOfId(sqlite3_column_int(stmt, 1));
+            if (category == categoryIndexById.end() || app < 0) continue;
+            links.emplace_back(category->second, (uint32_t)app);
+        }
+        sqlite3_finalize(stmt);
+    }
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+
+    // Keep only categories that have loaded apps
+    std::vector<uint32_t> remap(names.size(), UINT32_MAX);
+    for (const auto& link : links) {
+        if (remap[link.first] == UINT32_MAX) {
+            remap[link.first] = (uint32_t)categoryNames_.size();
+            categoryNames_.push_back(std::move(names[link.first]));
+        }
+    }
+    const size_t categoryCount = categoryNames_.size();
+
+    // category -> apps (links are already in that order)
+    categoryAppStart_.assign(categoryCount + 1, 0);
+    categoryApps_.reserve(links.size());
+    for (const auto& link : links) {
+        categoryAppStart_[remap[link.first] + 1]++;
+        categoryApps_.push_back(link.second);
+    }
+    for (size_t c = 0; c < categoryCount; ++c) categoryAppStart_[c + 1] += categoryAppStart_[c];
+
+    // app -> categories by counting sort; categories come out ascending per app
+    appCategoryStart_.assign(appCount + 1, 0);
+    for (const auto& link : links) appCategoryStart_[link.second + 1]++;
+    for (size_t i = 0; i < appCount; ++i) appCategoryStart_[i + 1] += appCategoryStart_[i];
+    appCategories_.resize(links.size());
+    std::vector<uint32_t> fill(appCategoryStart_.begin(), appCategoryStart_.end() - 1);
+    for (const auto& link : links) appCategories_[fill[link.second]++] = remap[link.first];
+
+    stats_.assign(categoryCount, CategoryStats());
+    for (size_t c = 0; c < categoryCount; ++c) {
+        IndexRange apps = CategoryApps(c);
+        stats_[c].apps = (int)apps.size();
+        for (uint32_t app : apps) {
+            if (appCategoryStart_[app + 1] - appCategoryStart_[app] == 1) stats_[c].orphanedApps++;
+        }
+    }
+
+    categoryBitsOf_.assign(categoryCount, -1);
+    for (size_t c = 0; c < categoryCount; ++c) {
+        IndexRange apps = CategoryApps(c);
+        if (apps.size() * 32 < appCount) continue;
+        categoryBitsOf_[c] = (int32_t)categoryBits_.size();
+        categoryBits_.emplace_back(appCount);
+        for (uint32_t app : apps) categoryBits_.back().Set(app);
+    }
+    return true;
+}
+
+int AppCatalog::IndexOfId(int id) const {
+    if (id < minId_) return -1;
+    size_t slot = (size_t)(id - minId_);
+    return slot < idToIndex_.size() ? idToIndex_[slot] : -1;
+}
+
+int AppCatalog::FindCategory(const std::wstring& name) const {
+    auto it = std::lower_bound(categoryNames_.begin(), categoryNames_.end(), name);
+    if (it == categoryNames_.end() || *it != name) return -1;
+    return (int)(it - categoryNames_.begin());
+}
+
+IndexRange AppCatalog::CategoryApps(size_t category) const {
+    IndexRange range;
+    if (category + 1 >= categoryAppStart_.size()) return range;
+    range.first = categoryApps_.data() + categoryAppStart_[category];
+    range.last = categoryApps_.data() + categoryAppStart_[category + 1];
+    return range;
+}
+
+IndexRange AppCatalog::AppCategories(size_t app) const {
+    IndexRange range;
+    if (app + 1 >= appCategoryStart_.size()) return range;
+    range.first = appCategories_.data() + appCategoryStart_[app];
+    range.last = appCategories_.data() + appCategoryStart_[app + 1];
+    return range;
+}
+
+bool AppCatalog::InCategory(size_t category, size_t app) const {
+    if (categoryBitsOf_[category] >= 0) return categoryBits_[categoryBitsOf_[category]].Test(app);
+    IndexRange apps = CategoryApps(category);
+    return std::binary_search(apps.begin(), apps.end(), (uint32_t)app);
+}
+
+size_t AppCatalog::CountInCategory(size_t category, const AppBitset& apps) const {
+    if (categoryBitsOf_[category] >= 0) return categoryBits_[categoryBitsOf_[category]].CountAnd(apps);
+    size_t count = 0;
+    for (uint32_t app : CategoryApps(category)) count += apps.Test(app);
+    return count;
+}
+
+std::vector<int> AppCatalog::CategoryCounts(const AppBitset& apps) const {
+    std::vector<int> counts(categoryNames_.size());
+    for (size_t c = 0; c < counts.size(); ++c) counts[c] = (int)CountInCategory(c, apps);
+    return counts;
+}
+
+void AppCatalog::RefreshInstalled(const std::function<bool(const std::wstring& packageId)>& isInstalled) {
+    installed_ = AppBitset(ids_.size());
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        if (isInstalled(packageIds_[i])) installed_.Set(i);
+    }
+    std::vector<int> counts = CategoryCounts(installed_);
+    for (size_t c = 0; c < counts.size(); ++c) stats_[c].installedApps = counts[c];
+}
+
+template <typename T>
+static size_t VectorBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+static size_t StringsBytes(const std::vector<std::wstring>& v) {
+    size_t bytes = VectorBytes(v);
+    for (const auto& s : v) {
+        // Short strings live inside the object
+        if (s.capacity() * sizeof(wchar_t) >= sizeof(std::wstring)) bytes += (s.capacity() + 1) * sizeof(wchar_t);
+    }
+    return bytes;
+}
+
+static size_t BitsetsBytes(const std::vector<AppBitset>& v) {
+    size_t bytes = VectorBytes(v);
+    for (const auto& bits : v) bytes += bits.MemoryBytes();
+    return bytes;
+}
+
+size_t AppCatalog::MemoryBytes() const {
+    return VectorBytes(ids_) + StringsBytes(packageIds_) + StringsBytes(names_) + StringsBytes(versions_) +
+           StringsBytes(homepages_) + VectorBytes(publisherOf_) + StringsBytes(publishers_) +
+           VectorBytes(iconIds_) + installed_.MemoryBytes() + VectorBytes(idToIndex_) +
+           StringsBytes(categoryNames_) + VectorBytes(categoryAppStart_) + VectorBytes(categoryApps_) +
+           VectorBytes(appCategoryStart_) + VectorBytes(appCategories_) + VectorBytes(stats_) +
+           VectorBytes(categoryBitsOf_) + BitsetsBytes(categoryBits_);
+}
+
+std::vector<uint32_t> AppListRows(const AppCatalog& catalog, const AppListFilter& filter) {
+    const bool allApps = filter.category < 0;
+    const AppBitset* search = filter.searchMatches;
+    if (search && search->Size() != catalog.AppCount()) search = nullptr;
+    auto keep = [&](size_t app) {
+        return (!search || search->Test(app)) && (!filter.installedOnly || catalog.Installed(app));
+    };
+
+    std::vector<uint32_t> rows;
+    if (filter.textMatches) {
+        for (uint32_t app : *filter.textMatches) {
+            if (app >= catalog.AppCount()) continue;
+            if (!allApps && !catalog.InCategory(filter.category, app)) continue;
+            if (keep(app)) rows.push_back(app);
+        }
+    } else if (allApps) {
+        rows.reserve(search ? search->Count() : catalog.AppCount());
+        if (search) {
+            search->ForEach([&](size_t app) {
+                if (keep(app)) rows.push_back((uint32_t)app);
+            });
+        } else {
+            for (size_t app = 0; app < catalog.AppCount(); ++app) {
+                if (keep(app)) rows.push_back((uint32_t)app);
+            }
+        }
+    } else {
+        IndexRange apps = catalog.CategoryApps(filter.category);
+        rows.reserve(apps.size());
+        for (uint32_t app : apps) {
+            if (keep(app)) rows.push_back(app);
+        }
+    }
+    return rows;
+}
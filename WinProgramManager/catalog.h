@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "app_bitset.h"
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+// Sorted run of app (or category) indexes inside an AppCatalog.
+struct IndexRange {
+    const uint32_t* first = nullptr;
+    const uint32_t* last = nullptr;
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// Per-category numbers the category list filters on, computed at load time
+// (installed counts by RefreshInstalled).
+struct CategoryStats {
+    int apps = 0;           // apps in the category
+    int orphanedApps = 0;   // apps whose only category this is
+    int installedApps = 0;  // apps reported installed by the last RefreshInstalled
+};
+
+// In-memory copy of the apps/categories tables for the main window.
+//
+// Apps are addressed by index (0..AppCount()-1, in name order as loaded) and
+// stored column by column; publishers and category names are interned. apps.id
+// is mapped to an index through a dense table, and category membership is kept
+// both ways as sorted index arrays (compressed rows), so "apps in category" and
+// "categories of app" are slices instead of scans over every app. Categories
+// holding at least 1/32 of the apps also get an AppBitset (no bigger than their
+// index array then), so filters are counted against them a word at a time.
+class AppCatalog {
+public:
+    // Replace the contents with the apps and categories in `db`.
+    bool Load(sqlite3* db);
+    void Clear();
+
+    size_t AppCount() const { return ids_.size(); }
+    bool Empty() const { return ids_.empty(); }
+    // Index of the app with apps.id `id`, -1 if it is not loaded.
+    int IndexOfId(int id) const;
+
+    int Id(size_t app) const { return ids_[app]; }
+    const std::wstring& PackageId(size_t app) const { return packageIds_[app]; }
+    const std::wstring& Name(size_t app) const { return names_[app]; }
+    const std::wstring& Version(size_t app) const { return versions_[app]; }
+    const std::wstring& Publisher(size_t app) const { return publishers_[publisherOf_[app]]; }
+    const std::wstring& Homepage(size_t app) const { return homepages_[app]; }
+    // Row id in icons of the app's icon, 0 if it has none. Apps sharing an
+    // icon share the id (the icon itself is decoded on demand by IconCache).
+    int IconId(size_t app) const { return iconIds_[app]; }
+    bool Installed(size_t app) const { return installed_.Test(app); }
+    const AppBitset& InstalledApps() const { return installed_; }
+
+    // Categories, sorted by (trimmed, capitalized) name.
+    size_t CategoryCount() const { return categoryNames_.size(); }
+    const std::vector<std::wstring>& CategoryNames() const { return categoryNames_; }
+    const std::wstring& CategoryName(size_t category) const { return categoryNames_[category]; }
+    // Index of category `name`, -1 if unknown.
+    int FindCategory(const std::wstring& name) const;
+    IndexRange CategoryApps(size_t category) const;
+    IndexRange AppCategories(size_t app) const;
+    const CategoryStats& Stats(size_t category) const { return stats_[category]; }
+    bool InCategory(size_t category, size_t app) const;
+    // Number of apps of `category` that are in `apps`.
+    size_t CountInCategory(size_t category, const AppBitset& apps) const;
+    // CountInCategory for every category.
+    std::vector<int> CategoryCounts(const AppBitset& apps) const;
+
+    // Re-evaluate the installed flag of every app and the installed count of
+    // every category.
+    void RefreshInstalled(const std::function<bool(const std::wstring& packageId)>& isInstalled);
+
+    // Heap bytes held by the catalog (string and vector capacities).
+    size_t MemoryBytes() const;
+
+private:
+    std::vector<int> ids_;
+    std::vector<std::wstring> packageIds_;
+    std::vector<std::wstring> names_;
+    std::vector<std::wstring> versions_;
+    std::vector<std::wstring> homepages_;
+    std::vector<uint32_t> publisherOf_;
+    std::vector<std::wstring> publishers_;
+    std::vector<int32_t> iconIds_;
+    AppBitset installed_;
+
+    int minId_ = 0;
+    std::vector<int32_t> idToIndex_;   // apps.id - minId_ -> index, -1 for gaps
+
+    std::vector<std::wstring> categoryNames_;
+    std::vector<uint32_t> categoryAppStart_;  // CategoryCount() + 1 offsets into categoryApps_
+    std::vector<uint32_t> categoryApps_;
+    std::vector<uint32_t> appCategoryStart_;  // AppCount() + 1 offsets into appCategories_
+    std::vector<uint32_t> appCategories_;
+    std::vector<CategoryStats> stats_;
+    std::vector<int32_t> categoryBitsOf_;  // category -> index into categoryBits_, -1 for small ones
+    std::vector<AppBitset> categoryBits_;
+};
+
+// What the app list shows: the apps of a category, narrowed by the active
+// search and the filter text, and to installed apps.
+struct AppListFilter {
+    int category = -1;                                    // -1: all apps
+    const AppBitset* searchMatches = nullptr;             // null: no active search
+    const std::vector<uint32_t>* textMatches = nullptr;   // null: no filter text
+    bool installedOnly = false;
+};
+
+// Rows of the app list (catalog indexes) for `filter`: in name order, or in
+// the order of textMatches (best match first) when there is filter text.
+std::vector<uint32_t> AppListRows(const AppCatalog& catalog, const AppListFilter& filter);
+
+// UTF-8 column text as the catalog converts it (ANSI code page fallback).
+std::wstring ColumnToWide(const char* utf8);
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <utility>
+
+// Bounded worker pool for slow per-package lookups (one `winget show` each).
+//
+// Up to `workers` threads call fetch(key) concurrently and queue the results;
+// the calling thread drains the queue and hands every batch of finished
+// results to consume(batch). The caller therefore stays the only thread that
+// touches the database, and can wrap each batch in one transaction. Results
+// arrive in completion order, not key order.
+//
+// Workers stop picking up new keys once *cancel is set; results already
+// fetched are still consumed. At most 4 * workers results wait in the queue,
+// so a slow consumer throttles the fetchers instead of buffering everything.
+template <typename Key, typename Fetch, typename Consume>
+void RunFetchPool(const std::vector<Key>& keys, int workers, const std::atomic<bool>* cancel,
+                  Fetch fetch, Consume consume) {
+    using Result = decltype(fetch(keys[0]));
+    if (keys.empty()) return;
+    if (workers < 1) workers = 1;
+    if ((size_t)workers > keys.size()) workers = (int)keys.size();
+    const size_t maxQueued = (size_t)workers * 4;
+
+    std::mutex mtx;
+    std::condition_variable resultReady, spaceFree;
+    std::deque<Result> queue;
+    std::atomic<size_t> next{0};
+    int running = workers;
+
+    auto worker = [&]() {
+        for (;;) {
+            if (cancel && cancel->load()) break;
+            size_t i = next.fetch_add(1);
+            if (i >= keys.size()) break;
+            Result r = fetch(keys[i]);
+            std::unique_lock<std::mutex> lk(mtx);
+            spaceFree.wait(lk, [&] { return queue.size() < maxQueued; });
+            queue.push_back(std::move(r));
+            resultReady.notify_one();
+        }
+        std::lock_guard<std::mutex> lk(mtx);
+        --running;
+        resultReady.notify_one();
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (int t = 0; t < workers; ++t) threads.emplace_back(worker);
+
+    std::vector<Result> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            resultReady.wait(lk, [&] { return !queue.empty() || running == 0; });
+            if (queue.empty()) break;
+            batch.clear();
+            while (!queue.empty()) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            spaceFree.notify_all();
+        }
+        consume(batch);
+    }
+    for (auto& t : threads) t.join();
+}
@@ -0,0 +1,188 @@
+#include "icon_cache.h"
+#include <sqlite3.h>
+
+IconCache::IconCache(int iconSize, size_t capacity, int workers, LoadBlob load, std::function<void()> notify)
+    : iconSize_(iconSize),
+      capacity_(capacity < 1 ? 1 : capacity),
+      maxQueued_((capacity < 1 ? 1 : capacity) * 2),
+      load_(std::move(load)),
+      notify_(std::move(notify)) {
+    if (workers < 1) workers = 1;
+    for (int i = 0; i < workers; ++i) threads_.emplace_back(&IconCache::Worker, this);
+}
+
+IconCache::~IconCache() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+int IconCache::Slot(int key) {
+    auto it = slots_.find(key);
+    if (it != slots_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.position);
+        return it->second.slot;
+    }
+    if (failed_.count(key)) return kPlaceholder;
+
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (queued_.insert(key).second) {
+            queue_.push_back(key);
+            // Rows scrolled past long ago are not worth decoding any more
+            if (queue_.size() > maxQueued_) {
+                queued_.erase(queue_.front());
+                queue_.pop_front();
+            }
+            queued = true;
+        }
+    }
+    if (queued) wake_.notify_one();
+    return kPlaceholder;
+}
+
+bool IconCache::Collect(const Install& install) {
+    std::vector<Result> results;
+    unsigned generation;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        results.swap(done_);
+        generation = generation_;
+        for (const auto& r : results) queued_.erase(r.key);
+    }
+
+    bool changed = false;
+    for (auto& r : results) {
+        if (r.generation != generation || slots_.count(r.key)) continue;
+        if (r.loaded == kBusy) {
+            // No longer queued: the repaint asks for it again if still shown
+            changed = true;
+            continue;
+        }
+        if (!r.ok) {
+            failed_.insert(r.key);
+            continue;
+        }
+        int slot;
+        if (!freeSlots_.empty()) {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+        } else if ((size_t)nextSlot_ <= capacity_) {
+            slot = nextSlot_++;
+        } else {
+            // Take the slot of the icon painted least recently
+            int victim = lru_.back();
+            lru_.pop_back();
+            slot = slots_[victim].slot;
+            slots_.erase(victim);
+        }
+        install(slot, r.pixels);
+        lru_.push_front(r.key);
+        slots_[r.key] = Entry{slot, lru_.begin()};
+        decoded_++;
+        changed = true;
+    }
+    return changed;
+}
+
+size_t IconCache::Pending() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return queued_.size();
+}
+
+void IconCache::Reset() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        queue_.clear();
+        queued_.clear();
+        done_.clear();
+        generation_++;
+    }
+    lru_.clear();
+    slots_.clear();
+    failed_.clear();
+    // The ImageList keeps its images; their slots are simply free again
+    freeSlots_.clear();
+    for (int slot = nextSlot_ - 1; slot >= 1; --slot) freeSlots_.push_back(slot);
+}
+
+void IconCache::Worker() {
+    std::vector<unsigned char> blob;
+    for (;;) {
+        int key;
+        unsigned generation;
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            wake_.wait(lk, [this] { return stop_ || !queue_.empty(); });
+            if (stop_) return;
+            // Newest request first: that row is most likely still on screen
+            key = queue_.back();
+            queue_.pop_back();
+            generation = generation_;
+        }
+
+        Result result{key, generation, kNoBlob, false, IconPixels()};
+        blob.clear();
+        result.loaded = load_(key, blob);
+        if (result.loaded == kLoaded && !blob.empty()) {
+            result.ok = DecodeIcon(blob.data(), blob.size(), iconSize_, result.pixels);
+        }
+
+        bool first;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (stop_) return;
+            if (generation != generation_) continue;
+            first = done_.empty();
+            done_.push_back(std::move(result));
+        }
+        if (first && notify_) notify_();
+    }
+}
+
+static bool Transient(int rc) {
+    return (rc & 0xFF) == SQLITE_BUSY || (rc & 0xFF) == SQLITE_LOCKED;
+}
+
+IconCache::LoadBlob SqliteIconLoader(const std::string& dbPath) {
+    return [dbPath](int key, std::vector<unsigned char>& blob) -> IconCache::LoadResult {
+        // One connection per worker thread, closed when the thread ends
+        struct Connection {
+            std::string path;
+            sqlite3* db = nullptr;
+            ~Connection() {
+                if (db) sqlite3_close(db);
+            }
+        };
+        thread_local Connection connection;
+        if (!connection.db || connection.path != dbPath) {
+            if (connection.db) sqlite3_close(connection.db);
+            connection.db = nullptr;
+            connection.path = dbPath;
+            if (sqlite3_open_v2(dbPath.c_str(), &connection.db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+                sqlite3_close(connection.db);
+                connection.db = nullptr;
+                return IconCache::kNoBlob;
+            }
+            sqlite3_busy_timeout(connection.db, 2000);
+        }
+
+        // Straight to the blob by rowid, without a statement
+        sqlite3_blob* handle = nullptr;
+        int rc = sqlite3_blob_open(connection.db, "main", "icons", "data", key, 0, &handle);
+        if (rc != SQLITE_OK) {
+            if (handle) sqlite3_blob_close(handle);
+            return Transient(rc) ? IconCache::kBusy : IconCache::kNoBlob;
+        }
+        int size = sqlite3_blob_bytes(handle);
+        blob.resize(size > 0 ? (size_t)size : 0);
+        rc = size > 0 ? sqlite3_blob_read(handle, blob.data(), size, 0) : SQLITE_OK;
+        sqlite3_blob_close(handle);
+        if (rc != SQLITE_OK) return Transient(rc) ? IconCache::kBusy : IconCache::kNoBlob;
+        return size > 0 ? IconCache::kLoaded : IconCache::kNoBlob;
+    };
+}
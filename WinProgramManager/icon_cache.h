@@ -0,0 +1,107 @@
+#pragma once
+#include "icon_decoder.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// App list icons, decoded on demand.
+//
+// The list asks Slot(key) for each row it paints. Decoded icons live in
+// numbered slots 1..Capacity() (0 is the placeholder) which the UI mirrors in
+// its ImageList; when all slots are taken, the icon painted least recently
+// gives up its slot. Memory therefore follows what has been on screen rather
+// than the size of the catalog. Keys without an icon yet are queued and
+// decoded by a few background threads, newest request first; Collect() hands
+// the finished ones to the UI thread, and `notify` (called from a worker)
+// tells it to do so. A key whose blob could not be read for now (the database
+// was busy) is not given up on: it is asked for again the next time its row
+// is painted.
+//
+// Slot, Collect and Reset must be called from one thread (the UI thread).
+class IconCache {
+public:
+    // What LoadBlob found: the blob, no blob (the key fails for good), or a
+    // read that may work later (the key is asked for again).
+    enum LoadResult { kLoaded, kNoBlob, kBusy };
+    // Fetch the icon blob of `key`; runs on a worker thread.
+    using LoadBlob = std::function<LoadResult(int key, std::vector<unsigned char>& blob)>;
+    // Show `pixels` in `slot`. Slots are first handed out in order 1, 2, 3...
+    // so a slot equal to the current image count means "append".
+    using Install = std::function<void(int slot, const IconPixels& pixels)>;
+
+    static const int kPlaceholder = 0;
+
+    IconCache(int iconSize, size_t capacity, int workers, LoadBlob load, std::function<void()> notify);
+    ~IconCache();
+    IconCache(const IconCache&) = delete;
+    IconCache& operator=(const IconCache&) = delete;
+
+    // Slot of the decoded icon of `key`, or kPlaceholder while it is being
+    // decoded or if it cannot be.
+    int Slot(int key);
+    // Install finished icons; true if any slot changed or a key is to be
+    // asked for again (repaint the list).
+    bool Collect(const Install& install);
+    // Forget all icons and queued work, e.g. after the database was reloaded.
+    void Reset();
+
+    size_t Capacity() const { return capacity_; }
+    size_t Resident() const { return lru_.size(); }
+    size_t Decoded() const { return decoded_; }
+    size_t Failed() const { return failed_.size(); }
+    // Keys queued or being decoded whose result Collect() has not taken yet.
+    // Requests dropped from a full queue are not pending.
+    size_t Pending();
+
+private:
+    struct Result {
+        int key;
+        unsigned generation;
+        LoadResult loaded;
+        bool ok;
+        IconPixels pixels;
+    };
+
+    void Worker();
+
+    const int iconSize_;
+    const size_t capacity_;
+    const size_t maxQueued_;
+    LoadBlob load_;
+    std::function<void()> notify_;
+
+    // Shared with the workers
+    std::mutex mtx_;
+    std::condition_variable wake_;
+    std::deque<int> queue_;
+    std::unordered_set<int> queued_;   // queued or being decoded
+    std::vector<Result> done_;
+    unsigned generation_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+
+    // UI thread only
+    std::list<int> lru_;   // keys, most recently painted first
+    struct Entry {
+        int slot;
+        std::list<int>::iterator position;
+    };
+    std::unordered_map<int, Entry> slots_;
+    std::unordered_set<int> failed_;
+    std::vector<int> freeSlots_;   // handed out before new slots after a Reset
+    int nextSlot_ = 1;
+    size_t decoded_ = 0;
+};
+
+// LoadBlob reading icons.data by icons rowid (AppCatalog::IconId) from the
+// database at `dbPath` (UTF-8), with one read-only connection per worker thread.
+// SQLITE_BUSY and SQLITE_LOCKED are kBusy.
+IconCache::LoadBlob SqliteIconLoader(const std::string& dbPath);
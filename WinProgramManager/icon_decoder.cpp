@@ -0,0 +1,720 @@
+#include "icon_decoder.h"
+#include <algorithm>
+#include <cstring>
+
+// Icons larger than this are not favicons; refuse them rather than inflate them
+static const int kMaxDimension = 1024;
+
+static uint32_t ReadBE32(const unsigned char* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint32_t ReadLE32(const unsigned char* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t ReadLE16(const unsigned char* p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t Pack(unsigned r, unsigned g, unsigned b, unsigned a) {
+    return (uint32_t)a << 24 | (uint32_t)r << 16 | (uint32_t)g << 8 | b;
+}
+
+// --- Inflate (RFC 1950/1951) -------------------------------------------------
+
+namespace {
+
+struct Huffman {
+    short count[16];
+    short symbol[320];
+};
+
+class Inflater {
+public:
+    Inflater(const unsigned char* in, size_t size, std::vector<unsigned char>& out, size_t limit)
+        : in_(in), size_(size), out_(out), limit_(limit) {}
+
+    bool Run() {
+        int last;
+        do {
+            last = Bits(1);
+            int type = Bits(2);
+            if (last < 0 || type < 0) return false;
+            bool ok = type == 0 ? Stored() : type == 1 ? Fixed() : type == 2 ? Dynamic() : false;
+            if (!ok) return false;
+        } while (!last);
+        return true;
+    }
+
+    size_t Consumed() const { return pos_; }
+
+private:
+    int Bits(int need) {
+        uint32_t value = bitBuf_;
+        while (bitCount_ < need) {
+            if (pos_ >= size_) return -1;
+            value |= (uint32_t)in_[pos_++] << bitCount_;
+            bitCount_ += 8;
+        }
+        bitBuf_ = value >> need;
+        bitCount_ -= need;
+        return (int)(value & ((1u << need) - 1));
+    }
+
+    bool Put(unsigned char byte) {
+        if (out_.size() >= limit_) return false;
+        out_.push_back(byte);
+        return true;
+    }
+
+    bool Stored() {
+        bitBuf_ = 0;
+        bitCount_ = 0;
+        if (pos_ + 4 > size_) return false;
+        unsigned len = in_[pos_] | in_[pos_ + 1] << 8;
+        unsigned nlen = in_[pos_ + 2] | in_[pos_ + 3] << 8;
+        pos_ += 4;
+        if (len != (~nlen & 0xFFFF) || pos_ + len > size_) return false;
+        for (unsigned i = 0; i < len; ++i) {
+            if (!Put(in_[pos_++])) return false;
+        }
+        return true;
+    }
+
+    // Returns 0 when complete or incomplete-but-usable, < 0 when over-subscribed.
+    static int Build(Huffman& h, const short* length, int n) {
+        for (int len = 0; len < 16; ++len) h.count[len] = 0;
+        for (int s = 0; s < n; ++s) h.count[length[s]]++;
+        if (h.count[0] == n) return 0;
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left <<= 1;
+            left -= h.count[len];
+            if (left < 0) return left;
+        }
+        short offs[16];
+        offs[1] = 0;
+        for (int len = 1; len < 15; ++len) offs[len + 1] = (short)(offs[len] + h.count[len]);
+        for (int s = 0; s < n; ++s) {
+            if (length[s] != 0) h.symbol[offs[length[s]]++] = (short)s;
+        }
+        return left;
+    }
+
+    int Decode(const Huffman& h) {
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            int bit = Bits(1);
+            if (bit < 0) return -1;
+            code |= bit;
+            int count = h.count[len];
+            if (code - count < first) return h.symbol[index + (code - first)];
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    bool Codes(const Huffman& lencode, const Huffman& distcode) {
+        static const short lbase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const short lext[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const short dbase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                        6145, 8193, 12289, 16385, 24577};
+        static const short dext[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                       6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        for (;;) {
+            int symbol = Decode(lencode);
+            if (symbol < 0) return false;
+            if (symbol < 256) {
+                if (!Put((unsigned char)symbol)) return false;
+            } else if (symbol == 256) {
+                return true;
+            } else {
+                symbol -= 257;
+                if (symbol >= 29) return false;
+                int extra = Bits(lext[symbol]);
+                if (extra < 0) return false;
+                int len = lbase[symbol] + extra;
+                symbol = Decode(distcode);
+                if (symbol < 0 || symbol >= 30) return false;
+                extra = Bits(dext[symbol]);
+                if (extra < 0) return false;
+                size_t dist = (size_t)(dbase[symbol] + extra);
+                if (dist > out_.size()) return false;
+                for (int i = 0; i < len; ++i) {
+                    if (!Put(out_[out_.size() - dist])) return false;
+                }
+            }
+        }
+    }
+
+    bool Fixed() {
+        Huffman lencode, distcode;
+        short lengths[288];
+        int s = 0;
+        for (; s < 144; ++s) lengths[s] = 8;
+        for (; s < 256; ++s) lengths[s] = 9;
+        for (; s < 280; ++s) lengths[s] = 7;
+        for (; s < 288; ++s) lengths[s] = 8;
+        Build(lencode, lengths, 288);
+        for (s = 0; s < 30; ++s) lengths[s] = 5;
+        Build(distcode, lengths, 30);
+        return Codes(lencode, distcode);
+    }
+
+    bool Dynamic() {
+        static const short order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        int nlen = Bits(5), ndist = Bits(5), ncode = Bits(4);
+        if (nlen < 0 || ndist < 0 || ncode < 0) return false;
+        nlen += 257;
+        ndist += 1;
+        ncode += 4;
+        if (nlen > 286 || ndist > 30) return false;
+
+        short lengths[320] = {};
+        for (int i = 0; i < ncode; ++i) {
+            int len = Bits(3);
+            if (len < 0) return false;
+            lengths[order[i]] = (short)len;
+        }
+        Huffman lencode, distcode;
+        if (Build(lencode, lengths, 19) != 0) return false;
+
+        int index = 0;
+        while (index < nlen + ndist) {
+            int symbol = Decode(lencode);
+            if (symbol < 0) return false;
+            if (symbol < 16) {
+                lengths[index++] = (short)symbol;
+                continue;
+            }
+            short len = 0;
+            int repeat;
+            if (symbol == 16) {
+                if (index == 0) return false;
+                len = lengths[index - 1];
+                repeat = Bits(2);
+                if (repeat < 0) return false;
+                repeat += 3;
+            } else if (symbol == 17) {
+                repeat = Bits(3);
+                if (repeat < 0) return false;
+                repeat += 3;
+            } else {
+                repeat = Bits(7);
+                if (repeat < 0) return false;
+                repeat += 11;
+            }
+            if (index + repeat > nlen + ndist) return false;
+            while (repeat--) lengths[index++] = len;
+        }
+        if (lengths[256] == 0) return false;
+
+        // Incomplete codes are only allowed for a single length/distance code
+        int err = Build(lencode, lengths, nlen);
+        if (err < 0 || (err > 0 && nlen - lencode.count[0] != 1)) return false;
+        err = Build(distcode, lengths + nlen, ndist);
+        if (err < 0 || (err > 0 && ndist - distcode.count[0] != 1)) return false;
+        return Codes(lencode, distcode);
+    }
+
+    const unsigned char* in_;
+    size_t size_;
+    size_t pos_ = 0;
+    uint32_t bitBuf_ = 0;
+    int bitCount_ = 0;
+    std::vector<unsigned char>& out_;
+    size_t limit_;
+};
+
+bool ZlibInflate(const unsigned char* in, size_t size, std::vector<unsigned char>& out, size_t limit) {
+    if (size < 6) return false;
+    if ((in[0] & 0x0F) != 8 || ((in[0] << 8) | in[1]) % 31 != 0 || (in[1] & 0x20)) return false;
+    out.clear();
+    out.reserve(limit);
+    Inflater inflater(in + 2, size - 2, out, limit);
+    if (!inflater.Run()) return false;
+
+    // Adler-32 of the output follows the deflate stream
+    size_t end = 2 + inflater.Consumed();
+    if (end + 4 > size) return false;
+    uint32_t a = 1, b = 0;
+    for (unsigned char c : out) {
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    return ReadBE32(in + end) == (b << 16 | a);
+}
+
+}  // namespace
+
+// --- PNG ----------------------------------------------------------------------
+
+static const unsigned char kPngSignature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+
+static bool IsPng(const unsigned char* data, size_t size) {
+    return size >= 8 && memcmp(data, kPngSignature, 8) == 0;
+}
+
+static unsigned PaethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = p > a ? p - a : a - p;
+    int pb = p > b ? p - b : b - p;
+    int pc = p > c ? p - c : c - p;
+    if (pa <= pb && pa <= pc) return (unsigned)a;
+    return (unsigned)(pb <= pc ? b : c);
+}
+
+// Undo the per-row filters of one (sub)image in place; rows are 1 + rowBytes long.
+static bool Unfilter(unsigned char* data, size_t rows, size_t rowBytes, size_t bpp) {
+    unsigned char* prev = nullptr;
+    for (size_t y = 0; y < rows; ++y) {
+        unsigned char* row = data + y * (rowBytes + 1);
+        unsigned filter = row[0];
+        unsigned char* cur = row + 1;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            unsigned a = i >= bpp ? cur[i - bpp] : 0;
+            unsigned b = prev ? prev[i] : 0;
+            unsigned c = prev && i >= bpp ? prev[i - bpp] : 0;
+            switch (filter) {
+                case 0: break;
+                case 1: cur[i] = (unsigned char)(cur[i] + a); break;
+                case 2: cur[i] = (unsigned char)(cur[i] + b); break;
+                case 3: cur[i] = (unsigned char)(cur[i] + ((a + b) >> 1)); break;
+                case 4: cur[i] = (unsigned char)(cur[i] + PaethPredictor((int)a, (int)b, (int)c)); break;
+                default: return false;
+            }
+        }
+        prev = cur;
+    }
+    return true;
+}
+
+bool DecodePng(const unsigned char* data, size_t size, IconPixels& out) {
+    if (!IsPng(data, size)) return false;
+
+    uint32_t width = 0, height = 0;
+    int depth = 0, colorType = -1, interlace = 0;
+    std::vector<unsigned char> idat;
+    unsigned char palette[256][4];
+    size_t paletteSize = 0;
+    bool hasKey = false;
+    unsigned keyR = 0, keyG = 0, keyB = 0;
+
+    size_t pos = 8;
+    bool seenEnd = false;
+    while (pos + 12 <= size && !seenEnd) {
+        uint32_t len = ReadBE32(data + pos);
+        const unsigned char* type = data + pos + 4;
+        const unsigned char* body = data + pos + 8;
+        if (len > size - pos - 12) return false;
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (len < 13) return false;
+            width = ReadBE32(body);
+            height = ReadBE32(body + 4);
+            depth = body[8];
+            colorType = body[9];
+            interlace = body[12];
+            if (body[10] != 0 || body[11] != 0 || interlace > 1) return false;
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            paletteSize = std::min<size_t>(len / 3, 256);
+            for (size_t i = 0; i < paletteSize; ++i) {
+                palette[i][0] = body[i * 3];
+                palette[i][1] = body[i * 3 + 1];
+                palette[i][2] = body[i * 3 + 2];
+                palette[i][3] = 255;
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (colorType == 3) {
+                for (size_t i = 0; i < len && i < paletteSize; ++i) palette[i][3] = body[i];
+            } else if (colorType == 0 && len >= 2) {
+                hasKey = true;
+                keyR = keyG = keyB = (unsigned)(body[0] << 8 | body[1]);
+            } else if (colorType == 2 && len >= 6) {
+                hasKey = true;
+                keyR = (unsigned)(body[0] << 8 | body[1]);
+                keyG = (unsigned)(body[2] << 8 | body[3]);
+                keyB = (unsigned)(body[4] << 8 | body[5]);
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            idat.insert(idat.end(), body, body + len);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            seenEnd = true;
+        }
+        pos += 12 + (size_t)len;
+    }
+
+    if (width == 0 || height == 0 || width > (uint32_t)kMaxDimension || height > (uint32_t)kMaxDimension) return false;
+    int channels;
+    switch (colorType) {
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default: return false;
+    }
+    bool depthOk = depth == 8 || depth == 16 ||
+                   ((colorType == 0 || colorType == 3) && (depth == 1 || depth == 2 || depth == 4));
+    if (!depthOk || (colorType == 3 && (depth == 16 || paletteSize == 0))) return false;
+
+    const size_t bitsPerPixel = (size_t)channels * depth;
+    const size_t bpp = std::max<size_t>(1, bitsPerPixel / 8);
+
+    // Adam7 passes: x start, y start, x step, y step (one full pass when not interlaced)
+    static const int passes[7][4] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4},
+                                     {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}};
+    static const int single[1][4] = {{0, 0, 1, 1}};
+    const int (*layout)[4] = interlace ? passes : single;
+    const int passCount = interlace ? 7 : 1;
+
+    size_t expected = 0;
+    for (int p = 0; p < passCount; ++p) {
+        size_t pw = (width - layout[p][0] + layout[p][2] - 1) / layout[p][2];
+        size_t ph = (height - layout[p][1] + layout[p][3] - 1) / layout[p][3];
+        if (layout[p][0] >= (int)width) pw = 0;
+        if (layout[p][1] >= (int)height) ph = 0;
+        if (pw && ph) expected += ph * (1 + (pw * bitsPerPixel + 7) / 8);
+    }
+    std::vector<unsigned char> raw;
+    if (!ZlibInflate(idat.data(), idat.size(), raw, expected) || raw.size() != expected) return false;
+
+    out.width = (int)width;
+    out.height = (int)height;
+    out.bgra.assign((size_t)width * height, 0);
+
+    size_t offset = 0;
+    for (int p = 0; p < passCount; ++p) {
+        if (layout[p][0] >= (int)width || layout[p][1] >= (int)height) continue;
+        size_t pw = (width - layout[p][0] + layout[p][2] - 1) / layout[p][2];
+        size_t ph = (height - layout[p][1] + layout[p][3] - 1) / layout[p][3];
+        size_t rowBytes = (pw * bitsPerPixel + 7) / 8;
+        if (!Unfilter(raw.data() + offset, ph, rowBytes, bpp)) return false;
+
+        for (size_t py = 0; py < ph; ++py) {
+            const unsigned char* row = raw.data() + offset + py * (rowBytes + 1) + 1;
+            size_t y = layout[p][1] + py * layout[p][3];
+            for (size_t px = 0; px < pw; ++px) {
+                size_t x = layout[p][0] + px * layout[p][2];
+                // Full-depth samples (for tRNS keys) and their 8-bit values
+                unsigned sample[4] = {};
+                unsigned value[4] = {};
+                for (int c = 0; c < channels; ++c) {
+                    if (depth == 16) {
+                        const unsigned char* s = row + (px * channels + c) * 2;
+                        sample[c] = (unsigned)(s[0] << 8 | s[1]);
+                        value[c] = s[0];
+                    } else if (depth == 8) {
+                        sample[c] = value[c] = row[px * channels + c];
+                    } else {
+                        size_t bit = px * depth;
+                        unsigned v = (row[bit / 8] >> (8 - depth - bit % 8)) & ((1u << depth) - 1);
+                        sample[c] = v;
+                        value[c] = colorType == 3 ? v : v * 255 / ((1u << depth) - 1);
+                    }
+                }
+                uint32_t pixel;
+                switch (colorType) {
+                    case 0: {
+                        unsigned a = hasKey && sample[0] == keyR ? 0 : 255;
+                        pixel = Pack(value[0], value[0], value[0], a);
+                        break;
+                    }
+                    case 2: {
+                        unsigned a = hasKey && sample[0] == keyR && sample[1] == keyG && sample[2] == keyB ? 0 : 255;
+                        pixel = Pack(value[0], value[1], value[2], a);
+                        break;
+                    }
+                    case 3: {
+                        if (value[0] >= paletteSize) return false;
+                        const unsigned char* e = palette[value[0]];
+                        pixel = Pack(e[0], e[1], e[2], e[3]);
+                        break;
+                    }
+                    case 4: pixel = Pack(value[0], value[0], value[0], value[1]); break;
+                    default: pixel = Pack(value[0], value[1], value[2], value[3]); break;
+                }
+                out.bgra[y * width + x] = pixel;
+            }
+        }
+        offset += ph * (rowBytes + 1);
+    }
+    return true;
+}
+
+// --- BMP / ICO ----------------------------------------------------------------
+
+// Decode a DIB (BITMAPINFOHEADER + palette + pixels). In icons the height is
+// doubled and an AND mask follows the colour pixels.
+static bool DecodeDib(const unsigned char* data, size_t size, bool iconFrame, IconPixels& out) {
+    if (size < 40) return false;
+    uint32_t headerSize = ReadLE32(data);
+    int32_t width = (int32_t)ReadLE32(data + 4);
+    int32_t rawHeight = (int32_t)ReadLE32(data + 8);
+    uint16_t bitCount = ReadLE16(data + 14);
+    uint32_t compression = ReadLE32(data + 16);
+    uint32_t colorsUsed = ReadLE32(data + 32);
+    if (headerSize < 40 || headerSize > size) return false;
+
+    bool topDown = rawHeight < 0;
+    int32_t height = topDown ? -rawHeight : rawHeight;
+    if (iconFrame) height /= 2;
+    if (width <= 0 || height <= 0 || width > kMaxDimension || height > kMaxDimension) return false;
+    if (bitCount != 1 && bitCount != 4 && bitCount != 8 && bitCount != 24 && bitCount != 32) return false;
+    // BI_RGB, or BI_BITFIELDS with the usual 32-bit BGRA layout
+    if (compression != 0 && !(compression == 3 && bitCount == 32)) return false;
+
+    size_t pos = headerSize;
+    if (compression == 3 && headerSize == 40) pos += 12;  // masks follow a v1 header
+    size_t paletteCount = 0;
+    if (bitCount <= 8) paletteCount = colorsUsed ? std::min<uint32_t>(colorsUsed, 256) : (1u << bitCount);
+    const unsigned char* palette = data + pos;
+    pos += paletteCount * 4;
+
+    size_t stride = (((size_t)width * bitCount + 31) / 32) * 4;
+    size_t maskStride = (((size_t)width + 31) / 32) * 4;
+    size_t needed = pos + stride * height + (iconFrame ? maskStride * height : 0);
+    // Some icons omit the mask of 32-bit frames
+    bool hasMask = iconFrame;
+    if (needed > size) {
+        if (!(iconFrame && bitCount == 32 && pos + stride * height <= size)) return false;
+        hasMask = false;
+    }
+    const unsigned char* pixels = data + pos;
+    const unsigned char* mask = pixels + stride * height;
+
+    out.width = width;
+    out.height = height;
+    out.bgra.assign((size_t)width * height, 0);
+    bool anyAlpha = false;
+    for (int32_t y = 0; y < height; ++y) {
+        int32_t srcRow = topDown ? y : height - 1 - y;
+        const unsigned char* row = pixels + srcRow * stride;
+        for (int32_t x = 0; x < width; ++x) {
+            unsigned r, g, b, a = 255;
+            if (bitCount == 32) {
+                b = row[x * 4];
+                g = row[x * 4 + 1];
+                r = row[x * 4 + 2];
+                a = row[x * 4 + 3];
+                if (a) anyAlpha = true;
+            } else if (bitCount == 24) {
+                b = row[x * 3];
+                g = row[x * 3 + 1];
+                r = row[x * 3 + 2];
+            } else {
+                size_t bit = (size_t)x * bitCount;
+                unsigned index = (row[bit / 8] >> (8 - bitCount - bit % 8)) & ((1u << bitCount) - 1);
+                if (index >= paletteCount) index = 0;
+                b = palette[index * 4];
+                g = palette[index * 4 + 1];
+                r = palette[index * 4 + 2];
+            }
+            out.bgra[(size_t)y * width + x] = Pack(r, g, b, a);
+        }
+    }
+
+    // 32-bit frames with an all-zero alpha channel and all other depths use the mask
+    bool useMask = hasMask && (bitCount != 32 || !anyAlpha);
+    if (bitCount == 32 && !anyAlpha && !hasMask) {
+        for (auto& pixel : out.bgra) pixel |= 0xFF000000u;
+    }
+    if (useMask) {
+        for (int32_t y = 0; y < height; ++y) {
+            int32_t srcRow = topDown ? y : height - 1 - y;
+            const unsigned char* row = mask + srcRow * maskStride;
+            for (int32_t x = 0; x < width; ++x) {
+                bool transparent = (row[x / 8] >> (7 - x % 8)) & 1;
+                uint32_t& pixel = out.bgra[(size_t)y * width + x];
+                pixel = transparent ? 0 : (pixel | 0xFF000000u);
+            }
+        }
+    }
+    return true;
+}
+
+bool DecodeBmp(const unsigned char* data, size_t size, IconPixels& out) {
+    if (size < 14 + 40 || data[0] != 'B' || data[1] != 'M') return false;
+    return DecodeDib(data + 14, size - 14, false, out);
+}
+
+bool DecodeIco(const unsigned char* data, size_t size, int preferredSize, IconPixels& out) {
+    if (size < 6 || ReadLE16(data) != 0 || (ReadLE16(data + 2) != 1 && ReadLE16(data + 2) != 2)) return false;
+    size_t count = ReadLE16(data + 4);
+    if (count == 0 || 6 + count * 16 > size) return false;
+
+    // Frames ordered by preference: the smallest at or above preferredSize,
+    // then the largest below it; deeper colour wins among equal sizes
+    struct Frame {
+        int dim;
+        int bits;
+        size_t offset;
+        size_t length;
+    };
+    std::vector<Frame> frames;
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* e = data + 6 + i * 16;
+        int w = e[0] ? e[0] : 256;
+        int h = e[1] ? e[1] : 256;
+        size_t length = ReadLE32(e + 8);
+        size_t offset = ReadLE32(e + 12);
+        if (offset >= size || length > size - offset || length == 0) continue;
+        frames.push_back({std::max(w, h), ReadLE16(e + 6), offset, length});
+    }
+    std::sort(frames.begin(), frames.end(), [preferredSize](const Frame& a, const Frame& b) {
+        bool aFits = a.dim >= preferredSize, bFits = b.dim >= preferredSize;
+        if (aFits != bFits) return aFits;
+        if (a.dim != b.dim) return aFits ? a.dim < b.dim : a.dim > b.dim;
+        return a.bits > b.bits;
+    });
+
+    for (const Frame& frame : frames) {
+        const unsigned char* p = data + frame.offset;
+        bool ok = IsPng(p, frame.length) ? DecodePng(p, frame.length, out) : DecodeDib(p, frame.length, true, out);
+        if (ok) return true;
+    }
+    return false;
+}
+
+// --- Scaling ------------------------------------------------------------------
+
+void FitIcon(const IconPixels& in, int size, IconPixels& out) {
+    out.width = size;
+    out.height = size;
+    out.bgra.assign((size_t)size * size, 0);
+    if (in.width <= 0 || in.height <= 0 || size <= 0) return;
+
+    int dw = size, dh = size;
+    if (in.width > in.height) dh = std::max(1, (in.height * size + in.width / 2) / in.width);
+    else if (in.height > in.width) dw = std::max(1, (in.width * size + in.height / 2) / in.height);
+    int ox = (size - dw) / 2, oy = (size - dh) / 2;
+
+    // Area average over the source pixels each target pixel covers, weighted by
+    // alpha so transparent pixels do not darken edges
+    double sx = (double)in.width / dw, sy = (double)in.height / dh;
+    for (int y = 0; y < dh; ++y) {
+        double y0 = y * sy, y1 = (y + 1) * sy;
+        for (int x = 0; x < dw; ++x) {
+            double x0 = x * sx, x1 = (x + 1) * sx;
+            double r = 0, g = 0, b = 0, a = 0, area = 0;
+            for (int iy = (int)y0; iy < in.height && iy < y1; ++iy) {
+                double wy = std::min(y1, iy + 1.0) - std::max(y0, (double)iy);
+                if (wy <= 0) continue;
+                for (int ix = (int)x0; ix < in.width && ix < x1; ++ix) {
+                    double wx = std::min(x1, ix + 1.0) - std::max(x0, (double)ix);
+                    if (wx <= 0) continue;
+                    double w = wx * wy;
+                    uint32_t p = in.bgra[(size_t)iy * in.width + ix];
+                    double pa = (p >> 24) / 255.0;
+                    r += ((p >> 16) & 0xFF) * pa * w;
+                    g += ((p >> 8) & 0xFF) * pa * w;
+                    b += (p & 0xFF) * pa * w;
+                    a += pa * w;
+                    area += w;
+                }
+            }
+            if (area <= 0 || a <= 0) continue;
+            auto channel = [](double v) { return (unsigned)std::min(255.0, v + 0.5); };
+            out.bgra[(size_t)(oy + y) * size + ox + x] =
+                Pack(channel(r / a), channel(g / a), channel(b / a), channel(a / area * 255.0));
+        }
+    }
+}
+
+// --- Icon bitmaps -------------------------------------------------------------
+
+const char kIconBitmapType[] = "bgra";
+// Only what is shown: a 32 x 32 frame would add 4 KB to every icon
+const int kIconBitmapSizes[1] = {16};
+
+static const unsigned char kIconBitmapMagic[4] = {'W', 'P', 'I', 'B'};
+static const unsigned char kIconBitmapVersion = 1;
+
+// Calls frame(size, pixels) for each frame; false if the blob is malformed.
+template <typename Frame>
+static bool ForEachBitmapFrame(const unsigned char* data, size_t size, Frame frame) {
+    if (size < 6 || memcmp(data, kIconBitmapMagic, 4) != 0 || data[4] != kIconBitmapVersion) return false;
+    size_t count = data[5];
+    size_t pos = 6;
+    for (size_t i = 0; i < count; ++i) {
+        if (pos >= size) return false;
+        size_t dim = data[pos++];
+        size_t bytes = dim * dim * 4;
+        if (dim == 0 || bytes > size - pos) return false;
+        frame((int)dim, data + pos);
+        pos += bytes;
+    }
+    return count > 0 && pos == size;
+}
+
+bool IsIconBitmap(const unsigned char* data, size_t size) {
+    return data && ForEachBitmapFrame(data, size, [](int, const unsigned char*) {});
+}
+
+static bool DecodeIconBitmap(const unsigned char* data, size_t size, int iconSize, IconPixels& out) {
+    // The frame of exactly iconSize, else the largest
+    int best = 0;
+    const unsigned char* bestPixels = nullptr;
+    if (!ForEachBitmapFrame(data, size, [&](int dim, const unsigned char* pixels) {
+            if (best != iconSize && (dim == iconSize || dim > best)) {
+                best = dim;
+                bestPixels = pixels;
+            }
+        })) {
+        return false;
+    }
+    out.width = out.height = best;
+    out.bgra.resize((size_t)best * best);
+    for (size_t i = 0; i < out.bgra.size(); ++i) out.bgra[i] = ReadLE32(bestPixels + i * 4);
+    return true;
+}
+
+bool TranscodeIcon(const unsigned char* data, size_t size, std::vector<unsigned char>& out) {
+    out.clear();
+    if (!data || size == 0 || size > kMaxIconBytes) return false;
+
+    std::vector<unsigned char> blob(kIconBitmapMagic, kIconBitmapMagic + 4);
+    blob.push_back(kIconBitmapVersion);
+    blob.push_back((unsigned char)(sizeof(kIconBitmapSizes) / sizeof(kIconBitmapSizes[0])));
+    for (int iconSize : kIconBitmapSizes) {
+        IconPixels pixels;
+        if (!DecodeIcon(data, size, iconSize, pixels)) return false;
+        // Nothing to see (a fully transparent placeholder favicon)
+        bool visible = false;
+        for (uint32_t p : pixels.bgra) visible = visible || (p >> 24) != 0;
+        if (!visible) return false;
+        blob.push_back((unsigned char)iconSize);
+        for (uint32_t p : pixels.bgra) {
+            unsigned char bytes[4] = {(unsigned char)p, (unsigned char)(p >> 8), (unsigned char)(p >> 16),
+                                      (unsigned char)(p >> 24)};
+            blob.insert(blob.end(), bytes, bytes + 4);
+        }
+    }
+    out.swap(blob);
+    return true;
+}
+
+// --- Entry point --------------------------------------------------------------
+
+bool DecodeIcon(const unsigned char* data, size_t size, int iconSize, IconPixels& out) {
+    if (!data || size == 0 || iconSize <= 0) return false;
+    IconPixels decoded;
+    bool ok = (size >= 4 && memcmp(data, kIconBitmapMagic, 4) == 0) ? DecodeIconBitmap(data, size, iconSize, decoded)
+            : IsPng(data, size) ? DecodePng(data, size, decoded)
+            : (size >= 2 && data[0] == 'B' && data[1] == 'M') ? DecodeBmp(data, size, decoded)
+            : DecodeIco(data, size, iconSize, decoded);
+    if (!ok) return false;
+    if (decoded.width == iconSize && decoded.height == iconSize) {
+        out = std::move(decoded);
+    } else {
+        FitIcon(decoded, iconSize, out);
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decoded icon: width * height pixels as 0xAARRGGBB (BGRA in memory on
+// little-endian), top row first, straight (not premultiplied) alpha.
+struct IconPixels {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> bgra;
+};
+
+// Decode an icons.data blob (an icon bitmap written by TranscodeIcon, ICO with
+// BMP or PNG frames, PNG or BMP) into a size x size image: scaled to fit with
+// its aspect ratio kept and centered on a transparent background. Returns
+// false for anything else (JPEG, SVG, HTML error pages saved as favicons) and
+// for corrupt data. Icon bitmaps with a size x size frame are simply copied.
+// Needs no OS support, so it can run on any thread and on any platform.
+bool DecodeIcon(const unsigned char* data, size_t size, int iconSize, IconPixels& out);
+
+// The steps of DecodeIcon.
+bool DecodePng(const unsigned char* data, size_t size, IconPixels& out);
+bool DecodeBmp(const unsigned char* data, size_t size, IconPixels& out);
+// Picks the frame closest to (and preferably not below) preferredSize.
+bool DecodeIco(const unsigned char* data, size_t size, int preferredSize, IconPixels& out);
+void FitIcon(const IconPixels& in, int size, IconPixels& out);
+
+// Icon bitmaps (icons.type kIconBitmapType) are what the updater stores: the
+// favicon decoded once and rendered at each of kIconBitmapSizes, so showing
+// it is a copy. Layout: "WPIB", version 1, frame count, then per frame its
+// size N and N x N pixels as above (B, G, R, A bytes, top row first).
+extern const char kIconBitmapType[];
+extern const int kIconBitmapSizes[1];   // 16, what the app list shows
+
+static const size_t kMaxIconBytes = 1024 * 1024;
+
+// Turn whatever a site served as favicon into an icon bitmap. Rejects what
+// DecodeIcon cannot read, inputs over kMaxIconBytes, images over 1024 pixels
+// and images that are fully transparent.
+bool TranscodeIcon(const unsigned char* data, size_t size, std::vector<unsigned char>& out);
+bool IsIconBitmap(const unsigned char* data, size_t size);
@@ -0,0 +1,969 @@
+#include "icon_fetcher.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+const char kUserAgent[] = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) WinProgramUpdater";
+const size_t kMaxPageBytes = 512 * 1024;    // the head is all that is scanned
+const size_t kMaxIconBytes = 1024 * 1024;   // TranscodeIcon refuses larger ones anyway
+const int kMaxRedirects = 5;
+const int kDeadHostFailures = 2;            // transport failures in a row, without an answer before
+const int64_t kRetryFailedAfter = 7 * 24 * 3600;
+
+char LowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+}
+
+std::string Lower(std::string text) {
+    for (char& c : text) c = LowerAscii(c);
+    return text;
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+std::string Trim(const std::string& text) {
+    size_t start = 0, end = text.size();
+    while (start < end && IsSpace(text[start])) ++start;
+    while (end > start && IsSpace(text[end - 1])) --end;
+    return text.substr(start, end - start);
+}
+
+int DefaultPort(const std::string& scheme) {
+    return scheme == "https" ? 443 : 80;
+}
+
+// Path with "." and ".." segments resolved; the query is left alone
+std::string RemoveDotSegments(const std::string& path) {
+    size_t queryStart = path.find('?');
+    std::string segmentsPart = path.substr(0, queryStart);
+    std::vector<std::string> segments;
+    size_t start = 1;
+    for (;;) {
+        size_t slash = segmentsPart.find('/', start);
+        std::string segment = segmentsPart.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+        bool last = slash == std::string::npos;
+        if (segment == "..") {
+            if (!segments.empty()) segments.pop_back();
+            if (last) segments.push_back("");
+        } else if (segment == ".") {
+            if (last) segments.push_back("");
+        } else {
+            segments.push_back(segment);
+        }
+        if (last) break;
+        start = slash + 1;
+    }
+    std::string result;
+    for (const std::string& segment : segments) result += "/" + segment;
+    if (result.empty()) result = "/";
+    return queryStart == std::string::npos ? result : result + path.substr(queryStart);
+}
+
+int64_t UnixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// At most `limit` requests to one host at a time
+class HostSlots {
+public:
+    explicit HostSlots(int limit) : limit_(limit < 1 ? 1 : limit) {}
+
+    void Acquire(const std::string& host) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        freed_.wait(lock, [&] { return active_[host] < limit_; });
+        ++active_[host];
+    }
+
+    void Release(const std::string& host) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_[host];
+        freed_.notify_all();
+    }
+
+    int Limit() const { return limit_; }
+
+private:
+    int limit_;
+    std::mutex mutex_;
+    std::condition_variable freed_;
+    std::map<std::string, int> active_;
+};
+
+// Passes body bytes to the callback or the response, up to the byte limit
+struct BodySink {
+    HttpResponse& response;
+    const std::function<bool(const char*, size_t)>& onBody;
+    size_t maxBytes;
+    size_t total = 0;
+
+    // False once reading should stop
+    bool Write(const char* data, size_t size) {
+        if (total + size > maxBytes) {
+            size = maxBytes - total;
+            response.truncated = true;
+        }
+        total += size;
+        bool more = onBody ? onBody(data, size) : (response.body.append(data, size), true);
+        return more && !response.truncated;
+    }
+};
+
+}  // namespace
+
+// --- URLs -------------------------------------------------------------------
+
+std::string HttpUrl::Origin() const {
+    std::string origin = scheme + "://" + (host.find(':') != std::string::npos ? "[" + host + "]" : host);
+    if (port != DefaultPort(scheme)) origin += ":" + std::to_string(port);
+    return origin;
+}
+
+bool ParseUrl(const std::string& text, HttpUrl& url) {
+    std::string trimmed = Trim(text);
+    size_t schemeEnd = trimmed.find("://");
+    if (schemeEnd == std::string::npos) return false;
+    HttpUrl parsed;
+    parsed.scheme = Lower(trimmed.substr(0, schemeEnd));
+    if (parsed.scheme != "http" && parsed.scheme != "https") return false;
+
+    size_t authorityStart = schemeEnd + 3;
+    size_t authorityEnd = trimmed.find_first_of("/?#", authorityStart);
+    if (authorityEnd == std::string::npos) authorityEnd = trimmed.size();
+    std::string authority = trimmed.substr(authorityStart, authorityEnd - authorityStart);
+    size_t at = authority.rfind('@');
+    if (at != std::string::npos) authority = authority.substr(at + 1);
+
+    std::string portText;
+    if (!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) return false;
+        parsed.host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size() && authority[close + 1] == ':') portText = authority.substr(close + 2);
+    } else {
+        size_t colon = authority.find(':');
+        parsed.host = authority.substr(0, colon);
+        if (colon != std::string::npos) portText = authority.substr(colon + 1);
+    }
+    parsed.host = Lower(parsed.host);
+    if (parsed.host.empty()) return false;
+    parsed.port = DefaultPort(parsed.scheme);
+    if (!portText.empty()) {
+        if (portText.size() > 5 || portText.find_first_not_of("0123456789") != std::string::npos) return false;
+        parsed.port = std::stoi(portText);
+        if (parsed.port < 1 || parsed.port > 65535) return false;
+    }
+
+    std::string path = trimmed.substr(authorityEnd);
+    path = path.substr(0, path.find('#'));
+    if (path.empty() || path[0] != '/') path = "/" + path;
+    // Spaces are common in hand-written hrefs; requests need them escaped
+    std::string escaped;
+    for (char c : path) escaped += c == ' ' ? std::string("%20") : std::string(1, c);
+    parsed.path = RemoveDotSegments(escaped);
+    url = std::move(parsed);
+    return true;
+}
+
+bool ResolveUrl(const HttpUrl& base, const std::string& href, HttpUrl& out) {
+    std::string ref;
+    for (char c : Trim(href)) {
+        if (c != '\n' && c != '\r' && c != '\t') ref += c;
+    }
+    for (const char* entity : {"&amp;", "&#38;", "&#x26;"}) {
+        for (size_t pos; (pos = ref.find(entity)) != std::string::npos;) ref.replace(pos, strlen(entity), "&");
+    }
+    ref = ref.substr(0, ref.find('#'));
+    if (ref.empty()) return false;
+
+    // Absolute: a scheme before any path, query or fragment
+    size_t colon = ref.find(':');
+    if (colon != std::string::npos && colon < ref.find_first_of("/?") &&
+        std::all_of(ref.begin(), ref.begin() + colon, [](char c) { return isalnum((unsigned char)c) || c == '+' || c == '-' || c == '.'; })) {
+        return ParseUrl(ref, out);
+    }
+    if (ref.compare(0, 2, "//") == 0) return ParseUrl(base.scheme + ":" + ref, out);
+
+    HttpUrl resolved = base;
+    std::string basePath = base.path.substr(0, base.path.find('?'));
+    if (ref[0] == '/') {
+        resolved.path = ref;
+    } else if (ref[0] == '?') {
+        resolved.path = basePath + ref;
+    } else {
+        resolved.path = basePath.substr(0, basePath.rfind('/') + 1) + ref;
+    }
+    return ParseUrl(resolved.Origin() + resolved.path, out);
+}
+
+// --- HTTP -------------------------------------------------------------------
+
+#ifdef _WIN32
+
+namespace {
+
+std::wstring Wide(const std::string& text) {
+    if (text.empty()) return std::wstring();
+    int size = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), nullptr, 0);
+    std::wstring wide(size, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), &wide[0], size);
+    return wide;
+}
+
+std::string Narrow(const std::wstring& text) {
+    if (text.empty()) return std::string();
+    int size = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), (int)text.size(), nullptr, 0, nullptr, nullptr);
+    std::string narrow(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), (int)text.size(), &narrow[0], size, nullptr, nullptr);
+    return narrow;
+}
+
+std::string QueryHeader(HINTERNET request, DWORD info) {
+    DWORD size = 0;
+    WinHttpQueryHeaders(request, info, WINHTTP_HEADER_NAME_BY_INDEX, WINHTTP_NO_OUTPUT_BUFFER, &size,
+                        WINHTTP_NO_HEADER_INDEX);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || size == 0) return std::string();
+    std::wstring value(size / sizeof(wchar_t), L'\0');
+    if (!WinHttpQueryHeaders(request, info, WINHTTP_HEADER_NAME_BY_INDEX, &value[0], &size, WINHTTP_NO_HEADER_INDEX)) {
+        return std::string();
+    }
+    value.resize(size / sizeof(wchar_t));
+    return Narrow(value);
+}
+
+}  // namespace
+
+struct HttpClient::Impl {
+    HostSlots slots;
+    HINTERNET session = nullptr;
+
+    Impl(int timeoutMs, int connectionsPerHost) : slots(connectionsPerHost) {
+        std::wstring agent = Wide(kUserAgent);
+#ifdef WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY
+        session = WinHttpOpen(agent.c_str(), WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, WINHTTP_NO_PROXY_NAME,
+                              WINHTTP_NO_PROXY_BYPASS, 0);
+#endif
+        if (!session) {
+            session = WinHttpOpen(agent.c_str(), WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME,
+                                  WINHTTP_NO_PROXY_BYPASS, 0);
+        }
+        if (!session) return;
+        WinHttpSetTimeouts(session, timeoutMs, timeoutMs, timeoutMs, timeoutMs);
+        DWORD connections = (DWORD)slots.Limit();
+        WinHttpSetOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &connections, sizeof(connections));
+        WinHttpSetOption(session, WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER, &connections, sizeof(connections));
+#ifdef WINHTTP_OPTION_DECOMPRESSION
+        DWORD decompression = WINHTTP_DECOMPRESSION_FLAG_ALL;
+        WinHttpSetOption(session, WINHTTP_OPTION_DECOMPRESSION, &decompression, sizeof(decompression));
+#endif
+    }
+
+    ~Impl() {
+        if (session) WinHttpCloseHandle(session);
+    }
+
+    bool Request(const HttpUrl& url, const Headers& headers, size_t maxBytes, HttpResponse& response,
+                 const std::function<bool(const char*, size_t)>& onBody) {
+        if (!session) return false;
+        // Connect handles are cheap; the session keeps the sockets underneath alive
+        HINTERNET connect = WinHttpConnect(session, Wide(url.host).c_str(), (INTERNET_PORT)url.port, 0);
+        if (!connect) return false;
+        HINTERNET request = WinHttpOpenRequest(connect, L"GET", Wide(url.path).c_str(), nullptr, WINHTTP_NO_REFERER,
+                                               WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                               url.scheme == "https" ? WINHTTP_FLAG_SECURE : 0);
+        bool answered = false;
+        if (request) {
+            DWORD policy = WINHTTP_OPTION_REDIRECT_POLICY_NEVER;
+            WinHttpSetOption(request, WINHTTP_OPTION_REDIRECT_POLICY, &policy, sizeof(policy));
+            std::wstring extra;
+            for (const auto& header : headers) extra += Wide(header.first + ": " + header.second + "\r\n");
+            if (WinHttpSendRequest(request, extra.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : extra.c_str(), (DWORD)-1L,
+                                   WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
+                WinHttpReceiveResponse(request, nullptr)) {
+                DWORD status = 0, size = sizeof(status);
+                WinHttpQueryHeaders(request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                    WINHTTP_HEADER_NAME_BY_INDEX, &status, &size, WINHTTP_NO_HEADER_INDEX);
+                response.status = (int)status;
+                response.contentType = QueryHeader(request, WINHTTP_QUERY_CONTENT_TYPE);
+                response.location = QueryHeader(request, WINHTTP_QUERY_LOCATION);
+                response.etag = QueryHeader(request, WINHTTP_QUERY_ETAG);
+                response.lastModified = QueryHeader(request, WINHTTP_QUERY_LAST_MODIFIED);
+                answered = true;
+
+                BodySink sink{response, onBody, maxBytes};
+                char buffer[16384];
+                DWORD read = 0;
+                while (WinHttpReadData(request, buffer, sizeof(buffer), &read) && read > 0) {
+                    if (!sink.Write(buffer, read)) break;
+                }
+            }
+            WinHttpCloseHandle(request);
+        }
+        WinHttpCloseHandle(connect);
+        return answered;
+    }
+
+    long long Connections() const { return -1; }
+};
+
+#else  // POSIX
+
+namespace {
+
+// Buffered reads from a socket; each wait for data is bounded by the timeout
+struct SocketReader {
+    int fd;
+    int timeoutMs;
+    std::string buffer;
+    size_t pos = 0;
+
+    SocketReader(int socket, int timeout) : fd(socket), timeoutMs(timeout) {}
+
+    bool Fill() {
+        if (pos > 65536) {
+            buffer.erase(0, pos);
+            pos = 0;
+        }
+        char chunk[16384];
+        for (;;) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                buffer.append(chunk, (size_t)n);
+                return true;
+            }
+            if (n == 0) return false;
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            pollfd p{fd, POLLIN, 0};
+            if (poll(&p, 1, timeoutMs) <= 0) return false;
+        }
+    }
+
+    bool ReadLine(std::string& line) {
+        for (;;) {
+            size_t end = buffer.find("\r\n", pos);
+            if (end != std::string::npos) {
+                line = buffer.substr(pos, end - pos);
+                pos = end + 2;
+                return true;
+            }
+            if (buffer.size() - pos > 65536 || !Fill()) return false;
+        }
+    }
+
+    // Pass `size` bytes (or everything up to EOF if size is npos) to the sink.
+    // False if the connection failed or the sink stopped; `eof` tells which.
+    bool Copy(size_t size, BodySink& sink, bool& eof) {
+        eof = false;
+        while (size > 0) {
+            if (pos == buffer.size()) {
+                if (!Fill()) {
+                    eof = true;
+                    return false;
+                }
+            }
+            size_t n = std::min(size, buffer.size() - pos);
+            const char* data = buffer.data() + pos;
+            pos += n;
+            if (size != std::string::npos) size -= n;
+            if (!sink.Write(data, n)) return false;
+        }
+        return true;
+    }
+};
+
+bool SendAll(int fd, const std::string& data, int timeoutMs) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd p{fd, POLLOUT, 0};
+            if (poll(&p, 1, timeoutMs) <= 0) return false;
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+struct HttpClient::Impl {
+    HostSlots slots;
+    int timeoutMs;
+    std::mutex idleMutex;
+    std::map<std::string, std::vector<int>> idle;   // kept-alive connections per host:port
+    std::atomic<long long> connections{0};
+
+    Impl(int timeout, int connectionsPerHost) : slots(connectionsPerHost), timeoutMs(timeout) {}
+
+    ~Impl() {
+        for (auto& host : idle) {
+            for (int fd : host.second) close(fd);
+        }
+    }
+
+    int Connect(const HttpUrl& url) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(url.host.c_str(), std::to_string(url.port).c_str(), &hints, &addresses) != 0) return -1;
+        int fd = -1;
+        for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+            fd = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+            if (fd < 0) continue;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            int error = 0;
+            if (connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+                error = errno;
+                if (error == EINPROGRESS) {
+                    pollfd p{fd, POLLOUT, 0};
+                    socklen_t length = sizeof(error);
+                    if (poll(&p, 1, timeoutMs) <= 0) {
+                        error = ETIMEDOUT;
+                    } else if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0) {
+                        error = errno;
+                    }
+                }
+            }
+            if (error != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+        if (fd >= 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            ++connections;
+        }
+        return fd;
+    }
+
+    // An idle connection the server has not closed meanwhile, or -1
+    int TakeIdle(const std::string& key) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        std::vector<int>& fds = idle[key];
+        while (!fds.empty()) {
+            int fd = fds.back();
+            fds.pop_back();
+            pollfd p{fd, POLLIN, 0};
+            if (poll(&p, 1, 0) == 0) return fd;   // nothing to read: still open
+            close(fd);
+        }
+        return -1;
+    }
+
+    void PutIdle(const std::string& key, int fd) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        std::vector<int>& fds = idle[key];
+        if ((int)fds.size() < slots.Limit()) {
+            fds.push_back(fd);
+        } else {
+            close(fd);
+        }
+    }
+
+    // Status line and headers; skips interim 1xx responses
+    bool ReadHead(SocketReader& reader, HttpResponse& response, bool& keepAlive, bool& chunked, size_t& length) {
+        std::string line;
+        do {
+            if (!reader.ReadLine(line) || line.compare(0, 5, "HTTP/") != 0) return false;
+            size_t space = line.find(' ');
+            if (space == std::string::npos) return false;
+            response.status = atoi(line.c_str() + space + 1);
+            keepAlive = line.compare(0, 8, "HTTP/1.0") != 0;
+            chunked = false;
+            length = std::string::npos;
+            for (;;) {
+                if (!reader.ReadLine(line)) return false;
+                if (line.empty()) break;
+                size_t colon = line.find(':');
+                if (colon == std::string::npos) continue;
+                std::string name = Lower(Trim(line.substr(0, colon)));
+                std::string value = Trim(line.substr(colon + 1));
+                if (name == "content-length") {
+                    length = (size_t)strtoull(value.c_str(), nullptr, 10);
+                } else if (name == "transfer-encoding") {
+                    chunked = Lower(value).find("chunked") != std::string::npos;
+                } else if (name == "connection") {
+                    std::string token = Lower(value);
+                    if (token.find("close") != std::string::npos) keepAlive = false;
+                    if (token.find("keep-alive") != std::string::npos) keepAlive = true;
+                } else if (name == "content-type") {
+                    response.contentType = value;
+                } else if (name == "location") {
+                    response.location = value;
+                } else if (name == "etag") {
+                    response.etag = value;
+                } else if (name == "last-modified") {
+                    response.lastModified = value;
+                }
+            }
+        } while (response.status / 100 == 1);
+        return response.status > 0;
+    }
+
+    // Whole body read (the connection can be reused)
+    bool ReadBody(SocketReader& reader, HttpResponse& response, BodySink& sink, bool chunked, size_t length,
+                  bool& keepAlive) {
+        bool eof = false;
+        if (response.status == 204 || response.status == 304) return true;
+        if (chunked) {
+            std::string line;
+            for (;;) {
+                if (!reader.ReadLine(line)) return false;
+                size_t size = (size_t)strtoull(line.c_str(), nullptr, 16);
+                if (size == 0) break;
+                if (!reader.Copy(size, sink, eof) || !reader.ReadLine(line)) return false;
+            }
+            // Trailers up to the empty line
+            do {
+                if (!reader.ReadLine(line)) return false;
+            } while (!line.empty());
+            return true;
+        }
+        if (length != std::string::npos) return reader.Copy(length, sink, eof);
+        // Neither: the body ends when the server closes
+        keepAlive = false;
+        reader.Copy(std::string::npos, sink, eof);
+        return false;
+    }
+
+    bool Request(const HttpUrl& url, const Headers& headers, size_t maxBytes, HttpResponse& response,
+                 const std::function<bool(const char*, size_t)>& onBody) {
+        if (url.scheme != "http") return false;   // this backend has no TLS
+        std::string key = url.host + ":" + std::to_string(url.port);
+        std::string request = "GET " + url.path + " HTTP/1.1\r\nHost: " + url.host +
+                              (url.port != 80 ? ":" + std::to_string(url.port) : std::string()) +
+                              "\r\nUser-Agent: " + kUserAgent + "\r\nConnection: keep-alive\r\n";
+        for (const auto& header : headers) request += header.first + ": " + header.second + "\r\n";
+        request += "\r\n";
+
+        // A kept-alive connection may have been closed by the server just as
+        // it was picked up; then try once more on a new one
+        int fd = TakeIdle(key);
+        bool reused = fd >= 0;
+        SocketReader reader(-1, timeoutMs);
+        bool keepAlive = false, chunked = false;
+        size_t length = std::string::npos;
+        for (;;) {
+            if (fd < 0) fd = Connect(url);
+            if (fd < 0) return false;
+            reader = SocketReader(fd, timeoutMs);
+            if (SendAll(fd, request, timeoutMs) && ReadHead(reader, response, keepAlive, chunked, length)) break;
+            close(fd);
+            fd = -1;
+            response = HttpResponse();
+            if (!reused) return false;
+            reused = false;
+        }
+
+        BodySink sink{response, onBody, maxBytes};
+        bool complete = ReadBody(reader, response, sink, chunked, length, keepAlive);
+        if (complete && keepAlive && reader.pos == reader.buffer.size()) {
+            PutIdle(key, fd);
+        } else {
+            close(fd);
+        }
+        return true;
+    }
+
+    long long Connections() const { return connections; }
+};
+
+#endif
+
+HttpClient::HttpClient(int timeoutMs, int connectionsPerHost) : impl_(new Impl(timeoutMs, connectionsPerHost)) {}
+
+HttpClient::~HttpClient() = default;
+
+bool HttpClient::Get(const HttpUrl& url, const Headers& headers, size_t maxBytes, HttpResponse& response,
+                     const std::function<bool(const char*, size_t)>& onBody) {
+    ++requests_;
+    response = HttpResponse();
+    std::string host = url.host + ":" + std::to_string(url.port);
+    impl_->slots.Acquire(host);
+    bool answered = impl_->Request(url, headers, maxBytes, response, onBody);
+    impl_->slots.Release(host);
+    return answered;
+}
+
+long long HttpClient::Connections() const {
+    return impl_->Connections();
+}
+
+// --- Icon links -------------------------------------------------------------
+
+bool IconLinkScanner::Feed(const char* data, size_t size) {
+    for (size_t i = 0; i < size && !done_; ++i) {
+        char c = data[i];
+        switch (state_) {
+        case kText:
+            if (c == '<') {
+                state_ = kTag;
+                tag_.clear();
+            }
+            break;
+        case kTag:
+            if (c == '>' && !quote_) {
+                Tag();
+                break;
+            }
+            if (quote_) {
+                if (c == quote_) quote_ = 0;
+            } else if ((c == '"' || c == '\'') && afterEquals_) {
+                quote_ = c;
+            }
+            if (!IsSpace(c)) afterEquals_ = c == '=';
+            tag_ += c;
+            if (tag_ == "!--") {
+                state_ = kComment;
+                tag_.clear();
+            } else if (tag_.size() > 8192) {
+                state_ = kText;   // not a tag worth reading
+                quote_ = 0;
+            }
+            break;
+        case kComment:
+            tag_ += c;
+            if (tag_.size() > 3) tag_.erase(0, tag_.size() - 3);
+            if (tag_ == "-->") state_ = kText;
+            break;
+        case kRawText:
+            tag_ += LowerAscii(c);
+            if (tag_.size() > rawEnd_.size()) tag_.erase(0, tag_.size() - rawEnd_.size());
+            if (tag_ == rawEnd_) {
+                // Read the end tag like any other
+                state_ = kTag;
+                tag_ = rawEnd_.substr(1);
+            }
+            break;
+        }
+    }
+    return !done_;
+}
+
+void IconLinkScanner::Tag() {
+    state_ = kText;
+    quote_ = 0;
+    afterEquals_ = false;
+    size_t pos = 0;
+    std::string name;
+    if (pos < tag_.size() && tag_[pos] == '/') name += tag_[pos++];
+    while (pos < tag_.size() && (isalnum((unsigned char)tag_[pos]) || tag_[pos] == '-')) name += LowerAscii(tag_[pos++]);
+
+    if (name == "body" || name == "/head") {
+        done_ = true;
+        return;
+    }
+    bool selfClosing = !tag_.empty() && tag_.back() == '/';
+    if ((name == "script" || name == "style") && !selfClosing) {
+        state_ = kRawText;
+        rawEnd_ = "</" + name;
+        tag_.clear();
+        return;
+    }
+    if (name != "link") return;
+
+    std::string rel, href, type;
+    while (pos < tag_.size()) {
+        while (pos < tag_.size() && (IsSpace(tag_[pos]) || tag_[pos] == '/')) ++pos;
+        size_t nameStart = pos;
+        while (pos < tag_.size() && !IsSpace(tag_[pos]) && tag_[pos] != '=' && tag_[pos] != '/') ++pos;
+        std::string attribute = Lower(tag_.substr(nameStart, pos - nameStart));
+        while (pos < tag_.size() && IsSpace(tag_[pos])) ++pos;
+        std::string value;
+        if (pos < tag_.size() && tag_[pos] == '=') {
+            ++pos;
+            while (pos < tag_.size() && IsSpace(tag_[pos])) ++pos;
+            if (pos < tag_.size() && (tag_[pos] == '"' || tag_[pos] == '\'')) {
+                char quote = tag_[pos++];
+                size_t end = tag_.find(quote, pos);
+                if (end == std::string::npos) end = tag_.size();
+                value = tag_.substr(pos, end - pos);
+                pos = end + 1;
+            } else {
+                size_t valueStart = pos;
+                while (pos < tag_.size() && !IsSpace(tag_[pos])) ++pos;
+                value = tag_.substr(valueStart, pos - valueStart);
+            }
+        }
+        if (attribute.empty()) {
+            ++pos;
+        } else if (attribute == "rel") {
+            rel = Lower(value);
+        } else if (attribute == "href") {
+            href = Trim(value);
+        } else if (attribute == "type") {
+            type = Lower(value);
+        }
+    }
+
+    bool icon = false;
+    for (size_t start = 0; start < rel.size();) {
+        while (start < rel.size() && IsSpace(rel[start])) ++start;
+        size_t end = start;
+        while (end < rel.size() && !IsSpace(rel[end])) ++end;
+        icon = icon || rel.substr(start, end - start) == "icon";
+        start = end;
+    }
+    if (!icon || href.empty()) return;
+    std::string path = Lower(href.substr(0, href.find_first_of("?#")));
+    bool svg = type.find("svg") != std::string::npos ||
+               (path.size() >= 4 && path.compare(path.size() - 4, 4, ".svg") == 0);
+    if (svg || href.compare(0, 5, "data:") == 0) return;
+    href_ = href;
+    done_ = true;
+}
+
+// --- Fetcher ----------------------------------------------------------------
+
+IconFetcher::IconFetcher(int timeoutMs, int connectionsPerHost) : http_(timeoutMs, connectionsPerHost) {}
+
+void IconFetcher::Load(std::vector<IconSource> sources) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (IconSource& source : sources) {
+        auto icon = std::make_shared<Icon>();
+        icon->source = std::move(source);
+        icons_[icon->source.url] = icon;
+    }
+}
+
+template <typename Entry, typename Compute>
+std::shared_ptr<Entry> IconFetcher::Once(std::map<std::string, std::shared_ptr<Entry>>& entries,
+                                         const std::string& key, Compute compute) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::shared_ptr<Entry>& slot = entries[key];
+    if (!slot) slot = std::make_shared<Entry>();
+    std::shared_ptr<Entry> entry = slot;
+    if (entry->done || entry->busy) {
+        done_.wait(lock, [&] { return entry->done; });
+        ++cacheHits_;
+        return entry;
+    }
+    // Only this thread touches the entry until it is done
+    entry->busy = true;
+    lock.unlock();
+    compute(*entry);
+    lock.lock();
+    entry->busy = false;
+    entry->done = true;
+    done_.notify_all();
+    return entry;
+}
+
+FetchedIcon IconFetcher::Fetch(const std::string& homepage) {
+    FetchedIcon result;
+    auto page = Once(pages_, homepage, [&](Page& p) { p.iconUrl = ResolvePage(homepage); });
+    if (page->iconUrl.empty()) return result;
+    result.url = page->iconUrl;
+    auto icon = Once(icons_, result.url, [&](Icon& i) { FetchIcon(result.url, i); });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (icon->unchanged) {
+        result.storedHash = icon->source.iconHash;
+    } else {
+        result.data = icon->data;
+    }
+    return result;
+}
+
+void IconFetcher::Stored(const std::string& url, const std::string& hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = icons_.find(url);
+    if (it == icons_.end() || !it->second->done) return;
+    it->second->source.iconHash = hash;
+    it->second->failed = false;
+}
+
+std::vector<IconSource> IconFetcher::Sources() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<IconSource> sources;
+    for (const auto& entry : icons_) {
+        const Icon& icon = *entry.second;
+        // Served but never stored (not an image, or its package was not added): ask again next time
+        if (!icon.done || !icon.fetched || (!icon.failed && icon.source.iconHash.empty())) continue;
+        sources.push_back(icon.source);
+    }
+    return sources;
+}
+
+bool IconFetcher::HostDead(const std::string& origin) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hostFailures_.find(origin);
+    return it != hostFailures_.end() && it->second >= kDeadHostFailures;
+}
+
+void IconFetcher::HostAnswered(const std::string& origin, bool answered) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int& failures = hostFailures_[origin];
+    if (answered) {
+        failures = -1;
+    } else if (failures >= 0) {
+        ++failures;
+    }
+}
+
+bool IconFetcher::GetFollowing(HttpUrl url, const HttpClient::Headers& headers, size_t maxBytes,
+                               HttpResponse& response, const std::function<bool(const char*, size_t)>& onBody,
+                               HttpUrl& finalUrl) {
+    for (int hop = 0;; ++hop) {
+        if (HostDead(url.Origin())) return false;
+        bool answered = http_.Get(url, headers, maxBytes, response, onBody);
+        HostAnswered(url.Origin(), answered);
+        if (!answered) return false;
+        finalUrl = url;
+        int status = response.status;
+        bool redirect = (status == 301 || status == 302 || status == 303 || status == 307 || status == 308) &&
+                        !response.location.empty();
+        HttpUrl next;
+        if (!redirect || hop == kMaxRedirects || !ResolveUrl(url, response.location, next)) return true;
+        url = next;
+    }
+}
+
+std::string IconFetcher::ResolvePage(const std::string& homepage) {
+    HttpUrl url, finalUrl;
+    if (!ParseUrl(homepage, url)) return std::string();
+    IconLinkScanner scanner;
+    HttpResponse response;
+    // Redirect bodies are read (so the connection stays usable) but not scanned
+    bool answered = GetFollowing(url, {{"Accept", "text/html,application/xhtml+xml,*/*;q=0.8"}}, kMaxPageBytes,
+                                 response,
+                                 [&](const char* data, size_t size) {
+                                     return response.status / 100 != 2 || scanner.Feed(data, size);
+                                 },
+                                 finalUrl);
+    if (!answered || response.status / 100 != 2) return std::string();
+
+    // No usable link: the site-wide favicon, like browsers do
+    HttpUrl icon;
+    if (scanner.Href().empty() || !ResolveUrl(finalUrl, scanner.Href(), icon)) {
+        icon = finalUrl;
+        icon.path = "/favicon.ico";
+    }
+    return icon.ToString();
+}
+
+void IconFetcher::FetchIcon(const std::string& url, Icon& icon) {
+    HttpUrl parsed, finalUrl;
+    int64_t now = UnixNow();
+    bool stored = !icon.source.iconHash.empty();
+    if (icon.source.checked > 0 && !stored && now - icon.source.checked < kRetryFailedAfter) {
+        icon.failed = true;   // failed last time, recently
+        return;
+    }
+    icon.source.url = url;
+    icon.source.checked = now;
+    icon.fetched = true;
+    if (!ParseUrl(url, parsed)) {
+        icon.failed = true;
+        return;
+    }
+
+    HttpClient::Headers headers{{"Accept", "image/*,*/*;q=0.8"}};
+    if (stored && !icon.source.etag.empty()) headers.emplace_back("If-None-Match", icon.source.etag);
+    if (stored && !icon.source.lastModified.empty()) headers.emplace_back("If-Modified-Since", icon.source.lastModified);
+    HttpResponse response;
+    bool answered = GetFollowing(parsed, headers, kMaxIconBytes, response, nullptr, finalUrl);
+    if (answered && response.status == 304 && stored) {
+        icon.unchanged = true;
+        ++revalidated_;
+        return;
+    }
+    icon.source.iconHash.clear();
+    if (!answered || response.status != 200 || response.truncated || response.body.empty()) {
+        icon.failed = true;
+        icon.source.etag.clear();
+        icon.source.lastModified.clear();
+        return;
+    }
+    icon.data.assign(response.body.begin(), response.body.end());
+    icon.source.etag = response.etag;
+    icon.source.lastModified = response.lastModified;
+}
+
+// --- icon_sources -----------------------------------------------------------
+
+int LoadIconSources(sqlite3* db, IconFetcher& fetcher) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db,
+                           "SELECT url, icon_hash, etag, last_modified, checked FROM icon_sources s "
+                           "WHERE s.icon_hash IS NULL OR EXISTS (SELECT 1 FROM icons i WHERE i.hash = s.icon_hash);",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    auto text = [&](int col) {
+        const unsigned char* value = sqlite3_column_text(stmt, col);
+        return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+    };
+    std::vector<IconSource> sources;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        sources.push_back({text(0), text(1), text(2), text(3), sqlite3_column_int64(stmt, 4)});
+    }
+    sqlite3_finalize(stmt);
+    int count = (int)sources.size();
+    fetcher.Load(std::move(sources));
+    return count;
+}
+
+int SaveIconSources(sqlite3* db, const IconFetcher& fetcher) {
+    std::vector<IconSource> sources = fetcher.Sources();
+    if (sources.empty()) return 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db,
+                           "INSERT OR REPLACE INTO icon_sources (url, icon_hash, etag, last_modified, checked) "
+                           "VALUES (?, ?, ?, ?, ?);",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    bool ownTransaction = sqlite3_get_autocommit(db) != 0;
+    if (ownTransaction) sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+    int written = 0;
+    auto bindText = [&](int col, const std::string& value) {
+        if (value.empty()) {
+            sqlite3_bind_null(stmt, col);
+        } else {
+            sqlite3_bind_text(stmt, col, value.c_str(), -1, SQLITE_STATIC);
+        }
+    };
+    for (const IconSource& source : sources) {
+        bindText(1, source.url);
+        bindText(2, source.iconHash);
+        bindText(3, source.etag);
+        bindText(4, source.lastModified);
+        sqlite3_bind_int64(stmt, 5, source.checked);
+        if (sqlite3_step(stmt) == SQLITE_DONE) ++written;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (ownTransaction) sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    return written;
+}
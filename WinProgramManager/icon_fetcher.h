@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+// An absolute http(s) URL, split the way requests need it.
+struct HttpUrl {
+    std::string scheme;   // "http" or "https"
+    std::string host;     // lowercase
+    int port = 0;
+    std::string path;     // path and query, always starting with '/'; no fragment
+    std::string Origin() const;
+    std::string ToString() const { return Origin() + path; }
+};
+
+// Parse an absolute http(s) URL. False for anything else.
+bool ParseUrl(const std::string& text, HttpUrl& url);
+// `href` as written in a page at `base`, made absolute (HTML entities for &
+// decoded). False if it does not lead to an http(s) URL (data:, javascript:).
+bool ResolveUrl(const HttpUrl& base, const std::string& href, HttpUrl& out);
+
+struct HttpResponse {
+    int status = 0;              // 0 if no response arrived
+    std::string contentType, location, etag, lastModified;
+    std::string body;            // kept only when the request has no body callback
+    bool truncated = false;      // stopped reading at the byte limit
+};
+
+// HTTP/1.1 GET shared by the fetch threads; redirects are left to the caller.
+//
+// Windows uses one WinHTTP session, which keeps connections alive, pools them
+// per server and does TLS and decompression. The POSIX backend speaks plain
+// HTTP over sockets with its own keep-alive pool, so the fetcher can be run on
+// Linux against a local stand-in server. Either way at most
+// `connectionsPerHost` requests to one host run at a time.
+class HttpClient {
+public:
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+
+    explicit HttpClient(int timeoutMs = 5000, int connectionsPerHost = 2);
+    ~HttpClient();
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    // GET `url`. Body bytes go to onBody as they arrive (reading stops, and
+    // the connection is dropped, when it returns false) or, without onBody,
+    // into response.body; status and headers are set before the first call.
+    // At most `maxBytes` are read. False if no response arrived: no
+    // connection, timeout, or a scheme the backend cannot speak.
+    bool Get(const HttpUrl& url, const Headers& headers, size_t maxBytes, HttpResponse& response,
+             const std::function<bool(const char* data, size_t size)>& onBody = nullptr);
+
+    long long Requests() const { return requests_; }
+    // Connections opened; -1 where the backend does not tell (WinHTTP).
+    long long Connections() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+    std::atomic<long long> requests_{0};
+};
+
+// Finds the icon a page links to while the page is still downloading:
+// <link rel="icon"> or rel="shortcut icon", outside comments, scripts and
+// styles. Scanning ends at <body> or </head>, so the rest is never read.
+class IconLinkScanner {
+public:
+    // Feed the next piece of the page. Returns false once nothing more can be
+    // found.
+    bool Feed(const char* data, size_t size);
+    // href of the first linked icon that is not SVG (TranscodeIcon cannot
+    // read those), empty if there is none.
+    const std::string& Href() const { return href_; }
+
+private:
+    void Tag();
+
+    enum State { kText, kTag, kComment, kRawText } state_ = kText;
+    std::string tag_;        // tag text after '<', or the tail of a comment or raw text
+    std::string rawEnd_;     // "</script" or "</style" while in kRawText
+    std::string href_;
+    char quote_ = 0;             // inside a quoted attribute value
+    bool afterEquals_ = false;   // last non-space character of the tag was '='
+    bool done_ = false;
+};
+
+// An icon URL as fetched by an earlier run, kept in icon_sources.
+struct IconSource {
+    std::string url;
+    std::string iconHash;          // icons.hash of what it served; empty if it failed
+    std::string etag, lastModified;
+    int64_t checked = 0;           // unix time of the last request
+};
+
+struct FetchedIcon {
+    std::string url;                  // icon URL; empty if the page could not be read
+    std::vector<unsigned char> data;  // as served; empty if failed or unchanged
+    std::string storedHash;           // icons.hash of the stored copy, if the server says it is current
+};
+
+// Homepage favicons for the updater's fetch threads.
+//
+// Requests go through one HttpClient (kept-alive connections, bounded per
+// host). Within a run every homepage and icon URL is fetched once: packages
+// sharing a site get the cached result, and threads asking for a URL that is
+// in flight wait for it. A host that stops answering fails fast for the rest
+// of the run. Across runs, icon URLs remember their validators: a stored icon
+// is revalidated with If-None-Match / If-Modified-Since, and a failed one is
+// not retried for a week.
+class IconFetcher {
+public:
+    explicit IconFetcher(int timeoutMs = 5000, int connectionsPerHost = 2);
+
+    // Icon URLs of earlier runs; call before fetching.
+    void Load(std::vector<IconSource> sources);
+    // Thread-safe.
+    FetchedIcon Fetch(const std::string& homepage);
+    // `url` served the icon now stored as `hash`.
+    void Stored(const std::string& url, const std::string& hash);
+    // Icon URLs requested this run, to be kept for the next one.
+    std::vector<IconSource> Sources() const;
+
+    long long Requests() const { return http_.Requests(); }
+    long long Connections() const { return http_.Connections(); }
+    long long CacheHits() const { return cacheHits_; }
+    long long Revalidated() const { return revalidated_; }
+
+private:
+    // One homepage or icon URL within a run; filled in by the first thread
+    // asking for it.
+    struct Page {
+        bool done = false, busy = false;
+        std::string iconUrl;    // empty if the page failed
+    };
+    struct Icon {
+        bool done = false, busy = false;
+        IconSource source;
+        std::vector<unsigned char> data;
+        bool fetched = false;   // requested this run (not just loaded)
+        bool unchanged = false; // answered 304 for the stored copy
+        bool failed = false;
+    };
+
+    // The entry for `key`, computed by the first thread that asks
+    template <typename Entry, typename Compute>
+    std::shared_ptr<Entry> Once(std::map<std::string, std::shared_ptr<Entry>>& entries, const std::string& key,
+                                Compute compute);
+
+    bool GetFollowing(HttpUrl url, const HttpClient::Headers& headers, size_t maxBytes, HttpResponse& response,
+                      const std::function<bool(const char*, size_t)>& onBody, HttpUrl& finalUrl);
+    bool HostDead(const std::string& origin);
+    void HostAnswered(const std::string& origin, bool answered);
+    std::string ResolvePage(const std::string& homepage);
+    void FetchIcon(const std::string& url, Icon& icon);
+
+    HttpClient http_;
+    mutable std::mutex mutex_;
+    std::condition_variable done_;
+    std::map<std::string, std::shared_ptr<Page>> pages_;
+    std::map<std::string, std::shared_ptr<Icon>> icons_;
+    std::map<std::string, int> hostFailures_;   // per origin: transport failures in a row; -1 once it answered
+    std::atomic<long long> cacheHits_{0}, revalidated_{0};
+};
+
+// Load icon_sources into `fetcher`, dropping entries whose icon is no longer
+// stored. Returns the number loaded, -1 on error.
+int LoadIconSources(sqlite3* db, IconFetcher& fetcher);
+// Write the fetcher's sources back in one transaction. Returns the number
+// written, -1 on error.
+int SaveIconSources(sqlite3* db, const IconFetcher& fetcher);
@@ -0,0 +1,319 @@
+#include "icon_store.h"
+#include "icon_decoder.h"
+#include <sqlite3.h>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// FIPS 180-4 SHA-256
+class Sha256 {
+public:
+    Sha256() {
+        static const uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        for (int i = 0; i < 8; ++i) state_[i] = init[i];
+    }
+
+    void Update(const unsigned char* data, size_t size) {
+        length_ += size;
+        if (buffered_ > 0) {
+            while (size > 0 && buffered_ < 64) {
+                buffer_[buffered_++] = *data++;
+                size--;
+            }
+            if (buffered_ < 64) return;
+            Block(buffer_);
+            buffered_ = 0;
+        }
+        for (; size >= 64; data += 64, size -= 64) Block(data);
+        while (size > 0) {
+            buffer_[buffered_++] = *data++;
+            size--;
+        }
+    }
+
+    std::string HexDigest() {
+        uint64_t bits = length_ * 8;
+        unsigned char pad[72] = {0x80};
+        size_t padLength = (buffered_ < 56 ? 56 : 120) - buffered_;
+        for (int i = 0; i < 8; ++i) pad[padLength + i] = (unsigned char)(bits >> (56 - 8 * i));
+        Update(pad, padLength + 8);
+
+        static const char hex[] = "0123456789abcdef";
+        std::string digest;
+        digest.reserve(64);
+        for (uint32_t word : state_) {
+            for (int shift = 28; shift >= 0; shift -= 4) digest += hex[(word >> shift) & 0xF];
+        }
+        return digest;
+    }
+
+private:
+    static uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void Block(const unsigned char* p) {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+        uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state_[0] += a;
+        state_[1] += b;
+        state_[2] += c;
+        state_[3] += d;
+        state_[4] += e;
+        state_[5] += f;
+        state_[6] += g;
+        state_[7] += h;
+    }
+
+    uint32_t state_[8];
+    unsigned char buffer_[64];
+    size_t buffered_ = 0;
+    uint64_t length_ = 0;
+};
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+bool HasColumn(sqlite3* db, const char* table, const char* column) {
+    std::string sql = std::string("PRAGMA table_info(") + table + ");";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return false;
+    bool found = false;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* name = (const char*)sqlite3_column_text(stmt, 1);
+        found = name && sqlite3_stricmp(name, column) == 0;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int PragmaInt(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt;
+    int value = 0;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+// Move the inline icons of `ids` into icons; false on any failure.
+bool MoveInlineIcons(sqlite3* db, const std::vector<int>& ids, bool hasType) {
+    sqlite3_stmt* read = nullptr;
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_stmt* update = nullptr;
+    bool ok = sqlite3_prepare_v2(db, hasType ? "SELECT icon_data, icon_type FROM apps WHERE id = ?;"
+                                             : "SELECT icon_data, NULL FROM apps WHERE id = ?;",
+                                 -1, &read, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO icons (hash, type, data) VALUES (?, ?, ?);", -1, &insert,
+                                 nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, hasType ? "UPDATE apps SET icon_hash = ?, icon_data = NULL, icon_type = NULL WHERE id = ?;"
+                                             : "UPDATE apps SET icon_hash = ?, icon_data = NULL WHERE id = ?;",
+                                 -1, &update, nullptr) == SQLITE_OK;
+
+    for (size_t i = 0; ok && i < ids.size(); ++i) {
+        sqlite3_bind_int(read, 1, ids[i]);
+        if (sqlite3_step(read) == SQLITE_ROW) {
+            const unsigned char* data = (const unsigned char*)sqlite3_column_blob(read, 0);
+            int size = sqlite3_column_bytes(read, 0);
+            // Empty blobs are no icon
+            std::string hash;
+            if (data && size > 0) {
+                hash = IconHash(data, (size_t)size);
+                sqlite3_bind_text(insert, 1, hash.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(insert, 2, (const char*)sqlite3_column_text(read, 1), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_blob(insert, 3, data, size, SQLITE_STATIC);
+                ok = sqlite3_step(insert) == SQLITE_DONE;
+                sqlite3_reset(insert);
+                sqlite3_clear_bindings(insert);
+            }
+            if (ok) {
+                if (hash.empty()) {
+                    sqlite3_bind_null(update, 1);
+                } else {
+                    sqlite3_bind_text(update, 1, hash.c_str(), -1, SQLITE_STATIC);
+                }
+                sqlite3_bind_int(update, 2, ids[i]);
+                ok = sqlite3_step(update) == SQLITE_DONE;
+                sqlite3_reset(update);
+            }
+        }
+        sqlite3_reset(read);
+    }
+    sqlite3_finalize(read);
+    sqlite3_finalize(insert);
+    sqlite3_finalize(update);
+    return ok;
+}
+
+}  // namespace
+
+std::string IconHash(const unsigned char* data, size_t size) {
+    Sha256 sha;
+    sha.Update(data, size);
+    return sha.HexDigest();
+}
+
+int MigrateIconStore(sqlite3* db) {
+    if (!db) return -1;
+    bool hasInline = HasColumn(db, "apps", "icon_data");
+    bool hasType = HasColumn(db, "apps", "icon_type");
+    bool firstTime = !HasColumn(db, "apps", "icon_hash");
+
+    if (!Exec(db, "BEGIN IMMEDIATE;")) return -1;
+    bool ok = Exec(db, "CREATE TABLE IF NOT EXISTS icons (hash TEXT PRIMARY KEY, type TEXT, data BLOB NOT NULL);") &&
+              (!firstTime || Exec(db, "ALTER TABLE apps ADD COLUMN icon_hash TEXT;")) &&
+              Exec(db, "CREATE INDEX IF NOT EXISTS idx_apps_icon_hash ON apps(icon_hash);");
+
+    // Rows with an inline icon: all of them the first time, afterwards only
+    // those the build scripts wrote since
+    std::vector<int> ids;
+    if (ok && hasInline) {
+        sqlite3_stmt* stmt;
+        ok = sqlite3_prepare_v2(db, "SELECT id FROM apps WHERE icon_data IS NOT NULL;", -1, &stmt, nullptr) == SQLITE_OK;
+        if (ok) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) ids.push_back(sqlite3_column_int(stmt, 0));
+            sqlite3_finalize(stmt);
+        }
+    }
+    if (ok && !ids.empty()) ok = MoveInlineIcons(db, ids, hasType);
+
+    if (!ok) {
+        Exec(db, "ROLLBACK;");
+        return -1;
+    }
+    if (!Exec(db, "COMMIT;")) {
+        Exec(db, "ROLLBACK;");
+        return -1;
+    }
+
+    // Moving every icon leaves the apps pages mostly empty (SQLite reuses the
+    // freed ones for icons, so the free list alone does not show it); rebuild
+    // the file once then, and later only when a lot of it is free
+    if (!ids.empty()) {
+        int pages = PragmaInt(db, "PRAGMA page_count;");
+        int freePages = PragmaInt(db, "PRAGMA freelist_count;");
+        if (firstTime || (pages > 0 && freePages * 4 > pages)) Exec(db, "VACUUM;");
+    }
+    return (int)ids.size();
+}
+
+int PruneIcons(sqlite3* db) {
+    if (!db) return -1;
+    if (!Exec(db, "DELETE FROM icons WHERE hash NOT IN (SELECT icon_hash FROM apps WHERE icon_hash IS NOT NULL);")) {
+        return -1;
+    }
+    return sqlite3_changes(db);
+}
+
+int TranscodeStoredIcons(sqlite3* db) {
+    if (!db) return -1;
+
+    // Hashes first: rows are added and deleted as we go
+    std::vector<std::string> hashes;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT hash FROM icons WHERE type IS NOT ?;", -1, &stmt, nullptr) != SQLITE_OK) return -1;
+    sqlite3_bind_text(stmt, 1, kIconBitmapType, -1, SQLITE_STATIC);
+    while (sqlite3_step(stmt) == SQLITE_ROW) hashes.push_back((const char*)sqlite3_column_text(stmt, 0));
+    sqlite3_finalize(stmt);
+    if (hashes.empty()) return 0;
+
+    if (!Exec(db, "BEGIN IMMEDIATE;")) return -1;
+    sqlite3_stmt* read = nullptr;
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_stmt* relink = nullptr;
+    sqlite3_stmt* remove = nullptr;
+    bool ok = sqlite3_prepare_v2(db, "SELECT data FROM icons WHERE hash = ?;", -1, &read, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO icons (hash, type, data) VALUES (?, ?, ?);", -1, &insert,
+                                 nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, "UPDATE apps SET icon_hash = ? WHERE icon_hash = ?;", -1, &relink, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, "DELETE FROM icons WHERE hash = ?;", -1, &remove, nullptr) == SQLITE_OK;
+
+    int transcoded = 0;
+    std::vector<unsigned char> bitmap;
+    for (size_t i = 0; ok && i < hashes.size(); ++i) {
+        const std::string& hash = hashes[i];
+        sqlite3_bind_text(read, 1, hash.c_str(), -1, SQLITE_STATIC);
+        bool readable = false;
+        if (sqlite3_step(read) == SQLITE_ROW) {
+            const unsigned char* data = (const unsigned char*)sqlite3_column_blob(read, 0);
+            readable = TranscodeIcon(data, (size_t)sqlite3_column_bytes(read, 0), bitmap);
+        }
+        sqlite3_reset(read);
+
+        // Point the apps at the bitmap (or at nothing), then drop the original
+        std::string bitmapHash;
+        if (readable) {
+            bitmapHash = IconHash(bitmap.data(), bitmap.size());
+            sqlite3_bind_text(insert, 1, bitmapHash.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(insert, 2, kIconBitmapType, -1, SQLITE_STATIC);
+            sqlite3_bind_blob(insert, 3, bitmap.data(), (int)bitmap.size(), SQLITE_STATIC);
+            ok = sqlite3_step(insert) == SQLITE_DONE;
+            sqlite3_reset(insert);
+            transcoded++;
+        }
+        if (ok) {
+            if (readable) {
+                sqlite3_bind_text(relink, 1, bitmapHash.c_str(), -1, SQLITE_STATIC);
+            } else {
+                sqlite3_bind_null(relink, 1);
+            }
+            sqlite3_bind_text(relink, 2, hash.c_str(), -1, SQLITE_STATIC);
+            ok = sqlite3_step(relink) == SQLITE_DONE;
+            sqlite3_reset(relink);
+        }
+        if (ok && bitmapHash != hash) {
+            sqlite3_bind_text(remove, 1, hash.c_str(), -1, SQLITE_STATIC);
+            ok = sqlite3_step(remove) == SQLITE_DONE;
+            sqlite3_reset(remove);
+        }
+    }
+    sqlite3_finalize(read);
+    sqlite3_finalize(insert);
+    sqlite3_finalize(relink);
+    sqlite3_finalize(remove);
+
+    if (!ok) {
+        Exec(db, "ROLLBACK;");
+        return -1;
+    }
+    if (!Exec(db, "COMMIT;")) {
+        Exec(db, "ROLLBACK;");
+        return -1;
+    }
+    int pages = PragmaInt(db, "PRAGMA page_count;");
+    int freePages = PragmaInt(db, "PRAGMA freelist_count;");
+    if (pages > 0 && freePages * 4 > pages) Exec(db, "VACUUM;");
+    return transcoded;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+// App icons are stored once per distinct image:
+//
+//   icons(hash TEXT PRIMARY KEY, type TEXT, data BLOB)
+//   apps.icon_hash -> icons.hash
+//
+// The hash is the lowercase hex SHA-256 of the data, so packages sharing a
+// favicon (same publisher or homepage) share one row, and scans of apps no
+// longer page through icon blobs. apps.icon_data/icon_type are kept (NULL) so
+// the PowerShell build scripts can still write icons inline; MigrateIconStore
+// moves whatever they wrote into icons the next time the database is opened.
+
+// Lowercase hex SHA-256 of `data`.
+std::string IconHash(const unsigned char* data, size_t size);
+
+// Create the icons table and apps.icon_hash when missing and move every inline
+// apps.icon_data into icons. Compacts the file when that left most of it free.
+// Returns the number of apps whose icon was moved, -1 on error.
+int MigrateIconStore(sqlite3* db);
+
+// Delete icons no app refers to any more. Returns the number deleted, -1 on error.
+int PruneIcons(sqlite3* db);
+
+// Transcode every stored icon that is not an icon bitmap yet (see
+// TranscodeIcon); apps whose icon cannot be read lose it. Compacts the file
+// when that freed a lot of it. Returns the number of icons transcoded, -1 on error.
+int TranscodeStoredIcons(sqlite3* db);
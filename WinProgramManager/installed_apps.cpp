@@ -1,4 +1,7 @@
 #include "installed_apps.h"
+#include "process_runner.h"
+#include "uninstall_index.h"
+#include "winget_index.h"
 #include <windows.h>
 #include <set>
 #include <string>
@@ -11,14 +14,17 @@
 // Static module-level state
 static bool g_installedFilterActive = false;
 static std::set<std::wstring> g_installedPackageIds;
+static unsigned g_installedGeneration = 0;
 
 void InitInstalledApps() {
     g_installedFilterActive = false;
     g_installedPackageIds.clear();
+    g_installedGeneration++;
 }
 
 void LoadInstalledPackageIds(sqlite3* db) {
     g_installedPackageIds.clear();
+    g_installedGeneration++;
     if (!db) return;
     
     sqlite3_stmt* stmt;
@@ -54,139 +60,23 @@ void SetInstalledFilterActive(bool active) {
 
 void ClearInstalledApps() {
     g_installedPackageIds.clear();
+    g_installedGeneration++;
 }
 
 size_t GetInstalledPackageCount() {
     return g_installedPackageIds.size();
 }
 
-// Helper to check if a package ID exists in Windows registry
-static bool IsInstalledInRegistry(const std::string& packageId) {
-    // Convert package ID to wide string
-    int wsize = MultiByteToWideChar(CP_UTF8, 0, packageId.c_str(), -1, nullptr, 0);
-    if (wsize <= 0) return false;
-    std::wstring wPackageId(wsize - 1, L'\0');
-    MultiByteToWideChar(CP_UTF8, 0, packageId.c_str(), -1, &wPackageId[0], wsize);
-    
-    // Normalize package ID for matching (lowercase, remove special chars)
-    auto normalize = [](const std::wstring& str) -> std::wstring {
-        std::wstring result;
-        for (wchar_t c : str) {
-            wchar_t lower = towlower(c);
-            if ((lower >= L'a' && lower <= L'z') || (lower >= L'0' && lower <= L'9')) {
-                result += lower;
-            }
-        }
-        return result;
-    };
-    
-    // Split package ID by dot (e.g., "7zip.7zip" -> ["7zip", "7zip"])
-    std::wstring pkgNorm = normalize(wPackageId);
-    std::vector<std::wstring> pkgParts;
-    size_t dotPos = wPackageId.find(L'.');
-    if (dotPos != std::wstring::npos) {
-        pkgParts.push_back(normalize(wPackageId.substr(0, dotPos)));
-        pkgParts.push_back(normalize(wPackageId.substr(dotPos + 1)));
-    } else {
-        pkgParts.push_back(pkgNorm);
-    }
-    
-    // Check both registry locations for installed programs
-    const wchar_t* uninstallKeys[] = {
-        L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall",
-        L"SOFTWARE\\WOW6432Node\\Microsoft\\Windows\\CurrentVersion\\Uninstall"
-    };
-    
-    for (int i = 0; i < 2; i++) {
-        HKEY hKey;
-        if (RegOpenKeyExW(HKEY_LOCAL_MACHINE, uninstallKeys[i], 0, KEY_READ, &hKey) == ERROR_SUCCESS) {
-            DWORD index = 0;
-            wchar_t subKeyName[256];
-            DWORD subKeyLen = 256;
-            
-            while (RegEnumKeyExW(hKey, index++, subKeyName, &subKeyLen, NULL, NULL, NULL, NULL) == ERROR_SUCCESS) {
-                HKEY hSubKey;
-                if (RegOpenKeyExW(hKey, subKeyName, 0, KEY_READ, &hSubKey) == ERROR_SUCCESS) {
-                    // Check DisplayName
-                    wchar_t displayName[512] = {0};
-                    DWORD displayNameSize = sizeof(displayName);
-                    RegQueryValueExW(hSubKey, L"DisplayName", NULL, NULL, (LPBYTE)displayName, &displayNameSize);
-                    
-                    // Check Publisher
-                    wchar_t publisher[256] = {0};
-                    DWORD publisherSize = sizeof(publisher);
-                    RegQueryValueExW(hSubKey, L"Publisher", NULL, NULL, (LPBYTE)publisher, &publisherSize);
-                    
-                    // Normalize display name and publisher
-                    std::wstring nameNorm = normalize(displayName);
-                    std::wstring pubNorm = normalize(publisher);
-                    
-                    // Match if any part of package ID appears in display name or publisher
-                    bool matched = false;
-                    for (const auto& part : pkgParts) {
-                        if (!part.empty() && (nameNorm.find(part) != std::wstring::npos || 
-                                             pubNorm.find(part) != std::wstring::npos)) {
-                            matched = true;
-                            break;
-                        }
-                    }
-                    
-                    // Also check if the full normalized package ID is in the name
-                    if (!matched && !pkgNorm.empty() && nameNorm.find(pkgNorm) != std::wstring::npos) {
-                        matched = true;
-                    }
-                    
-                    RegCloseKey(hSubKey);
-                    
-                    if (matched) {
-                        RegCloseKey(hKey);
-                        return true;
-                    }
-                }
-                subKeyLen = 256;
-            }
-            RegCloseKey(hKey);
-        }
-    }
-    
-    // Also check current user registry
-    HKEY hUserKey;
-    if (RegOpenKeyExW(HKEY_CURRENT_USER, L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall", 0, KEY_READ, &hUserKey) == ERROR_SUCCESS) {
-        DWORD index = 0;
-        wchar_t subKeyName[256];
-        DWORD subKeyLen = 256;
-        
-        while (RegEnumKeyExW(hUserKey, index++, subKeyName, &subKeyLen, NULL, NULL, NULL, NULL) == ERROR_SUCCESS) {
-            HKEY hSubKey;
-            if (RegOpenKeyExW(hUserKey, subKeyName, 0, KEY_READ, &hSubKey) == ERROR_SUCCESS) {
-                wchar_t displayName[512] = {0};
-                DWORD displayNameSize = sizeof(displayName);
-                RegQueryValueExW(hSubKey, L"DisplayName", NULL, NULL, (LPBYTE)displayName, &displayNameSize);
-                
-                std::wstring nameNorm = normalize(displayName);
-                
-                // Check any part
-                bool matched = false;
-                for (const auto& part : pkgParts) {
-                    if (!part.empty() && nameNorm.find(part) != std::wstring::npos) {
-                        matched = true;
-                        break;
-                    }
-                }
-                
-                RegCloseKey(hSubKey);
-                
-                if (matched) {
-                    RegCloseKey(hUserKey);
-                    return true;
-                }
-            }
-            subKeyLen = 256;
-        }
-        RegCloseKey(hUserKey);
-    }
-    
-    return false;
+unsigned GetInstalledGeneration() {
+    return g_installedGeneration;
+}
+
+// This machine's Uninstall entries, attributed by winget's product codes where
+// its source index can be read and by name otherwise
+static void BuildInstalledCorrelator(InstalledCorrelator& correlator) {
+    std::string indexPath = WingetIndexReader::FindInstalledIndex();
+    if (!indexPath.empty()) LoadProductCodes(indexPath, correlator);
+    correlator.Build(ReadUninstallEntries());
 }
 
 void SyncInstalledAppsWithWinget(sqlite3* db) {
@@ -226,8 +116,10 @@ void SyncInstalledAppsWithWinget(sqlite3* db) {
     std::set<std::string> toRemove;
     
     // Check each package to see if it's actually installed
+    InstalledCorrelator correlator;
+    BuildInstalledCorrelator(correlator);
     for (const std::string& pkgId : allPackages) {
-        bool isInstalled = IsInstalledInRegistry(pkgId);
+        bool isInstalled = correlator.IsInstalled(pkgId);
         bool isMarkedInstalled = dbInstalledPackages.count(pkgId) > 0;
         
         if (isInstalled && !isMarkedInstalled) {
@@ -302,8 +194,10 @@ void CleanupInstalledApps(sqlite3* db) {
     
     // Check each installed package against registry
     std::vector<std::string> toRemove;
+    InstalledCorrelator correlator;
+    BuildInstalledCorrelator(correlator);
     for (const std::string& pkgId : installedPackages) {
-        if (!IsInstalledInRegistry(pkgId)) {
+        if (!correlator.IsInstalled(pkgId)) {
             toRemove.push_back(pkgId);
         }
     }
@@ -332,50 +226,12 @@ void CleanupInstalledApps(sqlite3* db) {
 bool DiscoverInstalledApps(sqlite3* db) {
     if (!db) return false;
     
-    // Execute winget list command
-    HANDLE hStdoutRead = NULL, hStdoutWrite = NULL;
-    SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), NULL, TRUE };
-    
-    if (!CreatePipe(&hStdoutRead, &hStdoutWrite, &sa, 0)) {
-        return false;
-    }
-    
-    SetHandleInformation(hStdoutRead, HANDLE_FLAG_INHERIT, 0);
-    
-    STARTUPINFOW si = {};
-    si.cb = sizeof(si);
-    si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
-    si.hStdOutput = hStdoutWrite;
-    si.hStdError = hStdoutWrite;
-    si.wShowWindow = SW_HIDE;
-    
-    PROCESS_INFORMATION pi = {};
-    
-    std::wstring cmdLine = L"winget list --accept-source-agreements";
-    
-    if (!CreateProcessW(NULL, &cmdLine[0], NULL, NULL, TRUE, CREATE_NO_WINDOW, 
-                        NULL, NULL, &si, &pi)) {
-        CloseHandle(hStdoutWrite);
-        CloseHandle(hStdoutRead);
-        return false;
-    }
-    
-    CloseHandle(hStdoutWrite);
-    
-    // Read output
-    std::string output;
-    char buffer[4096];
-    DWORD bytesRead;
-    
-    while (ReadFile(hStdoutRead, buffer, sizeof(buffer) - 1, &bytesRead, NULL) && bytesRead > 0) {
-        buffer[bytesRead] = '\0';
-        output += buffer;
-    }
-    
-    WaitForSingleObject(pi.hProcess, INFINITE);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-    CloseHandle(hStdoutRead);
+    // Execute winget list command (drained while it runs; killed if it hangs)
+    ProcessOptions opts;
+    opts.timeoutMs = 120000;
+    ProcessResult res = RunProcess(L"winget list --accept-source-agreements", opts);
+    if (res.timedOut()) return false;
+    std::string output = std::move(res.output);
     
     if (output.empty()) {
         return false;
@@ -23,6 +23,10 @@ void ClearInstalledApps();
 // Get the count of installed packages (for debugging)
 size_t GetInstalledPackageCount();
 
+// Changes every time the in-memory installed set is reloaded or cleared, so
+// callers holding a copy of it know when to refresh
+unsigned GetInstalledGeneration();
+
 // Sync installed apps with winget (query actual installed packages and update database)
 void SyncInstalledAppsWithWinget(sqlite3* db);
 
@@ -15,6 +15,7 @@
 #include <thread>
 #include <atomic>
 #include <regex>
+#include <memory>
 #include "resource.h"
 #include "search.h"
 #include "installed_apps.h"
@@ -24,6 +25,11 @@
 #include "task_scheduler.h"
 #include "settings_dialog.h"
 #include "ini_utils.h"
+#include "catalog.h"
+#include "icon_cache.h"
+#include "icon_store.h"
+#include "schema.h"
+#include "search_index.h"
 
 // Bring the given window to the user's foreground reliably (temporary attach input)
 static void BringWindowToFront(HWND hwnd) {
@@ -93,6 +99,7 @@ bool g_searchCaseSensitive = false;
 bool g_searchExactMatch = false;
 bool g_searchUseRegex = false;
 bool g_searchRefineResults = false;
+AppBitset g_searchMatches;  // apps the active search found (all of them without an app filter)
 std::vector<std::wstring> g_filteredCategories;
 std::vector<std::wstring> g_allCategories;  // Store all categories for reset
 
@@ -239,30 +246,25 @@ DWORD WINAPI LoadingDialogThread(LPVOID lpParam) {
 int g_splitterPos = 300;  // Initial splitter position
 bool g_draggingSplitter = false;
 std::wstring g_selectedTag = L"All";
-std::map<int, std::vector<unsigned char>> g_iconCache;
+std::unique_ptr<IconCache> g_iconCache;  // App icons, decoded as rows become visible
 std::vector<std::wstring*> g_tagTextBuffers;  // Persistent storage for TreeView text
 
 // Structures
-struct AppInfo {
-    int id;
-    std::wstring packageId;
-    std::wstring name;
-    std::wstring version;
-    std::wstring publisher;
-    std::wstring homepage;
-    int iconIndex;
-    std::vector<std::wstring> categories; // Categories this app belongs to
-};
-
 struct TagInfo {
     std::wstring name;
     int count;
 };
 
-// In-memory data cache for fast searching (declared after AppInfo)
-std::vector<AppInfo> g_allApps;  // All apps loaded into memory (metadata only, not icons)
-std::vector<std::wstring> g_allCategoryNames;  // All unique category names
-std::map<std::wstring, std::vector<int>> g_categoryToAppIds;  // Map category name to app IDs
+// In-memory data cache for fast searching: all apps (metadata only, not icons) and categories
+AppCatalog g_catalog;
+// Catalog index of every app list row; the list is owner-data and asks for the
+// text and icon of visible rows only
+std::vector<uint32_t> g_appRows;
+// Text index over g_catalog for the search dialog, built on first search
+SearchIndex g_searchIndex;
+// installed_apps generation the catalog's installed set was last taken from
+unsigned g_catalogInstalledGeneration = 0;
+bool g_catalogInstalledStale = true;
 
 // Forward declarations
 INT_PTR CALLBACK SearchDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam);
@@ -300,16 +302,20 @@ void ResizeControls(HWND hwnd);
 bool OpenDatabase();
 void CloseDatabase();
 void LoadAllDataIntoMemory();  // Load all apps and categories into memory for fast search
-void LoadAllIcons();  // Load all app icons into ImageList (call after ImageList is created)
+void StartIconCache(HWND hwnd);  // Start decoding app icons on demand (call after ImageList is created)
+void InstallAppIcon(int slot, const IconPixels& pixels);  // Put a decoded icon into the ImageList
+int AppIconImage(size_t app);  // ImageList index for a catalog app (0 until decoded)
+void ShowAppRows(std::vector<uint32_t> rows);
 void LoadInstalledPackageIds();  // Load installed package IDs from database
 HBITMAP LoadIconFromBlob(const std::vector<unsigned char>& data, const std::wstring& type);
-HICON LoadIconFromMemory(const unsigned char* data, int size);
 void OnTagSelectionChanged();
 void OnAppDoubleClick();
 void OnLanguageChanged();
 void ExecuteSearch();
 void EndSearch();
 bool MatchString(const std::wstring& text, const std::wstring& pattern);
+std::vector<uint32_t> FindApps(const std::wstring& query);
+void SyncCatalogInstalled();
 bool LoadLocale(const std::wstring& lang);
 std::wstring FormatNumber(int num);
 std::wstring CapitalizeFirst(const std::wstring& str);
@@ -641,73 +647,90 @@ bool MatchString(const std::wstring& text, const std::wstring& pattern) {
     }
 }
 
+// Catalog indexes of the apps matching the search dialog's app filter, best
+// match first. Regular expressions are tried against app names.
+std::vector<uint32_t> FindApps(const std::wstring& query) {
+    std::vector<uint32_t> apps;
+    if (g_searchUseRegex && !query.empty()) {
+        try {
+            std::wregex re(query, std::regex_constants::icase);
+            for (size_t app = 0; app < g_catalog.AppCount(); app++) {
+                if (std::regex_search(g_catalog.Name(app), re)) apps.push_back((uint32_t)app);
+            }
+        } catch (...) {
+            // Invalid regex matches nothing
+        }
+        return apps;
+    }
+    
+    if (g_searchIndex.Empty()) {
+        g_searchIndex.Build(g_catalog, g_db);
+    }
+    SearchOptions options;
+    options.caseSensitive = g_searchCaseSensitive;
+    options.exactMatch = g_searchExactMatch;
+    return g_searchIndex.Search(query, options);
+}
+
 // Execute search based on current criteria
 void ExecuteSearch() {
-    if (g_allApps.empty()) return;  // No data loaded
+    if (g_catalog.Empty()) return;  // No data loaded
     
     // Populate g_allCategories if empty (for potential future use)
     if (g_allCategories.empty()) {
-        g_allCategories = g_allCategoryNames;
+        g_allCategories = g_catalog.CategoryNames();
     }
     
+    // "Search in Results" narrows the active search instead of starting over
+    bool refine = g_searchActive && g_searchRefineResults;
+    std::vector<std::wstring> previousCategories;
+    if (refine) previousCategories.swap(g_filteredCategories);
+    
     // Clear previous results
     g_filteredCategories.clear();
     ListView_DeleteAllItems(g_hTagTree);
     
-    // Determine which categories to search
-    std::vector<std::wstring> categoriesToSearch;
+    // Apps matching the app filter, as a set over the catalog
+    AppBitset matches(g_catalog.AppCount(), g_searchAppFilter.empty());
+    if (!g_searchAppFilter.empty()) {
+        for (uint32_t app : FindApps(g_searchAppFilter)) matches.Set(app);
+    }
+    if (refine && g_searchMatches.Size() == matches.Size()) {
+        matches &= g_searchMatches;
+    }
+    g_searchMatches = matches;
     
-    if (!g_searchCategoryFilter.empty()) {
-        // Filter categories based on search criteria (in-memory)
-        for (const auto& category : g_allCategoryNames) {
-            if (MatchString(category, g_searchCategoryFilter)) {
-                categoriesToSearch.push_back(category);
-            }
-        }
-    } else {
-        // No category filter - use all categories
-        categoriesToSearch = g_allCategoryNames;
+    // Count matching apps of every category at once (installed ones only when
+    // the installed filter is on)
+    if (IsInstalledFilterActive()) {
+        SyncCatalogInstalled();
+        matches &= g_catalog.InstalledApps();
     }
+    std::vector<int> matchingAppCounts = g_catalog.CategoryCounts(matches);
     
-    // Now filter by app name if specified, and count matching apps per category
     int displayIndex = 0;
-    for (const auto& category : categoriesToSearch) {
-        int matchingAppCount = 0;
+    for (size_t categoryIndex = 0; categoryIndex < g_catalog.CategoryCount(); categoryIndex++) {
+        const std::wstring& category = g_catalog.CategoryName(categoryIndex);
         
-        // Get app IDs for this category
-        auto it = g_categoryToAppIds.find(category);
-        if (it != g_categoryToAppIds.end()) {
-            for (int appId : it->second) {
-                // Find the app in g_allApps
-                for (const auto& app : g_allApps) {
-                    if (app.id == appId) {
-                        // Check if app matches app filter (if any)
-                        if (g_searchAppFilter.empty() || MatchString(app.name, g_searchAppFilter)) {
-                            matchingAppCount++;
-                        }
-                        break;
-                    }
-                }
-            }
-        }
+        // Only categories with matching apps, matching the category filter
+        if (matchingAppCounts[categoryIndex] == 0) continue;
+        if (!g_searchCategoryFilter.empty() && !MatchString(category, g_searchCategoryFilter)) continue;
+        if (refine && !std::binary_search(previousCategories.begin(), previousCategories.end(), category)) continue;
         
-        // Only add category if it has matching apps
-        if (matchingAppCount > 0) {
-            g_filteredCategories.push_back(category);
-            
-            // Add to ListView
-            std::wstring* displayText = new std::wstring(L"   " + category);
-            g_tagTextBuffers.push_back(displayText);
-            
-            LVITEMW lvi = {};
-            lvi.mask = LVIF_TEXT | LVIF_PARAM | LVIF_IMAGE;
-            lvi.iItem = displayIndex++;
-            lvi.iSubItem = 0;
-            lvi.pszText = (LPWSTR)displayText->c_str();
-            lvi.lParam = (LPARAM)displayText;
-            lvi.iImage = 0; // Closed folder
-            ListView_InsertItem(g_hTagTree, &lvi);
-        }
+        g_filteredCategories.push_back(category);
+        
+        // Add to ListView
+        std::wstring* displayText = new std::wstring(L"   " + category);
+        g_tagTextBuffers.push_back(displayText);
+        
+        LVITEMW lvi = {};
+        lvi.mask = LVIF_TEXT | LVIF_PARAM | LVIF_IMAGE;
+        lvi.iItem = displayIndex++;
+        lvi.iSubItem = 0;
+        lvi.pszText = (LPWSTR)displayText->c_str();
+        lvi.lParam = (LPARAM)displayText;
+        lvi.iImage = 0; // Closed folder
+        ListView_InsertItem(g_hTagTree, &lvi);
     }
     
     // Update category count
@@ -716,18 +739,18 @@ void ExecuteSearch() {
     std::wstring countText = FormatNumber(categoryCount) + L" " + g_locale.categories;
     SetWindowTextW(g_hTagCountLabel, countText.c_str());
     
+    // Mark search as active (LoadApps then only lists the matches)
+    g_searchActive = true;
+    
     // Select first category if any results
     if (categoryCount > 0) {
         ListView_SetItemState(g_hTagTree, 0, LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
         OnTagSelectionChanged();
     } else {
-        ListView_DeleteAllItems(g_hAppList);
+        ShowAppRows({});
         SetWindowTextW(g_hAppCountLabel, (L"0 " + g_locale.apps).c_str());
     }
     
-    // Mark search as active
-    g_searchActive = true;
-    
     // Show End Search button
     ShowWindow(g_hEndSearchBtn, SW_SHOW);
     ResizeControls(g_mainWindow);
@@ -773,6 +796,7 @@ void EndSearch() {
     g_searchExactMatch = false;
     g_searchUseRegex = false;
     g_searchRefineResults = false;
+    g_searchMatches = AppBitset();
     g_filteredCategories.clear();
     
     // Do the work on main thread (these are UI operations)
@@ -858,6 +882,14 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             return 0;
         }
         
+        case WM_USER + 3: {
+            // Icon decoder finished some icons - show them
+            if (g_iconCache && g_iconCache->Collect(InstallAppIcon)) {
+                InvalidateRect(g_hAppList, NULL, FALSE);
+            }
+            return 0;
+        }
+        
         case WM_USER: {
             // Database loaded - create controls and load data
             CreateControls(hwnd);
@@ -870,8 +902,8 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 InvalidateRect(g_hAboutBtn, NULL, TRUE);
             }
             
-            // Load all icons into ImageList (must happen after ImageList is created)
-            LoadAllIcons();
+            // Icons are decoded in the background as rows become visible
+            StartIconCache(hwnd);
             
             // Load data into controls
             LoadTags();
@@ -1071,21 +1103,40 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             }
             else if (nmhdr->idFrom == ID_APP_LIST && nmhdr->code == LVN_GETDISPINFOW) {
                 NMLVDISPINFOW* pDispInfo = (NMLVDISPINFOW*)lParam;
-                AppInfo* app = (AppInfo*)pDispInfo->item.lParam;
+                if (pDispInfo->item.iItem < 0 || (size_t)pDispInfo->item.iItem >= g_appRows.size()) return 0;
+                size_t app = g_appRows[pDispInfo->item.iItem];
                 
                 if (pDispInfo->item.mask & LVIF_TEXT) {
+                    static std::wstring displayName;
                     switch (pDispInfo->item.iSubItem) {
-                        case 0: // Name
-                            pDispInfo->item.pszText = (LPWSTR)app->name.c_str();
+                        case 0: // Name, with spaces before it for spacing from icon
+                            displayName = L"   " + g_catalog.Name(app);
+                            pDispInfo->item.pszText = (LPWSTR)displayName.c_str();
                             break;
                         case 1: // Version
-                            pDispInfo->item.pszText = (LPWSTR)app->version.c_str();
+                            pDispInfo->item.pszText = (LPWSTR)g_catalog.Version(app).c_str();
                             break;
                         case 2: // Publisher
-                            pDispInfo->item.pszText = (LPWSTR)app->publisher.c_str();
+                            pDispInfo->item.pszText = (LPWSTR)g_catalog.Publisher(app).c_str();
                             break;
                     }
                 }
+                if (pDispInfo->item.mask & LVIF_IMAGE) {
+                    pDispInfo->item.iImage = AppIconImage(app);
+                }
+            }
+            else if (nmhdr->idFrom == ID_APP_LIST && nmhdr->code == LVN_ODFINDITEMW) {
+                // Type-ahead: next row from iStart whose name starts with the typed text
+                NMLVFINDITEMW* pFind = (NMLVFINDITEMW*)lParam;
+                if (!(pFind->lvfi.flags & LVFI_STRING) || !pFind->lvfi.psz || g_appRows.empty()) return -1;
+                size_t length = wcslen(pFind->lvfi.psz);
+                size_t start = pFind->iStart >= 0 && (size_t)pFind->iStart < g_appRows.size() ? pFind->iStart : 0;
+                for (size_t n = 0; n < g_appRows.size(); n++) {
+                    size_t row = (start + n) % g_appRows.size();
+                    const std::wstring& name = g_catalog.Name(g_appRows[row]);
+                    if (name.size() >= length && _wcsnicmp(name.c_str(), pFind->lvfi.psz, length) == 0) return (LRESULT)row;
+                }
+                return -1;
             }
             return 0;
         }
@@ -1323,6 +1374,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         }
 
         case WM_DESTROY:
+            g_iconCache.reset();
             CloseDatabase();
             if (g_hFont) DeleteObject(g_hFont);
             if (g_hBoldFont) DeleteObject(g_hBoldFont);
@@ -1841,7 +1893,7 @@ void CreateControls(HWND hwnd) {
         WS_EX_CLIENTEDGE,
         WC_LISTVIEW,
         L"",
-        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS,
+        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS | LVS_OWNERDATA,
         0, 0, 0, 0,
         hwnd,
         (HMENU)ID_APP_LIST,
@@ -2070,6 +2122,11 @@ bool OpenDatabase() {
         return false;
     }
     
+    // Icons live in their own table; move any still inline in apps there
+    MigrateIconStore(g_db);
+    // Tables and indexes added since the build scripts' schema
+    MigrateSchema(g_db);
+    
     // Test query to verify database has data
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(g_db, "SELECT COUNT(*) FROM apps;", -1, &stmt, nullptr) != SQLITE_OK) {
@@ -2102,95 +2159,26 @@ void CloseDatabase() {
 void LoadAllDataIntoMemory() {
     if (!g_db) return;
     
-    // Clear existing data
-    g_allApps.clear();
-    g_allCategoryNames.clear();
-    g_categoryToAppIds.clear();
-    
-    // Load all apps metadata (icons loaded separately after ImageList is created)
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, package_id, name, version, publisher, homepage FROM apps WHERE name IS NOT NULL AND TRIM(name) != '' ORDER BY name;";
-    
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            AppInfo app;
-            app.id = sqlite3_column_int(stmt, 0);
-            app.iconIndex = 0;  // Default to brown package icon (index 0)
-            
-            // Convert UTF-8 to wide strings
-            auto convert = [](const char* utf8) -> std::wstring {
-                if (!utf8 || !utf8[0]) return L"";
-                
-                int wsize = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8, -1, nullptr, 0);
-                if (wsize == 0) {
-                    wsize = MultiByteToWideChar(CP_ACP, 0, utf8, -1, nullptr, 0);
-                    if (wsize == 0) return L"";
-                    std::wstring result(wsize - 1, 0);
-                    MultiByteToWideChar(CP_ACP, 0, utf8, -1, &result[0], wsize);
-                    return result;
-                }
-                std::wstring result(wsize - 1, 0);
-                MultiByteToWideChar(CP_UTF8, 0, utf8, -1, &result[0], wsize);
-                return result;
-            };
-            
-            app.packageId = convert((const char*)sqlite3_column_text(stmt, 1));
-            app.name = convert((const char*)sqlite3_column_text(stmt, 2));
-            app.version = convert((const char*)sqlite3_column_text(stmt, 3));
-            app.publisher = convert((const char*)sqlite3_column_text(stmt, 4));
-            app.homepage = convert((const char*)sqlite3_column_text(stmt, 5));
-            
-            g_allApps.push_back(app);
-        }
-        sqlite3_finalize(stmt);
-    }
-    
-    // Load all categories and build app-category associations
-    const char* catSql = "SELECT c.category_name, ac.app_id FROM categories c " 
-                         "JOIN app_categories ac ON c.id = ac.category_id " 
-                         "ORDER BY c.category_name;";
-    
-    std::set<std::wstring> uniqueCategories;
-    
-    if (sqlite3_prepare_v2(g_db, catSql, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            const char* catName = (const char*)sqlite3_column_text(stmt, 0);
-            int appId = sqlite3_column_int(stmt, 1);
-            
-            if (!catName || !catName[0]) continue;
-            
-            // Convert to wide string
-            int wsize = MultiByteToWideChar(CP_UTF8, 0, catName, -1, nullptr, 0);
-            if (wsize <= 1) continue;
-            std::wstring categoryName(wsize - 1, 0);
-            MultiByteToWideChar(CP_UTF8, 0, catName, -1, &categoryName[0], wsize);
-            
-            // Trim and capitalize
-            size_t first = categoryName.find_first_not_of(L" \t\r\n");
-            if (first == std::wstring::npos) continue;
-            size_t last = categoryName.find_last_not_of(L" \t\r\n");
-            categoryName = categoryName.substr(first, last - first + 1);
-            categoryName = CapitalizeFirst(categoryName);
-            
-            uniqueCategories.insert(categoryName);
-            g_categoryToAppIds[categoryName].push_back(appId);
-            
-            // Add category to the app's categories list
-            for (auto& app : g_allApps) {
-                if (app.id == appId) {
-                    app.categories.push_back(categoryName);
-                    break;
-                }
-            }
-        }
-        sqlite3_finalize(stmt);
-    }
-    
-    // Convert set to vector for easier access
-    g_allCategoryNames.assign(uniqueCategories.begin(), uniqueCategories.end());
+    // Apps, categories and the links between them, indexed by AppCatalog
+    g_catalog.Load(g_db);
+    // App indexes may have changed; the search index is rebuilt on next search
+    g_searchIndex.Clear();
+    g_catalogInstalledStale = true;
+    // So are the rows of the app list
+    if (g_hAppList) ShowAppRows({});
+    // Icon ids may have changed; decoded icons belong to the old ones
+    if (g_iconCache) g_iconCache->Reset();
+}
+
+// Take the installed flags of the catalog from installed_apps again if that was
+// reloaded since (or the catalog was)
+void SyncCatalogInstalled() {
+    if (!g_catalogInstalledStale && g_catalogInstalledGeneration == GetInstalledGeneration()) return;
+    g_catalog.RefreshInstalled(IsPackageInstalled);
+    g_catalogInstalledGeneration = GetInstalledGeneration();
+    g_catalogInstalledStale = false;
 }
 
-// Load all app icons into ImageList (must be called after ImageList is created)
 // Dialog procedure for icon loading dialog
 INT_PTR CALLBACK IconLoadingDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam) {
     static int spinnerFrame = 0;
@@ -2290,52 +2278,71 @@ INT_PTR CALLBACK IconLoadingDialogProc(HWND hDlg, UINT message, WPARAM wParam, L
     return FALSE;
 }
 
-void LoadAllIcons() {
+void StartIconCache(HWND hwnd) {
     if (!g_db || !g_hImageList) return;
     
-    // NOTE: Index 0 in ImageList is the brown package icon (default for apps without icons)
-    // We must preserve this by starting custom icons at index 1+
-    
-    // Query all apps with their icons
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, icon_data FROM apps WHERE name IS NOT NULL AND TRIM(name) != '' ORDER BY name;";
+    // Workers read icon blobs through their own read-only connections
+    const char* dbFile = sqlite3_db_filename(g_db, "main");
+    g_iconCache.reset(new IconCache(16, 256, 2, SqliteIconLoader(dbFile ? dbFile : ""),
+                                    [hwnd]() { PostMessageW(hwnd, WM_USER + 3, 0, 0); }));
+}
+
+void InstallAppIcon(int slot, const IconPixels& pixels) {
+    // ImageList cells are 21x19; the 16x16 icon is centered in the cell
+    const int cellWidth = 21, cellHeight = 19;
+    const int left = (cellWidth - pixels.width) / 2, top = (cellHeight - pixels.height) / 2;
+    
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = cellWidth;
+    bmi.bmiHeader.biHeight = -cellHeight;  // Top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    HBITMAP hColor = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!hColor || !bits) {
+        if (hColor) DeleteObject(hColor);
+        return;
+    }
     
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            int appId = sqlite3_column_int(stmt, 0);
-            
-            // Find this app in g_allApps
-            for (auto& app : g_allApps) {
-                if (app.id == appId) {
-                    // Try to load icon from database
-                    if (sqlite3_column_type(stmt, 1) == SQLITE_BLOB) {
-                        const void* blobData = sqlite3_column_blob(stmt, 1);
-                        int blobSize = sqlite3_column_bytes(stmt, 1);
-                        
-                        if (blobData && blobSize > 0) {
-                            HICON hIcon = LoadIconFromMemory((const unsigned char*)blobData, blobSize);
-                            if (hIcon) {
-                                // Add icon to ImageList - this returns new index (1, 2, 3, ...)
-                                app.iconIndex = ImageList_AddIcon(g_hImageList, hIcon);
-                                DestroyIcon(hIcon);
-                            } else {
-                                // Icon data exists but failed to load - use brown package
-                                app.iconIndex = 0;
-                            }
-                        } else {
-                            // No icon data - use brown package icon (index 0)
-                            app.iconIndex = 0;
-                        }
-                    } else {
-                        // No icon in database - use brown package icon (index 0)
-                        app.iconIndex = 0;
-                    }
-                    break;
-                }
-            }
+    // Mask rows are WORD aligned; 1 = transparent
+    const int maskStride = ((cellWidth + 15) / 16) * 2;
+    std::vector<unsigned char> maskBits(maskStride * cellHeight, 0xFF);
+    uint32_t* color = (uint32_t*)bits;
+    ZeroMemory(color, cellWidth * cellHeight * 4);
+    for (int y = 0; y < pixels.height; y++) {
+        for (int x = 0; x < pixels.width; x++) {
+            uint32_t pixel = pixels.bgra[y * pixels.width + x];
+            int cx = left + x, cy = top + y;
+            color[cy * cellWidth + cx] = pixel;
+            if (pixel >> 24) maskBits[cy * maskStride + cx / 8] &= (unsigned char)~(0x80 >> (cx % 8));
         }
-        sqlite3_finalize(stmt);
     }
+    HBITMAP hMask = CreateBitmap(cellWidth, cellHeight, 1, 1, maskBits.data());
+    
+    ICONINFO iconInfo = {};
+    iconInfo.fIcon = TRUE;
+    iconInfo.hbmMask = hMask;
+    iconInfo.hbmColor = hColor;
+    HICON hIcon = CreateIconIndirect(&iconInfo);
+    DeleteObject(hColor);
+    DeleteObject(hMask);
+    if (!hIcon) return;
+    
+    // New slots are handed out in order, so a slot past the end means append
+    if (slot < ImageList_GetImageCount(g_hImageList)) {
+        ImageList_ReplaceIcon(g_hImageList, slot, hIcon);
+    } else {
+        ImageList_AddIcon(g_hImageList, hIcon);
+    }
+    DestroyIcon(hIcon);
+}
+
+int AppIconImage(size_t app) {
+    // Index 0 is the brown package icon: no icon, or not decoded yet
+    if (app >= g_catalog.AppCount() || g_catalog.IconId(app) <= 0 || !g_iconCache) return 0;
+    return g_iconCache->Slot(g_catalog.IconId(app));
 }
 
 // All old dialog code removed - new dialog is created in WinMain before main window
@@ -2356,7 +2363,7 @@ void LoadTags(const std::wstring& filter) {
     }
     g_tagTextBuffers.clear();
     
-    if (g_allCategoryNames.empty()) return;  // No data loaded
+    if (g_catalog.CategoryCount() == 0) return;  // No data loaded
     
     // Add "All" item - use persistent storage
     std::wstring* allText = new std::wstring(L"   " + g_locale.all);
@@ -2372,60 +2379,30 @@ void LoadTags(const std::wstring& filter) {
     int allIndex = ListView_InsertItem(g_hTagTree, &lvi);
     ListView_SetItemState(g_hTagTree, allIndex, LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
     
+    // Installed counts per category are only needed for the installed filter
+    bool installedFilter = IsInstalledFilterActive();
+    if (installedFilter) {
+        SyncCatalogInstalled();
+    }
+    
     // Load categories from in-memory cache
     int itemIndex = 1;
     int processedCount = 0;
-    for (const auto& categoryName : g_allCategoryNames) {
+    for (size_t category = 0; category < g_catalog.CategoryCount(); category++) {
+        const std::wstring& categoryName = g_catalog.CategoryName(category);
         // Process messages every 10 items to keep dialog responsive
         if (g_hIconLoadingDialog && (++processedCount % 10 == 0)) {
             ProcessDialogMessages();
         }
         
-        // Get app count for this category (show all with 4+ apps, or categories where apps would be orphaned)
-        auto it = g_categoryToAppIds.find(categoryName);
-        if (it == g_categoryToAppIds.end() || it->second.empty()) continue;
-        
-        int appCount = it->second.size();
-        bool hasOrphanedApps = false;
-        
-        // Check if category has apps that would be orphaned (only in this one category)
-        if (appCount < 4) {
-            for (int appId : it->second) {
-                // Find this app in g_allApps and check how many categories it belongs to
-                for (const auto& app : g_allApps) {
-                    if (app.id == appId) {
-                        if (app.categories.size() == 1) {
-                            hasOrphanedApps = true;
-                            break;
-                        }
-                        break;
-                    }
-                }
-                if (hasOrphanedApps) break;
-            }
-        }
+        // Show all with 4+ apps, or categories where apps would be orphaned
+        // (only in this one category)
+        const CategoryStats& stats = g_catalog.Stats(category);
+        if (stats.apps == 0) continue;
+        if (stats.apps < 4 && stats.orphanedApps == 0) continue;
         
-        // Only show categories with 4+ apps, or categories with orphaned apps
-        if (appCount < 4 && !hasOrphanedApps) continue;
-        
-        // If installed filter is active, check if category has any installed apps
-        if (IsInstalledFilterActive()) {
-            bool hasInstalledApp = false;
-            for (int appId : it->second) {
-                // Find this app in g_allApps
-                for (const auto& app : g_allApps) {
-                    if (app.id == appId) {
-                        if (IsPackageInstalled(app.packageId)) {
-                            hasInstalledApp = true;
-                            break;
-                        }
-                        break;
-                    }
-                }
-                if (hasInstalledApp) break;
-            }
-            if (!hasInstalledApp) continue;  // Skip categories with no installed apps
-        }
+        // If installed filter is active, skip categories with no installed apps
+        if (installedFilter && stats.installedApps == 0) continue;
         
         // Apply filter if specified
         if (!filter.empty()) {
@@ -2463,86 +2440,44 @@ void LoadTags(const std::wstring& filter) {
     ListView_SetItemState(g_hTagTree, allIndex, LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
 }
 
+// Show `rows` (catalog indexes) in the app list, scrolled to the top. The list
+// has no items of its own, so this costs the same for 10 rows or 10,000.
+void ShowAppRows(std::vector<uint32_t> rows) {
+    ListView_SetItemState(g_hAppList, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+    g_appRows = std::move(rows);
+    ListView_SetItemCountEx(g_hAppList, (int)g_appRows.size(), 0);
+    if (!g_appRows.empty()) ListView_EnsureVisible(g_hAppList, 0, FALSE);
+    InvalidateRect(g_hAppList, NULL, FALSE);
+}
+
 void LoadApps(const std::wstring& tag, const std::wstring& filter) {
-    ListView_DeleteAllItems(g_hAppList);
-    
-    if (g_allApps.empty()) return;  // No data loaded
-    
-    int appCount = 0;
-    int index = 0;
-    int processedCount = 0;
+    if (g_catalog.Empty()) {  // No data loaded
+        ShowAppRows({});
+        return;
+    }
     
-    // Filter apps from in-memory cache
-    for (const auto& app : g_allApps) {
-        // Process messages every 50 items to keep dialog responsive
-        if (g_hIconLoadingDialog && (++processedCount % 50 == 0)) {
-            ProcessDialogMessages();
-        }
-        
-        // Check if app belongs to selected category
-        bool categoryMatch = false;
-        if (tag == L"All") {
-            categoryMatch = true;
-        } else {
-            // Check if app has this category
-            for (const auto& cat : app.categories) {
-                if (cat == tag) {
-                    categoryMatch = true;
-                    break;
-                }
-            }
-        }
-        
-        if (!categoryMatch) continue;
-        
-        // Apply filter if specified
-        if (!filter.empty()) {
-            std::wstring lower_name = app.name;
-            std::wstring lower_publisher = app.publisher;
-            std::wstring lower_packageId = app.packageId;
-            std::wstring lower_filter = filter;
-            
-            std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::towlower);
-            std::transform(lower_publisher.begin(), lower_publisher.end(), lower_publisher.begin(), ::towlower);
-            std::transform(lower_packageId.begin(), lower_packageId.end(), lower_packageId.begin(), ::towlower);
-            std::transform(lower_filter.begin(), lower_filter.end(), lower_filter.begin(), ::towlower);
-            
-            if (lower_name.find(lower_filter) == std::wstring::npos &&
-                lower_publisher.find(lower_filter) == std::wstring::npos &&
-                lower_packageId.find(lower_filter) == std::wstring::npos) {
-                continue;
-            }
-        }
-        
-        // Apply installed filter if active
-        if (IsInstalledFilterActive()) {
-            if (!IsPackageInstalled(app.packageId)) {
-                continue;  // Skip non-installed apps
-            }
-        }
-        
-        // Create a copy of the app for ListView (using new to persist beyond this function)
-        AppInfo* appCopy = new AppInfo(app);
-        
-        // Add to list view
-        LVITEMW lvi = {};
-        lvi.mask = LVIF_TEXT | LVIF_PARAM | LVIF_IMAGE;
-        lvi.iItem = index++;
-        lvi.iSubItem = 0;
-        // Add spaces before name for spacing from icon
-        std::wstring displayName = L"   " + appCopy->name;
-        lvi.pszText = (LPWSTR)displayName.c_str();
-        lvi.lParam = (LPARAM)appCopy;
-        // Use iconIndex if valid, otherwise use 0 (brown package icon)
-        lvi.iImage = (appCopy->iconIndex >= 0) ? appCopy->iconIndex : 0;
-        ListView_InsertItem(g_hAppList, &lvi);
-        
-        ListView_SetItemText(g_hAppList, lvi.iItem, 1, (LPWSTR)appCopy->version.c_str());
-        ListView_SetItemText(g_hAppList, lvi.iItem, 2, (LPWSTR)appCopy->publisher.c_str());
-        
-        appCount++;
+    // Apps of the selected category; while searching, only what the search
+    // found; with a filter, the apps it finds, best match first
+    bool allApps = (tag == L"All");
+    AppListFilter rowFilter;
+    if (!allApps) rowFilter.category = g_catalog.FindCategory(tag);
+    if (g_searchActive) rowFilter.searchMatches = &g_searchMatches;
+    std::vector<uint32_t> textMatches;
+    if (!filter.empty()) {
+        textMatches = FindApps(filter);
+        rowFilter.textMatches = &textMatches;
+    }
+    rowFilter.installedOnly = IsInstalledFilterActive();
+    if (rowFilter.installedOnly) {
+        SyncCatalogInstalled();
     }
     
+    // Rows of the list, in display order (none for an unknown category)
+    std::vector<uint32_t> rows;
+    if (allApps || rowFilter.category >= 0) rows = AppListRows(g_catalog, rowFilter);
+    int appCount = (int)rows.size();
+    ShowAppRows(std::move(rows));
+    
     // Update app count label
     SetWindowTextW(g_hAppCountLabel, L"                                        ");
     std::wstring countText = FormatNumber(appCount) + L" " + g_locale.apps;
@@ -2592,89 +2527,83 @@ void OnTagSelectionChanged() {
         SetWindowTextW(g_hCategoryLabel, (*(std::wstring*)item.lParam).c_str());
     }
     
-    // Load apps for selected category (no filter)
-    LoadApps(g_selectedTag, L"");
+    // Load apps for selected category (only the search matches while searching)
+    LoadApps(g_selectedTag, g_searchActive ? g_searchAppFilter : L"");
 }
 
 void OnAppDoubleClick() {
     int index = ListView_GetNextItem(g_hAppList, -1, LVNI_SELECTED);
-    if (index == -1) return;
-    
-    LVITEMW lvi = {};
-    lvi.mask = LVIF_PARAM | LVIF_IMAGE;
-    lvi.iItem = index;
-    ListView_GetItem(g_hAppList, &lvi);
-    
-    AppInfo* app = (AppInfo*)lvi.lParam;
-    if (app) {
-        // Get the icon from the image list and scale it up for the details dialog
-        HICON hIcon = nullptr;
-        if (lvi.iImage >= 0) {
-            // Extract the small icon from image list
-            HICON hSmallIcon = ImageList_GetIcon(g_hImageList, lvi.iImage, ILD_NORMAL);
-            if (hSmallIcon) {
-                // Create a 128x128 icon by scaling up
-                // Get icon info
-                ICONINFO iconInfo;
-                if (GetIconInfo(hSmallIcon, &iconInfo)) {
-                    // Create DCs for scaling
-                    HDC hdcScreen = GetDC(NULL);
-                    HDC hdcMem = CreateCompatibleDC(hdcScreen);
-                    HDC hdcMemSrc = CreateCompatibleDC(hdcScreen);
-                    
-                    // Create 50x50 bitmap
-                    HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, 50, 50);
-                    HBITMAP hOldBmp = (HBITMAP)SelectObject(hdcMem, hBitmap);
-                    HBITMAP hOldSrc = (HBITMAP)SelectObject(hdcMemSrc, iconInfo.hbmColor);
-                    
-                    // Fill with transparent background
-                    HBRUSH hBrush = (HBRUSH)GetStockObject(WHITE_BRUSH);
-                    RECT rc = {0, 0, 50, 50};
-                    FillRect(hdcMem, &rc, hBrush);
-                    
-                    // Scale and draw
-                    SetStretchBltMode(hdcMem, HALFTONE);
-                    StretchBlt(hdcMem, 0, 0, 50, 50, hdcMemSrc, 0, 0, 21, 19, SRCCOPY);
-                    
-                    // Create mask
-                    SelectObject(hdcMemSrc, iconInfo.hbmMask);
-                    HBITMAP hMask = CreateCompatibleBitmap(hdcScreen, 50, 50);
-                    SelectObject(hdcMem, hMask);
-                    StretchBlt(hdcMem, 0, 0, 50, 50, hdcMemSrc, 0, 0, 21, 19, SRCCOPY);
-                    
-                    // Create the large icon
-                    SelectObject(hdcMem, hBitmap);
-                    ICONINFO newIconInfo;
-                    newIconInfo.fIcon = TRUE;
-                    newIconInfo.xHotspot = 0;
-                    newIconInfo.yHotspot = 0;
-                    newIconInfo.hbmMask = hMask;
-                    newIconInfo.hbmColor = hBitmap;
-                    hIcon = CreateIconIndirect(&newIconInfo);
-                    
-                    // Cleanup
-                    SelectObject(hdcMem, hOldBmp);
-                    SelectObject(hdcMemSrc, hOldSrc);
-                    DeleteObject(hBitmap);
-                    DeleteObject(hMask);
-                    DeleteObject(iconInfo.hbmColor);
-                    DeleteObject(iconInfo.hbmMask);
-                    DeleteDC(hdcMem);
-                    DeleteDC(hdcMemSrc);
-                    ReleaseDC(NULL, hdcScreen);
-                }
-                DestroyIcon(hSmallIcon);
-            }
-        }
-        
-        // Show app details dialog with the scaled icon
-        ShowAppDetailsDialog(g_mainWindow, g_db, app->packageId, hIcon);
-        
-        // Clean up scaled icon
-        if (hIcon) {
-            DestroyIcon(hIcon);
+    if (index < 0 || (size_t)index >= g_appRows.size()) return;
+    
+    size_t app = g_appRows[index];
+    // Get the icon from the image list and scale it up for the details dialog
+    HICON hIcon = nullptr;
+    int image = AppIconImage(app);
+    if (image >= 0) {
+        // Extract the small icon from image list
+        HICON hSmallIcon = ImageList_GetIcon(g_hImageList, image, ILD_NORMAL);
+        if (hSmallIcon) {
+            // Create a 128x128 icon by scaling up
+            // Get icon info
+            ICONINFO iconInfo;
+            if (GetIconInfo(hSmallIcon, &iconInfo)) {
+                // Create DCs for scaling
+                HDC hdcScreen = GetDC(NULL);
+                HDC hdcMem = CreateCompatibleDC(hdcScreen);
+                HDC hdcMemSrc = CreateCompatibleDC(hdcScreen);
+                
+                // Create 50x50 bitmap
+                HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, 50, 50);
+                HBITMAP hOldBmp = (HBITMAP)SelectObject(hdcMem, hBitmap);
+                HBITMAP hOldSrc = (HBITMAP)SelectObject(hdcMemSrc, iconInfo.hbmColor);
+                
+                // Fill with transparent background
+                HBRUSH hBrush = (HBRUSH)GetStockObject(WHITE_BRUSH);
+                RECT rc = {0, 0, 50, 50};
+                FillRect(hdcMem, &rc, hBrush);
+                
+                // Scale and draw
+                SetStretchBltMode(hdcMem, HALFTONE);
+                StretchBlt(hdcMem, 0, 0, 50, 50, hdcMemSrc, 0, 0, 21, 19, SRCCOPY);
+                
+                // Create mask
+                SelectObject(hdcMemSrc, iconInfo.hbmMask);
+                HBITMAP hMask = CreateCompatibleBitmap(hdcScreen, 50, 50);
+                SelectObject(hdcMem, hMask);
+                StretchBlt(hdcMem, 0, 0, 50, 50, hdcMemSrc, 0, 0, 21, 19, SRCCOPY);
+                
+                // Create the large icon
+                SelectObject(hdcMem, hBitmap);
+                ICONINFO newIconInfo;
+                newIconInfo.fIcon = TRUE;
+                newIconInfo.xHotspot = 0;
+                newIconInfo.yHotspot = 0;
+                newIconInfo.hbmMask = hMask;
+                newIconInfo.hbmColor = hBitmap;
+                hIcon = CreateIconIndirect(&newIconInfo);
+                
+                // Cleanup
+                SelectObject(hdcMem, hOldBmp);
+                SelectObject(hdcMemSrc, hOldSrc);
+                DeleteObject(hBitmap);
+                DeleteObject(hMask);
+                DeleteObject(iconInfo.hbmColor);
+                DeleteObject(iconInfo.hbmMask);
+                DeleteDC(hdcMem);
+                DeleteDC(hdcMemSrc);
+                ReleaseDC(NULL, hdcScreen);
+            }
+            DestroyIcon(hSmallIcon);
         }
     }
+    
+    // Show app details dialog with the scaled icon
+    ShowAppDetailsDialog(g_mainWindow, g_db, g_catalog.PackageId(app), hIcon);
+    
+    // Clean up scaled icon
+    if (hIcon) {
+        DestroyIcon(hIcon);
+    }
 }
 
 HBITMAP LoadIconFromBlob(const std::vector<unsigned char>& data, const std::wstring& type) {
@@ -2685,35 +2614,6 @@ HBITMAP LoadIconFromBlob(const std::vector<unsigned char>& data, const std::wstr
     return NULL;
 }
 
-HICON LoadIconFromMemory(const unsigned char* data, int size) {
-    if (!data || size <= 0) return NULL;
-    
-    // Check if it's an ICO file (starts with 0x00 0x00 0x01 0x00)
-    if (size >= 4 && data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x01 && data[3] == 0x00) {
-        // Try to load as ICO
-        int offset = LookupIconIdFromDirectoryEx((PBYTE)data, TRUE, 16, 16, LR_DEFAULTCOLOR);
-        if (offset != 0 && offset < size) {
-            HICON hIcon = CreateIconFromResourceEx((PBYTE)data + offset, size - offset, 
-                                                   TRUE, 0x00030000, 16, 16, LR_DEFAULTCOLOR);
-            if (hIcon) return hIcon;
-        }
-    }
-    
-    // Check if it's a PNG file (starts with 0x89 'P' 'N' 'G')
-    if (size >= 8 && data[0] == 0x89 && data[1] == 0x50 && data[2] == 0x4E && data[3] == 0x47) {
-        // Try to load as PNG using IStream
-        IStream* pStream = SHCreateMemStream(data, size);
-        if (pStream) {
-            // For now, we'll skip PNG support and return NULL
-            // TODO: Implement PNG to HICON conversion using GDI+
-            pStream->Release();
-        }
-    }
-    
-    // Return NULL if format not supported
-    return NULL;
-}
-
 // Save configuration to INI file
 void SaveConfig() {
     wchar_t* appDataPath = nullptr;
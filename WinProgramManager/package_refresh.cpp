@@ -0,0 +1,167 @@
+#include "package_refresh.h"
+#include "icon_store.h"
+#include "schema.h"
+#include "updater_store.h"
+#include "version.h"
+#include <sqlite3.h>
+
+namespace {
+
+std::string ColumnText(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+}  // namespace
+
+std::vector<ChangedPackage> FindChangedPackages(sqlite3* db) {
+    std::vector<ChangedPackage> changed;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, kChangedAppsSql, -1, &stmt, nullptr) != SQLITE_OK) return changed;
+    // SQL narrows it to versions written differently; Version drops the ones
+    // that are only written differently
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ChangedPackage package{ColumnText(stmt, 0), ColumnText(stmt, 1), ColumnText(stmt, 2)};
+        Version listed(package.listedVersion);
+        if (listed.IsKnown() && listed != Version(package.storedVersion)) changed.push_back(std::move(package));
+    }
+    sqlite3_finalize(stmt);
+    return changed;
+}
+
+int WritePackage(UpdaterStore& store, const PackageInfo& pkg, std::string* iconHash) {
+    if (iconHash) iconHash->clear();
+    // Packages with missing names are skipped (all characters, international
+    // ones included, are allowed)
+    if (pkg.name.empty()) return -1;
+
+    // Icons are stored once by content; packages sharing a favicon share the row
+    std::string hash = pkg.iconHash;
+    if (!pkg.iconData.empty()) {
+        hash = IconHash(pkg.iconData.data(), pkg.iconData.size());
+        if (sqlite3_stmt* icon = store.Statement("INSERT OR IGNORE INTO icons (hash, type, data) VALUES (?, ?, ?);")) {
+            sqlite3_bind_text(icon, 1, hash.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(icon, 2, pkg.iconType.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_blob(icon, 3, pkg.iconData.data(), (int)pkg.iconData.size(), SQLITE_STATIC);
+            if (sqlite3_step(icon) != SQLITE_DONE) hash.clear();
+            sqlite3_reset(icon);
+        } else {
+            hash.clear();
+        }
+    }
+    if (iconHash) *iconHash = hash;
+
+    // A package already stored is updated in place and keeps its id
+    sqlite3_stmt* stmt = store.Statement(kUpsertAppSql);
+    if (!stmt) return -1;
+    sqlite3_bind_text(stmt, 1, pkg.packageId.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, pkg.name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, pkg.version.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, pkg.publisher.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, pkg.description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 6, pkg.homepage.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 7, pkg.publisherUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 8, pkg.publisherSupportUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 9, pkg.author.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 10, pkg.license.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 11, pkg.licenseUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 12, pkg.privacyUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 13, pkg.copyright.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 14, pkg.copyrightUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 15, pkg.releaseNotesUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 16, pkg.moniker.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 17, pkg.releaseDate.c_str(), -1, SQLITE_STATIC);
+    // NULL keeps the stored icon
+    if (!hash.empty()) {
+        sqlite3_bind_text(stmt, 18, hash.c_str(), -1, SQLITE_STATIC);
+    } else {
+        sqlite3_bind_null(stmt, 18);
+    }
+    sqlite3_bind_text(stmt, 19, pkg.source.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 20, pkg.installerType.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 21, pkg.architecture.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 22, pkg.documentationUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 23, pkg.installerUrl.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 24, pkg.installerSha256.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 25, pkg.offlineDistributionSupported.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 26, pkg.commands.c_str(), -1, SQLITE_STATIC);
+    int appId = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        appId = sqlite3_column_int(stmt, 0);
+        store.SetPackageId(pkg.packageId, appId);
+    }
+    sqlite3_reset(stmt);
+    if (appId <= 0) return -1;
+
+    for (const std::string& tag : pkg.tags) {
+        int categoryId = store.CategoryId(tag);
+        if (categoryId > 0) store.AddCategoryLink(appId, categoryId);
+    }
+    return appId;
+}
+
+int RefreshPackage(UpdaterStore& store, const PackageInfo& pkg, std::string* iconHash) {
+    if (pkg.name.empty()) {
+        if (iconHash) iconHash->clear();
+        return -1;
+    }
+    // Categories are worked out again: winget's tags here, Steps 5 to 7 for
+    // apps left without any
+    int storedId = store.PackageId(pkg.packageId);
+    if (storedId > 0) store.ClearCategoryLinks(storedId);
+    int appId = WritePackage(store, pkg, iconHash);
+    if (appId <= 0) return -1;
+    // winget was just asked for its tags; Step 4 need not ask again
+    if (sqlite3_stmt* stmt = store.Statement("UPDATE apps SET tags_updated = 1 WHERE id = ?;")) {
+        sqlite3_bind_int(stmt, 1, appId);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    return appId;
+}
+
+bool RemoveDeletedPackages(UpdaterStore& store, PackageRemoval& removal) {
+    removal = PackageRemoval();
+    sqlite3* db = store.Db();
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT (SELECT COUNT(*) FROM search_db.search_results), (SELECT COUNT(*) FROM apps);",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            removal.listed = sqlite3_column_int(stmt, 0);
+            removal.stored = sqlite3_column_int(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+    }
+    // Nothing listed means the lookup failed, not that every package was removed
+    if (removal.listed == 0) return false;
+
+    // Not available and not installed, collected once so both DELETEs and the
+    // id map see the same set
+    if (!Exec(db, "BEGIN IMMEDIATE;")) return false;
+    bool ok = Exec(db, "CREATE TEMP TABLE IF NOT EXISTS removed_apps (id INTEGER PRIMARY KEY, package_id TEXT);"
+                       "DELETE FROM removed_apps;") &&
+              Exec(db, (std::string("INSERT INTO removed_apps ") + kRemovedAppsSql).c_str());
+    if (ok && sqlite3_prepare_v2(db, "SELECT package_id FROM removed_apps;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) removal.packageIds.push_back(ColumnText(stmt, 0));
+        sqlite3_finalize(stmt);
+    }
+    if (ok && removal.packageIds.size() > removal.stored * kMaxRemovedFraction) {
+        removal.heldBack = true;
+        Exec(db, "ROLLBACK;");
+        return false;
+    }
+    ok = ok && Exec(db, "DELETE FROM app_categories WHERE app_id IN (SELECT id FROM removed_apps);") &&
+         Exec(db, "DELETE FROM apps WHERE id IN (SELECT id FROM removed_apps);") &&
+         Exec(db, "DELETE FROM removed_apps;") && Exec(db, "COMMIT;");
+    if (!ok) {
+        Exec(db, "ROLLBACK;");
+        removal.packageIds.clear();
+        return false;
+    }
+    for (const std::string& packageId : removal.packageIds) store.ForgetPackage(packageId);
+    return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+class UpdaterStore;
+
+// A package as `winget show` describes it
+struct PackageInfo {
+    std::string packageId;
+    std::string name;
+    std::string version;
+    std::string publisher;
+    std::string moniker;
+    std::string description;
+    std::string shortDescription;
+    std::string homepage;
+    std::string license;
+    std::string author;
+    std::string copyright;
+    std::string licenseUrl;
+    std::string privacyUrl;
+    std::string packageUrl;
+    std::vector<unsigned char> iconData;
+    std::string iconType;
+    std::string iconUrl;    // where the icon came from
+    std::string iconHash;   // icons.hash of the stored icon when iconUrl says it is unchanged
+    std::vector<std::string> tags;
+    // Additional metadata fields
+    std::string publisherUrl;
+    std::string publisherSupportUrl;
+    std::string copyrightUrl;
+    std::string releaseNotesUrl;
+    std::string releaseDate;
+    std::string source;
+    std::string installerType;
+    std::string architecture;
+    std::string documentationUrl;
+    std::string installerUrl;
+    std::string installerSha256;
+    std::string offlineDistributionSupported;
+    std::string commands;
+};
+
+// A stored package winget now lists at another version.
+struct ChangedPackage {
+    std::string packageId;        // as in apps
+    std::string storedVersion;    // apps.version
+    std::string listedVersion;    // search_db.search_results.version
+};
+
+// The packages to re-fetch so the database follows winget's catalog: those
+// Step 1 listed (search_db.search_results, attached) at a version other than
+// the stored one. Versions are compared as Version values, so "1.0" listed
+// for a stored "1.0.0" is not a change; packages listed without a version (a
+// truncated `winget search` column) or as "Unknown" are left alone. New and
+// removed packages are Steps 2 and 3, not changes.
+std::vector<ChangedPackage> FindChangedPackages(sqlite3* db);
+
+// Store a fetched package: its icon once by content in icons, its row through
+// kUpsertAppSql (a package already stored keeps its apps.id; without an icon
+// it keeps the stored one) and a category per tag. Packages without a name
+// are skipped. Returns apps.id, -1 if no row was written; `iconHash` gets the
+// icons.hash stored for it, empty if none.
+int WritePackage(UpdaterStore& store, const PackageInfo& pkg, std::string* iconHash = nullptr);
+
+// Step 2 for one re-fetched package: its categories are dropped and worked
+// out again from the new tags, and tags_updated is set so Step 4 does not ask
+// winget for them again. Returns as WritePackage.
+int RefreshPackage(UpdaterStore& store, const PackageInfo& pkg, std::string* iconHash = nullptr);
+
+// More removals than this fraction of the stored apps in one run means Step 1
+// saw a partial list (a failed or cut-short winget read), not that winget
+// retired that many packages.
+const double kMaxRemovedFraction = 0.10;
+
+// What Step 3 found: the package ids it removed, or would have removed when
+// it held back.
+struct PackageRemoval {
+    int listed = 0;                      // packages in search_db.search_results
+    int stored = 0;                      // apps before the step
+    std::vector<std::string> packageIds;
+    bool heldBack = false;               // more than kMaxRemovedFraction of stored
+};
+
+// Step 3: delete the apps neither in Step 1's list (search_db.search_results,
+// attached) nor installed, with their category links, in one BEGIN IMMEDIATE
+// transaction, and drop them from the store's id map. Nothing is removed when
+// Step 1 listed nothing or the removal is held back. Returns false if it
+// removed nothing for either reason or a statement failed (rolled back).
+bool RemoveDeletedPackages(UpdaterStore& store, PackageRemoval& removal);
@@ -0,0 +1,163 @@
+#include "schema.h"
+#include <sqlite3.h>
+#include <cstring>
+
+const char kCatalogAppsSql[] =
+    "SELECT a.id, a.package_id, a.name, a.version, a.publisher, a.homepage, i.rowid FROM apps a "
+    "LEFT JOIN icons i ON i.hash = a.icon_hash "
+    "WHERE a.name IS NOT NULL AND TRIM(a.name) != '' ORDER BY a.name;";
+const char kUncategorizedAppsSql[] =
+    "SELECT id, package_id, name, moniker FROM apps "
+    "WHERE NOT EXISTS (SELECT 1 FROM app_categories ac WHERE ac.app_id = apps.id);";
+const char kTagUncategorizedSql[] =
+    "INSERT INTO app_categories (app_id, category_id) "
+    "SELECT id, ?1 FROM apps WHERE NOT EXISTS (SELECT 1 FROM app_categories ac WHERE ac.app_id = apps.id);";
+const char kUncheckedUntaggedAppsSql[] =
+    "SELECT package_id FROM apps "
+    "WHERE tags_updated = 0 AND NOT EXISTS (SELECT 1 FROM app_categories ac WHERE ac.app_id = apps.id);";
+const char kNewPackagesSql[] =
+    "SELECT package_id FROM search_db.search_results sr "
+    "WHERE NOT EXISTS (SELECT 1 FROM apps a WHERE a.package_id = sr.package_id);";
+const char kRemovedAppsSql[] =
+    "SELECT id, package_id FROM apps "
+    "WHERE NOT EXISTS (SELECT 1 FROM search_db.search_results sr WHERE sr.package_id = apps.package_id) "
+    "AND NOT EXISTS (SELECT 1 FROM installed_apps ia WHERE ia.package_id = apps.package_id);";
+const char kChangedAppsSql[] =
+    "SELECT a.package_id, a.version, sr.version FROM apps a "
+    "JOIN search_db.search_results sr ON sr.package_id = a.package_id "
+    "WHERE sr.version IS NOT NULL AND sr.version != '' AND sr.version IS NOT a.version;";
+const char kUpsertAppSql[] =
+    "INSERT INTO apps (package_id, name, version, publisher, description, "
+    "homepage, publisher_url, publisher_support_url, author, license, license_url, "
+    "privacy_url, copyright, copyright_url, release_notes_url, moniker, release_date, "
+    "icon_hash, source, installer_type, architecture, documentation_url, "
+    "installer_url, installer_sha256, offline_distribution_supported, commands) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+    "ON CONFLICT(package_id) DO UPDATE SET "
+    "name = excluded.name, version = excluded.version, publisher = excluded.publisher, "
+    "description = excluded.description, homepage = excluded.homepage, publisher_url = excluded.publisher_url, "
+    "publisher_support_url = excluded.publisher_support_url, author = excluded.author, "
+    "license = excluded.license, license_url = excluded.license_url, privacy_url = excluded.privacy_url, "
+    "copyright = excluded.copyright, copyright_url = excluded.copyright_url, "
+    "release_notes_url = excluded.release_notes_url, moniker = excluded.moniker, "
+    "release_date = excluded.release_date, icon_hash = COALESCE(excluded.icon_hash, apps.icon_hash), "
+    "source = excluded.source, installer_type = excluded.installer_type, architecture = excluded.architecture, "
+    "documentation_url = excluded.documentation_url, installer_url = excluded.installer_url, "
+    "installer_sha256 = excluded.installer_sha256, "
+    "offline_distribution_supported = excluded.offline_distribution_supported, commands = excluded.commands "
+    "RETURNING id;";
+const char kAppCategoriesSql[] =
+    "SELECT c.category_name FROM categories c "
+    "JOIN app_categories ac ON c.id = ac.category_id "
+    "JOIN apps a ON a.id = ac.app_id "
+    "WHERE a.package_id = ?1 "
+    "ORDER BY c.category_name;";
+
+namespace {
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+int UserVersion(sqlite3* db) {
+    sqlite3_stmt* stmt;
+    int version = -1;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return version;
+}
+
+bool HasColumn(sqlite3* db, const char* table, const char* column) {
+    sqlite3_stmt* stmt;
+    bool found = false;
+    std::string sql = std::string("PRAGMA table_info(") + table + ");";
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* name = sqlite3_column_text(stmt, 1);
+            found = name && strcmp(reinterpret_cast<const char*>(name), column) == 0;
+        }
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+// 1: installed_apps, until now created by whichever code touched it first
+bool CreateInstalledApps(sqlite3* db) {
+    return Exec(db,
+                "CREATE TABLE IF NOT EXISTS installed_apps ("
+                "    package_id TEXT PRIMARY KEY,"
+                "    installed_date TEXT,"
+                "    last_seen TEXT,"
+                "    installed_version TEXT,"
+                "    source TEXT,"
+                "    FOREIGN KEY (package_id) REFERENCES apps(package_id)"
+                ");"
+                "CREATE INDEX IF NOT EXISTS idx_installed_last_seen ON installed_apps(last_seen);");
+}
+
+// 2: apps.tags_updated, which Step 4 of the updater reads and sets
+bool AddTagsUpdated(sqlite3* db) {
+    return HasColumn(db, "apps", "tags_updated") ||
+           Exec(db, "ALTER TABLE apps ADD COLUMN tags_updated INTEGER NOT NULL DEFAULT 0;");
+}
+
+// 3: indexes for the hot queries: categories to apps (the primary key only
+// goes from apps to categories), and one covering the catalog in name order.
+// Needs apps.icon_hash, which MigrateIconStore adds
+bool AddHotQueryIndexes(sqlite3* db) {
+    return Exec(db,
+                "CREATE INDEX IF NOT EXISTS idx_app_categories_category ON app_categories(category_id, app_id);"
+                "CREATE INDEX IF NOT EXISTS idx_apps_catalog ON apps(name, package_id, version, publisher, homepage, icon_hash);");
+}
+
+// 4: icon_sources, the validators of every icon URL the updater fetched
+bool CreateIconSources(sqlite3* db) {
+    return Exec(db,
+                "CREATE TABLE IF NOT EXISTS icon_sources ("
+                "    url TEXT PRIMARY KEY,"
+                "    icon_hash TEXT,"
+                "    etag TEXT,"
+                "    last_modified TEXT,"
+                "    checked INTEGER NOT NULL DEFAULT 0"
+                ");");
+}
+
+struct Migration {
+    int version;
+    bool (*apply)(sqlite3* db);
+};
+
+const Migration kMigrations[] = {
+    {1, CreateInstalledApps},
+    {2, AddTagsUpdated},
+    {3, AddHotQueryIndexes},
+    {4, CreateIconSources},
+};
+
+}  // namespace
+
+int MigrateSchema(sqlite3* db) {
+    if (!db) return -1;
+    int version = UserVersion(db);
+    if (version < 0) return -1;
+    for (const Migration& migration : kMigrations) {
+        if (migration.version <= version) continue;
+
+        // Another process may have migrated meanwhile: check again under the write lock
+        if (!Exec(db, "BEGIN IMMEDIATE;")) return -1;
+        int current = UserVersion(db);
+        bool ok = current >= 0;
+        if (ok && current < migration.version) {
+            std::string bump = "PRAGMA user_version = " + std::to_string(migration.version) + ";";
+            ok = migration.apply(db) && Exec(db, bump.c_str());
+        }
+        if (!ok || !Exec(db, "COMMIT;")) {
+            Exec(db, "ROLLBACK;");
+            return -1;
+        }
+        version = current > migration.version ? current : migration.version;
+    }
+    return version;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+// Version of the app database schema this build maintains, kept in
+// PRAGMA user_version. The build scripts create version 0 databases (apps,
+// categories, app_categories); everything added since is a numbered migration
+// in schema.cpp, so any database opened by WinProgramManager or the updater
+// ends up with the same tables and indexes.
+const int kSchemaVersion = 4;
+
+// Apply the migrations past the database's user_version, each in its own
+// transaction together with the version bump, so a failed one is rolled back
+// and retried on the next open. Call after MigrateIconStore, which stays
+// separate as it also moves the icons the build scripts write inline on every
+// run. Returns the version reached, -1 on error.
+int MigrateSchema(sqlite3* db);
+
+// SQL of the hot queries. The callers run exactly these texts, so
+// CheckQueryPlans (tests/query_plans.cpp) checks the plans that actually run.
+
+// The catalog: every named app in name order, with the rowid of its icon.
+extern const char kCatalogAppsSql[];
+// Apps without any category: id, package_id, name, moniker.
+extern const char kUncategorizedAppsSql[];
+// Give every app without a category the category bound to ?1.
+extern const char kTagUncategorizedSql[];
+// Apps without categories whose tags winget was not asked for yet.
+extern const char kUncheckedUntaggedAppsSql[];
+// package_id of the packages search_db.search_results lists that apps does
+// not have yet (Step 2's new packages).
+extern const char kNewPackagesSql[];
+// id, package_id of the apps neither in search_db.search_results (the
+// packages winget lists, attached by the updater) nor marked installed.
+extern const char kRemovedAppsSql[];
+// package_id, version, listed version of the apps search_db.search_results
+// lists at a version other than apps.version (see FindChangedPackages).
+extern const char kChangedAppsSql[];
+// Insert a package, or update its row in place so apps.id, and with it the
+// app's categories and installed_apps entry, stays valid. Binds the 26
+// columns in the order listed; a NULL icon_hash keeps the stored icon.
+// Returns the row's id.
+extern const char kUpsertAppSql[];
+// Category names of the app whose package_id is bound to ?1.
+extern const char kAppCategoriesSql[];
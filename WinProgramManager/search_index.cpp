@@ -0,0 +1,271 @@
+#include "search_index.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cwctype>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Ranks, best first; a field never ranks better than its first entry here
+enum Rank {
+    kRankNameExact,
+    kRankMonikerExact,
+    kRankNamePrefix,
+    kRankIdSegment,    // package id starts with the query after a '.'
+    kRankNameWord,
+    kRankName,
+    kRankIdOrMoniker,
+    kRankPublisher,
+    kRankDescription,
+};
+
+// Fields in the order they are tried, with the best rank each can give
+const std::pair<SearchIndex::Field, int> kFieldOrder[] = {
+    {SearchIndex::kName, kRankNameExact},        {SearchIndex::kMoniker, kRankMonikerExact},
+    {SearchIndex::kPackageId, kRankIdSegment},   {SearchIndex::kPublisher, kRankPublisher},
+    {SearchIndex::kDescription, kRankDescription},
+};
+
+// Lowercase without the C runtime's locale, which the app never sets: in the
+// "C" locale towlower only maps A-Z. Latin-1, Latin Extended-A, Greek and
+// Cyrillic are mapped here; the rest is left to towlower.
+wchar_t Fold(wchar_t c) {
+    if (c < 0x80) return c >= L'A' && c <= L'Z' ? (wchar_t)(c + (L'a' - L'A')) : c;
+    if (c >= 0xC0 && c <= 0xDE) return c == 0xD7 ? c : (wchar_t)(c + 0x20);
+    if (c >= 0x100 && c <= 0x17F) {
+        // Upper/lower pairs, upper first, except 0x139-0x148 and 0x179-0x17E
+        // which start on an odd code point
+        if (c == 0x130 || c == 0x131 || c == 0x138 || c == 0x149 || c == 0x17F) return c;
+        if (c == 0x178) return 0xFF;
+        bool oddUpper = (c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E);
+        return (c % 2 == 1) == oddUpper ? (wchar_t)(c + 1) : c;
+    }
+    if (c >= 0x391 && c <= 0x3AB) return c == 0x3A2 ? c : (wchar_t)(c + 0x20);
+    if (c == 0x386) return 0x3AC;
+    if (c >= 0x388 && c <= 0x38A) return (wchar_t)(c + 0x25);
+    if (c == 0x38C) return 0x3CC;
+    if (c == 0x38E || c == 0x38F) return (wchar_t)(c + 0x3F);
+    if (c >= 0x400 && c <= 0x40F) return (wchar_t)(c + 0x50);
+    if (c >= 0x410 && c <= 0x42F) return (wchar_t)(c + 0x20);
+    return static_cast<wchar_t>(std::towlower(c));
+}
+
+std::wstring Fold(std::wstring_view text) {
+    std::wstring folded(text);
+    for (auto& c : folded) c = Fold(c);
+    return folded;
+}
+
+uint64_t GramKey(const wchar_t* p) {
+    return ((uint64_t)(p[0] & 0x1FFFFF) << 42) | ((uint64_t)(p[1] & 0x1FFFFF) << 21) | (uint64_t)(p[2] & 0x1FFFFF);
+}
+
+// Does `query` occur in `text` right after a character that is not `inWord`?
+template <typename InWord>
+bool OccursAtBoundary(std::wstring_view text, std::wstring_view query, size_t pos, InWord inWord) {
+    for (; pos != std::wstring_view::npos; pos = text.find(query, pos + 1)) {
+        if (pos == 0 || !inWord(text[pos - 1])) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+bool SearchIndex::Build(const AppCatalog& catalog, sqlite3* db) {
+    Clear();
+    appCount_ = catalog.AppCount();
+
+    // Moniker and description are not part of the catalog
+    std::vector<std::wstring> monikers(appCount_), descriptions(appCount_);
+    sqlite3_stmt* stmt;
+    if (db && sqlite3_prepare_v2(db, "SELECT id, moniker, description FROM apps;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            int app = catalog.IndexOfId(sqlite3_column_int(stmt, 0));
+            if (app < 0) continue;
+            monikers[app] = ColumnToWide((const char*)sqlite3_column_text(stmt, 1));
+            descriptions[app] = ColumnToWide((const char*)sqlite3_column_text(stmt, 2));
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    for (int field = 0; field < kFieldCount; ++field) {
+        std::wstring& text = text_[field];
+        std::vector<uint32_t>& start = start_[field];
+        start.reserve(appCount_ + 1);
+        start.push_back(0);
+        for (size_t app = 0; app < appCount_; ++app) {
+            switch (field) {
+                case kName: text += catalog.Name(app); break;
+                case kPackageId: text += catalog.PackageId(app); break;
+                case kMoniker: text += monikers[app]; break;
+                case kPublisher: text += catalog.Publisher(app); break;
+                case kDescription: text += descriptions[app]; break;
+            }
+            start.push_back((uint32_t)text.size());
+        }
+        text.shrink_to_fit();
+        folded_[field] = Fold(text);
+    }
+
+    // Number every distinct gram as it is first seen and record each app's
+    // grams once; apps are visited in order, so every run comes out sorted
+    std::unordered_map<uint64_t, uint32_t> gramIds;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> lastApp, counts;
+    std::vector<uint32_t> appGrams, appGramStart(1, 0);
+    for (size_t app = 0; app < appCount_; ++app) {
+        for (int field = 0; field < kFieldCount; ++field) {
+            std::wstring_view text = Folded(field, app);
+            for (size_t i = 0; i + 3 <= text.size(); ++i) {
+                const uint64_t key = GramKey(text.data() + i);
+                auto it = gramIds.find(key);
+                if (it == gramIds.end()) {
+                    it = gramIds.emplace(key, (uint32_t)keys.size()).first;
+                    keys.push_back(key);
+                    lastApp.push_back(UINT32_MAX);
+                    counts.push_back(0);
+                }
+                const uint32_t id = it->second;
+                if (lastApp[id] == app) continue;
+                lastApp[id] = (uint32_t)app;
+                counts[id]++;
+                appGrams.push_back(id);
+            }
+        }
+        appGramStart.push_back((uint32_t)appGrams.size());
+    }
+
+    // Lay the runs out in key order
+    std::vector<uint32_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    std::vector<uint32_t> fill(keys.size());
+    grams_.reserve(keys.size());
+    gramStart_.reserve(keys.size() + 1);
+    uint32_t offset = 0;
+    for (uint32_t id : order) {
+        grams_.push_back(keys[id]);
+        gramStart_.push_back(offset);
+        fill[id] = offset;
+        offset += counts[id];
+    }
+    gramStart_.push_back(offset);
+    postings_.resize(offset);
+    for (size_t app = 0; app < appCount_; ++app) {
+        for (uint32_t i = appGramStart[app]; i < appGramStart[app + 1]; ++i) postings_[fill[appGrams[i]]++] = (uint32_t)app;
+    }
+    return true;
+}
+
+void SearchIndex::Clear() {
+    *this = SearchIndex();
+}
+
+std::wstring_view SearchIndex::Text(int field, size_t app) const {
+    return std::wstring_view(text_[field]).substr(start_[field][app], start_[field][app + 1] - start_[field][app]);
+}
+
+std::wstring_view SearchIndex::Folded(int field, size_t app) const {
+    return std::wstring_view(folded_[field]).substr(start_[field][app], start_[field][app + 1] - start_[field][app]);
+}
+
+int SearchIndex::Rank(size_t app, std::wstring_view query, std::wstring_view folded, const SearchOptions& options) const {
+    int best = -1;
+    for (const auto& entry : kFieldOrder) {
+        const int field = entry.first;
+        if (best >= 0 && best <= entry.second) break;
+        std::wstring_view text = options.caseSensitive ? Text(field, app) : Folded(field, app);
+        std::wstring_view q = options.caseSensitive ? query : folded;
+
+        int rank = -1;
+        if (options.exactMatch) {
+            if (text == q) rank = entry.second;
+        } else {
+            size_t pos = text.find(q);
+            if (pos == std::wstring_view::npos) continue;
+            switch (field) {
+                case kName:
+                    if (pos == 0) rank = text.size() == q.size() ? kRankNameExact : kRankNamePrefix;
+                    else rank = OccursAtBoundary(text, q, pos, [](wchar_t c) { return std::iswalnum(c) != 0; })
+                                    ? kRankNameWord : kRankName;
+                    break;
+                case kMoniker:
+                    rank = text.size() == q.size() ? kRankMonikerExact : kRankIdOrMoniker;
+                    break;
+                case kPackageId:
+                    rank = OccursAtBoundary(text, q, pos, [](wchar_t c) { return c != L'.'; }) ? kRankIdSegment
+                                                                                             : kRankIdOrMoniker;
+                    break;
+                case kPublisher: rank = kRankPublisher; break;
+                default: rank = kRankDescription; break;
+            }
+        }
+        if (rank >= 0 && (best < 0 || rank < best)) best = rank;
+    }
+    return best;
+}
+
+std::vector<uint32_t> SearchIndex::Search(const std::wstring& query, const SearchOptions& options) const {
+    std::vector<uint32_t> result;
+    if (query.empty()) {
+        result.resize(appCount_);
+        std::iota(result.begin(), result.end(), 0u);
+        return result;
+    }
+    const std::wstring folded = Fold(query);
+
+    // Candidates: apps listed under every gram of the query, shortest list first
+    std::vector<uint32_t> candidates;
+    const bool scanAll = folded.size() < 3;
+    if (!scanAll) {
+        std::vector<std::pair<const uint32_t*, const uint32_t*>> lists;
+        for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+            auto it = std::lower_bound(grams_.begin(), grams_.end(), GramKey(folded.data() + i));
+            if (it == grams_.end() || *it != GramKey(folded.data() + i)) return result;
+            size_t g = (size_t)(it - grams_.begin());
+            lists.emplace_back(postings_.data() + gramStart_[g], postings_.data() + gramStart_[g + 1]);
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+            return a.second - a.first < b.second - b.first;
+        });
+        candidates.assign(lists[0].first, lists[0].second);
+        for (size_t l = 1; l < lists.size() && !candidates.empty(); ++l) {
+            const uint32_t* from = lists[l].first;
+            size_t kept = 0;
+            for (uint32_t app : candidates) {
+                from = std::lower_bound(from, lists[l].second, app);
+                if (from == lists[l].second) break;
+                if (*from == app) candidates[kept++] = app;
+            }
+            candidates.resize(kept);
+        }
+    }
+
+    std::vector<std::pair<int, uint32_t>> ranked;
+    auto consider = [&](uint32_t app) {
+        int rank = Rank(app, query, folded, options);
+        if (rank >= 0) ranked.emplace_back(rank, app);
+    };
+    if (scanAll) {
+        for (size_t app = 0; app < appCount_; ++app) consider((uint32_t)app);
+    } else {
+        for (uint32_t app : candidates) consider(app);
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    result.reserve(ranked.size());
+    for (const auto& entry : ranked) result.push_back(entry.second);
+    return result;
+}
+
+size_t SearchIndex::MemoryBytes() const {
+    size_t bytes = grams_.capacity() * sizeof(uint64_t) + gramStart_.capacity() * sizeof(uint32_t) +
+                   postings_.capacity() * sizeof(uint32_t);
+    for (int field = 0; field < kFieldCount; ++field) {
+        bytes += (text_[field].capacity() + folded_[field].capacity()) * sizeof(wchar_t) +
+                 start_[field].capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
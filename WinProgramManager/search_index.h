@@ -0,0 +1,59 @@
+#pragma once
+#include "catalog.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+// The case/exact options of the search dialog.
+struct SearchOptions {
+    bool caseSensitive = false;
+    bool exactMatch = false;   // whole field equals the query (else: contains)
+};
+
+// Text search over the apps of an AppCatalog: name, package id, moniker,
+// publisher and description.
+//
+// Every field is lowercased once when the index is built, and each app is
+// listed under every three-character sequence its fields contain. A query of
+// three or more characters only looks at the apps listed under all of its
+// sequences; shorter queries scan the lowercased text. Matches are ranked
+// by where they were found (exact name, moniker, name prefix, package id
+// segment, name word, name, id/moniker, publisher, description), then by name.
+class SearchIndex {
+public:
+    enum Field { kName, kPackageId, kMoniker, kPublisher, kDescription, kFieldCount };
+
+    // Index the apps of `catalog`; moniker and description come from `db`.
+    bool Build(const AppCatalog& catalog, sqlite3* db);
+    void Clear();
+    bool Empty() const { return appCount_ == 0; }
+
+    // Catalog indexes of the apps matching `query`, best first. An empty
+    // query matches every app, in name order.
+    std::vector<uint32_t> Search(const std::wstring& query, const SearchOptions& options) const;
+
+    // Heap bytes held by the index.
+    size_t MemoryBytes() const;
+
+private:
+    std::wstring_view Text(int field, size_t app) const;
+    std::wstring_view Folded(int field, size_t app) const;
+    // Rank of the best match of `query` in `app`, -1 if it does not match.
+    int Rank(size_t app, std::wstring_view query, std::wstring_view folded, const SearchOptions& options) const;
+
+    size_t appCount_ = 0;
+    // Per field: all apps' text back to back, original and lowercased, with
+    // appCount_ + 1 offsets
+    std::wstring text_[kFieldCount];
+    std::wstring folded_[kFieldCount];
+    std::vector<uint32_t> start_[kFieldCount];
+    // Sorted three-character keys, each with its sorted run of apps
+    std::vector<uint64_t> grams_;
+    std::vector<uint32_t> gramStart_;
+    std::vector<uint32_t> postings_;
+};
@@ -0,0 +1,117 @@
+#include "tag_correlation.h"
+#include "app_bitset.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Apply correlation rules (66.67% threshold, min 6 samples)
+const double kCorrelationThreshold = 0.6667;
+const int kMinSamples = 6;
+
+// Offsets of a CSR layout from per-row sizes: start[r]..start[r + 1]
+std::vector<uint32_t> Offsets(const std::vector<uint32_t>& sizes) {
+    std::vector<uint32_t> start(sizes.size() + 1, 0);
+    for (size_t r = 0; r < sizes.size(); ++r) start[r + 1] = start[r] + sizes[r];
+    return start;
+}
+
+}  // namespace
+
+std::vector<AppCategory> InferCorrelatedCategories(sqlite3* db) {
+    std::vector<AppCategory> inferred;
+    sqlite3_stmt* stmt;
+
+    // Categories in name order, the order rules are applied in
+    std::vector<std::pair<std::string, int>> categories;
+    if (sqlite3_prepare_v2(db, "SELECT category_name, id FROM categories;", -1, &stmt, nullptr) != SQLITE_OK) return inferred;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* name = sqlite3_column_text(stmt, 0);
+        if (name) categories.emplace_back(reinterpret_cast<const char*>(name), sqlite3_column_int(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    std::sort(categories.begin(), categories.end());
+    std::unordered_map<int, uint32_t> tagOf;
+    for (uint32_t tag = 0; tag < categories.size(); ++tag) tagOf[categories[tag].second] = tag;
+
+    // (app, tag) pairs, apps renumbered 0..n-1. Rows linking to a missing
+    // category give no pair but still count towards the app's rows, as they
+    // did in the GROUP BY that picked the apps with several categories.
+    std::vector<int> appIds;
+    std::unordered_map<int, uint32_t> appOf;
+    std::vector<uint32_t> rowsPerApp;
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    if (sqlite3_prepare_v2(db, "SELECT app_id, category_id FROM app_categories;", -1, &stmt, nullptr) != SQLITE_OK) return inferred;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        auto app = appOf.emplace(sqlite3_column_int(stmt, 0), (uint32_t)appIds.size());
+        if (app.second) {
+            appIds.push_back(app.first->first);
+            rowsPerApp.push_back(0);
+        }
+        rowsPerApp[app.first->second]++;
+        auto tag = tagOf.find(sqlite3_column_int(stmt, 1));
+        if (tag != tagOf.end()) pairs.emplace_back(app.first->second, tag->second);
+    }
+    sqlite3_finalize(stmt);
+    const size_t appCount = appIds.size(), tagCount = categories.size();
+
+    // Tags of every app, and apps of every tag among apps with several rows
+    std::vector<uint32_t> tagsPerApp(appCount, 0), appsPerTag(tagCount, 0);
+    for (const auto& pair : pairs) tagsPerApp[pair.first]++;
+    for (const auto& pair : pairs) {
+        if (rowsPerApp[pair.first] > 1) appsPerTag[pair.second]++;
+    }
+    std::vector<uint32_t> appStart = Offsets(tagsPerApp), tagStart = Offsets(appsPerTag);
+    std::vector<uint32_t> appTags(pairs.size()), multiTagApps(tagStart.back());
+    {
+        std::vector<uint32_t> appFill(appStart.begin(), appStart.end() - 1), tagFill(tagStart.begin(), tagStart.end() - 1);
+        for (const auto& pair : pairs) {
+            appTags[appFill[pair.first]++] = pair.second;
+            if (rowsPerApp[pair.first] > 1) multiTagApps[tagFill[pair.second]++] = pair.first;
+        }
+    }
+
+    // Rules: per source tag, count the other tags of its multi-tag apps
+    std::vector<std::pair<uint32_t, uint32_t>> rules;
+    std::vector<uint32_t> together(tagCount, 0), seen;
+    for (uint32_t source = 0; source < tagCount; ++source) {
+        if (appsPerTag[source] < (uint32_t)kMinSamples) continue;
+        for (uint32_t i = tagStart[source]; i < tagStart[source + 1]; ++i) {
+            uint32_t app = multiTagApps[i];
+            for (uint32_t j = appStart[app]; j < appStart[app + 1]; ++j) {
+                uint32_t target = appTags[j];
+                if (target != source && together[target]++ == 0) seen.push_back(target);
+            }
+        }
+        std::sort(seen.begin(), seen.end());
+        for (uint32_t target : seen) {
+            double correlation = static_cast<double>(together[target]) / appsPerTag[source];
+            if (correlation >= kCorrelationThreshold) rules.emplace_back(source, target);
+            together[target] = 0;
+        }
+        seen.clear();
+    }
+
+    // Every app with the source tag gets the target tag; later rules see the
+    // apps earlier ones tagged
+    std::vector<std::vector<uint32_t>> tagApps(tagCount);
+    for (const auto& pair : pairs) tagApps[pair.second].push_back(pair.first);
+    std::vector<AppBitset> members(tagCount);
+    for (const auto& rule : rules) {
+        AppBitset& targets = members[rule.second];
+        if (targets.Size() != appCount) {
+            targets = AppBitset(appCount);
+            for (uint32_t app : tagApps[rule.second]) targets.Set(app);
+        }
+        for (uint32_t app : tagApps[rule.first]) {
+            if (targets.Test(app)) continue;
+            targets.Set(app);
+            tagApps[rule.second].push_back(app);
+            inferred.push_back({appIds[app], categories[rule.second].second});
+        }
+    }
+    return inferred;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+// One app_categories row.
+struct AppCategory {
+    int appId;
+    int categoryId;
+};
+
+// Rows the updater's correlation rules add to app_categories (Step 6).
+//
+// Among apps with more than one app_categories row (links to categories that
+// no longer exist included), if at least 66.67% of those with category S also
+// have T, and S occurs on at least 6 of them, every app with S gets T.
+// Rules apply in (S, T) name order and see the rows added by earlier rules,
+// as the one-INSERT-per-rule SQL did.
+//
+// app_categories and categories are read once into integer (app, category)
+// pairs; co-occurrence is counted per source category over those, and rule
+// application works on per-category app bitsets. Nothing is written: the
+// caller inserts the returned rows in one batch.
+std::vector<AppCategory> InferCorrelatedCategories(sqlite3* db);
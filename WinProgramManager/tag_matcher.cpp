@@ -0,0 +1,211 @@
+#include "tag_matcher.h"
+#include <algorithm>
+#include <deque>
+
+const std::map<std::string, std::string>& NameTagPatterns() {
+    static const std::map<std::string, std::string> patterns = {
+        // Technology/Hardware
+        {"USB", "usb"},
+        {"Bluetooth", "bluetooth"},
+        {"WiFi|Wi-Fi", "wifi"},
+        {"HDMI", "hdmi"},
+        {"GPU", "gpu"},
+        {"CPU", "cpu"},
+
+        // Application types
+        {"Browser", "browser"},
+        {"Client", "client"},
+        {"Server", "server"},
+        {"Manager", "manager"},
+        {"Viewer", "viewer"},
+        {"Editor", "editor"},
+        {"Player", "player"},
+        {"Launcher", "launcher"},
+        {"Download", "download"},
+
+        // Functions
+        {"Emulator", "emulator"},
+        {"Driver", "driver"},
+        {"Manual", "manual"},
+        {"Toolkit", "toolkit"},
+        {"SDK", "development"},
+        {"CLI|Command.?Line", "cli"},
+        {"Mock", "testing"},
+        {"Test", "testing"},
+        {"Debug", "development"},
+        {"Simulator", "emulator"},
+
+        // File formats/protocols
+        {"INI", "configuration"},
+        {"JSON", "data"},
+        {"XML", "data"},
+        {"YAML", "configuration"},
+        {"CSV", "data"},
+        {"SQL", "database"},
+        {"HTML", "web"},
+        {"FTP", "network"},
+        {"HTTP", "web"},
+        {"ODBC", "database"},
+        {"API", "development"},
+
+        // Media
+        {"Video", "video"},
+        {"Audio", "audio"},
+        {"Image", "graphics"},
+        {"Photo", "graphics"},
+        {"Music", "audio"},
+        {"PDF", "document"},
+
+        // Categories
+        {"Game", "gaming"},
+        {"Utility", "utilities"},
+        {"Security", "security"},
+        {"Password", "security"},
+        {"Recovery", "utilities"},
+        {"Backup", "backup"},
+        {"Chocolatey", "package-manager"},
+        {"Winget", "winget"},
+    };
+    return patterns;
+}
+
+namespace {
+
+const int kAnyChar = -1;
+// Input classes every automaton has; pattern characters get 3, 4, ...
+const int kOtherClass = 0, kNewlineClass = 1, kReturnClass = 2;
+
+int LowerAscii(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// Every string one alternative ("Command.?Line") matches, as lowercase bytes
+// and kAnyChar.
+void Expand(std::string_view alternative, size_t pos, std::vector<int>& prefix, std::vector<std::vector<int>>& out) {
+    if (pos == alternative.size()) {
+        out.push_back(prefix);
+        return;
+    }
+    int symbol = alternative[pos] == '.' ? kAnyChar : LowerAscii((unsigned char)alternative[pos]);
+    bool optional = pos + 1 < alternative.size() && alternative[pos + 1] == '?';
+    size_t nextPos = pos + (optional ? 2 : 1);
+    if (optional) Expand(alternative, nextPos, prefix, out);
+    prefix.push_back(symbol);
+    Expand(alternative, nextPos, prefix, out);
+    prefix.pop_back();
+}
+
+}  // namespace
+
+void TagMatcher::Build(const std::map<std::string, std::string>& patterns) {
+    *this = TagMatcher();
+
+    // Expand every pattern, remembering which pattern each string belongs to
+    std::vector<std::pair<int, std::vector<int>>> strings;
+    int pattern = 0;
+    for (const auto& entry : patterns) {
+        auto tag = std::find(tags_.begin(), tags_.end(), entry.second);
+        patternTag_.push_back((int)(tag - tags_.begin()));
+        if (tag == tags_.end()) tags_.push_back(entry.second);
+
+        std::vector<std::vector<int>> expanded;
+        std::vector<int> prefix;
+        size_t start = 0;
+        for (size_t bar = entry.first.find('|'); ; bar = entry.first.find('|', start)) {
+            Expand(std::string_view(entry.first).substr(start, bar == std::string::npos ? std::string::npos : bar - start), 0,
+                   prefix, expanded);
+            if (bar == std::string::npos) break;
+            start = bar + 1;
+        }
+        for (auto& string : expanded) strings.emplace_back(pattern, std::move(string));
+        ++pattern;
+    }
+
+    // Bytes no pattern mentions all share one class; line breaks get their own
+    // so that `.` can leave them out
+    classOf_[(unsigned char)'\n'] = kNewlineClass;
+    classOf_[(unsigned char)'\r'] = kReturnClass;
+    classCount_ = 3;
+    for (const auto& string : strings) {
+        for (int symbol : string.second) {
+            if (symbol == kAnyChar || classOf_[symbol] != kOtherClass) continue;
+            classOf_[symbol] = (uint8_t)classCount_;
+            if (symbol >= 'a' && symbol <= 'z') classOf_[symbol - 'a' + 'A'] = (uint8_t)classCount_;
+            ++classCount_;
+        }
+    }
+    std::vector<int> anyClasses{kOtherClass};
+    for (int c = 3; c < classCount_; ++c) anyClasses.push_back(c);
+
+    // Trie; 0 is both the root and "no child yet", as the root is nobody's child
+    outputWords_ = (patterns.size() + 63) / 64;
+    auto addState = [&]() {
+        next_.resize(next_.size() + classCount_, 0);
+        output_.resize(output_.size() + outputWords_, 0);
+        return (uint16_t)stateCount_++;
+    };
+    addState();
+    for (const auto& string : strings) {
+        std::vector<uint16_t> states{0}, nextStates;
+        for (int symbol : string.second) {
+            nextStates.clear();
+            for (uint16_t state : states) {
+                for (int c : symbol == kAnyChar ? anyClasses : std::vector<int>{classOf_[symbol]}) {
+                    if (!next_[state * classCount_ + c]) {
+                        uint16_t child = addState();
+                        next_[state * classCount_ + c] = child;
+                    }
+                    nextStates.push_back(next_[state * classCount_ + c]);
+                }
+            }
+            states.swap(nextStates);
+        }
+        for (uint16_t state : states) output_[state * outputWords_ + string.first / 64] |= uint64_t(1) << (string.first % 64);
+    }
+
+    // Failure links, breadth first, folded into the transition table so that
+    // matching never follows them; each state also reports what its failure
+    // state reports
+    std::vector<uint16_t> fail(stateCount_, 0);
+    std::deque<uint16_t> queue;
+    for (int c = 0; c < classCount_; ++c) {
+        if (next_[c]) queue.push_back(next_[c]);
+    }
+    while (!queue.empty()) {
+        uint16_t state = queue.front();
+        queue.pop_front();
+        for (size_t w = 0; w < outputWords_; ++w) output_[state * outputWords_ + w] |= output_[fail[state] * outputWords_ + w];
+        for (int c = 0; c < classCount_; ++c) {
+            uint16_t& child = next_[state * classCount_ + c];
+            uint16_t fallback = next_[fail[state] * classCount_ + c];
+            if (child) {
+                fail[child] = fallback;
+                queue.push_back(child);
+            } else {
+                child = fallback;
+            }
+        }
+    }
+}
+
+std::vector<std::string> TagMatcher::Match(std::initializer_list<std::string_view> fields) const {
+    std::vector<std::string> tags;
+    if (!stateCount_) return tags;
+
+    std::vector<uint64_t> found(outputWords_, 0);
+    for (std::string_view field : fields) {
+        size_t state = 0;
+        for (char c : field) {
+            state = next_[state * classCount_ + classOf_[(unsigned char)c]];
+            for (size_t w = 0; w < outputWords_; ++w) found[w] |= output_[state * outputWords_ + w];
+        }
+    }
+
+    std::vector<bool> added(tags_.size(), false);
+    for (size_t pattern = 0; pattern < patternTag_.size(); ++pattern) {
+        if (!((found[pattern / 64] >> (pattern % 64)) & 1) || added[patternTag_[pattern]]) continue;
+        added[patternTag_[pattern]] = true;
+        tags.push_back(tags_[patternTag_[pattern]]);
+    }
+    return tags;
+}
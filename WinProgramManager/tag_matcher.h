@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The name-based tag rules of WinProgramUpdater: pattern -> tag, matched
+// case-insensitively anywhere in an app's name, package id or moniker.
+const std::map<std::string, std::string>& NameTagPatterns();
+
+// All tag patterns compiled once into one case-insensitive Aho-Corasick
+// automaton, so tagging an app is a single pass over its text however many
+// patterns there are, instead of a regex compiled and run per pattern.
+//
+// Patterns are literals with the few regex forms the rules use: alternation
+// (`WiFi|Wi-Fi`), `.` (any character but a line break) and `?` after a single
+// character. Both are expanded into plain strings when the automaton is built.
+// Letters compare ASCII case-insensitively, as std::regex::icase did.
+class TagMatcher {
+public:
+    void Build(const std::map<std::string, std::string>& patterns);
+
+    // Tags of the patterns found in any of `fields` (no match spans two
+    // fields), in pattern order, each tag once.
+    std::vector<std::string> Match(std::initializer_list<std::string_view> fields) const;
+
+    size_t StateCount() const { return stateCount_; }
+
+private:
+    uint8_t classOf_[256] = {};          // byte -> input class (0: in no pattern)
+    int classCount_ = 0;
+    size_t stateCount_ = 0;
+    std::vector<uint16_t> next_;         // stateCount_ x classCount_ transitions
+    size_t outputWords_ = 0;
+    std::vector<uint64_t> output_;       // per state, bitset of the patterns ending there
+    std::vector<int> patternTag_;        // pattern (in map order) -> tags_ index
+    std::vector<std::string> tags_;
+};
@@ -0,0 +1,167 @@
+// AppBitset against a std::vector<bool> model, at sizes on and around word
+// boundaries, and the facet counts ExecuteSearch takes from the fixture
+// catalog (a search, refined by an earlier one, with and without the
+// installed filter) against counting every category's apps one by one.
+//
+// Usage: app_bitset_test <scratch dir>
+#include "app_bitset.h"
+#include "catalog.h"
+#include "check.h"
+#include "fixture_catalog.h"
+#include <sqlite3.h>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::vector<bool> Model;
+
+Model RandomModel(size_t size, double density, std::mt19937& rng) {
+    std::bernoulli_distribution bit(density);
+    Model model(size);
+    for (size_t app = 0; app < size; ++app) model[app] = bit(rng);
+    return model;
+}
+
+AppBitset FromModel(const Model& model) {
+    AppBitset bits(model.size());
+    for (size_t app = 0; app < model.size(); ++app) {
+        if (model[app]) bits.Set(app);
+    }
+    return bits;
+}
+
+size_t ModelCount(const Model& model) {
+    size_t count = 0;
+    for (bool bit : model) count += bit;
+    return count;
+}
+
+// Every bit, the count and the ForEach order of `bits` match `model`
+void CheckSame(const AppBitset& bits, const Model& model) {
+    CHECK_EQ(bits.Size(), model.size());
+    size_t differing = 0;
+    for (size_t app = 0; app < model.size(); ++app) differing += bits.Test(app) != model[app];
+    CHECK_EQ(differing, 0u);
+    CHECK_EQ(bits.Count(), ModelCount(model));
+    std::vector<size_t> visited, expected;
+    bits.ForEach([&](size_t app) { visited.push_back(app); });
+    for (size_t app = 0; app < model.size(); ++app) {
+        if (model[app]) expected.push_back(app);
+    }
+    CHECK(visited == expected);
+}
+
+void TestBitset() {
+    std::mt19937 rng(16);
+    for (size_t size : {0, 1, 2, 63, 64, 65, 127, 128, 129, 1000, 4097}) {
+        CheckSame(AppBitset(size), Model(size, false));
+        CheckSame(AppBitset(size, true), Model(size, true));
+
+        for (double density : {0.02, 0.5, 0.98}) {
+            Model a = RandomModel(size, density, rng), b = RandomModel(size, 0.5, rng);
+            AppBitset bitsA = FromModel(a), bitsB = FromModel(b);
+            CheckSame(bitsA, a);
+
+            // Set and Reset flip only their own bit
+            for (size_t i = 0; size && i < 50; ++i) {
+                size_t app = rng() % size;
+                if (rng() & 1) {
+                    bitsA.Set(app);
+                    a[app] = true;
+                } else {
+                    bitsA.Reset(app);
+                    a[app] = false;
+                }
+            }
+            CheckSame(bitsA, a);
+
+            Model both(size);
+            for (size_t app = 0; app < size; ++app) both[app] = a[app] && b[app];
+            CHECK_EQ(bitsA.CountAnd(bitsB), ModelCount(both));
+            CHECK_EQ(bitsB.CountAnd(bitsA), ModelCount(both));
+            CHECK_EQ(bitsA.CountAnd(AppBitset(size, true)), ModelCount(a));
+            bitsA &= bitsB;
+            CheckSame(bitsA, both);
+        }
+
+        // A set of another size: a longer one does not set bits past Size(),
+        // a shorter one clears the apps it does not cover
+        Model a = RandomModel(size, 0.7, rng);
+        AppBitset bits = FromModel(a);
+        bits &= AppBitset(size + 70, true);
+        CheckSame(bits, a);
+        CHECK_EQ(bits.CountAnd(AppBitset(size + 70, true)), ModelCount(a));
+        const size_t shorter = size / 2;
+        bits &= AppBitset(shorter, true);
+        for (size_t app = shorter; app < size; ++app) a[app] = false;
+        CheckSame(bits, a);
+    }
+}
+
+// Apps of `category` in `apps`, one by one
+int SlowCount(const AppCatalog& catalog, size_t category, const AppBitset& apps) {
+    int count = 0;
+    for (uint32_t app : catalog.CategoryApps(category)) count += apps.Test(app);
+    return count;
+}
+
+void CheckCounts(const AppCatalog& catalog, const AppBitset& apps) {
+    std::vector<int> counts = catalog.CategoryCounts(apps);
+    CHECK_EQ(counts.size(), catalog.CategoryCount());
+    size_t differing = 0;
+    for (size_t c = 0; c < catalog.CategoryCount() && c < counts.size(); ++c) {
+        differing += counts[c] != SlowCount(catalog, c, apps);
+        differing += (int)catalog.CountInCategory(c, apps) != counts[c];
+    }
+    CHECK_EQ(differing, 0u);
+}
+
+void TestFacets(const std::string& path) {
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK);
+    AppCatalog catalog;
+    CHECK(catalog.Load(db));
+    sqlite3_close(db);
+    CHECK(catalog.AppCount() > 0);
+
+    // Both ways a category is counted: its bitset and its index array
+    size_t large = 0;
+    for (size_t c = 0; c < catalog.CategoryCount(); ++c) large += catalog.CategoryApps(c).size() * 32 >= catalog.AppCount();
+    CHECK(large > 0);
+    CHECK(large < catalog.CategoryCount());
+
+    std::mt19937 rng(61);
+    catalog.RefreshInstalled([&](const std::wstring&) { return rng() % 3 == 0; });
+    const AppBitset& installed = catalog.InstalledApps();
+    for (double density : {0.0, 0.01, 0.3, 1.0}) {
+        AppBitset search = FromModel(RandomModel(catalog.AppCount(), density, rng));
+        CheckCounts(catalog, search);
+
+        // Refined by the previous search, then filtered to installed apps
+        AppBitset refined = search;
+        refined &= FromModel(RandomModel(catalog.AppCount(), 0.5, rng));
+        CheckCounts(catalog, refined);
+        refined &= installed;
+        CheckCounts(catalog, refined);
+    }
+    CheckCounts(catalog, installed);
+    CheckCounts(catalog, AppBitset(catalog.AppCount(), true));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    TestBitset();
+    std::string path = std::string(argv[1]) + "/app_bitset_test.db";
+    std::remove(path.c_str());
+    CHECK(WriteFixtureDatabase(MakeCatalogFixture(3000, 16), path));
+    TestFacets(path);
+    return TestResult("app_bitset_test");
+}
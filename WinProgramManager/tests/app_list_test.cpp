@@ -0,0 +1,128 @@
+// AppListRows against the row-by-row filtering LoadApps did before the list
+// became owner-data: for "All", large and small categories, with and without
+// an active search, filter text and the installed filter, the rows are the
+// same apps in the same order.
+//
+// Usage: app_list_test <scratch dir>
+#include "catalog.h"
+#include "check.h"
+#include "fixture_catalog.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The old LoadApps loop: walk the candidates in display order and test every
+// filter per app
+std::vector<uint32_t> SlowRows(const AppCatalog& catalog, const AppListFilter& filter) {
+    const bool searching = filter.searchMatches && filter.searchMatches->Size() == catalog.AppCount();
+    std::vector<uint32_t> candidates;
+    if (filter.textMatches) {
+        candidates = *filter.textMatches;
+    } else {
+        for (size_t app = 0; app < catalog.AppCount(); ++app) candidates.push_back((uint32_t)app);
+    }
+    std::vector<uint32_t> rows;
+    for (uint32_t app : candidates) {
+        if (app >= catalog.AppCount()) continue;
+        if (filter.category >= 0) {
+            IndexRange apps = catalog.CategoryApps(filter.category);
+            if (std::find(apps.begin(), apps.end(), app) == apps.end()) continue;
+        }
+        if (searching && !filter.searchMatches->Test(app)) continue;
+        if (filter.installedOnly && !catalog.Installed(app)) continue;
+        rows.push_back(app);
+    }
+    return rows;
+}
+
+AppBitset RandomSet(size_t size, double density, std::mt19937& rng) {
+    std::bernoulli_distribution bit(density);
+    AppBitset bits(size);
+    for (size_t app = 0; app < size; ++app) {
+        if (bit(rng)) bits.Set(app);
+    }
+    return bits;
+}
+
+// Some apps in no particular order, as FindApps ranks them
+std::vector<uint32_t> RandomMatches(size_t appCount, size_t count, std::mt19937& rng) {
+    std::vector<uint32_t> matches(appCount);
+    for (size_t app = 0; app < appCount; ++app) matches[app] = (uint32_t)app;
+    std::shuffle(matches.begin(), matches.end(), rng);
+    matches.resize(std::min(count, appCount));
+    return matches;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    std::string path = std::string(argv[1]) + "/app_list_test.db";
+    std::remove(path.c_str());
+    CHECK(WriteFixtureDatabase(MakeCatalogFixture(2000, 17), path));
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK);
+    AppCatalog catalog;
+    CHECK(catalog.Load(db));
+    sqlite3_close(db);
+    CHECK(catalog.AppCount() > 0 && catalog.CategoryCount() > 2);
+
+    std::mt19937 rng(17);
+    catalog.RefreshInstalled([&](const std::wstring&) { return rng() % 4 == 0; });
+
+    // "All", the largest and smallest categories and a few in between
+    std::vector<int> categories = {-1};
+    std::vector<size_t> bySize(catalog.CategoryCount());
+    for (size_t c = 0; c < bySize.size(); ++c) bySize[c] = c;
+    std::sort(bySize.begin(), bySize.end(),
+              [&](size_t a, size_t b) { return catalog.CategoryApps(a).size() > catalog.CategoryApps(b).size(); });
+    for (size_t i : {(size_t)0, (size_t)1, bySize.size() / 2, bySize.size() - 1}) categories.push_back((int)bySize[i]);
+
+    const AppBitset search = RandomSet(catalog.AppCount(), 0.4, rng);
+    const AppBitset stale = RandomSet(catalog.AppCount() + 5, 0.1, rng);   // from before a reload
+    const std::vector<uint32_t> text = RandomMatches(catalog.AppCount(), catalog.AppCount() / 3, rng);
+    const std::vector<uint32_t> noText;
+    const AppBitset* searches[] = {nullptr, &search, &stale};
+    const std::vector<uint32_t>* texts[] = {nullptr, &text, &noText};
+
+    int compared = 0;
+    size_t shown = 0;
+    for (int category : categories) {
+        for (const AppBitset* searchMatches : searches) {
+            for (const std::vector<uint32_t>* textMatches : texts) {
+                for (bool installedOnly : {false, true}) {
+                    AppListFilter filter;
+                    filter.category = category;
+                    filter.searchMatches = searchMatches;
+                    filter.textMatches = textMatches;
+                    filter.installedOnly = installedOnly;
+                    std::vector<uint32_t> rows = AppListRows(catalog, filter);
+                    CHECK(rows == SlowRows(catalog, filter));
+                    shown += rows.size();
+                    compared++;
+                }
+            }
+        }
+    }
+    CHECK(shown > 0);
+
+    // "All" without filters is every app in name order; a category alone is
+    // its sorted index array
+    CHECK_EQ(AppListRows(catalog, AppListFilter()).size(), catalog.AppCount());
+    AppListFilter one;
+    one.category = (int)bySize[0];
+    std::vector<uint32_t> rows = AppListRows(catalog, one);
+    IndexRange apps = catalog.CategoryApps(bySize[0]);
+    CHECK(rows == std::vector<uint32_t>(apps.begin(), apps.end()));
+
+    std::printf("%zu apps, %d filter combinations compared\n", catalog.AppCount(), compared);
+    return TestResult("app_list_test");
+}
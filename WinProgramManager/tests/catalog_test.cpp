@@ -0,0 +1,169 @@
+// AppCatalog against a plain model of the fixture catalog: every app, link and
+// per-category number the main window reads is compared with what the
+// fixture put in the database, including the rows LoadAllDataIntoMemory had
+// to cope with (deleted apps, links to them, category names differing only
+// in case and blanks, apps without a name).
+//
+// Usage: catalog_test <scratch dir>
+#include "catalog.h"
+#include "check.h"
+#include "fixture_catalog.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::wstring Wide(const std::string& ascii) {
+    return std::wstring(ascii.begin(), ascii.end());
+}
+
+// What the catalog shows for a category name: trimmed, first letter capital
+std::wstring Shown(const std::string& name) {
+    std::wstring shown = Wide(name);
+    shown[0] = (wchar_t)std::toupper(shown[0]);
+    return shown;
+}
+
+bool Deleted(size_t app) {
+    return (app + 1) % 7 == 0;
+}
+
+struct Model {
+    std::map<std::wstring, size_t> appByPackage;          // package id -> fixture index
+    std::map<std::wstring, std::set<std::wstring>> apps;  // category -> package ids
+    std::map<std::wstring, std::set<std::wstring>> categories;   // package id -> categories
+};
+
+Model BuildModel(const CatalogFixture& fixture) {
+    Model model;
+    for (size_t i = 0; i < fixture.apps.size(); ++i) {
+        if (Deleted(i)) continue;
+        std::wstring id = Wide(fixture.apps[i].packageId);
+        model.appByPackage[id] = i;
+        model.categories[id];
+        for (int c : fixture.apps[i].categories) {
+            model.apps[Shown(fixture.categories[c])].insert(id);
+            model.categories[id].insert(Shown(fixture.categories[c]));
+        }
+        // Every fifth app is also in " Utilities " (see Damage), which is
+        // "utilities" once trimmed
+        if (i % 5 == 0) {
+            model.apps[L"Utilities"].insert(id);
+            model.categories[id].insert(L"Utilities");
+        }
+    }
+    return model;
+}
+
+// Rows the build scripts and older updaters leave behind
+bool Damage(sqlite3* db) {
+    return sqlite3_exec(db,
+                        "DELETE FROM apps WHERE id % 7 = 0;"
+                        "INSERT INTO apps (package_id, name) VALUES ('Blank.Name', '   '), ('Null.Name', NULL);"
+                        "INSERT INTO app_categories SELECT id, 1 FROM apps WHERE package_id IN ('Blank.Name', 'Null.Name');"
+                        "INSERT INTO categories (category_name) VALUES (' Utilities ');"
+                        "INSERT INTO app_categories SELECT a.id, (SELECT id FROM categories WHERE category_name = ' Utilities ') "
+                        "FROM apps a WHERE (a.id - 1) % 5 = 0 AND a.name IS NOT NULL AND TRIM(a.name) != '';"
+                        "INSERT INTO categories (category_name) VALUES ('never-used');",
+                        nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+void TestCatalog(const CatalogFixture& fixture, const std::string& path) {
+    Model model = BuildModel(fixture);
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    CHECK(Damage(db));
+    AppCatalog catalog;
+    CHECK(catalog.Load(db));
+    sqlite3_close(db);
+
+    // Apps: the named, undeleted ones, in name order, each found by its id
+    CHECK_EQ(catalog.AppCount(), model.appByPackage.size());
+    for (size_t app = 0; app < catalog.AppCount(); ++app) {
+        if (app > 0) CHECK(catalog.Name(app - 1) <= catalog.Name(app));
+        CHECK_EQ(catalog.IndexOfId(catalog.Id(app)), (int)app);
+        auto it = model.appByPackage.find(catalog.PackageId(app));
+        if (it == model.appByPackage.end()) {
+            CHECK(it != model.appByPackage.end());
+            continue;
+        }
+        const FixtureApp& expected = fixture.apps[it->second];
+        CHECK_EQ(catalog.Id(app), (int)it->second + 1);
+        CHECK(catalog.Name(app) == Wide(expected.name));
+        CHECK(catalog.Version(app) == Wide(expected.version));
+        CHECK(catalog.Publisher(app) == Wide(expected.publisher));
+        CHECK(catalog.Homepage(app) == Wide(expected.homepage));
+    }
+    for (size_t i = 0; i < fixture.apps.size(); i += 7) {
+        if (Deleted(i)) CHECK_EQ(catalog.IndexOfId((int)i + 1), -1);
+    }
+    CHECK_EQ(catalog.IndexOfId(0), -1);
+    CHECK_EQ(catalog.IndexOfId((int)fixture.apps.size() + 100), -1);
+
+    // Categories: only those with apps, sorted, merged by their shown name
+    CHECK_EQ(catalog.CategoryCount(), model.apps.size());
+    CHECK(std::is_sorted(catalog.CategoryNames().begin(), catalog.CategoryNames().end()));
+    CHECK_EQ(catalog.FindCategory(L"Never-used"), -1);
+    for (size_t c = 0; c < catalog.CategoryCount(); ++c) {
+        CHECK_EQ(catalog.FindCategory(catalog.CategoryName(c)), (int)c);
+        const std::set<std::wstring>& expected = model.apps[catalog.CategoryName(c)];
+        IndexRange apps = catalog.CategoryApps(c);
+        CHECK_EQ(apps.size(), expected.size());
+        CHECK(std::is_sorted(apps.begin(), apps.end()));
+        int orphans = 0;
+        for (uint32_t app : apps) {
+            CHECK(expected.count(catalog.PackageId(app)));
+            CHECK(catalog.InCategory(c, app));
+            orphans += model.categories[catalog.PackageId(app)].size() == 1;
+        }
+        CHECK_EQ(catalog.Stats(c).apps, (int)expected.size());
+        CHECK_EQ(catalog.Stats(c).orphanedApps, orphans);
+    }
+    for (size_t app = 0; app < catalog.AppCount(); ++app) {
+        IndexRange categories = catalog.AppCategories(app);
+        CHECK_EQ(categories.size(), model.categories[catalog.PackageId(app)].size());
+        CHECK(std::is_sorted(categories.begin(), categories.end()));
+        for (uint32_t c : categories) CHECK(model.categories[catalog.PackageId(app)].count(catalog.CategoryName(c)));
+    }
+
+    // Installed counts, through the bitsets of large categories and the
+    // index arrays of small ones alike
+    std::set<std::wstring> installed;
+    for (const FixtureApp& app : fixture.apps) {
+        if (app.installed) installed.insert(Wide(app.packageId));
+    }
+    catalog.RefreshInstalled([&](const std::wstring& packageId) { return installed.count(packageId) > 0; });
+    size_t installedLoaded = 0;
+    for (size_t app = 0; app < catalog.AppCount(); ++app) {
+        CHECK_EQ(catalog.Installed(app), installed.count(catalog.PackageId(app)) > 0);
+        installedLoaded += catalog.Installed(app);
+    }
+    CHECK(installedLoaded > 0);
+    CHECK_EQ(catalog.InstalledApps().Count(), installedLoaded);
+    std::vector<int> counts = catalog.CategoryCounts(catalog.InstalledApps());
+    for (size_t c = 0; c < catalog.CategoryCount(); ++c) {
+        int expected = 0;
+        for (const std::wstring& id : model.apps[catalog.CategoryName(c)]) expected += installed.count(id) > 0;
+        CHECK_EQ(catalog.Stats(c).installedApps, expected);
+        CHECK_EQ(counts[c], expected);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    CatalogFixture fixture = MakeCatalogFixture(3000, 11);
+    std::string path = std::string(argv[1]) + "/catalog_test.db";
+    CHECK(WriteFixtureDatabase(fixture, path));
+    TestCatalog(fixture, path);
+    return TestResult("catalog_test");
+}
@@ -0,0 +1,140 @@
+// InstalledCorrelator: Uninstall keys looked up by the product codes of
+// winget's index, with the name rule only for keys no code claims. Small
+// hand-made cases pin the rules down; a generated catalog, whose installed
+// packages are known, checks precision and recall through both index schemas
+// against the substring rule it replaces.
+//
+// Usage: correlation_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "uninstall_index.h"
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+UninstallEntry Entry(const wchar_t* key, const wchar_t* name, const wchar_t* publisher, bool currentUser = false) {
+    UninstallEntry entry;
+    entry.keyName = key;
+    entry.displayName = name;
+    entry.publisher = publisher;
+    entry.currentUser = currentUser;
+    return entry;
+}
+
+void TestRules() {
+    InstalledCorrelator correlator;
+    correlator.AddProductCode("Igor.SevenZip", "{23170F69-40C1-2702-2301-000001000000}");
+    correlator.AddProductCode("Igor.SevenZip", "{23170f69-40c1-2702-2301-000001000000}");   // same, other case
+    correlator.AddProductCode("Vendor.Shared", "{11111111-2222-3333-4444-555555555555}");
+    correlator.AddProductCode("Vendor.SharedToo", "{11111111-2222-3333-4444-555555555555}");
+    correlator.AddProductCode("Microsoft.Teams", "{99999999-0000-0000-0000-000000000000}");
+    correlator.AddProductCode("Empty.Code", "");
+    CHECK_EQ(correlator.ProductCodeCount(), 3u);
+    correlator.Build({
+        Entry(L"{23170F69-40C1-2702-2301-000001000000}", L"7-Zip 23.01 (x64)", L"Igor Pavlov"),
+        Entry(L"{11111111-2222-3333-4444-555555555555}", L"Shared Runtime", L"Vendor"),
+        Entry(L"{AAAAAAAA-0000-0000-0000-000000000000}", L"Microsoft Visual Studio Code", L"Microsoft Corporation"),
+        Entry(L"Notepad++", L"Notepad++ (64-bit x64)", L"Notepad++ Team"),
+        Entry(L"Spotify", L"Spotify", L"Spotify AB", true),
+    });
+
+    // Keys that are known codes: exactly the packages declaring them
+    CHECK(correlator.IsInstalledByProductCode("Igor.SevenZip"));
+    CHECK(correlator.IsInstalled("Vendor.Shared"));
+    CHECK(correlator.IsInstalled("Vendor.SharedToo"));
+    CHECK(!correlator.IsInstalled("Microsoft.Teams"));
+    CHECK_EQ(correlator.ExactPackageCount(), 3u);
+    CHECK_EQ(correlator.UnclaimedEntryCount(), 3u);
+
+    // Other keys: the product half in the name, the publisher half in name or publisher
+    CHECK(correlator.IsInstalled("Microsoft.VisualStudioCode"));
+    CHECK(!correlator.IsInstalledByProductCode("Microsoft.VisualStudioCode"));
+    CHECK(correlator.IsInstalled("Notepad++.Notepad++"));
+    CHECK(correlator.IsInstalled("Spotify.Spotify"));
+    CHECK(!correlator.IsInstalled("Microsoft.Edge"));          // the old rule: "microsoft" anywhere
+    CHECK(!correlator.IsInstalled("Google.VisualStudioCode"));
+    // A claimed entry is not matched by name again
+    CHECK(!correlator.IsInstalled("Igor.7Zip"));
+    CHECK(!correlator.IsInstalled("Other.SharedRuntime"));
+}
+
+struct Score {
+    size_t reported = 0, correct = 0;
+    double Precision() const { return reported ? (double)correct / reported : 0; }
+};
+
+void TestFixture(const std::string& scratch) {
+    CatalogFixture fixture = MakeCatalogFixture(3000, 19);
+    std::set<std::string> truth, codes;
+    for (const FixtureApp& app : fixture.apps) {
+        if (app.installed) truth.insert(app.packageId);
+        for (const std::string& code : app.productCodes) {
+            std::string lower = code;
+            for (auto& c : lower) c = (char)tolower((unsigned char)c);
+            codes.insert(lower);
+        }
+    }
+    std::string regPath = scratch + "/correlation_test.reg";
+    CHECK(WriteFixtureUninstallExport(fixture, regPath));
+    std::vector<UninstallEntry> entries;
+    CHECK(ReadUninstallExport(regPath, entries));
+    UninstallIndex substring;
+    substring.Build(entries);
+
+    std::set<std::string> installedBySchema[2];
+    for (int schema : {1, 2}) {
+        std::string indexPath = scratch + "/correlation_test_v" + std::to_string(schema) + ".db";
+        CHECK(WriteFixtureWingetIndex(fixture, indexPath, schema));
+        InstalledCorrelator correlator;
+        CHECK(LoadProductCodes(indexPath, correlator));
+        CHECK_EQ(correlator.ProductCodeCount(), codes.size());
+        correlator.Build(entries);
+
+        Score correlated, old;
+        size_t byCode = 0, truthByCode = 0;
+        for (const FixtureApp& app : fixture.apps) {
+            bool installed = correlator.IsInstalled(app.packageId);
+            correlated.reported += installed;
+            correlated.correct += installed && app.installed;
+            byCode += correlator.IsInstalledByProductCode(app.packageId);
+            bool keyedByCode = app.installed && std::find(app.productCodes.begin(), app.productCodes.end(),
+                                                          app.uninstallKey) != app.productCodes.end();
+            truthByCode += keyedByCode;
+            // An app installed under one of its own codes is always found
+            if (keyedByCode) CHECK(correlator.IsInstalledByProductCode(app.packageId));
+            if (installed) installedBySchema[schema - 1].insert(app.packageId);
+
+            bool matched = substring.Matches(std::wstring(app.packageId.begin(), app.packageId.end()));
+            old.reported += matched;
+            old.correct += matched && app.installed;
+        }
+        std::printf("schema %d: %zu installed, %zu under one of their codes; product codes: %zu reported, "
+                    "%zu by code, precision %.1f%%, recall %.1f%%; substring rule: %zu reported, precision %.1f%%, "
+                    "recall %.1f%%\n",
+                    schema, truth.size(), truthByCode, correlated.reported, byCode, 100 * correlated.Precision(),
+                    100.0 * correlated.correct / truth.size(), old.reported, 100 * old.Precision(),
+                    100.0 * old.correct / truth.size());
+        CHECK(correlated.Precision() >= 0.9);
+        CHECK(correlated.correct >= truth.size() * 9 / 10);
+        CHECK(correlated.correct >= truthByCode);
+        CHECK(old.Precision() < 0.5);
+    }
+    // Schema 1 lists a package once per version, schema 2 once
+    CHECK(installedBySchema[0] == installedBySchema[1]);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    TestRules();
+    TestFixture(argv[1]);
+    return TestResult("correlation_test");
+}
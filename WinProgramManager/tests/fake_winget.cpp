@@ -0,0 +1,20 @@
+// Stand-in for `winget show <id>` in the fetch pool benchmark: waits as long
+// as winget takes to answer (FAKE_LATENCY milliseconds, 500 by default), then
+// prints a manifest the size of a small real one.
+//
+// Usage: fake_winget show <id>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+int main(int argc, char** argv) {
+    const char* latency = std::getenv("FAKE_LATENCY");
+    int ms = latency ? std::atoi(latency) : 500;
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms > 0 ? ms : 0));
+    const char* id = argc >= 3 ? argv[2] : "Unknown";
+    std::printf("Found Package [%s]\nVersion: 1.0\nPublisher: Bench\nDescription: A package for the benchmark\n"
+                "Tags:\n  a\n  b\n  c\n",
+                id);
+    return 0;
+}
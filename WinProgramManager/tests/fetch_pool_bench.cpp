@@ -0,0 +1,29 @@
+#include "wpm_benchmarks.h"
+#include "fetch_pool.h"
+#include "process_runner.h"
+#include <chrono>
+#include <cstdio>
+
+std::string BenchmarkFetchPool(const std::string& fakeWinget, int packages) {
+    std::vector<std::string> ids;
+    for (int i = 0; i < packages; ++i) ids.push_back("Bench.Package" + std::to_string(i));
+
+    std::string report;
+    for (int workers : {1, 4, 8}) {
+        size_t fetched = 0, bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        RunFetchPool(ids, workers, nullptr,
+            [&](const std::string& id) { return RunProcess(fakeWinget + " show \"" + id + "\"").output; },
+            [&](std::vector<std::string>& batch) {
+                fetched += batch.size();
+                for (auto& out : batch) bytes += out.size();
+            });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        char line[160];
+        snprintf(line, sizeof(line), "%sN=%d: %zu packages in %.2f s = %.0f packages/min (%zu bytes)%s",
+                 report.empty() ? "" : "; ", workers, fetched, seconds,
+                 seconds > 0 ? fetched * 60.0 / seconds : 0.0, bytes, fetched == ids.size() ? "" : " FAIL");
+        report += line;
+    }
+    return report;
+}
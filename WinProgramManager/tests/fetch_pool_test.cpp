@@ -0,0 +1,109 @@
+// RunFetchPool with an in-process fetch in place of `winget show`: every key
+// is fetched and consumed exactly once, a slow consumer throttles the
+// workers to the 4 * workers queue bound, and cancelling stops new fetches
+// while everything already fetched is still consumed.
+//
+// Usage: fetch_pool_test
+#include "check.h"
+#include "fetch_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<int> Keys(int n) {
+    std::vector<int> keys;
+    for (int i = 0; i < n; ++i) keys.push_back(i);
+    return keys;
+}
+
+void TestEveryKeyOnce() {
+    for (int workers : {1, 3, 8, 64}) {
+        std::vector<int> keys = Keys(2000);
+        std::vector<std::atomic<int>> fetched(keys.size());
+        std::vector<int> consumed;
+        std::thread::id caller = std::this_thread::get_id();
+        bool onCaller = true;
+        RunFetchPool(keys, workers, nullptr,
+            [&](int key) { fetched[key]++; return key * 2; },
+            [&](std::vector<int>& batch) {
+                onCaller = onCaller && std::this_thread::get_id() == caller;
+                consumed.insert(consumed.end(), batch.begin(), batch.end());
+            });
+        CHECK(onCaller);
+        CHECK_EQ(consumed.size(), keys.size());
+        std::sort(consumed.begin(), consumed.end());
+        for (size_t i = 0; i < consumed.size(); ++i) CHECK_EQ(consumed[i], (int)i * 2);
+        for (auto& n : fetched) CHECK_EQ(n.load(), 1);
+    }
+    // No keys: neither callback runs
+    int calls = 0;
+    RunFetchPool(std::vector<int>(), 4, nullptr, [&](int k) { ++calls; return k; },
+                 [&](std::vector<int>&) { ++calls; });
+    CHECK_EQ(calls, 0);
+}
+
+// While the consumer sleeps on a batch, at most the queue (4 * workers), one
+// result per worker waiting for room, and the batch itself are fetched ahead
+void TestBackPressure() {
+    const int workers = 4;
+    const size_t bound = 4 * workers;
+    std::vector<int> keys = Keys(1000);
+    std::atomic<size_t> fetched{0};
+    size_t consumed = 0, maxBatch = 0, maxAhead = 0;
+    RunFetchPool(keys, workers, nullptr,
+        [&](int key) { fetched++; return key; },
+        [&](std::vector<int>& batch) {
+            maxBatch = std::max(maxBatch, batch.size());
+            std::this_thread::sleep_for(std::chrono::milliseconds(consumed == 0 ? 200 : 1));
+            maxAhead = std::max(maxAhead, fetched.load() - consumed);
+            consumed += batch.size();
+        });
+    std::printf("back-pressure: largest batch %zu, at most %zu fetched ahead of the consumer\n", maxBatch, maxAhead);
+    CHECK_EQ(consumed, keys.size());
+    CHECK(maxBatch <= bound);
+    CHECK(maxAhead <= bound + workers + bound);
+    // The 200 ms pause did fill the queue
+    CHECK(maxAhead >= bound);
+}
+
+void TestCancel() {
+    const int workers = 4;
+    std::vector<int> keys = Keys(1000);
+    std::atomic<bool> cancel{false};
+    std::atomic<size_t> fetched{0};
+    size_t consumed = 0;
+    RunFetchPool(keys, workers, &cancel,
+        [&](int key) {
+            fetched++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return key;
+        },
+        [&](std::vector<int>& batch) {
+            consumed += batch.size();
+            cancel = true;
+        });
+    std::printf("cancel: %zu of %zu keys fetched\n", fetched.load(), keys.size());
+    CHECK(fetched.load() < keys.size());
+    // Each worker finishes at most the fetch it was in, and all of it is consumed
+    CHECK_EQ(consumed, fetched.load());
+
+    // Cancelled before the start: nothing is fetched
+    size_t calls = 0;
+    RunFetchPool(keys, workers, &cancel, [&](int k) { ++calls; return k; },
+                 [&](std::vector<int>&) { ++calls; });
+    CHECK_EQ(calls, 0u);
+}
+
+}  // namespace
+
+int main() {
+    TestEveryKeyOnce();
+    TestBackPressure();
+    TestCancel();
+    return TestResult("fetch_pool_test");
+}
@@ -0,0 +1,614 @@
+#include "fixture_catalog.h"
+#include "icon_store.h"
+#include "schema.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <unordered_set>
+
+namespace {
+
+// xorshift64*: the standard distributions differ between library
+// implementations, this does not
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t Next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545F4914F6CDD1Dull;
+    }
+    int Below(int n) { return n > 0 ? (int)(Next() % (uint64_t)n) : 0; }
+    int Between(int lo, int hi) { return lo + Below(hi - lo + 1); }
+    double Unit() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+    bool Chance(double p) { return Unit() < p; }
+
+private:
+    uint64_t state_;
+};
+
+const char* const kSyllables[] = {"ka", "lo", "mi", "zu", "pe", "ra", "ti", "no", "ve", "sa",
+                                  "do", "fu", "gi", "ba", "ne", "co", "re", "xi", "la", "mo"};
+// Product words, many of them what NameTagPatterns looks for
+const char* const kWords[] = {
+    "Code",    "Studio",  "Editor",   "Player",  "Viewer",  "Manager",   "Sync",     "Backup",  "Git",     "Zip",
+    "PDF",     "Chrome",  "Browser",  "Media",   "Video",   "Audio",     "Terminal", "Tools",   "SDK",     "Runtime",
+    "Server",  "Client",  "Desktop",  "Notes",   "Mail",    "Chat",      "Office",   "Photo",   "Image",   "Design",
+    "Data",    "SQL",     "Network",  "VPN",     "Cloud",   "Drive",     "Music",    "Game",    "Launcher", "Driver",
+    "Monitor", "Cleaner", "Converter", "Reader", "Recorder", "Writer",   "Finder",   "Explorer", "Emulator", "Toolkit"};
+const char* const kDescriptionWords[] = {
+    "a", "an", "the", "for", "and", "with", "to", "of", "free", "open", "source", "fast", "lightweight", "simple",
+    "powerful", "tool", "app", "application", "that", "lets", "you", "manage", "edit", "view", "files", "documents",
+    "images", "videos", "music", "code", "projects", "cross", "platform", "windows", "desktop", "client", "server",
+    "cloud", "sync", "backup", "secure", "privacy"};
+// The most used winget tags; the rest of the categories are made up
+const char* const kCommonTags[] = {
+    "utilities", "development", "productivity", "multimedia", "internet", "security", "graphics", "games",
+    "education", "office", "network", "system", "audio", "video", "browser", "cli", "editor", "database",
+    "communication", "backup", "cloud", "terminal", "emulator", "driver", "monitoring", "open-source", "file-manager",
+    "compression", "pdf", "music"};
+
+template <size_t N>
+const char* Pick(Random& rng, const char* const (&list)[N]) {
+    return list[rng.Below((int)N)];
+}
+
+std::string Word(Random& rng, int syllables) {
+    std::string word;
+    for (int i = 0; i < syllables; ++i) word += Pick(rng, kSyllables);
+    word[0] = (char)(word[0] - 'a' + 'A');
+    return word;
+}
+
+std::string Guid(Random& rng) {
+    char text[40];
+    uint64_t a = rng.Next(), b = rng.Next();
+    snprintf(text, sizeof(text), "{%08X-%04X-%04X-%04X-%012llX}", (unsigned)(a >> 32), (unsigned)(a >> 16) & 0xFFFF,
+             (unsigned)a & 0xFFFF, (unsigned)(b >> 48), (unsigned long long)(b & 0xFFFFFFFFFFFFull));
+    return text;
+}
+
+// --- Icons ---------------------------------------------------------------------
+
+void Put16(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back((unsigned char)v);
+    out.push_back((unsigned char)(v >> 8));
+}
+
+void Put32(std::vector<unsigned char>& out, uint32_t v) {
+    Put16(out, v & 0xFFFF);
+    Put16(out, v >> 16);
+}
+
+void Put32BigEndian(std::vector<unsigned char>& out, uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((unsigned char)(v >> shift));
+}
+
+uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready) {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        ready = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// size x size straight-alpha BGRA: a disc in the icon's colour on transparency
+std::vector<uint32_t> IconImage(int index, int size) {
+    uint32_t color = 0xFF000000u | (uint32_t)((index * 2654435761u) & 0xFFFFFF);
+    std::vector<uint32_t> pixels((size_t)size * size, 0);
+    double r = size / 2.0 - 0.5;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            double dx = x - r, dy = y - r;
+            if (dx * dx + dy * dy <= r * r) pixels[(size_t)y * size + x] = color ^ (uint32_t)((x ^ y ^ index) & 0x1F);
+        }
+    }
+    return pixels;
+}
+
+void PngChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data) {
+    Put32BigEndian(png, (uint32_t)data.size());
+    size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    Put32BigEndian(png, Crc32(png.data() + start, png.size() - start));
+}
+
+// RGBA PNG whose zlib stream uses stored blocks: valid, and no deflater needed
+std::vector<unsigned char> EncodePng(const std::vector<uint32_t>& pixels, int size) {
+    std::vector<unsigned char> raw;
+    for (int y = 0; y < size; ++y) {
+        raw.push_back(0);   // filter: none
+        for (int x = 0; x < size; ++x) {
+            uint32_t p = pixels[(size_t)y * size + x];
+            raw.push_back((unsigned char)(p >> 16));
+            raw.push_back((unsigned char)(p >> 8));
+            raw.push_back((unsigned char)p);
+            raw.push_back((unsigned char)(p >> 24));
+        }
+    }
+    std::vector<unsigned char> zlib = {0x78, 0x01};
+    for (size_t pos = 0; pos < raw.size() || pos == 0;) {
+        size_t len = std::min<size_t>(65535, raw.size() - pos);
+        zlib.push_back(pos + len == raw.size() ? 1 : 0);
+        Put16(zlib, (uint32_t)len);
+        Put16(zlib, (uint32_t)(~len & 0xFFFF));
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if (len == 0) break;
+    }
+    uint32_t a = 1, b = 0;
+    for (unsigned char c : raw) {
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    Put32BigEndian(zlib, (b << 16) | a);
+
+    std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<unsigned char> header;
+    Put32BigEndian(header, (uint32_t)size);
+    Put32BigEndian(header, (uint32_t)size);
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+    PngChunk(png, "IHDR", header);
+    PngChunk(png, "IDAT", zlib);
+    PngChunk(png, "IEND", {});
+    return png;
+}
+
+// ICO with a 32 bpp BMP frame per size
+std::vector<unsigned char> EncodeIco(int index, const std::vector<int>& sizes) {
+    std::vector<std::vector<unsigned char>> frames;
+    for (int size : sizes) {
+        std::vector<uint32_t> pixels = IconImage(index, size);
+        std::vector<unsigned char> dib;
+        size_t maskRow = ((size + 31) / 32) * 4;
+        Put32(dib, 40);
+        Put32(dib, (uint32_t)size);
+        Put32(dib, (uint32_t)size * 2);   // XOR and AND bitmaps
+        Put16(dib, 1);
+        Put16(dib, 32);
+        Put32(dib, 0);
+        Put32(dib, (uint32_t)(size * size * 4 + maskRow * size));
+        for (int i = 0; i < 4; ++i) Put32(dib, 0);
+        for (int y = size - 1; y >= 0; --y) {
+            for (int x = 0; x < size; ++x) Put32(dib, pixels[(size_t)y * size + x]);
+        }
+        for (int y = size - 1; y >= 0; --y) {
+            std::vector<unsigned char> row(maskRow, 0);
+            for (int x = 0; x < size; ++x) {
+                if ((pixels[(size_t)y * size + x] >> 24) == 0) row[x / 8] |= (unsigned char)(0x80 >> (x % 8));
+            }
+            dib.insert(dib.end(), row.begin(), row.end());
+        }
+        frames.push_back(std::move(dib));
+    }
+    std::vector<unsigned char> ico;
+    Put16(ico, 0);
+    Put16(ico, 1);
+    Put16(ico, (uint32_t)frames.size());
+    uint32_t offset = 6 + 16 * (uint32_t)frames.size();
+    for (size_t i = 0; i < frames.size(); ++i) {
+        ico.push_back((unsigned char)(sizes[i] >= 256 ? 0 : sizes[i]));
+        ico.push_back((unsigned char)(sizes[i] >= 256 ? 0 : sizes[i]));
+        ico.push_back(0);
+        ico.push_back(0);
+        Put16(ico, 1);
+        Put16(ico, 32);
+        Put32(ico, (uint32_t)frames[i].size());
+        Put32(ico, offset);
+        offset += (uint32_t)frames[i].size();
+    }
+    for (const auto& frame : frames) ico.insert(ico.end(), frame.begin(), frame.end());
+    return ico;
+}
+
+// --- SQLite ----------------------------------------------------------------------
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+// Fresh database at `path` (any old file is replaced)
+sqlite3* CreateDatabase(const std::string& path) {
+    std::remove(path.c_str());
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+    Exec(db, "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF;");
+    return db;
+}
+
+void BindText(sqlite3_stmt* stmt, int column, const std::string& text) {
+    if (text.empty()) sqlite3_bind_null(stmt, column);
+    else sqlite3_bind_text(stmt, column, text.c_str(), (int)text.size(), SQLITE_TRANSIENT);
+}
+
+// Insert `text` into a one-column string table; returns its rowid
+long long InsertString(sqlite3* db, const char* table, const std::string& text) {
+    std::string sql = std::string("INSERT INTO ") + table + " VALUES (?);";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return 0;
+    BindText(stmt, 1, text);
+    long long id = sqlite3_step(stmt) == SQLITE_DONE ? sqlite3_last_insert_rowid(db) : 0;
+    sqlite3_finalize(stmt);
+    return id;
+}
+
+bool InsertPair(sqlite3* db, const char* table, long long a, long long b) {
+    std::string sql = std::string("INSERT INTO ") + table + " VALUES (?, ?);";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return false;
+    sqlite3_bind_int64(stmt, 1, a);
+    sqlite3_bind_int64(stmt, 2, b);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+}  // namespace
+
+CatalogFixture MakeCatalogFixture(int apps, unsigned seed) {
+    CatalogFixture fixture;
+    Random rng(seed);
+    if (apps < 1) apps = 1;
+
+    // Categories, with implications between some of them (an app tagged with
+    // the first is usually tagged with the second too) for tag correlation
+    for (const char* tag : kCommonTags) fixture.categories.push_back(tag);
+    int categoryCount = std::max(300, apps / 25);
+    std::unordered_set<std::string> seenCategories(fixture.categories.begin(), fixture.categories.end());
+    while ((int)fixture.categories.size() < categoryCount) {
+        std::string name = Word(rng, rng.Between(2, 4));
+        for (auto& c : name) c = (char)tolower((unsigned char)c);
+        if (rng.Chance(0.1)) name += "-tools";
+        if (seenCategories.insert(name).second) fixture.categories.push_back(name);
+    }
+    std::vector<std::vector<std::pair<int, double>>> implies(categoryCount);
+    for (int i = 0; i < categoryCount / 6; ++i) {
+        int from = rng.Below(categoryCount), to = rng.Below(categoryCount);
+        if (from != to) implies[from].push_back({to, 0.5 + 0.45 * rng.Unit()});
+    }
+    // Popular tags first: weight 1 / (rank + 1)^0.8
+    std::vector<double> cumulative(categoryCount);
+    double total = 0;
+    for (int i = 0; i < categoryCount; ++i) cumulative[i] = total += 1.0 / std::pow(i + 1.0, 0.8);
+
+    // Publishers, each with its favicon
+    int publisherCount = std::max(8, apps / 4);
+    std::vector<std::string> publishers;
+    std::unordered_set<std::string> seenPublishers;
+    while ((int)publishers.size() < publisherCount) {
+        std::string name = Word(rng, rng.Between(2, 4));
+        if (seenPublishers.insert(name).second) publishers.push_back(name);
+    }
+    for (int i = 0; i < publisherCount; ++i) {
+        switch (i % 3) {
+        case 0: fixture.icons.push_back(EncodePng(IconImage(i, 32), 32)); break;
+        case 1: fixture.icons.push_back(EncodeIco(i, {16, 32})); break;
+        default: fixture.icons.push_back(EncodePng(IconImage(i, 64), 64)); break;
+        }
+    }
+
+    std::unordered_set<std::string> seenIds;
+    for (int a = 0; a < apps; ++a) {
+        FixtureApp app;
+        int publisher = rng.Below(publisherCount);
+        std::string product;
+        int words = rng.Between(1, 3);
+        for (int w = 0; w < words; ++w) product += std::string(product.empty() ? "" : " ") + Pick(rng, kWords);
+        if (rng.Chance(0.5)) product = Word(rng, rng.Between(2, 3)) + " " + product;
+        app.publisher = publishers[publisher];
+        app.name = product;
+        std::string compact;
+        for (char c : product) if (c != ' ') compact += c;
+        app.packageId = app.publisher + "." + compact;
+        while (!seenIds.insert(app.packageId).second) app.packageId += "X";
+        app.version = std::to_string(rng.Between(1, 30)) + "." + std::to_string(rng.Below(10)) + "." +
+                      std::to_string(rng.Below(100));
+        if (rng.Chance(0.6)) {
+            for (char c : product) app.moniker += c == ' ' ? '-' : (char)tolower((unsigned char)c);
+        }
+        int descriptionWords = rng.Between(8, 40);
+        for (int w = 0; w < descriptionWords; ++w) app.description += std::string(w ? " " : "") + Pick(rng, kDescriptionWords);
+        app.description[0] = (char)toupper((unsigned char)app.description[0]);
+        app.description += ".";
+        app.homepage = "https://" + publishers[publisher] + ".example/" + compact;
+        for (auto& c : app.homepage) c = (char)tolower((unsigned char)c);
+        if (rng.Chance(0.75)) app.icon = publisher;
+
+        std::set<int> tags;
+        int count = rng.Between(1, 6);
+        for (int t = 0; t < count; ++t) {
+            double pick = rng.Unit() * total;
+            tags.insert((int)(std::lower_bound(cumulative.begin(), cumulative.end(), pick) - cumulative.begin()));
+        }
+        for (int from : std::vector<int>(tags.begin(), tags.end())) {
+            for (const auto& rule : implies[from]) {
+                if (rng.Chance(rule.second)) tags.insert(rule.first);
+            }
+        }
+        if (!rng.Chance(0.05)) app.categories.assign(tags.begin(), tags.end());   // a few apps are uncategorized
+
+        // What winget's index knows to find the app in the Uninstall keys:
+        // MSI product codes, an installer's own key name, or nothing
+        double kind = rng.Unit();
+        if (kind < 0.55) {
+            int codes = rng.Between(1, 3);
+            for (int c = 0; c < codes; ++c) app.productCodes.push_back(Guid(rng));
+        } else if (kind < 0.75) {
+            app.productCodes.push_back(app.name + (rng.Chance(0.5) ? "_is1" : ""));
+        }
+        fixture.apps.push_back(std::move(app));
+    }
+
+    // This machine: a few percent of the catalog installed, mostly under a key
+    // winget's index knows
+    int installed = std::min(apps, std::max(10, apps / 70));
+    std::vector<int> order(apps);
+    for (int i = 0; i < apps; ++i) order[i] = i;
+    for (int i = 0; i < installed; ++i) {
+        std::swap(order[i], order[i + rng.Below(apps - i)]);
+        FixtureApp& app = fixture.apps[order[i]];
+        app.installed = true;
+        app.uninstallKey = !app.productCodes.empty() && rng.Chance(0.85)
+                               ? app.productCodes[rng.Below((int)app.productCodes.size())]
+                               : Guid(rng);
+    }
+    return fixture;
+}
+
+bool WriteFixtureDatabase(const CatalogFixture& fixture, const std::string& path) {
+    sqlite3* db = CreateDatabase(path);
+    if (!db) return false;
+    bool ok = Exec(db,
+                   "CREATE TABLE apps (id INTEGER PRIMARY KEY AUTOINCREMENT, package_id TEXT UNIQUE NOT NULL, name TEXT, "
+                   "version TEXT, publisher TEXT, description TEXT, processed_at DATETIME DEFAULT CURRENT_TIMESTAMP, "
+                   "homepage TEXT, publisher_url TEXT, publisher_support_url TEXT, author TEXT, license TEXT, "
+                   "license_url TEXT, privacy_url TEXT, copyright TEXT, copyright_url TEXT, release_notes_url TEXT, "
+                   "moniker TEXT, release_date TEXT, icon_data BLOB, icon_type TEXT, source TEXT, installer_type TEXT, "
+                   "architecture TEXT, documentation_url TEXT, installer_url TEXT, installer_sha256 TEXT, "
+                   "offline_distribution_supported TEXT, commands TEXT);"
+                   "CREATE TABLE categories (id INTEGER PRIMARY KEY AUTOINCREMENT, category_name TEXT UNIQUE NOT NULL COLLATE NOCASE);"
+                   "CREATE TABLE app_categories (app_id INTEGER, category_id INTEGER, PRIMARY KEY (app_id, category_id), "
+                   "FOREIGN KEY (app_id) REFERENCES apps(id), FOREIGN KEY (category_id) REFERENCES categories(id));"
+                   "CREATE INDEX idx_package_id ON apps(package_id);"
+                   "CREATE INDEX idx_category_name ON categories(category_name);"
+                   "CREATE TABLE installed_apps (package_id TEXT PRIMARY KEY, installed_date TEXT, last_seen TEXT, "
+                   "installed_version TEXT, source TEXT, FOREIGN KEY (package_id) REFERENCES apps(package_id));"
+                   "CREATE INDEX idx_installed_last_seen ON installed_apps(last_seen);"
+                   "BEGIN;");
+
+    sqlite3_stmt* category = nullptr;
+    sqlite3_stmt* app = nullptr;
+    sqlite3_stmt* link = nullptr;
+    sqlite3_stmt* installed = nullptr;
+    ok = ok &&
+         sqlite3_prepare_v2(db, "INSERT INTO categories (category_name) VALUES (?);", -1, &category, nullptr) == SQLITE_OK &&
+         sqlite3_prepare_v2(db,
+                            "INSERT INTO apps (package_id, name, version, publisher, description, homepage, moniker, "
+                            "icon_data, icon_type, source, license) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, 'winget', 'MIT');",
+                            -1, &app, nullptr) == SQLITE_OK &&
+         sqlite3_prepare_v2(db, "INSERT INTO app_categories VALUES (?, ?);", -1, &link, nullptr) == SQLITE_OK &&
+         sqlite3_prepare_v2(db,
+                            "INSERT INTO installed_apps VALUES (?, '2026-01-05 10:00:00', '2026-10-12 08:30:00', ?, 'winget');",
+                            -1, &installed, nullptr) == SQLITE_OK;
+
+    for (size_t i = 0; ok && i < fixture.categories.size(); ++i) {
+        BindText(category, 1, fixture.categories[i]);
+        ok = sqlite3_step(category) == SQLITE_DONE;
+        sqlite3_reset(category);
+    }
+    for (size_t i = 0; ok && i < fixture.apps.size(); ++i) {
+        const FixtureApp& a = fixture.apps[i];
+        BindText(app, 1, a.packageId);
+        BindText(app, 2, a.name);
+        BindText(app, 3, a.version);
+        BindText(app, 4, a.publisher);
+        BindText(app, 5, a.description);
+        BindText(app, 6, a.homepage);
+        BindText(app, 7, a.moniker);
+        if (a.icon >= 0) {
+            const auto& icon = fixture.icons[a.icon];
+            sqlite3_bind_blob(app, 8, icon.data(), (int)icon.size(), SQLITE_STATIC);
+            sqlite3_bind_text(app, 9, icon[0] == 0x89 ? "png" : "ico", -1, SQLITE_STATIC);
+        } else {
+            sqlite3_bind_null(app, 8);
+            sqlite3_bind_null(app, 9);
+        }
+        ok = sqlite3_step(app) == SQLITE_DONE;
+        sqlite3_reset(app);
+        sqlite3_int64 appId = (sqlite3_int64)i + 1;
+        for (int c : a.categories) {
+            if (!ok) break;
+            sqlite3_bind_int64(link, 1, appId);
+            sqlite3_bind_int64(link, 2, c + 1);
+            ok = sqlite3_step(link) == SQLITE_DONE;
+            sqlite3_reset(link);
+        }
+        // The sync script records most of what is installed, not all of it
+        if (ok && a.installed && i % 5 != 0) {
+            BindText(installed, 1, a.packageId);
+            BindText(installed, 2, a.version);
+            ok = sqlite3_step(installed) == SQLITE_DONE;
+            sqlite3_reset(installed);
+        }
+    }
+    sqlite3_finalize(category);
+    sqlite3_finalize(app);
+    sqlite3_finalize(link);
+    sqlite3_finalize(installed);
+    ok = ok && Exec(db, "COMMIT;");
+    sqlite3_close(db);
+    return ok;
+}
+
+bool WriteFixtureWingetIndex(const CatalogFixture& fixture, const std::string& path, int schemaMajor) {
+    sqlite3* db = CreateDatabase(path);
+    if (!db) return false;
+    bool ok = Exec(db, "CREATE TABLE metadata (name TEXT PRIMARY KEY, value TEXT);") &&
+              Exec(db, schemaMajor == 1 ? "INSERT INTO metadata VALUES ('majorVersion', '1'), ('minorVersion', '7');"
+                                        : "INSERT INTO metadata VALUES ('majorVersion', '2'), ('minorVersion', '0');");
+    if (schemaMajor == 1) {
+        ok = ok && Exec(db,
+                        "CREATE TABLE ids (id TEXT NOT NULL);"
+                        "CREATE TABLE names (name TEXT NOT NULL);"
+                        "CREATE TABLE monikers (moniker TEXT NOT NULL);"
+                        "CREATE TABLE versions (version TEXT NOT NULL);"
+                        "CREATE TABLE manifest (id INT64 NOT NULL, name INT64 NOT NULL, moniker INT64, version INT64 NOT NULL);"
+                        "CREATE TABLE tags (tag TEXT NOT NULL);"
+                        "CREATE TABLE tags_map (manifest INT64 NOT NULL, tag INT64 NOT NULL);"
+                        "CREATE TABLE productcodes (productcode TEXT NOT NULL);"
+                        "CREATE TABLE productcodes_map (manifest INT64 NOT NULL, productcode INT64 NOT NULL);");
+    } else {
+        ok = ok && Exec(db,
+                        "CREATE TABLE packages (id TEXT NOT NULL, name TEXT NOT NULL, moniker TEXT, latest_version TEXT NOT NULL);"
+                        "CREATE TABLE tags2 (tag TEXT NOT NULL);"
+                        "CREATE TABLE tags2_map (package INT64 NOT NULL, tag INT64 NOT NULL);"
+                        "CREATE TABLE productcodes2 (productcode TEXT NOT NULL);"
+                        "CREATE TABLE productcodes2_map (package INT64 NOT NULL, productcode INT64 NOT NULL);");
+    }
+    ok = ok && Exec(db, "BEGIN;");
+
+    std::vector<long long> tagIds(fixture.categories.size(), 0);
+    for (size_t i = 0; ok && i < fixture.categories.size(); ++i) {
+        tagIds[i] = InsertString(db, schemaMajor == 1 ? "tags" : "tags2", fixture.categories[i]);
+        ok = tagIds[i] != 0;
+    }
+    sqlite3_stmt* manifest = nullptr;
+    sqlite3_stmt* package = nullptr;
+    if (schemaMajor == 1) {
+        ok = ok && sqlite3_prepare_v2(db, "INSERT INTO manifest VALUES (?, ?, ?, ?);", -1, &manifest, nullptr) == SQLITE_OK;
+    } else {
+        ok = ok && sqlite3_prepare_v2(db, "INSERT INTO packages VALUES (?, ?, ?, ?);", -1, &package, nullptr) == SQLITE_OK;
+    }
+    for (size_t i = 0; ok && i < fixture.apps.size(); ++i) {
+        const FixtureApp& a = fixture.apps[i];
+        std::vector<long long> owners;   // manifests (1.x) or the package row (2.x)
+        if (schemaMajor == 1) {
+            long long id = InsertString(db, "ids", a.packageId);
+            long long name = InsertString(db, "names", a.name);
+            long long moniker = a.moniker.empty() ? 0 : InsertString(db, "monikers", a.moniker);
+            // An older version first; the reader keeps the highest one
+            for (const std::string& version : {std::string("0.9"), a.version}) {
+                long long v = InsertString(db, "versions", version);
+                sqlite3_bind_int64(manifest, 1, id);
+                sqlite3_bind_int64(manifest, 2, name);
+                if (moniker) sqlite3_bind_int64(manifest, 3, moniker);
+                else sqlite3_bind_null(manifest, 3);
+                sqlite3_bind_int64(manifest, 4, v);
+                ok = ok && sqlite3_step(manifest) == SQLITE_DONE;
+                sqlite3_reset(manifest);
+                owners.push_back(sqlite3_last_insert_rowid(db));
+            }
+        } else {
+            BindText(package, 1, a.packageId);
+            BindText(package, 2, a.name);
+            BindText(package, 3, a.moniker);
+            BindText(package, 4, a.version);
+            ok = sqlite3_step(package) == SQLITE_DONE;
+            sqlite3_reset(package);
+            owners.push_back(sqlite3_last_insert_rowid(db));
+        }
+        for (long long owner : owners) {
+            for (int c : a.categories) ok = ok && InsertPair(db, schemaMajor == 1 ? "tags_map" : "tags2_map", owner, tagIds[c]);
+            for (const std::string& code : a.productCodes) {
+                long long codeId = InsertString(db, schemaMajor == 1 ? "productcodes" : "productcodes2", code);
+                ok = ok && codeId && InsertPair(db, schemaMajor == 1 ? "productcodes_map" : "productcodes2_map", owner, codeId);
+            }
+        }
+    }
+    sqlite3_finalize(manifest);
+    sqlite3_finalize(package);
+    ok = ok && Exec(db, "COMMIT;");
+    sqlite3_close(db);
+    return ok;
+}
+
+bool WriteFixtureUninstallExport(const CatalogFixture& fixture, const std::string& path) {
+    Random rng(fixture.apps.size() * 31 + 7);
+    std::string text = "Windows Registry Editor Version 5.00\r\n\r\n";
+    auto escape = [](const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '\\' || c == '"') out += '\\';
+            out += c;
+        }
+        return out;
+    };
+    auto entry = [&](const std::string& key, const std::string& displayName, const std::string& publisher) {
+        double hive = rng.Unit();
+        text += hive < 0.15   ? "[HKEY_CURRENT_USER\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall\\"
+                : hive < 0.35 ? "[HKEY_LOCAL_MACHINE\\SOFTWARE\\WOW6432Node\\Microsoft\\Windows\\CurrentVersion\\Uninstall\\"
+                              : "[HKEY_LOCAL_MACHINE\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall\\";
+        text += key + "]\r\n";
+        text += "\"DisplayName\"=\"" + escape(displayName) + "\"\r\n";
+        if (!publisher.empty()) text += "\"Publisher\"=\"" + escape(publisher) + "\"\r\n";
+        text += "\"EstimatedSize\"=dword:000" + std::to_string(rng.Between(10000, 99999)) + "\r\n";
+        // REG_EXPAND_SZ as regedit writes it: UTF-16 hex bytes, wrapped
+        text += "\"UninstallString\"=hex(2):43,00,3a,00,5c,00,50,00,72,00,6f,00,67,00,72,00,61,00,6d,00,\\\r\n"
+                "  20,00,46,00,69,00,6c,00,65,00,73,00,00,00\r\n\r\n";
+    };
+    for (const FixtureApp& app : fixture.apps) {
+        if (!app.installed) continue;
+        entry(app.uninstallKey, app.name + " " + std::to_string(rng.Between(1, 9)) + "." + std::to_string(rng.Below(10)),
+              app.publisher);
+    }
+    const char* const noise[][2] = {
+        {"Microsoft Visual C++ 2015-2022 Redistributable (x64)", "Microsoft Corporation"},
+        {"NVIDIA Graphics Driver 551.23", "NVIDIA Corporation"},
+        {"Realtek High Definition Audio Driver", "Realtek Semiconductor Corp."},
+        {"Intel(R) Chipset Device Software", "Intel Corporation"},
+        {"Microsoft Edge", "Microsoft Corporation"},
+        {"Microsoft Update Health Tools", "Microsoft Corporation"},
+    };
+    for (int round = 0; round < 8; ++round) {
+        for (const auto& n : noise) entry(Guid(rng), n[0], n[1]);
+    }
+
+    // UTF-16LE with a byte order mark, as regedit exports; the text is ASCII
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.put((char)0xFF);
+    out.put((char)0xFE);
+    for (char c : text) {
+        out.put(c);
+        out.put(0);
+    }
+    return (bool)out;
+}
+
+std::string WriteFixtureFiles(const std::string& dir, int apps) {
+    CatalogFixture fixture = MakeCatalogFixture(apps);
+    if (!WriteFixtureDatabase(fixture, dir + "/catalog.db")) return "cannot write " + dir + "/catalog.db";
+    std::string migrated = dir + "/catalog_migrated.db";
+    if (!WriteFixtureDatabase(fixture, migrated)) return "cannot write " + migrated;
+    sqlite3* db = nullptr;
+    bool ok = sqlite3_open(migrated.c_str(), &db) == SQLITE_OK && MigrateIconStore(db) >= 0 &&
+              MigrateSchema(db) == kSchemaVersion;
+    sqlite3_close(db);
+    if (!ok) return "cannot migrate " + migrated;
+    if (!WriteFixtureWingetIndex(fixture, dir + "/index_v1.db", 1)) return "cannot write " + dir + "/index_v1.db";
+    if (!WriteFixtureWingetIndex(fixture, dir + "/index_v2.db", 2)) return "cannot write " + dir + "/index_v2.db";
+    if (!WriteFixtureUninstallExport(fixture, dir + "/uninstall.reg")) return "cannot write " + dir + "/uninstall.reg";
+    std::ofstream installed(dir + "/installed.txt", std::ios::trunc);
+    for (const FixtureApp& app : fixture.apps) {
+        if (app.installed) installed << app.packageId << "\n";
+    }
+    if (!installed) return "cannot write " + dir + "/installed.txt";
+    return std::string();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// A made-up winget catalog for the tests and benchmarks. The same size and
+// seed always give the same packages on every platform, so the files written
+// from one fixture (app database, winget index, Uninstall export) agree with
+// each other, and none of them has to be checked in: *.db is ignored and a
+// full-size catalog is tens of MB.
+struct FixtureApp {
+    std::string packageId;      // Publisher.Product
+    std::string name;
+    std::string publisher;
+    std::string version;
+    std::string moniker;        // empty for none
+    std::string description;
+    std::string homepage;
+    int icon = -1;              // index into CatalogFixture::icons, -1 for none
+    std::vector<int> categories;              // indexes into CatalogFixture::categories
+    std::vector<std::string> productCodes;    // what winget's index declares
+    bool installed = false;
+    std::string uninstallKey;   // key of its Uninstall entry when installed
+};
+
+struct CatalogFixture {
+    std::vector<FixtureApp> apps;
+    std::vector<std::string> categories;
+    // Favicons as sites serve them: PNG and ICO files, shared by the apps of
+    // one publisher
+    std::vector<std::vector<unsigned char>> icons;
+};
+
+CatalogFixture MakeCatalogFixture(int apps, unsigned seed = 1);
+
+// WinProgramManager.db as the build scripts leave it: schema version 0, icons
+// inline in apps.icon_data, installed_apps filled in by the sync script.
+bool WriteFixtureDatabase(const CatalogFixture& fixture, const std::string& path);
+// winget's source index.db in schema 1.x (a manifest row per version, two
+// versions per package) or 2.x (a packages row per package), with the
+// product codes of every package.
+bool WriteFixtureWingetIndex(const CatalogFixture& fixture, const std::string& path, int schemaMajor);
+// regedit export (UTF-16) of the Uninstall keys of the installed apps, plus
+// drivers and runtimes that are in no catalog.
+bool WriteFixtureUninstallExport(const CatalogFixture& fixture, const std::string& path);
+
+// Everything above for `apps` packages under `dir`: catalog.db, the same
+// database migrated as the updater leaves it (catalog_migrated.db),
+// index_v1.db, index_v2.db, uninstall.reg and installed.txt (the installed
+// package ids, one per line). Returns an error message, empty on success.
+std::string WriteFixtureFiles(const std::string& dir, int apps);
@@ -0,0 +1,274 @@
+// IconCache with an in-process loader in place of the database: the icon
+// painted least recently gives up its slot at capacity, Reset() hands the old
+// slots out again, results decoded for the previous generation are dropped,
+// a full queue drops its oldest requests, and keys that were busy are asked
+// for again instead of failing. SqliteIconLoader reports a locked database
+// as busy.
+//
+// Usage: icon_cache_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "icon_cache.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Serves one favicon for every key, except those told to fail or be busy.
+// Holding a key blocks the worker loading it until Release().
+class FakeLoader {
+public:
+    explicit FakeLoader(std::vector<unsigned char> icon) : icon_(std::move(icon)) {}
+
+    IconCache::LoadBlob Loader() {
+        return [this](int key, std::vector<unsigned char>& blob) {
+            std::unique_lock<std::mutex> lk(mtx_);
+            loads_.push_back(key);
+            changed_.notify_all();
+            if (key == held_) changed_.wait(lk, [this] { return held_ == 0; });
+            if (missing_.count(key)) return IconCache::kNoBlob;
+            if (busy_[key] > 0) {
+                busy_[key]--;
+                return IconCache::kBusy;
+            }
+            if (corrupt_.count(key)) {
+                blob.assign(64, 0x5A);
+            } else {
+                blob = icon_;
+            }
+            return IconCache::kLoaded;
+        };
+    }
+
+    void Hold(int key) { std::lock_guard<std::mutex> lk(mtx_); held_ = key; }
+    void Release() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        held_ = 0;
+        changed_.notify_all();
+    }
+    // Wait until a worker is loading `key`
+    bool WaitLoading(int key) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        return changed_.wait_for(lk, std::chrono::seconds(5),
+                                 [&] { return std::count(loads_.begin(), loads_.end(), key) > 0; });
+    }
+    void Missing(int key) { std::lock_guard<std::mutex> lk(mtx_); missing_.insert(key); }
+    void Corrupt(int key) { std::lock_guard<std::mutex> lk(mtx_); corrupt_.insert(key); }
+    void Busy(int key, int times) { std::lock_guard<std::mutex> lk(mtx_); busy_[key] = times; }
+    std::vector<int> Loads() { std::lock_guard<std::mutex> lk(mtx_); return loads_; }
+    void ClearLoads() { std::lock_guard<std::mutex> lk(mtx_); loads_.clear(); }
+
+private:
+    std::vector<unsigned char> icon_;
+    std::mutex mtx_;
+    std::condition_variable changed_;
+    std::vector<int> loads_;
+    std::set<int> missing_, corrupt_;
+    std::map<int, int> busy_;
+    int held_ = 0;
+};
+
+std::vector<unsigned char> FixtureIcon() {
+    CatalogFixture fixture = MakeCatalogFixture(50, 12);
+    for (const auto& icon : fixture.icons) {
+        IconPixels pixels;
+        if (DecodeIcon(icon.data(), icon.size(), 16, pixels)) return icon;
+    }
+    return {};
+}
+
+// Collect until nothing is pending; the slots installed, in order
+struct Drain {
+    std::vector<int> installed;
+    bool changed = false;
+
+    bool operator()(IconCache& cache) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        for (;;) {
+            changed = cache.Collect([&](int slot, const IconPixels& pixels) {
+                CHECK_EQ(pixels.width, 16);
+                installed.push_back(slot);
+            }) || changed;
+            if (cache.Pending() == 0) return true;
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+void TestEviction(FakeLoader& loader) {
+    const int capacity = 4;
+    IconCache cache(16, capacity, 1, loader.Loader(), nullptr);
+    for (int key = 1; key <= capacity; ++key) CHECK_EQ(cache.Slot(key), IconCache::kPlaceholder);
+    Drain drain;
+    CHECK(drain(cache));
+    CHECK(drain.changed);
+    std::vector<int> slots = drain.installed;
+    std::sort(slots.begin(), slots.end());
+    CHECK(slots == std::vector<int>({1, 2, 3, 4}));
+    CHECK_EQ(cache.Resident(), (size_t)capacity);
+
+    // Paint order 1, 2, 3, 4, then 1 again: 2 is the least recently painted
+    std::map<int, int> slotOf;
+    for (int key = 1; key <= capacity; ++key) slotOf[key] = cache.Slot(key);
+    CHECK(cache.Slot(1) == slotOf[1]);
+    CHECK_EQ(cache.Slot(5), IconCache::kPlaceholder);
+    Drain more;
+    CHECK(more(cache));
+    CHECK_EQ(more.installed.size(), 1u);
+    CHECK_EQ(cache.Slot(5), slotOf[2]);
+    CHECK_EQ(cache.Resident(), (size_t)capacity);
+    CHECK_EQ(cache.Decoded(), 5u);
+    for (int key : {1, 3, 4}) CHECK_EQ(cache.Slot(key), slotOf[key]);
+    // The evicted key is decoded again when painted again
+    CHECK_EQ(cache.Slot(2), IconCache::kPlaceholder);
+    CHECK_EQ(cache.Pending(), 1u);
+    CHECK(more(cache));
+
+    // Reset: nothing resident, and the next icons reuse slots 1.. instead of
+    // growing the ImageList
+    cache.Reset();
+    CHECK_EQ(cache.Resident(), 0u);
+    CHECK_EQ(cache.Pending(), 0u);
+    for (int key = 1; key <= capacity; ++key) CHECK_EQ(cache.Slot(key), IconCache::kPlaceholder);
+    Drain again;
+    CHECK(again(cache));
+    slots = again.installed;
+    std::sort(slots.begin(), slots.end());
+    CHECK(slots == std::vector<int>({1, 2, 3, 4}));
+    CHECK(again.installed.front() == 1);
+}
+
+// A decode still running when Reset() is called belongs to the old database
+void TestStaleGeneration(FakeLoader& loader) {
+    IconCache cache(16, 8, 1, loader.Loader(), nullptr);
+    loader.Hold(20);
+    cache.Slot(20);
+    CHECK(loader.WaitLoading(20));
+    cache.Reset();
+    loader.Release();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool changed = cache.Collect([](int, const IconPixels&) { CHECK(false); });
+    CHECK(!changed);
+    CHECK_EQ(cache.Resident(), 0u);
+    CHECK_EQ(cache.Decoded(), 0u);
+    CHECK_EQ(cache.Failed(), 0u);
+    // Asked for again in the new generation, it is decoded
+    CHECK_EQ(cache.Slot(20), IconCache::kPlaceholder);
+    Drain drain;
+    CHECK(drain(cache));
+    CHECK_EQ(cache.Slot(20), 1);
+}
+
+// Capacity 2 queues at most 4 requests; the oldest are dropped, not failed
+void TestQueueOverflow(FakeLoader& loader) {
+    IconCache cache(16, 2, 1, loader.Loader(), nullptr);
+    loader.ClearLoads();
+    loader.Hold(100);
+    cache.Slot(100);
+    CHECK(loader.WaitLoading(100));
+    for (int key = 101; key <= 110; ++key) cache.Slot(key);
+    // The one being decoded plus the newest four
+    CHECK_EQ(cache.Pending(), 5u);
+    loader.Release();
+    Drain drain;
+    CHECK(drain(cache));
+    std::vector<int> loads = loader.Loads();
+    std::sort(loads.begin(), loads.end());
+    CHECK(loads == std::vector<int>({100, 107, 108, 109, 110}));
+    CHECK_EQ(cache.Failed(), 0u);
+    CHECK_EQ(cache.Decoded(), 5u);
+    // A dropped key is queued again when its row is painted
+    CHECK_EQ(cache.Slot(101), IconCache::kPlaceholder);
+    CHECK_EQ(cache.Pending(), 1u);
+    CHECK(drain(cache));
+    CHECK(cache.Slot(101) != IconCache::kPlaceholder);
+}
+
+void TestUnreadable(FakeLoader& loader) {
+    IconCache cache(16, 8, 2, loader.Loader(), nullptr);
+    loader.Missing(30);
+    loader.Corrupt(31);
+    loader.Busy(32, 2);
+    for (int key : {30, 31, 32}) cache.Slot(key);
+    Drain drain;
+    CHECK(drain(cache));
+    CHECK_EQ(cache.Failed(), 2u);
+    CHECK_EQ(cache.Resident(), 0u);
+    // Failed keys are not asked for again
+    loader.ClearLoads();
+    CHECK_EQ(cache.Slot(30), IconCache::kPlaceholder);
+    CHECK_EQ(cache.Slot(31), IconCache::kPlaceholder);
+    CHECK(drain(cache));
+    for (int key : loader.Loads()) CHECK(key == 32);
+
+    // Busy twice, then loaded: each busy result asks for a repaint, and the
+    // repaint's Slot() queues the key again (the first busy load was above)
+    int rounds = 0;
+    while (cache.Slot(32) == IconCache::kPlaceholder && rounds < 10) {
+        Drain retry;
+        CHECK(retry(cache));
+        CHECK(retry.changed);
+        rounds++;
+    }
+    CHECK(cache.Slot(32) != IconCache::kPlaceholder);
+    CHECK_EQ(cache.Failed(), 2u);
+    std::vector<int> loads = loader.Loads();
+    CHECK_EQ(std::count(loads.begin(), loads.end(), 32), 2);
+}
+
+// A writer's exclusive lock makes the read busy (after the busy timeout), not
+// a missing icon
+void TestSqliteLoader(const std::string& scratch, const std::vector<unsigned char>& icon) {
+    std::string path = scratch + "/icon_cache_test.db";
+    std::remove(path.c_str());
+    std::remove((path + "-journal").c_str());
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    CHECK(sqlite3_exec(db, "CREATE TABLE icons (hash TEXT PRIMARY KEY, type TEXT, data BLOB);", nullptr, nullptr,
+                       nullptr) == SQLITE_OK);
+    sqlite3_stmt* stmt = nullptr;
+    CHECK(sqlite3_prepare_v2(db, "INSERT INTO icons (hash, type, data) VALUES ('h', 'image/png', ?);", -1, &stmt,
+                             nullptr) == SQLITE_OK);
+    sqlite3_bind_blob(stmt, 1, icon.data(), (int)icon.size(), SQLITE_STATIC);
+    CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_finalize(stmt);
+    int key = (int)sqlite3_last_insert_rowid(db);
+
+    IconCache::LoadBlob load = SqliteIconLoader(path);
+    std::vector<unsigned char> blob;
+    CHECK_EQ(load(key, blob), IconCache::kLoaded);
+    CHECK(blob == icon);
+    CHECK_EQ(load(key + 1, blob), IconCache::kNoBlob);
+    CHECK(sqlite3_exec(db, "BEGIN EXCLUSIVE;", nullptr, nullptr, nullptr) == SQLITE_OK);
+    CHECK_EQ(load(key, blob), IconCache::kBusy);
+    CHECK(sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK);
+    CHECK_EQ(load(key, blob), IconCache::kLoaded);
+    sqlite3_close(db);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    std::vector<unsigned char> icon = FixtureIcon();
+    CHECK(!icon.empty());
+    FakeLoader loader(icon);
+    TestEviction(loader);
+    TestStaleGeneration(loader);
+    TestQueueOverflow(loader);
+    TestUnreadable(loader);
+    TestSqliteLoader(argv[1], icon);
+    return TestResult("icon_cache_test");
+}
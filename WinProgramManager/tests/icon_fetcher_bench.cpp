@@ -0,0 +1,98 @@
+// The icon fetcher benchmark: fresh fetchers one package at a time versus one
+// shared fetcher on the pool threads, and the next run with its sources.
+#include "fetch_pool.h"
+#include "icon_fetcher.h"
+#include "icon_store.h"
+#include "wpm_benchmarks.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::string Trim(const std::string& text) {
+    const char* space = " \t\r\n";
+    size_t start = text.find_first_not_of(space);
+    if (start == std::string::npos) return std::string();
+    return text.substr(start, text.find_last_not_of(space) - start + 1);
+}
+
+}  // namespace
+
+std::string BenchmarkIconFetcher(const std::string& homepagesFile, int workers) {
+    std::vector<std::string> homepages;
+    std::ifstream file(homepagesFile);
+    for (std::string line; std::getline(file, line);) {
+        line = Trim(line);
+        if (!line.empty() && line[0] != '#') homepages.push_back(line);
+    }
+    if (homepages.empty()) return "no homepages in " + homepagesFile;
+
+    struct Pass {
+        std::map<std::string, FetchedIcon> icons;
+        double seconds = 0;
+        long long requests = 0, connections = 0, cacheHits = 0, revalidated = 0;
+    };
+    auto found = [](const Pass& pass) {
+        size_t count = 0;
+        for (const auto& icon : pass.icons) count += !icon.second.data.empty() || !icon.second.storedHash.empty();
+        return count;
+    };
+
+    // As before: nothing shared between packages, one at a time
+    Pass single;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& homepage : homepages) {
+        IconFetcher fetcher;
+        single.icons[homepage] = fetcher.Fetch(homepage);
+        single.requests += fetcher.Requests();
+        single.connections += fetcher.Connections();
+    }
+    single.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // One fetcher for the run on the pool threads, then the next run with its sources
+    std::vector<IconSource> sources;
+    Pass shared[2];
+    for (int run = 0; run < 2; ++run) {
+        IconFetcher fetcher;
+        fetcher.Load(sources);
+        Pass& pass = shared[run];
+        start = std::chrono::steady_clock::now();
+        RunFetchPool(homepages, workers, nullptr,
+            [&](const std::string& homepage) { return std::make_pair(homepage, fetcher.Fetch(homepage)); },
+            [&](std::vector<std::pair<std::string, FetchedIcon>>& batch) {
+                for (auto& result : batch) {
+                    // What AddPackage does once the icon is stored
+                    const FetchedIcon& icon = result.second;
+                    if (!icon.data.empty()) fetcher.Stored(icon.url, IconHash(icon.data.data(), icon.data.size()));
+                    pass.icons[result.first] = std::move(result.second);
+                }
+            });
+        pass.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        pass.requests = fetcher.Requests();
+        pass.connections = fetcher.Connections();
+        pass.cacheHits = fetcher.CacheHits();
+        pass.revalidated = fetcher.Revalidated();
+        sources = fetcher.Sources();
+    }
+
+    size_t differ = 0;
+    for (const auto& icon : single.icons) {
+        const FetchedIcon& other = shared[0].icons[icon.first];
+        differ += icon.second.url != other.url || icon.second.data != other.data;
+    }
+
+    char line[640];
+    snprintf(line, sizeof(line),
+             "%zu homepages: one fetcher per package %.2f s (%zu icons, %lld requests, %lld connections); "
+             "shared, %d workers %.2f s (%zu icons, %lld requests, %lld connections, %lld cache hits, %zu differ); "
+             "next run %.2f s (%lld requests, %lld revalidated)",
+             homepages.size(), single.seconds, found(single), single.requests, single.connections, workers,
+             shared[0].seconds, found(shared[0]), shared[0].requests, shared[0].connections, shared[0].cacheHits,
+             differ, shared[1].seconds, shared[1].requests, shared[1].revalidated);
+    return line;
+}
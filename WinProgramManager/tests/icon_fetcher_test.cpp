@@ -0,0 +1,259 @@
+// The icon fetcher's parts on their own: URLs parsed and resolved as browsers
+// do, and IconLinkScanner on pages fed whole, a byte at a time and in random
+// pieces. Given the homepage list of icon_sites.py, also every site's icon
+// through one IconFetcher on four threads: the URL and bytes each kind of page
+// leads to, nothing fetched twice in a run, the next run revalidating every
+// icon with its ETag, and a recently failed icon not asked for again.
+//
+// Usage: icon_fetcher_test [homepages.txt]
+#include "check.h"
+#include "icon_fetcher.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string Parsed(const std::string& text) {
+    HttpUrl url;
+    return ParseUrl(text, url) ? url.ToString() : "-";
+}
+
+std::string Resolved(const std::string& base, const std::string& href) {
+    HttpUrl baseUrl, url;
+    CHECK(ParseUrl(base, baseUrl));
+    return ResolveUrl(baseUrl, href, url) ? url.ToString() : "-";
+}
+
+void TestUrls() {
+    CHECK_EQ(Parsed("http://example.com"), std::string("http://example.com/"));
+    CHECK_EQ(Parsed("  HTTPS://Example.COM:443/a/b?x=1#frag "), std::string("https://example.com/a/b?x=1"));
+    CHECK_EQ(Parsed("http://user:pw@example.com:8080/"), std::string("http://example.com:8080/"));
+    CHECK_EQ(Parsed("http://[::1]:81/x"), std::string("http://[::1]:81/x"));
+    CHECK_EQ(Parsed("http://example.com/a/./b/../c/"), std::string("http://example.com/a/c/"));
+    CHECK_EQ(Parsed("http://example.com/my icon.png"), std::string("http://example.com/my%20icon.png"));
+    CHECK_EQ(Parsed("http://example.com?q"), std::string("http://example.com/?q"));
+    CHECK_EQ(Parsed("ftp://example.com/"), std::string("-"));
+    CHECK_EQ(Parsed("example.com"), std::string("-"));
+    CHECK_EQ(Parsed("http://:80/"), std::string("-"));
+    CHECK_EQ(Parsed("http://example.com:99999/"), std::string("-"));
+    CHECK_EQ(Parsed("http://example.com:8x/"), std::string("-"));
+    CHECK_EQ(Parsed("http://[::1/"), std::string("-"));
+
+    const std::string base = "https://example.com/dir/page.html?x=1";
+    CHECK_EQ(Resolved(base, "icon.png"), std::string("https://example.com/dir/icon.png"));
+    CHECK_EQ(Resolved(base, "/icon.png"), std::string("https://example.com/icon.png"));
+    CHECK_EQ(Resolved(base, "../up.ico"), std::string("https://example.com/up.ico"));
+    CHECK_EQ(Resolved(base, "../../../top.ico"), std::string("https://example.com/top.ico"));
+    CHECK_EQ(Resolved(base, "//cdn.example.net/i.ico"), std::string("https://cdn.example.net/i.ico"));
+    CHECK_EQ(Resolved(base, "?v=2"), std::string("https://example.com/dir/page.html?v=2"));
+    CHECK_EQ(Resolved(base, "favicon.ico?v=1&amp;x=2"), std::string("https://example.com/dir/favicon.ico?v=1&x=2"));
+    CHECK_EQ(Resolved(base, " fav\nicon.ico#top "), std::string("https://example.com/dir/favicon.ico"));
+    CHECK_EQ(Resolved(base, "http://other.org:8080/i.png"), std::string("http://other.org:8080/i.png"));
+    CHECK_EQ(Resolved(base, "data:image/png;base64,AAAA"), std::string("-"));
+    CHECK_EQ(Resolved(base, "javascript:void(0)"), std::string("-"));
+    CHECK_EQ(Resolved(base, "#"), std::string("-"));
+    CHECK_EQ(Resolved(base, "a:b/c.png"), std::string("-"));
+    CHECK_EQ(Resolved(base, "./a:b.png"), std::string("https://example.com/dir/a:b.png"));
+}
+
+// Href of `page` fed in pieces of `piece` bytes (0: whole), and whether the
+// scanner stopped before the end
+std::string Scan(const std::string& page, size_t piece, bool* stopped = nullptr) {
+    IconLinkScanner scanner;
+    bool more = true;
+    if (piece == 0) piece = page.size() + 1;
+    for (size_t pos = 0; pos < page.size() && more; pos += piece) {
+        more = scanner.Feed(page.data() + pos, std::min(piece, page.size() - pos));
+    }
+    if (stopped) *stopped = !more;
+    return scanner.Href();
+}
+
+void TestScanner() {
+    struct Case {
+        const char* page;
+        const char* href;
+    };
+    const Case cases[] = {
+        {"<html><head><link rel=\"icon\" href=\"/a.png\"></head>", "/a.png"},
+        {"<HEAD><LINK REL='Shortcut Icon' HREF='favicon.ico?v=1&amp;x=2'>", "favicon.ico?v=1&amp;x=2"},
+        {"<link href=/i.ico rel=icon>", "/i.ico"},
+        {"<link rel=\"apple-touch-icon\" href=\"/t.png\"><link rel=\"stylesheet\" href=\"s.css\">", ""},
+        {"<link rel=\"icon\" type=\"image/svg+xml\" href=\"/x.svg\"><link rel=\"icon\" href=\"/y.png\">", "/y.png"},
+        {"<link rel=icon href=/X.SVG?v=1><link rel=icon href=/z.ico>", "/z.ico"},
+        {"<link rel=icon href=\"data:image/png;base64,AAAA\"><link rel=icon href=/d.ico>", "/d.ico"},
+        {"<link rel=\"icon\" href=\"  /spaced.ico \">", "/spaced.ico"},
+        {"<link rel=\"alternate icon\" href=\"/alt.ico\">", "/alt.ico"},
+        {"<link rel=\"icons\" href=\"/no.ico\"><link rel=\"icon\">", ""},
+        {"<!-- <link rel=\"icon\" href=\"/c.png\"> --><link rel=icon href=/after.png>", "/after.png"},
+        {"<script>var s = \"<link rel=icon href=/s.png>\";</script><link rel=icon href=/ok.png>", "/ok.png"},
+        {"<SCRIPT type=x>a < b && '</scrip' </ScRiPt ><link rel=icon href=/ok2.png>", "/ok2.png"},
+        {"<script src=x.js /><link rel=icon href=/ok3.png>", "/ok3.png"},
+        {"<style>a>b{}</style><link rel=\"icon\" href=\"../4/i.png\">", "../4/i.png"},
+        {"<meta content=\"a>b\" name=x><link title='x > y' rel=icon href=/q.png>", "/q.png"},
+        {"<head></head><link rel=icon href=/late.png>", ""},
+        {"<body><link rel=icon href=/late.png>", ""},
+        {"<link rel=icon href=/first.png><link rel=icon href=/second.png>", "/first.png"},
+    };
+    std::mt19937 rng(24);
+    for (const Case& c : cases) {
+        const std::string page = c.page;
+        CHECK_EQ(Scan(page, 0), std::string(c.href));
+        CHECK_EQ(Scan(page, 1), std::string(c.href));
+        for (int round = 0; round < 10; ++round) {
+            IconLinkScanner scanner;
+            for (size_t pos = 0; pos < page.size();) {
+                size_t piece = std::min<size_t>(1 + rng() % 7, page.size() - pos);
+                if (!scanner.Feed(page.data() + pos, piece)) break;
+                pos += piece;
+            }
+            CHECK_EQ(scanner.Href(), std::string(c.href));
+        }
+    }
+
+    // Scanning stops at the icon or the end of the head, however long the rest is
+    bool stopped = false;
+    std::string tail(100000, 'x');
+    CHECK_EQ(Scan("<link rel=icon href=/a.ico>" + tail, 4096, &stopped), std::string("/a.ico"));
+    CHECK(stopped);
+    CHECK_EQ(Scan("<head><title>t</title></head>" + tail, 4096, &stopped), std::string());
+    CHECK(stopped);
+    CHECK_EQ(Scan("<head><title>t</title>" + tail, 4096, &stopped), std::string());
+    CHECK(!stopped);
+    // A tag that never ends is given up on, not buffered whole
+    CHECK_EQ(Scan("<div " + tail + "<link rel=icon href=/b.ico>", 4096), std::string("/b.ico"));
+}
+
+// What icon_sites.py serves for the homepage of site `n` on `origin`, per
+// kind of page (n % 6): the icon URL, empty if the page fails, and its bytes
+struct Expected {
+    std::string url;
+    std::string data;
+};
+
+Expected ExpectedIcon(const HttpUrl& homepage, int n) {
+    const std::string origin = homepage.Origin();
+    const std::string site = "/site/" + std::to_string(n) + "/";
+    const std::string ico("\0\0\1\0", 4);
+    switch (n % 6) {
+    case 0:
+        return {origin + "/icons/a.png", "\x89PNG\r\n\x1a\n" + std::string(300, 'A')};
+    case 1:
+        return {origin + site + "favicon.ico?v=1&x=2", ico + site + "favicon.ico"};
+    case 2:
+        return {"http://127.0.0.1:" + std::to_string(homepage.port) + "/icons/b.ico", ico + std::string(200, 'B')};
+    case 3:
+        return {origin + "/favicon.ico", ico + "/favicon.ico"};
+    case 4:
+        return {origin + site + "i.png", ico + site + "i.png"};
+    default:
+        return {};
+    }
+}
+
+// Fetch every homepage through `fetcher` on four threads
+std::map<std::string, FetchedIcon> FetchAll(IconFetcher& fetcher, const std::vector<std::string>& homepages) {
+    std::vector<FetchedIcon> icons(homepages.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (size_t i; (i = next++) < homepages.size();) icons[i] = fetcher.Fetch(homepages[i]);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    std::map<std::string, FetchedIcon> byHomepage;
+    for (size_t i = 0; i < homepages.size(); ++i) byHomepage[homepages[i]] = icons[i];
+    return byHomepage;
+}
+
+void TestSites(const std::string& homepagesFile) {
+    std::vector<std::string> homepages;
+    std::ifstream file(homepagesFile);
+    for (std::string line; std::getline(file, line);) {
+        if (!line.empty()) homepages.push_back(line);
+    }
+    CHECK(homepages.size() > 100);
+
+    std::map<std::string, Expected> expected;
+    std::set<std::string> iconUrls;
+    for (const std::string& homepage : homepages) {
+        HttpUrl url;
+        CHECK(ParseUrl(homepage, url));
+        int n = -1;
+        if (std::sscanf(url.path.c_str(), "/site/%d/", &n) != 1) n = 5;   // dead hosts and TLS: nothing
+        expected[homepage] = ExpectedIcon(url, n);
+        if (!expected[homepage].url.empty()) iconUrls.insert(expected[homepage].url);
+    }
+
+    // One run: every icon as served, each page and icon URL requested once
+    IconFetcher fetcher(2000, 2);
+    std::map<std::string, FetchedIcon> icons = FetchAll(fetcher, homepages);
+    size_t wrong = 0, found = 0;
+    for (const auto& entry : icons) {
+        const Expected& want = expected[entry.first];
+        const FetchedIcon& got = entry.second;
+        bool ok = got.url == want.url && std::string(got.data.begin(), got.data.end()) == want.data &&
+                  got.storedHash.empty();
+        if (!ok) std::fprintf(stderr, "%s: got '%s', expected '%s'\n", entry.first.c_str(), got.url.c_str(),
+                              want.url.c_str());
+        wrong += !ok;
+        found += !got.data.empty();
+        if (!got.data.empty()) fetcher.Stored(got.url, "hash:" + got.url);
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK(found > homepages.size() / 2);
+    const long long requests = fetcher.Requests();
+    CHECK(fetcher.CacheHits() >= (long long)(found - iconUrls.size()));
+    CHECK(requests < (long long)(homepages.size() + found));
+
+    // Again in the same run: all from the cache
+    CHECK(FetchAll(fetcher, homepages).size() == homepages.size());
+    CHECK_EQ(fetcher.Requests(), requests);
+
+    // The next run: stored icons come back as 304 Not Modified
+    std::vector<IconSource> sources = fetcher.Sources();
+    CHECK_EQ(sources.size(), iconUrls.size());
+    IconFetcher next(2000, 2);
+    next.Load(sources);
+    wrong = 0;
+    for (const auto& entry : FetchAll(next, homepages)) {
+        const Expected& want = expected[entry.first];
+        const FetchedIcon& got = entry.second;
+        wrong += got.url != want.url || !got.data.empty() ||
+                 got.storedHash != (want.url.empty() ? std::string() : "hash:" + want.url);
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK_EQ(next.Revalidated(), (long long)iconUrls.size());
+
+    // An icon that failed yesterday is not asked for again within the week
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::string& homepage = homepages[0];
+    IconFetcher retry(2000, 2);
+    retry.Load({{expected[homepage].url, "", "", "", now - 24 * 3600}});
+    FetchedIcon icon = retry.Fetch(homepage);
+    CHECK_EQ(icon.url, expected[homepage].url);
+    CHECK(icon.data.empty() && icon.storedHash.empty());
+    CHECK_EQ(retry.Requests(), 1);
+
+    std::printf("%zu homepages, %zu icons from %zu URLs in %lld requests\n", homepages.size(), found, iconUrls.size(),
+                requests);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    TestUrls();
+    TestScanner();
+    if (argc > 1) TestSites(argv[1]);
+    return TestResult("icon_fetcher_test");
+}
@@ -0,0 +1,112 @@
+"""Stand-in homepages for the icon fetcher benchmark.
+
+Serves 120 small sites on loopback (8 hosts, 127.0.0.1-8, one port) whose
+pages declare their favicon in the ways real ones do -- quoted and unquoted
+<link> attributes, relative and protocol-relative hrefs, icons in comments
+and scripts that must be ignored, redirects, 404s, chunked bodies -- with a
+fixed delay per request. Writes the homepage list, plus two dead hosts and a
+TLS URL, and runs the command with {homepages} replaced by its path.
+
+Usage: icon_sites.py <homepages.txt> <delay s> -- <command...>
+"""
+import subprocess
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+SITES = 120
+HOSTS = 8
+
+homepages_path, delay = sys.argv[1], float(sys.argv[2])
+command = sys.argv[sys.argv.index('--') + 1:]
+
+ICONS = {'/icons/a.png': b'\x89PNG\r\n\x1a\n' + b'A' * 300, '/icons/b.ico': b'\0\0\1\0' + b'B' * 200}
+
+
+def page(n, port):
+    head = '<html><head><title>x</title>'
+    kind = n % 6
+    if kind == 0:
+        head += '<link rel="stylesheet" href="s.css"><link rel="icon" href="/icons/a.png">'
+    elif kind == 1:
+        head += "<LINK REL='Shortcut Icon' HREF='favicon.ico?v=1&amp;x=2'>"
+    elif kind == 2:
+        head += ('<link rel=icon type=image/svg+xml href=x.svg><link rel="apple-touch-icon" href="/t.png">'
+                 '<link href="//127.0.0.1:%d/icons/b.ico" rel="icon">' % port)
+    elif kind == 3:
+        head += ('<!-- <link rel="icon" href="/bad1.png"> -->'
+                 '<script>var s = "<link rel=icon href=/bad2.png>";</script>')
+    elif kind == 4:
+        head += '<style>a>b{}</style><link rel="icon" href="../%d/i.png">' % n
+    # A long body, and an icon past </head> that must not be found
+    return (head + '</head><body>' + 'x' * 200000 + '<link rel=icon href=/late.png></body></html>').encode()
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def log_message(self, *args):
+        pass
+
+    def send(self, code, body=b'', headers=(), chunked=False):
+        self.send_response(code)
+        for key, value in headers:
+            self.send_header(key, value)
+        try:
+            if chunked:
+                self.send_header('Transfer-Encoding', 'chunked')
+                self.end_headers()
+                for i in range(0, len(body), 1000):
+                    chunk = body[i:i + 1000]
+                    self.wfile.write(b'%x\r\n' % len(chunk) + chunk + b'\r\n')
+                self.wfile.write(b'0\r\n\r\n')
+            else:
+                self.send_header('Content-Length', str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+    def do_GET(self):
+        time.sleep(delay)
+        path = self.path
+        port = self.server.server_address[1]
+        if path.startswith('/site/') and (path.endswith('/') or path.endswith('/real')):
+            n = int(path.split('/')[2])
+            if n % 6 == 5:
+                return self.send(404, b'<html><body>nope</body></html>')
+            if n % 6 == 4 and not path.endswith('/real'):
+                return self.send(302, b'<html><body>moved</body></html>', [('Location', '/site/%d/real' % n)])
+            return self.send(200, page(n, port), [('Content-Type', 'text/html')], chunked=(n % 2 == 0))
+        path = path.split('?')[0]
+        body = ICONS.get(path)
+        if body is None and (path.endswith('/favicon.ico') or path.endswith('/i.png')):
+            body = b'\0\0\1\0' + path.encode()
+        if body is None:
+            return self.send(404, b'no')
+        etag = '"%08x"' % (sum(body) * 2654435761 % 2**32)
+        if self.headers.get('If-None-Match') == etag:
+            return self.send(304, headers=[('ETag', etag)])
+        self.send(200, body, [('ETag', etag), ('Content-Type', 'image/x-icon')])
+
+
+class Server(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def handle_error(self, request, client_address):
+        # The fetcher hangs up once it has read the <head> of a page
+        if not isinstance(sys.exc_info()[1], ConnectionError):
+            super().handle_error(request, client_address)
+
+
+server = Server(('0.0.0.0', 0), Handler)
+port = server.server_address[1]
+threading.Thread(target=server.serve_forever, daemon=True).start()
+
+with open(homepages_path, 'w') as out:
+    for n in range(SITES):
+        out.write('http://127.0.0.%d:%d/site/%d/\n' % (n % HOSTS + 1, port, n))
+    out.write('http://127.0.0.1:1/dead/\nhttp://127.0.0.1:1/dead2/\nhttps://127.0.0.1:%d/tls/\n' % port)
+
+sys.exit(subprocess.call([arg.replace('{homepages}', homepages_path) for arg in command]))
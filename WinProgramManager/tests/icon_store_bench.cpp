@@ -0,0 +1,103 @@
+// Benchmark of the icon store migration: apps scan and catalog load with
+// icons inline in apps, and again after MigrateIconStore.
+#include "wpm_benchmarks.h"
+#include "catalog.h"
+#include "icon_store.h"
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+long long FileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? (long long)file.tellg() : -1;
+}
+
+int QueryInt(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    int value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+}  // namespace
+
+std::string BenchmarkIconStore(const std::string& dbPath) {
+    // Work on a copy; the migration rewrites the file
+    std::string copyPath = dbPath + ".iconstore-bench";
+    {
+        std::ifstream in(dbPath, std::ios::binary);
+        std::ofstream out(copyPath, std::ios::binary | std::ios::trunc);
+        if (!in || !out) return "cannot copy " + dbPath + " to " + copyPath;
+        out << in.rdbuf();
+        if (!out) return "cannot copy " + dbPath + " to " + copyPath;
+    }
+
+    // One fresh connection per measurement so SQLite's page cache starts empty
+    auto measure = [&copyPath](double& scanMs, double& loadMs, size_t& apps) {
+        sqlite3* db = nullptr;
+        scanMs = loadMs = -1;
+        apps = 0;
+        if (sqlite3_open_v2(copyPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK) {
+            // The apps scan LoadAllDataIntoMemory starts with
+            auto start = std::chrono::steady_clock::now();
+            sqlite3_stmt* stmt;
+            if (sqlite3_prepare_v2(db, "SELECT id, package_id, name, version, publisher, homepage FROM apps "
+                                       "WHERE name IS NOT NULL AND TRIM(name) != '' ORDER BY name;",
+                                   -1, &stmt, nullptr) == SQLITE_OK) {
+                while (sqlite3_step(stmt) == SQLITE_ROW) {
+                }
+                sqlite3_finalize(stmt);
+                scanMs = MillisecondsSince(start);
+            }
+        }
+        sqlite3_close(db);
+        db = nullptr;
+        if (sqlite3_open_v2(copyPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK) {
+            auto start = std::chrono::steady_clock::now();
+            AppCatalog catalog;
+            if (catalog.Load(db)) {
+                loadMs = MillisecondsSince(start);
+                apps = catalog.AppCount();
+            }
+        }
+        sqlite3_close(db);
+    };
+
+    long long sizeBefore = FileSize(copyPath);
+    double scanBefore, loadBefore, scanAfter, loadAfter;
+    size_t appsBefore, appsAfter;
+    measure(scanBefore, loadBefore, appsBefore);
+
+    sqlite3* db = nullptr;
+    int moved = -1;
+    size_t icons = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (sqlite3_open(copyPath.c_str(), &db) == SQLITE_OK) {
+        moved = MigrateIconStore(db);
+        icons = (size_t)QueryInt(db, "SELECT COUNT(*) FROM icons;");
+    }
+    sqlite3_close(db);
+    double migrateMs = MillisecondsSince(start);
+    long long sizeAfter = FileSize(copyPath);
+    measure(scanAfter, loadAfter, appsAfter);
+    std::remove(copyPath.c_str());
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "inline: %.1f MB, apps scan %.1f ms, catalog load %.1f ms (%zu apps); "
+             "migrated %d icons into %zu distinct in %.0f ms; "
+             "icon store: %.1f MB, apps scan %.1f ms, catalog load %.1f ms (%zu apps)",
+             sizeBefore / 1048576.0, scanBefore, loadBefore, appsBefore, moved, icons, migrateMs,
+             sizeAfter / 1048576.0, scanAfter, loadAfter, appsAfter);
+    return line;
+}
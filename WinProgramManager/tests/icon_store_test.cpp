@@ -0,0 +1,246 @@
+// The icon store on the fixture catalog.db: MigrateIconStore moves every
+// inline apps.icon_data into icons once per distinct image and points
+// apps.icon_hash at it, does nothing more when the database is opened again
+// except pick up icons written inline since, PruneIcons drops the unused ones
+// and TranscodeStoredIcons turns the rest into icon bitmaps.
+//
+// Usage: icon_store_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "icon_decoder.h"
+#include "icon_store.h"
+#include <sqlite3.h>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+int QueryInt(sqlite3* db, const std::string& sql) {
+    sqlite3_stmt* stmt = nullptr;
+    int value = -1;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+struct StoredIcon {
+    std::string type;
+    std::vector<unsigned char> data;
+};
+
+// package_id -> icon_hash ("" for NULL), and the icons table
+struct IconState {
+    std::map<std::string, std::string> hashOf;
+    std::map<std::string, StoredIcon> icons;
+
+    bool operator==(const IconState& other) const {
+        if (hashOf != other.hashOf || icons.size() != other.icons.size()) return false;
+        for (const auto& entry : icons) {
+            auto it = other.icons.find(entry.first);
+            if (it == other.icons.end() || it->second.type != entry.second.type || it->second.data != entry.second.data) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+IconState ReadState(sqlite3* db) {
+    IconState state;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT package_id, icon_hash FROM apps;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* hash = (const char*)sqlite3_column_text(stmt, 1);
+            state.hashOf[(const char*)sqlite3_column_text(stmt, 0)] = hash ? hash : "";
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (sqlite3_prepare_v2(db, "SELECT hash, type, data FROM icons;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            StoredIcon& icon = state.icons[(const char*)sqlite3_column_text(stmt, 0)];
+            const char* type = (const char*)sqlite3_column_text(stmt, 1);
+            icon.type = type ? type : "";
+            const unsigned char* data = (const unsigned char*)sqlite3_column_blob(stmt, 2);
+            icon.data.assign(data, data + sqlite3_column_bytes(stmt, 2));
+        }
+    }
+    sqlite3_finalize(stmt);
+    return state;
+}
+
+sqlite3* Open(const std::string& path) {
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    return db;
+}
+
+bool SetInlineIcon(sqlite3* db, const std::string& packageId, const std::vector<unsigned char>& data, const char* type) {
+    sqlite3_stmt* stmt = nullptr;
+    bool ok = sqlite3_prepare_v2(db, "UPDATE apps SET icon_data = ?, icon_type = ? WHERE package_id = ?;", -1, &stmt,
+                                 nullptr) == SQLITE_OK;
+    if (ok) {
+        sqlite3_bind_blob(stmt, 1, data.data(), (int)data.size(), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, type, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, packageId.c_str(), -1, SQLITE_STATIC);
+        ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) == 1;
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+std::string Hash(const std::vector<unsigned char>& data) { return IconHash(data.data(), data.size()); }
+
+void TestIconHash() {
+    CHECK_EQ(IconHash((const unsigned char*)"", 0),
+             std::string("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+    CHECK_EQ(IconHash((const unsigned char*)"abc", 3),
+             std::string("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+    // Past one 64-byte block, with the length spilling into a second padding block
+    std::string a(1000000, 'a');
+    CHECK_EQ(IconHash((const unsigned char*)a.data(), a.size()),
+             std::string("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"));
+    const char* two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    CHECK_EQ(IconHash((const unsigned char*)two, 56),
+             std::string("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+}
+
+void TestMigrate(const CatalogFixture& fixture, const std::string& path) {
+    std::remove(path.c_str());
+    CHECK(WriteFixtureDatabase(fixture, path));
+
+    size_t withIcon = 0;
+    std::set<std::string> distinct;
+    for (const FixtureApp& app : fixture.apps) {
+        if (app.icon < 0) continue;
+        withIcon++;
+        distinct.insert(Hash(fixture.icons[app.icon]));
+    }
+    CHECK(distinct.size() > 1 && distinct.size() < withIcon);
+
+    sqlite3* db = Open(path);
+    CHECK_EQ(MigrateIconStore(db), (int)withIcon);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM apps WHERE icon_data IS NOT NULL OR icon_type IS NOT NULL;"), 0);
+    IconState state = ReadState(db);
+    // One row per distinct image, keyed by its hash, with the type the build
+    // script gave it
+    CHECK_EQ(state.icons.size(), distinct.size());
+    for (const auto& entry : state.icons) {
+        CHECK_EQ(entry.first, Hash(entry.second.data));
+        CHECK(entry.second.type == (entry.second.data[0] == 0x89 ? "png" : "ico"));
+    }
+    for (const FixtureApp& app : fixture.apps) {
+        CHECK_EQ(state.hashOf[app.packageId], app.icon < 0 ? std::string() : Hash(fixture.icons[app.icon]));
+    }
+    sqlite3_close(db);
+
+    // Opened again: nothing to move, nothing changes
+    db = Open(path);
+    CHECK_EQ(MigrateIconStore(db), 0);
+    CHECK(ReadState(db) == state);
+
+    // Icons the build scripts wrote inline since: an app without one gets the
+    // image of an app with one (already stored, and still used), which gets a
+    // new image
+    const FixtureApp* noIcon = nullptr;
+    const FixtureApp* changed = nullptr;
+    for (const FixtureApp& app : fixture.apps) {
+        if (!noIcon && app.icon < 0) {
+            noIcon = &app;
+        } else if (!changed && app.icon >= 0) {
+            changed = &app;
+        }
+    }
+    CHECK(noIcon && changed);
+    if (!noIcon || !changed) return;
+    const std::vector<unsigned char>& shared = fixture.icons[changed->icon];
+    std::vector<unsigned char> fresh = fixture.icons[0];
+    fresh.push_back(0);   // trailing byte: another hash, still a readable PNG
+    CHECK(SetInlineIcon(db, noIcon->packageId, shared, "png"));
+    CHECK(SetInlineIcon(db, changed->packageId, fresh, "png"));
+    CHECK_EQ(MigrateIconStore(db), 2);
+    IconState after = ReadState(db);
+    CHECK_EQ(after.icons.size(), state.icons.size() + 1);
+    CHECK_EQ(after.hashOf[noIcon->packageId], Hash(shared));
+    CHECK_EQ(after.hashOf[changed->packageId], Hash(fresh));
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM apps WHERE icon_data IS NOT NULL;"), 0);
+    sqlite3_close(db);
+}
+
+// Icons no app points at any more are deleted, once
+void TestPrune(const std::string& path) {
+    sqlite3* db = Open(path);
+    CHECK_EQ(PruneIcons(db), 0);
+    IconState state = ReadState(db);
+    std::string dropped;
+    for (const auto& entry : state.hashOf) {
+        if (!entry.second.empty()) dropped = entry.second;
+    }
+    CHECK(!dropped.empty());
+    CHECK(sqlite3_exec(db, ("UPDATE apps SET icon_hash = NULL WHERE icon_hash = '" + dropped + "';").c_str(), nullptr,
+                       nullptr, nullptr) == SQLITE_OK);
+    CHECK_EQ(PruneIcons(db), 1);
+    CHECK_EQ(PruneIcons(db), 0);
+    IconState after = ReadState(db);
+    CHECK_EQ(after.icons.size(), state.icons.size() - 1);
+    CHECK(!after.icons.count(dropped));
+    sqlite3_close(db);
+}
+
+void TestTranscode(const std::string& path) {
+    sqlite3* db = Open(path);
+    IconState before = ReadState(db);
+    // An HTML error page saved as a favicon cannot be read: its app loses the icon
+    std::string lost;
+    for (const auto& entry : before.hashOf) {
+        if (!entry.second.empty()) lost = entry.first;
+    }
+    const std::string page = "<html><body>404 Not Found</body></html>";
+    CHECK(SetInlineIcon(db, lost, std::vector<unsigned char>(page.begin(), page.end()), "png"));
+    CHECK_EQ(MigrateIconStore(db), 1);
+    before = ReadState(db);
+
+    CHECK_EQ(TranscodeStoredIcons(db), (int)before.icons.size() - 1);
+    IconState after = ReadState(db);
+    CHECK_EQ(after.hashOf[lost], std::string());
+    for (const auto& entry : after.icons) {
+        CHECK_EQ(entry.second.type, std::string(kIconBitmapType));
+        CHECK(IsIconBitmap(entry.second.data.data(), entry.second.data.size()));
+        CHECK_EQ(entry.first, Hash(entry.second.data));
+    }
+    // Every other app still has an icon, and it exists
+    for (const auto& entry : after.hashOf) {
+        if (entry.first == lost) continue;
+        CHECK_EQ(entry.second.empty(), before.hashOf[entry.first].empty());
+        if (!entry.second.empty()) CHECK(after.icons.count(entry.second) == 1);
+    }
+    sqlite3_close(db);
+
+    // Opened again: nothing left to move or transcode
+    db = Open(path);
+    CHECK_EQ(MigrateIconStore(db), 0);
+    CHECK_EQ(TranscodeStoredIcons(db), 0);
+    CHECK(ReadState(db) == after);
+    sqlite3_close(db);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    std::string path = std::string(argv[1]) + "/icon_store_test.db";
+    CatalogFixture fixture = MakeCatalogFixture(400, 17);
+    TestIconHash();
+    TestMigrate(fixture, path);
+    TestPrune(path);
+    TestTranscode(path);
+    std::remove(path.c_str());
+    return TestResult("icon_store_test");
+}
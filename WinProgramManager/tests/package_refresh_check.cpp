@@ -0,0 +1,252 @@
+// Check of the weekly version-diff refresh (FindChangedPackages and
+// RefreshPackage) on two snapshots of a fixture catalog, run by
+// package_refresh_test and `wpm_bench --check-refresh`.
+#include "wpm_benchmarks.h"
+#include "icon_store.h"
+#include "package_refresh.h"
+#include "updater_store.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::string ColumnText(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// --- Fixture ----------------------------------------------------------------
+
+// One package of a fixture catalog: how Step 1 lists it and what `winget show`
+// reports for it
+struct FixturePackage {
+    std::string id;
+    bool listed = true;
+    std::string listedVersion;
+    std::string version, description, icon;
+    std::vector<std::string> tags;
+};
+
+// Week 0 lists `packages` packages, one in three with an icon. A week later
+// one in ten has a new version (new description and tags; half of them a new
+// icon, the others none), one in twenty-five is listed as "1.x" for the
+// stored "1.x.0", one in forty has a new version the listing truncated away,
+// one in fifty is gone, and one in twenty of the count is new
+std::vector<FixturePackage> FixtureSnapshot(int packages, int week) {
+    std::vector<FixturePackage> snapshot;
+    for (int i = 0; i < packages; ++i) {
+        FixturePackage p;
+        p.id = "Publisher" + std::to_string(i % 50) + ".App" + std::to_string(i);
+        std::string minor = "1." + std::to_string(i % 7);
+        p.version = minor + ".0";
+        p.tags = {"cat" + std::to_string(i % 13), "cat" + std::to_string(13 + i % 17)};
+        if (week == 0 && i % 3 == 0) p.icon = "icon " + std::to_string(i);
+        if (week > 0 && i % 10 == 3) {
+            p.version = minor + ".1";
+            p.tags = {"cat" + std::to_string((i + 1) % 13), "new" + std::to_string(i % 5)};
+            if (i % 20 == 13) p.icon = "icon " + std::to_string(i) + " at " + p.version;
+        }
+        if (week > 0 && i % 40 == 21) p.version = minor + ".1";
+        p.description = "App " + std::to_string(i) + " at " + p.version;
+        p.listedVersion = p.version;
+        if (week > 0 && i % 25 == 7) p.listedVersion = minor;
+        if (week > 0 && i % 40 == 21) p.listedVersion.clear();
+        p.listed = week == 0 || i % 50 != 9;
+        snapshot.push_back(p);
+    }
+    for (int i = 0; week > 0 && i < packages / 20; ++i) {
+        FixturePackage p;
+        p.id = "Newcomer.App" + std::to_string(i);
+        p.version = p.listedVersion = "1.0";
+        snapshot.push_back(p);
+    }
+    return snapshot;
+}
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+// Step 1: the listing in search_db.search_results
+void ListSnapshot(sqlite3* db, const std::vector<FixturePackage>& snapshot) {
+    Exec(db, "DELETE FROM search_db.search_results;");
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO search_db.search_results (package_id, version) VALUES (?, ?);",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    Exec(db, "BEGIN;");
+    for (const FixturePackage& p : snapshot) {
+        if (!p.listed) continue;
+        sqlite3_bind_text(stmt, 1, p.id.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, p.listedVersion.c_str(), -1, SQLITE_STATIC);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    Exec(db, "COMMIT;");
+    sqlite3_finalize(stmt);
+}
+
+// What `winget show` reports for a fixture package
+PackageInfo Shown(const FixturePackage& p) {
+    PackageInfo info;
+    info.packageId = p.id;
+    info.name = p.id.substr(p.id.find('.') + 1);
+    info.version = p.version;
+    info.description = p.description;
+    info.tags = p.tags;
+    info.iconData.assign(p.icon.begin(), p.icon.end());
+    if (!p.icon.empty()) info.iconType = "png";
+    return info;
+}
+
+std::string FixtureIconHash(const FixturePackage& p) {
+    return p.icon.empty() ? "" : IconHash(reinterpret_cast<const unsigned char*>(p.icon.data()), p.icon.size());
+}
+
+struct StoredApp {
+    int id = 0;
+    std::string version, description, iconHash;
+    bool tagsUpdated = false;
+    std::vector<std::string> categories;   // sorted
+
+    bool operator==(const StoredApp& o) const {
+        return id == o.id && version == o.version && description == o.description && iconHash == o.iconHash &&
+               tagsUpdated == o.tagsUpdated && categories == o.categories;
+    }
+};
+
+std::map<std::string, StoredApp> StoredApps(sqlite3* db) {
+    std::map<std::string, StoredApp> apps;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db,
+                           "SELECT a.package_id, a.id, a.version, a.description, a.icon_hash, a.tags_updated, "
+                           "c.category_name FROM apps a "
+                           "LEFT JOIN app_categories ac ON ac.app_id = a.id "
+                           "LEFT JOIN categories c ON c.id = ac.category_id "
+                           "ORDER BY a.package_id, c.category_name;",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return apps;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        StoredApp& app = apps[ColumnText(stmt, 0)];
+        app.id = sqlite3_column_int(stmt, 1);
+        app.version = ColumnText(stmt, 2);
+        app.description = ColumnText(stmt, 3);
+        app.iconHash = ColumnText(stmt, 4);
+        app.tagsUpdated = sqlite3_column_int(stmt, 5) != 0;
+        if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) app.categories.push_back(ColumnText(stmt, 6));
+    }
+    sqlite3_finalize(stmt);
+    return apps;
+}
+
+}  // namespace
+
+std::string CheckPackageRefresh(int packages, bool& ok) {
+    ok = false;
+    sqlite3* db = nullptr;
+    if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return "cannot open an in-memory database";
+    }
+    // The columns AddPackage writes, as the build scripts and migrations leave them
+    Exec(db,
+         "CREATE TABLE apps (id INTEGER PRIMARY KEY AUTOINCREMENT, package_id TEXT UNIQUE NOT NULL, name TEXT, "
+         "version TEXT, publisher TEXT, description TEXT, homepage TEXT, publisher_url TEXT, "
+         "publisher_support_url TEXT, author TEXT, license TEXT, license_url TEXT, privacy_url TEXT, "
+         "copyright TEXT, copyright_url TEXT, release_notes_url TEXT, moniker TEXT, release_date TEXT, "
+         "icon_hash TEXT, source TEXT, installer_type TEXT, architecture TEXT, documentation_url TEXT, "
+         "installer_url TEXT, installer_sha256 TEXT, offline_distribution_supported TEXT, commands TEXT, "
+         "tags_updated INTEGER NOT NULL DEFAULT 0);"
+         "CREATE TABLE icons (hash TEXT PRIMARY KEY, type TEXT, data BLOB NOT NULL);"
+         "CREATE TABLE categories (id INTEGER PRIMARY KEY AUTOINCREMENT, category_name TEXT UNIQUE NOT NULL COLLATE NOCASE);"
+         "CREATE TABLE app_categories (app_id INTEGER, category_id INTEGER, PRIMARY KEY (app_id, category_id));"
+         "CREATE INDEX idx_apps_catalog ON apps(name, package_id, version, publisher, homepage, icon_hash);"
+         "ATTACH DATABASE ':memory:' AS search_db;"
+         "CREATE TABLE search_db.search_results (package_id TEXT PRIMARY KEY COLLATE NOCASE, version TEXT);");
+
+    // Week 0: the database as a full build leaves it
+    std::vector<FixturePackage> week0 = FixtureSnapshot(packages, 0);
+    UpdaterStore store;
+    store.Attach(db);
+    store.BeginBatch();
+    for (const FixturePackage& p : week0) {
+        WritePackage(store, Shown(p));
+        store.Wrote();
+    }
+    store.EndBatch();
+    ListSnapshot(db, week0);
+    size_t changedBefore = FindChangedPackages(db).size();
+    std::map<std::string, StoredApp> before = StoredApps(db);
+
+    // Week 1: diff, and re-fetch what changed
+    std::vector<FixturePackage> week1 = FixtureSnapshot(packages, 1);
+    ListSnapshot(db, week1);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ChangedPackage> changed = FindChangedPackages(db);
+    double diffMs = MillisecondsSince(start);
+
+    std::map<std::string, const FixturePackage*> shown;
+    for (const FixturePackage& p : week1) shown[p.id] = &p;
+    start = std::chrono::steady_clock::now();
+    store.BeginBatch();
+    for (const ChangedPackage& c : changed) {
+        RefreshPackage(store, Shown(*shown[c.packageId]));
+        store.Wrote();
+    }
+    store.EndBatch();
+    double refreshMs = MillisecondsSince(start);
+    std::map<std::string, StoredApp> after = StoredApps(db);
+    size_t changedAfter = FindChangedPackages(db).size();
+    store.Detach();
+    sqlite3_close(db);
+
+    // Exactly the re-versioned packages were fetched; they kept their row and
+    // now match week 1, and every other row is as it was
+    std::set<std::string> expected, fetched;
+    for (int i = 3; i < packages; i += 10) expected.insert(week1[i].id);
+    for (const ChangedPackage& c : changed) fetched.insert(c.packageId);
+    size_t wrongRows = after.size() != before.size() ? 1 : 0;
+    for (const FixturePackage& p : week0) {
+        auto it = before.find(p.id);
+        if (it == before.end() || it->second.iconHash != FixtureIconHash(p) || it->second.tagsUpdated) ++wrongRows;
+    }
+    for (const auto& entry : before) {
+        auto it = after.find(entry.first);
+        if (it == after.end()) {
+            ++wrongRows;
+            continue;
+        }
+        StoredApp want = entry.second;
+        if (expected.count(entry.first)) {
+            const FixturePackage& p = *shown[entry.first];
+            want.version = p.version;
+            want.description = p.description;
+            want.categories = p.tags;
+            std::sort(want.categories.begin(), want.categories.end());
+            want.tagsUpdated = true;
+            if (!p.icon.empty()) want.iconHash = FixtureIconHash(p);
+        }
+        if (!(it->second == want)) ++wrongRows;
+    }
+    ok = changedBefore == 0 && fetched == expected && wrongRows == 0 && changedAfter == 0;
+    size_t listed = std::count_if(week1.begin(), week1.end(), [](const FixturePackage& p) { return p.listed; });
+
+    char line[320];
+    snprintf(line, sizeof(line),
+             "%d packages, %zu listed a week later: %zu to re-fetch (%zu expected, %s); diff %.2f ms, refresh %.2f ms; "
+             "%zu rows wrong; %zu left to re-fetch after, %zu before the week; %s",
+             packages, listed, changed.size(), expected.size(), fetched == expected ? "same" : "DIFFERENT",
+             diffMs, refreshMs, wrongRows, changedAfter, changedBefore, ok ? "OK" : "FAIL");
+    return line;
+}
@@ -0,0 +1,20 @@
+// The weekly refresh (see CheckPackageRefresh) at a few catalog sizes, from
+// one that has no new packages a week later to one that has every kind of
+// change many times over: exactly the re-versioned packages are re-fetched,
+// in place, and nothing else changes.
+#include "check.h"
+#include "wpm_benchmarks.h"
+#include <cstdio>
+#include <string>
+
+int main() {
+    for (int packages : {10, 120, 2000}) {
+        bool ok = false;
+        std::string report = CheckPackageRefresh(packages, ok);
+        std::printf("%s\n", report.c_str());
+        CHECK(ok);
+        CHECK(report.find("expected, same)") != std::string::npos);
+        CHECK(report.find(" 0 rows wrong") != std::string::npos);
+    }
+    return TestResult("package_refresh_test");
+}
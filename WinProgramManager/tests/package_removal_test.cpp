@@ -0,0 +1,199 @@
+// Step 3 through RemoveDeletedPackages on the fixture catalog: the apps Step 1
+// did not list and that are not installed go, with their category links and
+// id map entries, and nothing else does (ids listed in another case count as
+// listed, as in the script's hashtable). An empty list, a list missing more
+// than kMaxRemovedFraction of the apps and a database another connection is
+// writing to change nothing and leave no transaction open.
+//
+// Usage: package_removal_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "package_refresh.h"
+#include "schema.h"
+#include "updater_store.h"
+#include <sqlite3.h>
+#include <cstdio>
+#include <set>
+#include <string>
+
+namespace {
+
+std::string g_scratch;
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+int QueryInt(sqlite3* db, const std::string& sql) {
+    sqlite3_stmt* stmt = nullptr;
+    int value = -1;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+std::set<std::string> StoredPackages(sqlite3* db) {
+    std::set<std::string> ids;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT package_id FROM apps;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) ids.insert(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+        sqlite3_finalize(stmt);
+    }
+    return ids;
+}
+
+// The fixture database with an empty search_db attached, as Step 1 leaves it
+// before anything is listed
+sqlite3* OpenFixture(const std::string& name, const CatalogFixture& fixture) {
+    std::string path = g_scratch + "/" + name;
+    std::string searchPath = g_scratch + "/" + name + ".search";
+    std::remove(path.c_str());
+    std::remove(searchPath.c_str());
+    CHECK(WriteFixtureDatabase(fixture, path));
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    CHECK(Exec(db, ("ATTACH DATABASE '" + searchPath + "' AS search_db;").c_str()));
+    CHECK(Exec(db, "CREATE TABLE search_db.search_results (package_id TEXT PRIMARY KEY COLLATE NOCASE, version TEXT);"));
+    return db;
+}
+
+// List every fixture app for which `listed` says so
+template <typename Listed>
+void List(sqlite3* db, const CatalogFixture& fixture, Listed listed) {
+    CHECK(Exec(db, "DELETE FROM search_db.search_results;"));
+    sqlite3_stmt* stmt;
+    CHECK(sqlite3_prepare_v2(db, "INSERT INTO search_db.search_results (package_id, version) VALUES (?, ?);", -1, &stmt,
+                             nullptr) == SQLITE_OK);
+    for (size_t i = 0; i < fixture.apps.size(); ++i) {
+        std::string packageId = fixture.apps[i].packageId;
+        if (!listed(i, packageId)) continue;
+        sqlite3_bind_text(stmt, 1, packageId.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, fixture.apps[i].version.c_str(), -1, SQLITE_TRANSIENT);
+        CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+}
+
+std::string Upper(std::string text) {
+    for (char& c : text) c = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+    return text;
+}
+
+void TestRemoval(const CatalogFixture& fixture) {
+    sqlite3* db = OpenFixture("removal.db", fixture);
+    UpdaterStore store;
+    store.Attach(db);
+    const std::set<std::string> before = StoredPackages(db);
+    const int links = QueryInt(db, "SELECT COUNT(*) FROM app_categories;");
+
+    // One app in 25 unlisted, installed or not; one in 7 listed in capitals
+    std::set<std::string> expected;
+    List(db, fixture, [&](size_t i, std::string& packageId) {
+        if (i % 25 == 3) {
+            if (!fixture.apps[i].installed) expected.insert(packageId);
+            return false;
+        }
+        if (i % 7 == 0) packageId = Upper(packageId);
+        return true;
+    });
+    CHECK(!expected.empty());
+    CHECK(expected.size() <= fixture.apps.size() * kMaxRemovedFraction);
+    int expectedLinks = 0;
+    for (const FixtureApp& app : fixture.apps) {
+        if (expected.count(app.packageId)) expectedLinks += (int)app.categories.size();
+    }
+
+    PackageRemoval removal;
+    CHECK(RemoveDeletedPackages(store, removal));
+    CHECK(!removal.heldBack);
+    CHECK_EQ(removal.stored, (int)before.size());
+    CHECK(std::set<std::string>(removal.packageIds.begin(), removal.packageIds.end()) == expected);
+    CHECK_EQ(removal.packageIds.size(), expected.size());
+    CHECK(sqlite3_get_autocommit(db) != 0);
+
+    std::set<std::string> after = StoredPackages(db);
+    CHECK_EQ(after.size(), before.size() - expected.size());
+    size_t wrong = 0;
+    for (const std::string& packageId : before) {
+        wrong += (after.count(packageId) != 0) == (expected.count(packageId) != 0);
+        wrong += (store.PackageId(packageId) > 0) == (expected.count(packageId) != 0);
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM app_categories WHERE app_id NOT IN (SELECT id FROM apps);"), 0);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM app_categories;"), links - expectedLinks);
+
+    // Run again on the same list: nothing left to remove
+    CHECK(RemoveDeletedPackages(store, removal));
+    CHECK(removal.packageIds.empty());
+    CHECK(StoredPackages(db) == after);
+
+    store.Detach();
+    sqlite3_close(db);
+}
+
+// Every case where nothing may change
+void TestNothingRemoved(const CatalogFixture& fixture) {
+    sqlite3* db = OpenFixture("kept.db", fixture);
+    UpdaterStore store;
+    store.Attach(db);
+    const std::set<std::string> before = StoredPackages(db);
+    const int links = QueryInt(db, "SELECT COUNT(*) FROM app_categories;");
+    auto unchanged = [&]() {
+        CHECK(sqlite3_get_autocommit(db) != 0);
+        CHECK(StoredPackages(db) == before);
+        CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM app_categories;"), links);
+        size_t forgotten = 0;
+        for (const std::string& packageId : before) forgotten += store.PackageId(packageId) <= 0;
+        CHECK_EQ(forgotten, 0u);
+    };
+
+    // Step 1 listed nothing
+    PackageRemoval removal;
+    CHECK(!RemoveDeletedPackages(store, removal));
+    CHECK_EQ(removal.listed, 0);
+    CHECK(removal.packageIds.empty());
+    unchanged();
+
+    // A listing cut short after the first third
+    List(db, fixture, [&](size_t i, std::string&) { return i < fixture.apps.size() / 3; });
+    CHECK(!RemoveDeletedPackages(store, removal));
+    CHECK(removal.heldBack);
+    CHECK(removal.packageIds.size() > fixture.apps.size() * kMaxRemovedFraction);
+    unchanged();
+
+    // A plausible list while the manager holds the write lock
+    List(db, fixture, [&](size_t i, std::string&) { return i % 30 != 1; });
+    sqlite3* other = nullptr;
+    CHECK(sqlite3_open((g_scratch + "/kept.db").c_str(), &other) == SQLITE_OK);
+    CHECK(Exec(other, "BEGIN IMMEDIATE;"));
+    CHECK(!RemoveDeletedPackages(store, removal));
+    CHECK(!removal.heldBack);
+    CHECK(removal.packageIds.empty());
+    CHECK(Exec(other, "COMMIT;"));
+    sqlite3_close(other);
+    unchanged();
+
+    // Once it is released, the same list goes through
+    CHECK(RemoveDeletedPackages(store, removal));
+    CHECK(!removal.packageIds.empty());
+
+    store.Detach();
+    sqlite3_close(db);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    g_scratch = argv[1];
+    CatalogFixture fixture = MakeCatalogFixture(2000, 23);
+    TestRemoval(fixture);
+    TestNothingRemoved(fixture);
+    return TestResult("package_removal_test");
+}
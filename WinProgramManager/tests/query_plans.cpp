@@ -0,0 +1,183 @@
+// Query-plan check of the hot queries schema.h lists, run by query_plans_test
+// and `wpm_bench --check-query-plans`.
+#include "wpm_benchmarks.h"
+#include "icon_store.h"
+#include "schema.h"
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+int UserVersion(sqlite3* db) {
+    sqlite3_stmt* stmt;
+    int version = -1;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return version;
+}
+
+struct HotQuery {
+    const char* name;
+    const char* sql;
+    const char* legacySql;   // as the query was written before this schema version
+    const char* iterates;    // table (alias) the query walks by design, or nullptr
+    bool sorts;              // small per-app results may be sorted
+    bool writes;             // plan only; not timed
+};
+
+const HotQuery kHotQueries[] = {
+    {"catalog", kCatalogAppsSql, kCatalogAppsSql, "a", false, false},
+    {"uncategorized apps", kUncategorizedAppsSql,
+     "SELECT id, package_id, name, moniker FROM apps WHERE id NOT IN (SELECT DISTINCT app_id FROM app_categories);",
+     "apps", false, false},
+    {"tag uncategorized", kTagUncategorizedSql,
+     "INSERT INTO app_categories (app_id, category_id) "
+     "SELECT id, ?1 FROM apps WHERE id NOT IN (SELECT DISTINCT app_id FROM app_categories);",
+     "apps", false, true},
+    {"unchecked untagged apps", kUncheckedUntaggedAppsSql,
+     "SELECT package_id FROM apps WHERE tags_updated = 0 AND id NOT IN (SELECT DISTINCT app_id FROM app_categories);",
+     "apps", false, false},
+    {"new packages", kNewPackagesSql,
+     "SELECT package_id FROM search_db.search_results WHERE package_id NOT IN (SELECT package_id FROM apps);",
+     "sr", false, false},
+    {"removed apps", kRemovedAppsSql,
+     "SELECT id, package_id FROM apps WHERE package_id NOT IN (SELECT package_id FROM search_db.search_results) "
+     "AND package_id NOT IN (SELECT package_id FROM installed_apps);",
+     "apps", false, false},
+    {"changed apps", kChangedAppsSql, kChangedAppsSql, "a", false, false},
+    {"app categories", kAppCategoriesSql, kAppCategoriesSql, nullptr, true, false},
+};
+
+// Why the plan of `sql` is not acceptable, or empty if it is
+std::string PlanProblem(sqlite3* db, const HotQuery& query, const char* sql) {
+    sqlite3_stmt* stmt;
+    std::string explain = std::string("EXPLAIN QUERY PLAN ") + sql;
+    if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return std::string("does not compile: ") + sqlite3_errmsg(db);
+    }
+    std::string problem;
+    while (problem.empty() && sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 3);
+        std::string detail = text ? reinterpret_cast<const char*>(text) : "";
+        if (detail.compare(0, 5, "SCAN ") == 0) {
+            // "SCAN apps", "SCAN a USING COVERING INDEX idx_apps_catalog"; "SCAN TABLE apps" before SQLite 3.36
+            std::string table = detail.substr(5);
+            if (table.compare(0, 6, "TABLE ") == 0) table = table.substr(6);
+            table = table.substr(0, table.find(' '));
+            if (!query.iterates || table != query.iterates) problem = detail;
+        } else if (detail.find("AUTOMATIC") != std::string::npos) {
+            problem = detail;
+        } else if (detail.compare(0, 15, "USE TEMP B-TREE") == 0 && !query.sorts) {
+            problem = detail;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return problem;
+}
+
+// Milliseconds to run `sql` to completion, -1 if it does not compile
+double TimeQuery(sqlite3* db, const char* sql, const std::string& packageId) {
+    sqlite3_stmt* stmt;
+    auto start = std::chrono::steady_clock::now();
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return -1;
+    if (sqlite3_bind_parameter_count(stmt) > 0) sqlite3_bind_text(stmt, 1, packageId.c_str(), -1, SQLITE_TRANSIENT);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    }
+    sqlite3_finalize(stmt);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The updater's search database, listing every app but one in a hundred and
+// one in twenty at a newer version
+bool AttachSearchResults(sqlite3* db) {
+    return Exec(db,
+                "ATTACH DATABASE ':memory:' AS search_db;"
+                "CREATE TABLE search_db.search_results (package_id TEXT PRIMARY KEY COLLATE NOCASE, version TEXT);"
+                "INSERT OR IGNORE INTO search_db.search_results "
+                "SELECT package_id, CASE WHEN id % 20 = 0 THEN version || '.1' ELSE version END FROM apps "
+                "WHERE id % 100 != 0;");
+}
+
+sqlite3* CopyToMemory(sqlite3* source) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+    sqlite3_backup* backup = sqlite3_backup_init(db, "main", source, "main");
+    if (backup) {
+        sqlite3_backup_step(backup, -1);
+        sqlite3_backup_finish(backup);
+    }
+    return db;
+}
+
+}  // namespace
+
+std::string CheckQueryPlans(const std::string& dbPath, bool& ok) {
+    ok = false;
+    sqlite3* source = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::string error = "cannot open " + dbPath + ": " + (source ? sqlite3_errmsg(source) : "out of memory");
+        sqlite3_close(source);
+        return error;
+    }
+    // Before: what opening the database did until now. After: with the migrations
+    sqlite3* before = CopyToMemory(source);
+    sqlite3* after = CopyToMemory(source);
+    sqlite3_close(source);
+    if (!before || !after) {
+        sqlite3_close(before);
+        sqlite3_close(after);
+        return "cannot copy " + dbPath + " into memory";
+    }
+    MigrateIconStore(before);
+    MigrateIconStore(after);
+    int fromVersion = UserVersion(after);
+    int toVersion = MigrateSchema(after);
+    AttachSearchResults(before);
+    AttachSearchResults(after);
+
+    std::string packageId;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(after, "SELECT package_id FROM apps LIMIT 1;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+            packageId = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    char line[512];
+    snprintf(line, sizeof(line), "schema version %d -> %d", fromVersion, toVersion);
+    std::string report = line;
+    ok = toVersion == kSchemaVersion;
+    for (const HotQuery& query : kHotQueries) {
+        std::string problem = PlanProblem(after, query, query.sql);
+        std::string legacyProblem = PlanProblem(before, query, query.legacySql);
+        ok = ok && problem.empty();
+        report += "\n  " + std::string(query.name) + ": " + (problem.empty() ? "ok" : "FAIL (" + problem + ")") +
+                  "; before: " + (legacyProblem.empty() ? "ok" : legacyProblem);
+        if (query.writes) continue;
+        // Queries on tables the migrations add did not run before at all; time
+        // their old text on the migrated copy then
+        double legacyMs = TimeQuery(before, query.legacySql, packageId);
+        if (legacyMs < 0) legacyMs = TimeQuery(after, query.legacySql, packageId);
+        double ms = TimeQuery(after, query.sql, packageId);
+        if (legacyMs >= 0) {
+            snprintf(line, sizeof(line), "; %.2f ms -> %.2f ms", legacyMs, ms);
+        } else {
+            snprintf(line, sizeof(line), "; %.2f ms", ms);
+        }
+        report += line;
+    }
+    sqlite3_close(before);
+    sqlite3_close(after);
+    return report;
+}
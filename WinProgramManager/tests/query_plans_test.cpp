@@ -0,0 +1,65 @@
+// Query-plan regression test of the hot queries (see CheckQueryPlans): on a
+// database as the build scripts create it, on one the migrations already ran
+// on, and on one that lost a hot index after migrating, which must fail.
+//
+// Usage: query_plans_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "icon_store.h"
+#include "schema.h"
+#include "wpm_benchmarks.h"
+#include <sqlite3.h>
+#include <string>
+
+namespace {
+
+bool Migrate(const std::string& path, const char* afterwards = nullptr) {
+    sqlite3* db = nullptr;
+    bool ok = sqlite3_open(path.c_str(), &db) == SQLITE_OK && MigrateIconStore(db) >= 0 &&
+              MigrateSchema(db) == kSchemaVersion &&
+              (!afterwards || sqlite3_exec(db, afterwards, nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(db);
+    return ok;
+}
+
+bool PlansPass(const std::string& path, std::string& report) {
+    bool ok = false;
+    report = CheckQueryPlans(path, ok);
+    std::printf("%s: %s\n", path.c_str(), report.c_str());
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+    CatalogFixture fixture = MakeCatalogFixture(3000, 22);
+    std::string report;
+
+    // Schema version 0, as the build scripts leave it
+    std::string fresh = dir + "/query_plans_v0.db";
+    CHECK(WriteFixtureDatabase(fixture, fresh));
+    CHECK(PlansPass(fresh, report));
+    CHECK(report.find("schema version 0 -> " + std::to_string(kSchemaVersion)) != std::string::npos);
+    CHECK(report.find("FAIL") == std::string::npos);
+
+    // Already migrated: nothing left to do, same plans
+    std::string migrated = dir + "/query_plans_migrated.db";
+    CHECK(WriteFixtureDatabase(fixture, migrated));
+    CHECK(Migrate(migrated));
+    CHECK(PlansPass(migrated, report));
+
+    // A hot index dropped behind the migrations' back sorts the catalog again
+    std::string broken = dir + "/query_plans_broken.db";
+    CHECK(WriteFixtureDatabase(fixture, broken));
+    CHECK(Migrate(broken, "DROP INDEX idx_apps_catalog;"));
+    CHECK(!PlansPass(broken, report));
+    CHECK(report.find("catalog: FAIL") != std::string::npos);
+
+    CHECK(!PlansPass(dir + "/missing/query_plans.db", report));
+    return TestResult("query_plans_test");
+}
@@ -0,0 +1,195 @@
+// MigrateSchema on the databases it meets: one as the build scripts create it,
+// one that older builds already added installed_apps and tags_updated to, one
+// from a newer build, one another connection is writing to, and one where a
+// migration fails part way (the icon store not migrated yet), which must keep
+// the versions before it and roll back the rest.
+//
+// Usage: schema_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "icon_store.h"
+#include "schema.h"
+#include <sqlite3.h>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+bool Exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+int QueryInt(sqlite3* db, const std::string& sql) {
+    sqlite3_stmt* stmt;
+    int value = -1;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+int UserVersion(sqlite3* db) {
+    return QueryInt(db, "PRAGMA user_version;");
+}
+
+bool HasObject(sqlite3* db, const char* type, const char* name) {
+    return QueryInt(db, std::string("SELECT COUNT(*) FROM sqlite_master WHERE type = '") + type + "' AND name = '" +
+                            name + "';") == 1;
+}
+
+bool HasColumn(sqlite3* db, const char* table, const char* column) {
+    return QueryInt(db, std::string("SELECT COUNT(*) FROM pragma_table_info('") + table + "') WHERE name = '" +
+                            column + "';") == 1;
+}
+
+// Everything the migrations create, as of kSchemaVersion
+bool FullyMigrated(sqlite3* db) {
+    return UserVersion(db) == kSchemaVersion && HasObject(db, "table", "installed_apps") &&
+           HasObject(db, "index", "idx_installed_last_seen") && HasColumn(db, "apps", "tags_updated") &&
+           HasObject(db, "index", "idx_app_categories_category") && HasObject(db, "index", "idx_apps_catalog") &&
+           HasObject(db, "table", "icon_sources");
+}
+
+// The schema as text, to see that a second run changes nothing
+std::string SchemaText(sqlite3* db) {
+    std::string text;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT type, name, sql FROM sqlite_master ORDER BY type, name;", -1, &stmt, nullptr) ==
+        SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            for (int col = 0; col < 3; ++col) {
+                const unsigned char* value = sqlite3_column_text(stmt, col);
+                text += value ? reinterpret_cast<const char*>(value) : "";
+                text += '\t';
+            }
+            text += '\n';
+        }
+        sqlite3_finalize(stmt);
+    }
+    return text;
+}
+
+sqlite3* Open(const std::string& path) {
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    return db;
+}
+
+std::string FreshDatabase(const std::string& dir, const char* name, const CatalogFixture& fixture) {
+    std::string path = dir + "/" + name;
+    std::remove(path.c_str());
+    CHECK(WriteFixtureDatabase(fixture, path));
+    return path;
+}
+
+void TestFromBuildScripts(const std::string& dir, const CatalogFixture& fixture) {
+    sqlite3* db = Open(FreshDatabase(dir, "schema_v0.db", fixture));
+    CHECK_EQ(UserVersion(db), 0);
+    CHECK(MigrateIconStore(db) >= 0);
+    CHECK_EQ(MigrateSchema(db), kSchemaVersion);
+    CHECK(FullyMigrated(db));
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM apps WHERE tags_updated != 0;"), 0);
+
+    // Again: nothing to do, nothing changed
+    std::string schema = SchemaText(db);
+    CHECK_EQ(MigrateSchema(db), kSchemaVersion);
+    CHECK(SchemaText(db) == schema);
+    sqlite3_close(db);
+}
+
+void TestPartlyCreatedByOlderBuilds(const std::string& dir, const CatalogFixture& fixture) {
+    // The fixture has installed_apps as app_details.cpp created it; give it a
+    // row, and add the column Step 4 used to add itself
+    sqlite3* db = Open(FreshDatabase(dir, "schema_older.db", fixture));
+    CHECK(HasObject(db, "table", "installed_apps"));
+    CHECK(Exec(db,
+               "INSERT INTO installed_apps (package_id, last_seen) VALUES ('Kept.Package', '2026-01-01');"
+               "ALTER TABLE apps ADD COLUMN tags_updated INTEGER NOT NULL DEFAULT 0;"
+               "UPDATE apps SET tags_updated = 1 WHERE id % 2 = 0;"));
+    const int tagged = QueryInt(db, "SELECT COUNT(*) FROM apps WHERE tags_updated = 1;");
+    CHECK(tagged > 0);
+    CHECK(MigrateIconStore(db) >= 0);
+    CHECK_EQ(MigrateSchema(db), kSchemaVersion);
+    CHECK(FullyMigrated(db));
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM installed_apps WHERE package_id = 'Kept.Package';"), 1);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM apps WHERE tags_updated = 1;"), tagged);
+    sqlite3_close(db);
+}
+
+void TestNewerBuild(const std::string& dir, const CatalogFixture& fixture) {
+    // A version this build does not know is left alone
+    sqlite3* db = Open(FreshDatabase(dir, "schema_newer.db", fixture));
+    const int newer = kSchemaVersion + 5;
+    CHECK(Exec(db, ("PRAGMA user_version = " + std::to_string(newer) + ";").c_str()));
+    std::string schema = SchemaText(db);
+    CHECK_EQ(MigrateSchema(db), newer);
+    CHECK_EQ(UserVersion(db), newer);
+    CHECK(SchemaText(db) == schema);
+    sqlite3_close(db);
+    CHECK_EQ(MigrateSchema(nullptr), -1);
+}
+
+void TestFailedMigration(const std::string& dir, const CatalogFixture& fixture) {
+    // Migration 3 indexes apps.icon_hash, which only MigrateIconStore adds:
+    // 1 and 2 stay, 3 is rolled back whole and the version stops at 2
+    std::string path = FreshDatabase(dir, "schema_failed.db", fixture);
+    sqlite3* db = Open(path);
+    CHECK(!HasColumn(db, "apps", "icon_hash"));
+    CHECK_EQ(MigrateSchema(db), -1);
+    CHECK_EQ(UserVersion(db), 2);
+    CHECK(HasObject(db, "table", "installed_apps"));
+    CHECK(HasColumn(db, "apps", "tags_updated"));
+    CHECK(!HasObject(db, "index", "idx_app_categories_category"));
+    CHECK(!HasObject(db, "table", "icon_sources"));
+    CHECK(sqlite3_get_autocommit(db) != 0);
+
+    // Retried on the next open, once the icon store is in place
+    sqlite3_close(db);
+    db = Open(path);
+    CHECK(MigrateIconStore(db) >= 0);
+    CHECK_EQ(MigrateSchema(db), kSchemaVersion);
+    CHECK(FullyMigrated(db));
+    sqlite3_close(db);
+}
+
+void TestOtherConnection(const std::string& dir, const CatalogFixture& fixture) {
+    std::string path = FreshDatabase(dir, "schema_shared.db", fixture);
+    sqlite3* updater = Open(path);
+    sqlite3* manager = Open(path);
+    CHECK(MigrateIconStore(updater) >= 0);
+
+    // While the other side holds the write lock, migrating fails without
+    // changing anything, and leaves no transaction open
+    CHECK(Exec(updater, "BEGIN IMMEDIATE;"));
+    CHECK_EQ(MigrateSchema(manager), -1);
+    CHECK(sqlite3_get_autocommit(manager) != 0);
+    CHECK(Exec(updater, "COMMIT;"));
+    CHECK_EQ(UserVersion(manager), 0);
+
+    // Once one side migrated, the other finds nothing left to do
+    CHECK_EQ(MigrateSchema(updater), kSchemaVersion);
+    std::string schema = SchemaText(manager);
+    CHECK_EQ(MigrateSchema(manager), kSchemaVersion);
+    CHECK(FullyMigrated(manager));
+    CHECK(SchemaText(manager) == schema);
+    sqlite3_close(updater);
+    sqlite3_close(manager);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+    CatalogFixture fixture = MakeCatalogFixture(300, 22);
+    TestFromBuildScripts(dir, fixture);
+    TestPartlyCreatedByOlderBuilds(dir, fixture);
+    TestNewerBuild(dir, fixture);
+    TestFailedMigration(dir, fixture);
+    TestOtherConnection(dir, fixture);
+    return TestResult("schema_test");
+}
@@ -0,0 +1,76 @@
+// Benchmark of SearchIndex against the lowercase-and-find loop LoadApps ran
+// on every keystroke.
+#include "wpm_benchmarks.h"
+#include "search_index.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cwctype>
+
+std::string BenchmarkSearch(const std::string& dbPath) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::string error = "cannot open " + dbPath + ": " + (db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close(db);
+        return error;
+    }
+    AppCatalog catalog;
+    catalog.Load(db);
+    auto start = std::chrono::steady_clock::now();
+    SearchIndex index;
+    index.Build(catalog, db);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    sqlite3_close(db);
+
+    // What people type into the search box: 1-4 characters
+    const wchar_t* queries[] = {L"a", L"e", L"7", L"vs", L"go", L"pd", L"zip", L"git", L"pdf", L"sql",
+                                L"code", L"edit", L"play", L"chro", L"micr", L"sync"};
+    const int rounds = 5;
+    double legacyTotal = 0, legacyMax = 0, indexTotal = 0, indexMax = 0;
+    size_t legacyMatches = 0, indexMatches = 0;
+    for (const wchar_t* query : queries) {
+        // Before: lowercase copies of name, publisher and id of every app
+        start = std::chrono::steady_clock::now();
+        size_t matches = 0;
+        for (int round = 0; round < rounds; ++round) {
+            matches = 0;
+            std::wstring lower_filter = query;
+            std::transform(lower_filter.begin(), lower_filter.end(), lower_filter.begin(), ::towlower);
+            for (size_t app = 0; app < catalog.AppCount(); ++app) {
+                std::wstring lower_name = catalog.Name(app);
+                std::wstring lower_publisher = catalog.Publisher(app);
+                std::wstring lower_packageId = catalog.PackageId(app);
+                std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::towlower);
+                std::transform(lower_publisher.begin(), lower_publisher.end(), lower_publisher.begin(), ::towlower);
+                std::transform(lower_packageId.begin(), lower_packageId.end(), lower_packageId.begin(), ::towlower);
+                if (lower_name.find(lower_filter) != std::wstring::npos ||
+                    lower_publisher.find(lower_filter) != std::wstring::npos ||
+                    lower_packageId.find(lower_filter) != std::wstring::npos) {
+                    matches++;
+                }
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+        legacyTotal += ms;
+        legacyMax = std::max(legacyMax, ms);
+        legacyMatches += matches;
+
+        start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; ++round) matches = index.Search(query, SearchOptions()).size();
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+        indexTotal += ms;
+        indexMax = std::max(indexMax, ms);
+        indexMatches += matches;
+    }
+    const size_t queryCount = sizeof(queries) / sizeof(queries[0]);
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "%zu apps; index built in %.1f ms, %.1f MB; %zu queries of 1-4 characters: "
+             "lowercase-and-find (name, publisher, id) avg %.2f ms, max %.2f ms, %zu matches; "
+             "index (also moniker, description; ranked) avg %.2f ms, max %.2f ms, %zu matches",
+             catalog.AppCount(), buildMs, index.MemoryBytes() / 1048576.0, queryCount, legacyTotal / queryCount,
+             legacyMax, legacyMatches, indexTotal / queryCount, indexMax, indexMatches);
+    return line;
+}
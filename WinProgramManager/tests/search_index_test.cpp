@@ -0,0 +1,269 @@
+// SearchIndex against a brute-force scan of the fixture catalog: for queries
+// cut from every field of the apps (1 to 6 characters, whole fields, in
+// either case) and every combination of the case and exact options, the
+// index returns exactly the apps the scan finds, in the same ranked order.
+// Hand-made apps pin down the ranking and the folding of accented, Greek and
+// Cyrillic letters.
+//
+// Usage: search_index_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "search_index.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdio>
+#include <cwctype>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Upper and lower case of every non-ASCII letter the hand-made apps use
+const wchar_t kUpper[] = L"ÉÜÖÓŁŚŹЖЁБРАУЗЕЛТЫЙΣΎΝΘΗΉΧ";
+const wchar_t kLower[] = L"éüöółśźжёбраузелтыйσύνθηήχ";
+
+wchar_t OracleFold(wchar_t c) {
+    if (c >= L'A' && c <= L'Z') return (wchar_t)(c - L'A' + L'a');
+    for (size_t i = 0; kUpper[i]; ++i) {
+        if (kUpper[i] == c) return kLower[i];
+    }
+    return c;
+}
+
+std::wstring OracleFold(const std::wstring& s) {
+    std::wstring folded = s;
+    for (auto& c : folded) c = OracleFold(c);
+    return folded;
+}
+
+std::wstring OracleUpper(const std::wstring& s) {
+    std::wstring upper = s;
+    for (auto& c : upper) {
+        if (c >= L'a' && c <= L'z') c = (wchar_t)(c - L'a' + L'A');
+        for (size_t i = 0; kLower[i]; ++i) {
+            if (kLower[i] == c) c = kUpper[i];
+        }
+    }
+    return upper;
+}
+
+// The five fields of one app, in SearchIndex::Field order, and their folded
+// copies
+struct OracleApp {
+    std::wstring fields[SearchIndex::kFieldCount];
+    std::wstring folded[SearchIndex::kFieldCount];
+};
+
+// The ranking SearchIndex documents, computed field by field
+int OracleRank(const OracleApp& app, const std::wstring& query, const SearchOptions& options) {
+    const std::wstring q = options.caseSensitive ? query : OracleFold(query);
+    int best = -1;
+    auto offer = [&](int rank) {
+        if (best < 0 || rank < best) best = rank;
+    };
+    for (int field = 0; field < SearchIndex::kFieldCount; ++field) {
+        const std::wstring& text = options.caseSensitive ? app.fields[field] : app.folded[field];
+        if (options.exactMatch) {
+            if (text != q) continue;
+            const int exactRank[] = {0, 3, 1, 7, 8};   // name, id segment, moniker, publisher, description
+            offer(exactRank[field]);
+            continue;
+        }
+        if (text.find(q) == std::wstring::npos) continue;
+        bool atWord = false, atSegment = false;
+        for (size_t pos = text.find(q); pos != std::wstring::npos; pos = text.find(q, pos + 1)) {
+            atWord = atWord || pos == 0 || !std::iswalnum(text[pos - 1]);
+            atSegment = atSegment || pos == 0 || text[pos - 1] == L'.';
+        }
+        switch (field) {
+            case SearchIndex::kName:
+                if (text == q) offer(0);
+                else if (text.compare(0, q.size(), q) == 0) offer(2);
+                else offer(atWord ? 4 : 5);
+                break;
+            case SearchIndex::kMoniker: offer(text == q ? 1 : 6); break;
+            case SearchIndex::kPackageId: offer(atSegment ? 3 : 6); break;
+            case SearchIndex::kPublisher: offer(7); break;
+            default: offer(8); break;
+        }
+    }
+    return best;
+}
+
+std::vector<uint32_t> OracleSearch(const std::vector<OracleApp>& apps, const std::wstring& query,
+                                   const SearchOptions& options) {
+    std::vector<std::pair<int, uint32_t>> ranked;
+    for (size_t app = 0; app < apps.size(); ++app) {
+        int rank = query.empty() ? 0 : OracleRank(apps[app], query, options);
+        if (rank >= 0) ranked.emplace_back(rank, (uint32_t)app);
+    }
+    std::sort(ranked.begin(), ranked.end());
+    std::vector<uint32_t> result;
+    for (const auto& entry : ranked) result.push_back(entry.second);
+    return result;
+}
+
+FixtureApp HandMade(const std::string& packageId, const std::string& name, const std::string& publisher,
+                    const std::string& moniker = "", const std::string& description = "") {
+    FixtureApp app;
+    app.packageId = packageId;
+    app.name = name;
+    app.publisher = publisher;
+    app.version = "1.0";
+    app.moniker = moniker;
+    app.description = description;
+    return app;
+}
+
+// One app per rank for the query "code", plus names in other scripts; returns
+// how many were added
+size_t AddHandMadeApps(CatalogFixture& fixture) {
+    const FixtureApp apps[] = {
+        HandMade("Ranking.Exact", "Code", "Ranking Inc"),
+        HandMade("Ranking.Moniker", "Visual Studio", "Ranking Inc", "code"),
+        HandMade("Ranking.Prefix", "Codex Editor", "Ranking Inc"),
+        HandMade("Ranking.CodeTools", "Tools Suite", "Ranking Inc"),
+        HandMade("Ranking.Word", "My Code Tool", "Ranking Inc"),
+        HandMade("Ranking.Inside", "Encoder Plus", "Ranking Inc"),
+        HandMade("Ranking.Xcodebuild", "Builder Pro", "Ranking Inc"),
+        HandMade("Ranking.Publisher", "Widget Maker", "Codeworks Ltd"),
+        HandMade("Ranking.Description", "Quick Editor", "Ranking Inc", "", "Edits source code quickly"),
+        HandMade("Societe.Editeur", "Éditeur Ünicode", "Société Générale Ltd", "editeur"),
+        HandMade("Zhyoltiy.Browser", "Жёлтый Браузер", "Жёлтый", "", "Быстрый браузер"),
+        HandMade("Synthesi.Ichou", "Σύνθεση Ήχου", "Σύνθεση", "σύνθεση"),
+        HandMade("Lodz.Sciezka", "Łódź Ścieżka", "Łódź Software", "", "ŹRÓDŁO"),
+    };
+    for (const FixtureApp& app : apps) fixture.apps.push_back(app);
+    return sizeof(apps) / sizeof(apps[0]);
+}
+
+std::wstring Utf8(const std::string& text) { return ColumnToWide(text.c_str()); }
+
+std::string Narrow(const std::wstring& text) {
+    std::string out;
+    for (wchar_t c : text) out += c < 0x80 ? (char)c : '?';
+    return out;
+}
+
+int g_compared = 0;
+
+void Compare(const SearchIndex& index, const std::vector<OracleApp>& apps, const std::wstring& query) {
+    for (int options = 0; options < 4; ++options) {
+        SearchOptions opts;
+        opts.caseSensitive = (options & 1) != 0;
+        opts.exactMatch = (options & 2) != 0;
+        std::vector<uint32_t> expected = OracleSearch(apps, query, opts);
+        std::vector<uint32_t> got = index.Search(query, opts);
+        if (got != expected) {
+            std::fprintf(stderr, "query '%s' (case %d, exact %d): %zu results, expected %zu\n", Narrow(query).c_str(),
+                         opts.caseSensitive, opts.exactMatch, got.size(), expected.size());
+        }
+        CHECK(got == expected);
+        g_compared++;
+    }
+}
+
+// Queries cut from every field of the sampled apps, and their upper case
+std::vector<std::wstring> Queries(const std::vector<OracleApp>& apps, const std::vector<bool>& sampled) {
+    std::vector<std::wstring> queries = {L"", L"zzqxj", L"e", L"E", L"7", L"."};
+    for (size_t app = 0; app < apps.size(); ++app) {
+        if (!sampled[app]) continue;
+        for (const std::wstring& text : apps[app].fields) {
+            if (text.empty()) continue;
+            queries.push_back(text);
+            for (size_t len : {1, 2, 3, 4, 6}) {
+                if (len > text.size()) break;
+                for (size_t pos : {(size_t)0, text.size() / 2, text.size() - len}) {
+                    if (pos + len > text.size()) continue;
+                    queries.push_back(text.substr(pos, len));
+                }
+            }
+        }
+    }
+    size_t count = queries.size();
+    for (size_t i = 0; i < count; ++i) queries.push_back(OracleUpper(queries[i]));
+    std::sort(queries.begin(), queries.end());
+    queries.erase(std::unique(queries.begin(), queries.end()), queries.end());
+    return queries;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    CatalogFixture fixture = MakeCatalogFixture(400, 29);
+    size_t handMade = AddHandMadeApps(fixture);
+    std::string path = std::string(argv[1]) + "/search_index_test.db";
+    std::remove(path.c_str());
+    CHECK(WriteFixtureDatabase(fixture, path));
+
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK);
+    AppCatalog catalog;
+    CHECK(catalog.Load(db));
+    SearchIndex index;
+    CHECK(index.Build(catalog, db));
+    sqlite3_close(db);
+    CHECK(!index.Empty());
+
+    // The scan's view of the apps, in catalog order
+    std::map<std::wstring, const FixtureApp*> byId;
+    for (const FixtureApp& app : fixture.apps) byId[Utf8(app.packageId)] = &app;
+    const FixtureApp* firstHandMade = &fixture.apps[fixture.apps.size() - handMade];
+    std::vector<OracleApp> apps(catalog.AppCount());
+    // Every 11th generated app, and all hand-made ones
+    std::vector<bool> sampled(apps.size());
+    for (size_t app = 0; app < apps.size(); ++app) {
+        const FixtureApp* source = byId[catalog.PackageId(app)];
+        CHECK(source != nullptr);
+        if (!source) continue;
+        apps[app].fields[SearchIndex::kName] = catalog.Name(app);
+        apps[app].fields[SearchIndex::kPackageId] = catalog.PackageId(app);
+        apps[app].fields[SearchIndex::kMoniker] = Utf8(source->moniker);
+        apps[app].fields[SearchIndex::kPublisher] = catalog.Publisher(app);
+        apps[app].fields[SearchIndex::kDescription] = Utf8(source->description);
+        for (int field = 0; field < SearchIndex::kFieldCount; ++field) {
+            apps[app].folded[field] = OracleFold(apps[app].fields[field]);
+        }
+        sampled[app] = app % 11 == 0 || source >= firstHandMade;
+    }
+    std::vector<std::wstring> queries = Queries(apps, sampled);
+    for (const std::wstring& query : queries) Compare(index, apps, query);
+    std::printf("%zu apps, %zu queries, %d searches compared\n", apps.size(), queries.size(), g_compared);
+
+    // Ranking: every way "code" can match, best first
+    std::vector<std::wstring> ranked;
+    for (uint32_t app : index.Search(L"CODE", SearchOptions())) {
+        const std::wstring& id = catalog.PackageId(app);
+        if (id.compare(0, 8, L"Ranking.") == 0) ranked.push_back(id.substr(8));
+    }
+    const std::vector<std::wstring> expected = {L"Exact",  L"Moniker",    L"Prefix",    L"CodeTools",  L"Word",
+                                                L"Inside", L"Xcodebuild", L"Publisher", L"Description"};
+    CHECK(ranked == expected);
+
+    // Folding beyond ASCII: either case finds the app, unless case matters
+    auto finds = [&](const std::wstring& query, const char* packageId, bool caseSensitive) {
+        SearchOptions options;
+        options.caseSensitive = caseSensitive;
+        for (uint32_t app : index.Search(query, options)) {
+            if (catalog.PackageId(app) == Utf8(packageId)) return true;
+        }
+        return false;
+    };
+    CHECK(finds(L"éditeur", "Societe.Editeur", false));
+    CHECK(finds(L"ÉDITEUR ÜNICODE", "Societe.Editeur", false));
+    CHECK(!finds(L"éditeur", "Societe.Editeur", true));
+    CHECK(finds(L"ЖЁЛТЫЙ", "Zhyoltiy.Browser", false));
+    CHECK(finds(L"бы", "Zhyoltiy.Browser", false));
+    CHECK(!finds(L"ЖЁЛТЫЙ", "Zhyoltiy.Browser", true));
+    CHECK(finds(L"ΣΎΝΘΕΣΗ", "Synthesi.Ichou", false));
+    CHECK(finds(L"ήχ", "Synthesi.Ichou", false));
+    CHECK(finds(L"ŁÓDŹ", "Lodz.Sciezka", false));
+    CHECK(finds(L"źródło", "Lodz.Sciezka", false));
+    return TestResult("search_index_test");
+}
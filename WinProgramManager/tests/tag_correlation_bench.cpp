@@ -0,0 +1,159 @@
+// Benchmark of InferCorrelatedCategories against the per-app and per-rule SQL
+// Step 6 ran before.
+#include "wpm_benchmarks.h"
+#include "tag_correlation.h"
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+namespace {
+
+// Apply correlation rules (66.67% threshold, min 6 samples)
+const double kCorrelationThreshold = 0.6667;
+const int kMinSamples = 6;
+
+// WinProgramUpdater::ApplyCorrelationAnalysis as it was; returns the rows added
+int LegacyApplyCorrelation(sqlite3* db) {
+    int added = 0;
+    std::map<std::string, std::map<std::string, int>> coOccurrence;
+    std::map<std::string, int> tagCounts;
+
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT app_id FROM app_categories GROUP BY app_id HAVING COUNT(*) > 1;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            int appId = sqlite3_column_int(stmt, 0);
+            std::vector<std::string> appTags;
+            sqlite3_stmt* tagStmt;
+            std::string tagSql = "SELECT c.category_name FROM categories c "
+                                 "JOIN app_categories ac ON c.id = ac.category_id "
+                                 "WHERE ac.app_id = " + std::to_string(appId) + ";";
+            if (sqlite3_prepare_v2(db, tagSql.c_str(), -1, &tagStmt, nullptr) == SQLITE_OK) {
+                while (sqlite3_step(tagStmt) == SQLITE_ROW) {
+                    std::string tag = reinterpret_cast<const char*>(sqlite3_column_text(tagStmt, 0));
+                    appTags.push_back(tag);
+                    tagCounts[tag]++;
+                }
+                sqlite3_finalize(tagStmt);
+            }
+            for (size_t i = 0; i < appTags.size(); i++) {
+                for (size_t j = 0; j < appTags.size(); j++) {
+                    if (i != j) coOccurrence[appTags[i]][appTags[j]]++;
+                }
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    for (const auto& source : coOccurrence) {
+        if (tagCounts[source.first] < kMinSamples) continue;
+        for (const auto& target : source.second) {
+            double correlation = static_cast<double>(target.second) / tagCounts[source.first];
+            if (correlation < kCorrelationThreshold) continue;
+            std::string applySql =
+                "INSERT OR IGNORE INTO app_categories (app_id, category_id) "
+                "SELECT ac.app_id, (SELECT id FROM categories WHERE category_name = ?) "
+                "FROM app_categories ac "
+                "JOIN categories c ON ac.category_id = c.id "
+                "WHERE c.category_name = ? "
+                "AND ac.app_id NOT IN ("
+                "  SELECT app_id FROM app_categories "
+                "  WHERE category_id = (SELECT id FROM categories WHERE category_name = ?)"
+                ");";
+            sqlite3_stmt* applyStmt;
+            if (sqlite3_prepare_v2(db, applySql.c_str(), -1, &applyStmt, nullptr) == SQLITE_OK) {
+                sqlite3_bind_text(applyStmt, 1, target.first.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(applyStmt, 2, source.first.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(applyStmt, 3, target.first.c_str(), -1, SQLITE_STATIC);
+                if (sqlite3_step(applyStmt) == SQLITE_DONE) added += sqlite3_changes(db);
+                sqlite3_finalize(applyStmt);
+            }
+        }
+    }
+    return added;
+}
+
+// In-memory copy of `source`
+sqlite3* CopyToMemory(sqlite3* source) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+    sqlite3_backup* backup = sqlite3_backup_init(db, "main", source, "main");
+    if (backup) {
+        sqlite3_backup_step(backup, -1);
+        sqlite3_backup_finish(backup);
+    }
+    return db;
+}
+
+std::vector<std::pair<int, int>> AppCategoryRows(sqlite3* db) {
+    std::vector<std::pair<int, int>> rows;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT app_id, category_id FROM app_categories ORDER BY 1, 2;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) rows.emplace_back(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1));
+        sqlite3_finalize(stmt);
+    }
+    return rows;
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+std::string BenchmarkTagCorrelation(const std::string& dbPath) {
+    sqlite3* source = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::string error = "cannot open " + dbPath + ": " + (source ? sqlite3_errmsg(source) : "out of memory");
+        sqlite3_close(source);
+        return error;
+    }
+    sqlite3* legacyDb = CopyToMemory(source);
+    sqlite3* db = CopyToMemory(source);
+    sqlite3_close(source);
+    if (!legacyDb || !db) {
+        sqlite3_close(legacyDb);
+        sqlite3_close(db);
+        return "cannot copy " + dbPath + " into memory";
+    }
+    size_t rowsBefore = AppCategoryRows(db).size();
+
+    auto start = std::chrono::steady_clock::now();
+    int legacyAdded = LegacyApplyCorrelation(legacyDb);
+    double legacyMs = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<AppCategory> inferred = InferCorrelatedCategories(db);
+    double inferMs = MillisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    int added = 0;
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO app_categories (app_id, category_id) VALUES (?, ?);", -1, &stmt, nullptr) == SQLITE_OK) {
+        for (const AppCategory& row : inferred) {
+            sqlite3_bind_int(stmt, 1, row.appId);
+            sqlite3_bind_int(stmt, 2, row.categoryId);
+            if (sqlite3_step(stmt) == SQLITE_DONE) added += sqlite3_changes(db);
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    double insertMs = MillisecondsSince(start);
+
+    bool identical = AppCategoryRows(legacyDb) == AppCategoryRows(db);
+    sqlite3_close(legacyDb);
+    sqlite3_close(db);
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "%zu app_categories rows; Step 6 in memory: per-app queries + INSERT per rule %.1f ms, %d rows added; "
+             "integer pairs %.1f ms + one batched insert %.1f ms, %d rows added; tables %s",
+             rowsBefore, legacyMs, legacyAdded, inferMs, insertMs, added, identical ? "identical" : "DIFFER");
+    return line;
+}
@@ -0,0 +1,284 @@
+// InferCorrelatedCategories against Step 6 as it was (a query per multi-tag
+// app and an INSERT ... NOT IN per rule): after inserting the inferred rows,
+// app_categories must equal what the old SQL left, on the fixture catalog,
+// on hand-made tables for the threshold, the minimum sample count, rule
+// chains and links to deleted categories, and on random small tables.
+//
+// Usage: tag_correlation_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "tag_correlation.h"
+#include <sqlite3.h>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::vector<std::pair<int, int>> Rows;
+
+// ApplyCorrelationAnalysis as it was; returns the rows added
+int LegacyApplyCorrelation(sqlite3* db) {
+    int added = 0;
+    std::map<std::string, std::map<std::string, int>> coOccurrence;
+    std::map<std::string, int> tagCounts;
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT app_id FROM app_categories GROUP BY app_id HAVING COUNT(*) > 1;", -1, &stmt,
+                           nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::vector<std::string> appTags;
+            sqlite3_stmt* tagStmt;
+            std::string tagSql = "SELECT c.category_name FROM categories c JOIN app_categories ac ON c.id = ac.category_id "
+                                 "WHERE ac.app_id = " + std::to_string(sqlite3_column_int(stmt, 0)) + ";";
+            if (sqlite3_prepare_v2(db, tagSql.c_str(), -1, &tagStmt, nullptr) == SQLITE_OK) {
+                while (sqlite3_step(tagStmt) == SQLITE_ROW) {
+                    appTags.push_back(reinterpret_cast<const char*>(sqlite3_column_text(tagStmt, 0)));
+                    tagCounts[appTags.back()]++;
+                }
+                sqlite3_finalize(tagStmt);
+            }
+            for (size_t i = 0; i < appTags.size(); i++) {
+                for (size_t j = 0; j < appTags.size(); j++) {
+                    if (i != j) coOccurrence[appTags[i]][appTags[j]]++;
+                }
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    for (const auto& source : coOccurrence) {
+        if (tagCounts[source.first] < 6) continue;
+        for (const auto& target : source.second) {
+            if (static_cast<double>(target.second) / tagCounts[source.first] < 0.6667) continue;
+            sqlite3_stmt* applyStmt;
+            if (sqlite3_prepare_v2(db,
+                                   "INSERT OR IGNORE INTO app_categories (app_id, category_id) "
+                                   "SELECT ac.app_id, (SELECT id FROM categories WHERE category_name = ?) "
+                                   "FROM app_categories ac JOIN categories c ON ac.category_id = c.id "
+                                   "WHERE c.category_name = ? AND ac.app_id NOT IN ("
+                                   "  SELECT app_id FROM app_categories "
+                                   "  WHERE category_id = (SELECT id FROM categories WHERE category_name = ?));",
+                                   -1, &applyStmt, nullptr) == SQLITE_OK) {
+                sqlite3_bind_text(applyStmt, 1, target.first.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(applyStmt, 2, source.first.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(applyStmt, 3, target.first.c_str(), -1, SQLITE_STATIC);
+                if (sqlite3_step(applyStmt) == SQLITE_DONE) added += sqlite3_changes(db);
+                sqlite3_finalize(applyStmt);
+            }
+        }
+    }
+    return added;
+}
+
+// Step 6 as the updater runs it now; returns the rows added
+int ApplyInferred(sqlite3* db) {
+    int added = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO app_categories (app_id, category_id) VALUES (?, ?);", -1, &stmt,
+                           nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    for (const AppCategory& row : InferCorrelatedCategories(db)) {
+        sqlite3_bind_int(stmt, 1, row.appId);
+        sqlite3_bind_int(stmt, 2, row.categoryId);
+        if (sqlite3_step(stmt) == SQLITE_DONE) added += sqlite3_changes(db);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return added;
+}
+
+Rows AppCategoryRows(sqlite3* db) {
+    Rows rows;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT app_id, category_id FROM app_categories ORDER BY 1, 2;", -1, &stmt, nullptr) ==
+        SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) rows.emplace_back(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1));
+        sqlite3_finalize(stmt);
+    }
+    return rows;
+}
+
+sqlite3* CopyToMemory(sqlite3* source) {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    sqlite3_backup* backup = sqlite3_backup_init(db, "main", source, "main");
+    CHECK(backup != nullptr);
+    if (backup) {
+        sqlite3_backup_step(backup, -1);
+        sqlite3_backup_finish(backup);
+    }
+    return db;
+}
+
+// Step 6 both ways on copies of `db`; returns the rows the old SQL added
+int Compare(sqlite3* db, const char* what) {
+    sqlite3* legacy = CopyToMemory(db);
+    sqlite3* current = CopyToMemory(db);
+    int legacyAdded = LegacyApplyCorrelation(legacy);
+    int added = ApplyInferred(current);
+    if (added != legacyAdded) std::fprintf(stderr, "%s: %d rows added, expected %d\n", what, added, legacyAdded);
+    CHECK_EQ(added, legacyAdded);
+    CHECK(AppCategoryRows(current) == AppCategoryRows(legacy));
+    sqlite3_close(legacy);
+    sqlite3_close(current);
+    return legacyAdded;
+}
+
+// Empty categories and app_categories tables, as the updater's schema has them
+sqlite3* NewTables() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    CHECK(sqlite3_exec(db,
+                       "CREATE TABLE categories (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "category_name TEXT UNIQUE NOT NULL COLLATE NOCASE);"
+                       "CREATE TABLE app_categories (app_id INTEGER, category_id INTEGER, "
+                       "PRIMARY KEY (app_id, category_id));",
+                       nullptr, nullptr, nullptr) == SQLITE_OK);
+    return db;
+}
+
+void AddCategory(sqlite3* db, int id, const std::string& name) {
+    std::string sql = "INSERT INTO categories VALUES (" + std::to_string(id) + ", '" + name + "');";
+    CHECK(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+}
+
+void Link(sqlite3* db, int app, int category) {
+    std::string sql = "INSERT INTO app_categories VALUES (" + std::to_string(app) + ", " + std::to_string(category) + ");";
+    CHECK(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+}
+
+// `together` of `sources` apps with category 1 also have category 2; every
+// app has category 3 as well, so each has several. App 1000 has only 1.
+sqlite3* RuleTables(int sources, int together) {
+    sqlite3* db = NewTables();
+    AddCategory(db, 1, "source");
+    AddCategory(db, 2, "target");
+    AddCategory(db, 3, "zzz");
+    for (int app = 1; app <= sources; ++app) {
+        Link(db, app, 1);
+        Link(db, app, 3);
+        if (app <= together) Link(db, app, 2);
+    }
+    Link(db, 1000, 1);
+    return db;
+}
+
+// Categories added to app `app` by Step 6 on `db`
+std::vector<int> Added(sqlite3* db, int app) {
+    std::vector<int> categories;
+    for (const AppCategory& row : InferCorrelatedCategories(db)) {
+        if (row.appId == app) categories.push_back(row.categoryId);
+    }
+    return categories;
+}
+
+void TestHandMade() {
+    // 5 of 6 is over the threshold, 4 of 6 (0.66667) just under it, and 5
+    // of 5 too few samples. The single-category app 1000 gets the target,
+    // and "zzz" too, since all 6 apps with "source" have it.
+    sqlite3* db = RuleTables(6, 5);
+    CHECK(Added(db, 6) == std::vector<int>({2}));
+    CHECK(Added(db, 1000) == std::vector<int>({2, 3}));
+    Compare(db, "5 of 6");
+    sqlite3_close(db);
+    db = RuleTables(6, 4);
+    CHECK(Added(db, 6).empty());
+    Compare(db, "4 of 6");
+    sqlite3_close(db);
+    db = RuleTables(5, 5);
+    CHECK(Added(db, 1000).empty());
+    Compare(db, "5 of 5");
+    sqlite3_close(db);
+
+    // A chain: "a" implies "b" and "b" implies "c", so app 100, which has
+    // only "a" and a second category, ends up with all three. Rules run in
+    // name order, so "b" -> "c" sees the "b" rows "a" -> "b" added.
+    db = NewTables();
+    AddCategory(db, 10, "a");
+    AddCategory(db, 11, "b");
+    AddCategory(db, 12, "c");
+    AddCategory(db, 13, "other");
+    for (int app = 1; app <= 6; ++app) {
+        Link(db, app, 10);
+        Link(db, app, 11);
+        Link(db, app, 12);
+    }
+    Link(db, 100, 10);
+    Link(db, 100, 13);
+    std::vector<int> added = Added(db, 100);
+    CHECK(added == std::vector<int>({11, 12}));
+    Compare(db, "chain");
+    sqlite3_close(db);
+
+    // Links to a deleted category still make an app count as having
+    // several: 6 apps with "source" and "target" and 3 with "source" and a
+    // missing category are 6 of 9, just under the threshold, not 6 of 6
+    db = NewTables();
+    AddCategory(db, 1, "source");
+    AddCategory(db, 2, "target");
+    for (int app = 1; app <= 6; ++app) {
+        Link(db, app, 1);
+        Link(db, app, 2);
+    }
+    for (int app = 7; app <= 9; ++app) {
+        Link(db, app, 1);
+        Link(db, app, 99);
+    }
+    CHECK(Compare(db, "deleted category") == 0);
+    CHECK(InferCorrelatedCategories(db).empty());
+    sqlite3_close(db);
+}
+
+// Random tables: a few apps, categories that tend to come in pairs, links to
+// deleted categories
+void TestRandom(unsigned seed, int* totalAdded) {
+    std::mt19937 rng(seed);
+    sqlite3* db = NewTables();
+    const int categories = 3 + rng() % 8;
+    for (int c = 1; c <= categories; ++c) AddCategory(db, c * 3, "cat" + std::to_string(rng() % 1000) + "_" + std::to_string(c));
+    const int apps = 10 + rng() % 60;
+    for (int app = 1; app <= apps; ++app) {
+        std::vector<bool> has(categories + 1, false);
+        int first = 1 + rng() % categories;
+        has[first] = true;
+        if (rng() % 4) has[first % categories + 1] = true;   // its usual partner
+        for (int n = rng() % 3; n > 0; --n) has[1 + rng() % categories] = true;
+        for (int c = 1; c <= categories; ++c) {
+            if (has[c]) Link(db, app * 7, c * 3);
+        }
+        if (rng() % 10 == 0) Link(db, app * 7, 1000 + rng() % 5);
+    }
+    *totalAdded += Compare(db, ("seed " + std::to_string(seed)).c_str());
+    sqlite3_close(db);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    TestHandMade();
+
+    int randomAdded = 0;
+    for (unsigned seed = 1; seed <= 300; ++seed) TestRandom(seed, &randomAdded);
+    CHECK(randomAdded > 0);
+
+    std::string path = std::string(argv[1]) + "/tag_correlation_test.db";
+    std::remove(path.c_str());
+    CHECK(WriteFixtureDatabase(MakeCatalogFixture(3000, 21), path));
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK);
+    int fixtureAdded = Compare(db, "fixture catalog");
+    CHECK(fixtureAdded > 0);
+    sqlite3_close(db);
+
+    std::printf("fixture catalog: %d rows added; 300 random tables: %d rows added\n", fixtureAdded, randomAdded);
+    return TestResult("tag_correlation_test");
+}
@@ -0,0 +1,157 @@
+// TagMatcher against the std::regex loop WinProgramUpdater ran per pattern:
+// the updater's own patterns on the fixture catalog's apps and on random
+// text built from the patterns' letters (either case, separators, line
+// breaks, UTF-8 bytes), and a made-up set of more than 64 patterns so that
+// the per-state outputs take several words.
+#include "check.h"
+#include "fixture_catalog.h"
+#include "tag_matcher.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Oracle {
+    std::vector<std::pair<std::regex, std::string>> rules;
+
+    explicit Oracle(const std::map<std::string, std::string>& patterns) {
+        for (const auto& pattern : patterns) {
+            rules.emplace_back(std::regex(pattern.first, std::regex_constants::icase), pattern.second);
+        }
+    }
+
+    // ExtractTagsFromText as it was: every pattern searched in every field
+    std::vector<std::string> Match(const std::string& name, const std::string& packageId,
+                                   const std::string& moniker) const {
+        std::vector<std::string> tags;
+        for (const auto& rule : rules) {
+            if (std::regex_search(name, rule.first) || std::regex_search(packageId, rule.first) ||
+                (!moniker.empty() && std::regex_search(moniker, rule.first))) {
+                if (std::find(tags.begin(), tags.end(), rule.second) == tags.end()) tags.push_back(rule.second);
+            }
+        }
+        return tags;
+    }
+};
+
+int g_compared = 0;
+
+void Compare(const TagMatcher& matcher, const Oracle& oracle, const std::string& name, const std::string& packageId,
+             const std::string& moniker) {
+    std::vector<std::string> got = matcher.Match({name, packageId, moniker});
+    std::vector<std::string> expected = oracle.Match(name, packageId, moniker);
+    if (got != expected) {
+        std::fprintf(stderr, "'%s' / '%s' / '%s': %zu tags, expected %zu\n", name.c_str(), packageId.c_str(),
+                     moniker.c_str(), got.size(), expected.size());
+    }
+    CHECK(got == expected);
+    g_compared++;
+}
+
+// Text of up to `maxLength` bytes, mostly letters the patterns use
+std::string RandomText(const std::string& alphabet, size_t maxLength, std::mt19937& rng) {
+    static const char kOther[] = {' ', '-', '.', '_', '\n', '\r', '\t', '7', (char)0xC3, (char)0xA9, (char)0xFF};
+    std::string text(rng() % (maxLength + 1), ' ');
+    for (char& c : text) {
+        if (rng() % 6 == 0) {
+            c = kOther[rng() % sizeof(kOther)];
+        } else {
+            c = alphabet[rng() % alphabet.size()];
+            if (rng() & 1) c = (char)(c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+        }
+    }
+    return text;
+}
+
+// Random text with whole patterns (or their alternatives) spliced in
+std::string RandomTextWith(const std::vector<std::string>& words, const std::string& alphabet, std::mt19937& rng) {
+    std::string text = RandomText(alphabet, 12, rng);
+    for (int n = rng() % 3; n > 0; --n) text += words[rng() % words.size()] + RandomText(alphabet, 6, rng);
+    return text;
+}
+
+void TestPatterns(const std::map<std::string, std::string>& patterns, const std::vector<std::string>& samples,
+                  int randomApps, unsigned seed) {
+    TagMatcher matcher;
+    matcher.Build(patterns);
+    CHECK(matcher.StateCount() > patterns.size());
+    Oracle oracle(patterns);
+
+    // What the patterns match, spelled out, and the letters they use
+    std::vector<std::string> words;
+    std::string alphabet;
+    for (const auto& pattern : patterns) {
+        std::string word;
+        for (char c : pattern.first) {
+            if (c == '|') {
+                words.push_back(word);
+                word.clear();
+            } else if (c != '?') {
+                word += c == '.' ? ' ' : c;
+                if (c != '.' && alphabet.find(c) == std::string::npos) alphabet += c;
+            }
+        }
+        words.push_back(word);
+    }
+
+    for (const std::string& sample : samples) Compare(matcher, oracle, sample, "", "");
+    std::mt19937 rng(seed);
+    for (int app = 0; app < randomApps; ++app) {
+        Compare(matcher, oracle, RandomTextWith(words, alphabet, rng), RandomText(alphabet, 20, rng),
+                rng() % 3 ? std::string() : RandomTextWith(words, alphabet, rng));
+    }
+}
+
+}  // namespace
+
+int main() {
+    const auto& patterns = NameTagPatterns();
+
+    // The regex forms the rules use, case, and matches that would span fields
+    TagMatcher matcher;
+    matcher.Build(patterns);
+    auto tags = [&](const std::string& name, const std::string& packageId = "", const std::string& moniker = "") {
+        return matcher.Match({name, packageId, moniker});
+    };
+    typedef std::vector<std::string> Tags;
+    CHECK(tags("") == Tags());
+    CHECK(tags("Notepad") == Tags());
+    CHECK(tags("usb drive") == Tags({"usb"}));
+    CHECK(tags("Wi-Fi Analyzer") == Tags({"wifi"}));
+    CHECK(tags("WIFI Analyzer") == Tags({"wifi"}));
+    CHECK(tags("Command Line Tools") == Tags({"cli"}));
+    CHECK(tags("CommandLine") == Tags({"cli"}));
+    CHECK(tags("Command--Line") == Tags());
+    CHECK(tags("Command\nLine") == Tags());
+    CHECK(tags("Comm", "and Line") == Tags());
+    CHECK(tags("Video Player", "Acme.VideoPlayer", "player") == Tags({"player", "video"}));
+    CHECK(tags("Photo Editor", "Acme.ImageTool") == Tags({"editor", "graphics"}));
+
+    // The fixture catalog's apps, as the updater tags them
+    CatalogFixture fixture = MakeCatalogFixture(2000, 20);
+    Oracle oracle(patterns);
+    for (const FixtureApp& app : fixture.apps) Compare(matcher, oracle, app.name, app.packageId, app.moniker);
+    const int fixtureApps = g_compared;
+
+    TestPatterns(patterns, {}, 3000, 20);
+
+    // More than 64 patterns, sharing prefixes, suffixes and tags
+    std::map<std::string, std::string> many;
+    const char* stems[] = {"net", "sync", "data", "cloud", "edit", "view", "play", "scan", "zip", "code"};
+    const char* ends[] = {"er", "or", "ing", "s", "box", "hub", "kit"};
+    for (const char* stem : stems) {
+        for (const char* end : ends) many[std::string(stem) + end] = std::string(stem);
+    }
+    many["Net.?Work|LAN"] = "network";
+    many["Zip.Tool"] = "archive";
+    CHECK(many.size() > 64);
+    TestPatterns(many, {"netbox syncing datahub", "Cloud-Kit", "zip tool", "ZIPXTOOL", "lan party"}, 3000, 64);
+
+    std::printf("%d fixture apps, %d tag sets compared\n", fixtureApps, g_compared);
+    return TestResult("tag_matcher_test");
+}
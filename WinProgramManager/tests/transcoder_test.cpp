@@ -0,0 +1,114 @@
+// TranscodeIcon against a corpus of favicons as sites serve them
+// (fixtures/favicons, labelled accept or reject in labels.txt): accepted ones
+// become an icon bitmap that shows what the original showed and transcodes to
+// itself, rejected ones leave the app without an icon. Mutated copies of the
+// corpus must be rejected or decoded, never crash.
+//
+// Usage: transcoder_test <favicons dir> [mutations]
+#include "check.h"
+#include "icon_decoder.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<unsigned char> Bytes(const std::string& text) {
+    return std::vector<unsigned char>(text.begin(), text.end());
+}
+
+void TestCorpus(const std::string& dir, std::vector<std::vector<unsigned char>>& accepted) {
+    auto labels = ReadFixtureTable(dir + "/labels.txt");
+    CHECK(labels.size() > 30);
+    for (const auto& label : labels) {
+        if (label.size() < 2) {
+            CHECK(label.size() >= 2);
+            continue;
+        }
+        const std::string& name = label[1];
+        std::vector<unsigned char> data = Bytes(ReadFixture(dir + "/" + name));
+        std::vector<unsigned char> out;
+        bool ok = TranscodeIcon(data.data(), data.size(), out);
+        if (ok != (label[0] == "accept")) {
+            std::fprintf(stderr, "%s: %s\n", name.c_str(), ok ? "accepted" : "rejected");
+            CHECK(ok == (label[0] == "accept"));
+            continue;
+        }
+        if (!ok) continue;
+        accepted.push_back(data);
+        CHECK(IsIconBitmap(out.data(), out.size()));
+        // Only files smaller than the fixed-size bitmap grow
+        CHECK(out.size() < data.size() || data.size() < 1200);
+
+        // The list shows the same 16x16 pixels from either; other sizes still decode
+        for (int size : {16, 24, 32}) {
+            IconPixels original, transcoded;
+            CHECK(DecodeIcon(out.data(), out.size(), size, transcoded));
+            CHECK_EQ(transcoded.width, size);
+            CHECK_EQ(transcoded.height, size);
+            if (size == 16) {
+                CHECK(DecodeIcon(data.data(), data.size(), size, original));
+                if (original.bgra != transcoded.bgra) {
+                    std::fprintf(stderr, "%s: 16x16 pixels differ after transcoding\n", name.c_str());
+                    CHECK(original.bgra == transcoded.bgra);
+                }
+            }
+        }
+        std::vector<unsigned char> again;
+        CHECK(TranscodeIcon(out.data(), out.size(), again));
+        CHECK(again == out);
+    }
+}
+
+// A valid PNG padded past kMaxIconBytes is turned away on its size alone
+void TestOversizedFile(const std::string& dir) {
+    std::vector<unsigned char> data = Bytes(ReadFixture(dir + "/android_512.png"));
+    std::vector<unsigned char> out;
+    CHECK(TranscodeIcon(data.data(), data.size(), out));
+    data.resize(kMaxIconBytes + 1, 0);
+    CHECK(!TranscodeIcon(data.data(), data.size(), out));
+}
+
+void TestMutations(const std::vector<std::vector<unsigned char>>& corpus, int mutations) {
+    uint64_t state = 88172645463325252ull;
+    auto next = [&]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    for (int i = 0; i < mutations && !corpus.empty(); ++i) {
+        std::vector<unsigned char> data = corpus[next() % corpus.size()];
+        std::vector<unsigned char> out;
+        if (next() % 3 == 0 && TranscodeIcon(data.data(), data.size(), out)) data = out;
+        int edits = 1 + (int)(next() % 8);
+        for (int e = 0; e < edits && !data.empty(); ++e) {
+            size_t pos = next() % data.size();
+            switch (next() % 4) {
+            case 0: data[pos] ^= (unsigned char)(1 << (next() % 8)); break;
+            case 1: data[pos] = (unsigned char)next(); break;
+            case 2: data.resize(pos); break;
+            default: data.insert(data.begin() + pos, (unsigned char)next()); break;
+            }
+        }
+        IconPixels pixels;
+        if (TranscodeIcon(data.data(), data.size(), out)) CHECK(IsIconBitmap(out.data(), out.size()));
+        DecodeIcon(data.data(), data.size(), 16, pixels);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <favicons dir> [mutations]\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+    std::vector<std::vector<unsigned char>> accepted;
+    TestCorpus(dir, accepted);
+    TestOversizedFile(dir);
+    TestMutations(accepted, argc >= 3 ? std::atoi(argv[2]) : 2000);
+    return TestResult("transcoder_test");
+}
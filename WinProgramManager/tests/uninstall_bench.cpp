@@ -0,0 +1,145 @@
+// Benchmarks of UninstallIndex against matching every package entry by entry,
+// and of InstalledCorrelator against the substring rule alone.
+#include "wpm_benchmarks.h"
+#include "catalog.h"
+#include "uninstall_index.h"
+#include "winget_index.h"
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// The check IsInstalledInRegistry made for one package, minus the registry
+// reads: every entry normalized and searched again
+bool LegacyMatches(const std::vector<UninstallEntry>& entries, const std::wstring& packageId) {
+    std::string pkgNorm = NormalizeForMatch(packageId);
+    std::vector<std::string> pkgParts;
+    size_t dotPos = packageId.find(L'.');
+    if (dotPos != std::wstring::npos) {
+        pkgParts.push_back(NormalizeForMatch(std::wstring_view(packageId).substr(0, dotPos)));
+        pkgParts.push_back(NormalizeForMatch(std::wstring_view(packageId).substr(dotPos + 1)));
+    } else {
+        pkgParts.push_back(pkgNorm);
+    }
+    for (const auto& entry : entries) {
+        std::string nameNorm = NormalizeForMatch(entry.displayName);
+        std::string pubNorm = entry.currentUser ? std::string() : NormalizeForMatch(entry.publisher);
+        for (const auto& part : pkgParts) {
+            if (!part.empty() && (nameNorm.find(part) != std::string::npos || pubNorm.find(part) != std::string::npos)) {
+                return true;
+            }
+        }
+        if (!entry.currentUser && !pkgNorm.empty() && nameNorm.find(pkgNorm) != std::string::npos) return true;
+    }
+    return false;
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+std::string BenchmarkUninstallIndex(const std::string& regPath, const std::string& dbPath) {
+    std::vector<UninstallEntry> entries;
+    auto start = std::chrono::steady_clock::now();
+    if (regPath == "-") {
+        entries = ReadUninstallEntries();
+    } else if (!ReadUninstallExport(regPath, entries)) {
+        return "cannot read " + regPath;
+    }
+    double readMs = MillisecondsSince(start);
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::string error = "cannot open " + dbPath + ": " + (db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close(db);
+        return error;
+    }
+    std::vector<std::wstring> packageIds;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT package_id FROM apps;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) packageIds.push_back(ColumnToWide((const char*)sqlite3_column_text(stmt, 0)));
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
+
+    start = std::chrono::steady_clock::now();
+    size_t legacyMatched = 0;
+    for (const auto& id : packageIds) legacyMatched += LegacyMatches(entries, id);
+    double legacyMs = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    UninstallIndex index;
+    index.Build(entries);
+    double buildMs = MillisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    size_t matched = 0;
+    for (const auto& id : packageIds) matched += index.Matches(id);
+    double indexMs = MillisecondsSince(start);
+
+    size_t differ = 0;
+    for (const auto& id : packageIds) differ += index.Matches(id) != LegacyMatches(entries, id);
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "%zu Uninstall entries (read in %.1f ms, now once per sync instead of once per package), %zu packages; "
+             "entry-by-entry matching %.1f ms, %zu matched; index build %.2f ms + matching %.1f ms, %zu matched, "
+             "%zu differ",
+             entries.size(), readMs, packageIds.size(), legacyMs, legacyMatched, buildMs, indexMs,
+             matched, differ);
+    return line;
+}
+
+std::string BenchmarkCorrelation(const std::string& indexPath, const std::string& regPath) {
+    std::vector<UninstallEntry> entries;
+    if (regPath == "-") {
+        entries = ReadUninstallEntries();
+    } else if (!ReadUninstallExport(regPath, entries)) {
+        return "cannot read " + regPath;
+    }
+
+    std::vector<std::string> packageIds;
+    WingetIndexReader index;
+    if (!index.Open(indexPath)) return "cannot open " + indexPath + ": " + index.LastError();
+    index.ForEachPackage([&](const WingetIndexRecord& rec) {
+        packageIds.push_back(rec.id);
+        return true;
+    }, false);
+    index.Close();
+
+    auto start = std::chrono::steady_clock::now();
+    UninstallIndex substring;
+    substring.Build(entries);
+    std::vector<const std::string*> substringMatched;
+    for (const auto& id : packageIds) {
+        if (substring.Matches(ColumnToWide(id.c_str()))) substringMatched.push_back(&id);
+    }
+    double substringMs = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    InstalledCorrelator correlator;
+    if (!LoadProductCodes(indexPath, correlator)) return "cannot read product codes of " + indexPath;
+    double loadMs = MillisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    correlator.Build(entries);
+    size_t matched = 0;
+    for (const auto& id : packageIds) matched += correlator.IsInstalled(id);
+    double correlateMs = MillisecondsSince(start);
+
+    // Substring matches that a product code backs up; the rest are guesses
+    size_t confirmed = 0;
+    for (const std::string* id : substringMatched) confirmed += correlator.IsInstalledByProductCode(*id);
+
+    char line[640];
+    snprintf(line, sizeof(line),
+             "%zu packages, %zu product codes (loaded in %.1f ms), %zu Uninstall entries; "
+             "substring rule %.1f ms: %zu installed, %zu confirmed by a product code; "
+             "correlation %.1f ms: %zu installed, %zu by product code + %zu by name from %zu unclaimed entries",
+             packageIds.size(), correlator.ProductCodeCount(), loadMs, entries.size(), substringMs,
+             substringMatched.size(), confirmed, correlateMs, matched, correlator.ExactPackageCount(),
+             matched - correlator.ExactPackageCount(), correlator.UnclaimedEntryCount());
+    return line;
+}
@@ -0,0 +1,131 @@
+// Uninstall entries read from regedit exports, and UninstallIndex against the
+// rule installed_apps.cpp applied entry by entry: the hand-written exports in
+// fixtures/uninstall check the parser and the rule's corner cases, and every
+// package of a generated catalog checks that the index answers as the plain
+// search over the same entries would.
+//
+// Usage: uninstall_test <uninstall fixtures dir> <scratch dir>
+#include "catalog.h"
+#include "check.h"
+#include "fixture_catalog.h"
+#include "uninstall_index.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::wstring Wide(const std::string& utf8) {
+    return ColumnToWide(utf8.c_str());
+}
+
+// IsInstalledInRegistry without the registry: search every entry for either
+// half of the id
+bool MatchesEntryByEntry(const std::vector<UninstallEntry>& entries, const std::wstring& packageId) {
+    std::vector<std::string> parts;
+    size_t dot = packageId.find(L'.');
+    if (dot == std::wstring::npos) {
+        parts.push_back(NormalizeForMatch(packageId));
+    } else {
+        parts.push_back(NormalizeForMatch(std::wstring_view(packageId).substr(0, dot)));
+        parts.push_back(NormalizeForMatch(std::wstring_view(packageId).substr(dot + 1)));
+    }
+    for (const auto& entry : entries) {
+        std::string name = NormalizeForMatch(entry.displayName);
+        std::string publisher = entry.currentUser ? std::string() : NormalizeForMatch(entry.publisher);
+        for (const auto& part : parts) {
+            if (!part.empty() && (name.find(part) != std::string::npos || publisher.find(part) != std::string::npos)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TestExport(const std::string& path, const std::vector<std::vector<std::string>>& expected) {
+    std::vector<UninstallEntry> entries;
+    CHECK(ReadUninstallExport(path, entries));
+    CHECK_EQ(entries.size(), expected.size());
+    for (size_t i = 0; i < entries.size() && i < expected.size(); ++i) {
+        const auto& e = expected[i];
+        if (e.size() < 4) {
+            CHECK(e.size() >= 4);
+            continue;
+        }
+        CHECK_EQ(entries[i].currentUser, e[0] == "HKCU");
+        CHECK(entries[i].keyName == Wide(e[1]));
+        CHECK(entries[i].displayName == Wide(e[2]));
+        CHECK(entries[i].publisher == Wide(e[3]));
+    }
+}
+
+void TestHandWrittenExports(const std::string& dir) {
+    auto expected = ReadFixtureTable(dir + "/uninstall.expected");
+    CHECK(expected.size() > 5);
+    TestExport(dir + "/uninstall.reg", expected);
+    // The ANSI export is the same without the entry that needs UTF-16
+    expected.pop_back();
+    TestExport(dir + "/uninstall_regedit4.reg", expected);
+
+    std::vector<UninstallEntry> entries;
+    CHECK(!ReadUninstallExport(dir + "/missing.reg", entries));
+    CHECK(entries.empty());
+
+    // Both ways of matching give the answers the old rule gave
+    CHECK(ReadUninstallExport(dir + "/uninstall.reg", entries));
+    UninstallIndex index;
+    index.Build(entries);
+    CHECK_EQ(index.EntryCount(), entries.size());
+    auto matches = ReadFixtureTable(dir + "/uninstall.matches");
+    CHECK(matches.size() > 10);
+    for (const auto& m : matches) {
+        if (m.size() < 2) continue;
+        std::wstring id = Wide(m[0]);
+        bool expectMatch = m[1] == "yes";
+        if (index.Matches(id) != expectMatch || MatchesEntryByEntry(entries, id) != expectMatch) {
+            std::fprintf(stderr, "%s: expected %s, index %d, entry by entry %d\n", m[0].c_str(), m[1].c_str(),
+                         (int)index.Matches(id), (int)MatchesEntryByEntry(entries, id));
+            CHECK(false);
+        }
+    }
+}
+
+// Every package of a generated catalog, and the parts of ids that are not in
+// it, against the generated export
+void TestAgreement(const std::string& scratch) {
+    CatalogFixture fixture = MakeCatalogFixture(3000, 5);
+    std::string path = scratch + "/uninstall_test.reg";
+    CHECK(WriteFixtureUninstallExport(fixture, path));
+    std::vector<UninstallEntry> entries;
+    CHECK(ReadUninstallExport(path, entries));
+    CHECK(entries.size() > 40);
+    UninstallIndex index;
+    index.Build(entries);
+
+    std::vector<std::wstring> ids;
+    for (const FixtureApp& app : fixture.apps) {
+        ids.push_back(Wide(app.packageId));
+        ids.push_back(Wide(app.name));   // no dot: the whole id is one part
+        ids.push_back(Wide(app.publisher.substr(0, 2) + "." + app.name.substr(app.name.size() - 1)));
+    }
+    size_t matched = 0, differ = 0;
+    for (const std::wstring& id : ids) {
+        bool indexed = index.Matches(id);
+        matched += indexed;
+        differ += indexed != MatchesEntryByEntry(entries, id);
+    }
+    CHECK(matched > 0);
+    CHECK(matched < ids.size());
+    CHECK_EQ(differ, 0u);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <uninstall fixtures dir> <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    TestHandWrittenExports(argv[1]);
+    TestAgreement(argv[2]);
+    return TestResult("uninstall_test");
+}
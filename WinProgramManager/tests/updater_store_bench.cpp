@@ -0,0 +1,195 @@
+// Benchmark of UpdaterStore against the per-statement writes it replaced,
+// with SQLite file syncs counted by a pass-through VFS.
+#include "wpm_benchmarks.h"
+#include "updater_store.h"
+#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static sqlite3_vfs* g_baseVfs = nullptr;
+static std::atomic<int> g_syncCount{0};
+
+struct CountingFile {
+    sqlite3_file base;
+    sqlite3_file* real;   // lives right after this struct
+};
+
+static int CfClose(sqlite3_file* f) { auto* c = (CountingFile*)f; return c->real->pMethods->xClose(c->real); }
+static int CfRead(sqlite3_file* f, void* p, int n, sqlite3_int64 o) { auto* c = (CountingFile*)f; return c->real->pMethods->xRead(c->real, p, n, o); }
+static int CfWrite(sqlite3_file* f, const void* p, int n, sqlite3_int64 o) { auto* c = (CountingFile*)f; return c->real->pMethods->xWrite(c->real, p, n, o); }
+static int CfTruncate(sqlite3_file* f, sqlite3_int64 n) { auto* c = (CountingFile*)f; return c->real->pMethods->xTruncate(c->real, n); }
+static int CfSync(sqlite3_file* f, int flags) { auto* c = (CountingFile*)f; g_syncCount++; return c->real->pMethods->xSync(c->real, flags); }
+static int CfFileSize(sqlite3_file* f, sqlite3_int64* n) { auto* c = (CountingFile*)f; return c->real->pMethods->xFileSize(c->real, n); }
+static int CfLock(sqlite3_file* f, int l) { auto* c = (CountingFile*)f; return c->real->pMethods->xLock(c->real, l); }
+static int CfUnlock(sqlite3_file* f, int l) { auto* c = (CountingFile*)f; return c->real->pMethods->xUnlock(c->real, l); }
+static int CfCheckLock(sqlite3_file* f, int* r) { auto* c = (CountingFile*)f; return c->real->pMethods->xCheckReservedLock(c->real, r); }
+static int CfControl(sqlite3_file* f, int op, void* a) { auto* c = (CountingFile*)f; return c->real->pMethods->xFileControl(c->real, op, a); }
+static int CfSector(sqlite3_file* f) { auto* c = (CountingFile*)f; return c->real->pMethods->xSectorSize(c->real); }
+static int CfDevice(sqlite3_file* f) { auto* c = (CountingFile*)f; return c->real->pMethods->xDeviceCharacteristics(c->real); }
+
+static const sqlite3_io_methods kCountingMethods = {
+    1, CfClose, CfRead, CfWrite, CfTruncate, CfSync, CfFileSize, CfLock, CfUnlock,
+    CfCheckLock, CfControl, CfSector, CfDevice,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+static int CvOpen(sqlite3_vfs*, const char* name, sqlite3_file* f, int flags, int* outFlags) {
+    auto* c = (CountingFile*)f;
+    c->real = (sqlite3_file*)(c + 1);
+    int rc = g_baseVfs->xOpen(g_baseVfs, name, c->real, flags, outFlags);
+    c->base.pMethods = (rc == SQLITE_OK && c->real->pMethods) ? &kCountingMethods : nullptr;
+    return rc;
+}
+static int CvDelete(sqlite3_vfs*, const char* n, int s) { return g_baseVfs->xDelete(g_baseVfs, n, s); }
+static int CvAccess(sqlite3_vfs*, const char* n, int f, int* r) { return g_baseVfs->xAccess(g_baseVfs, n, f, r); }
+static int CvFullPath(sqlite3_vfs*, const char* n, int len, char* out) { return g_baseVfs->xFullPathname(g_baseVfs, n, len, out); }
+static void* CvDlOpen(sqlite3_vfs*, const char* n) { return g_baseVfs->xDlOpen(g_baseVfs, n); }
+static void CvDlError(sqlite3_vfs*, int n, char* msg) { g_baseVfs->xDlError(g_baseVfs, n, msg); }
+static void (*CvDlSym(sqlite3_vfs*, void* h, const char* s))(void) { return g_baseVfs->xDlSym(g_baseVfs, h, s); }
+static void CvDlClose(sqlite3_vfs*, void* h) { g_baseVfs->xDlClose(g_baseVfs, h); }
+static int CvRandom(sqlite3_vfs*, int n, char* out) { return g_baseVfs->xRandomness(g_baseVfs, n, out); }
+static int CvSleep(sqlite3_vfs*, int us) { return g_baseVfs->xSleep(g_baseVfs, us); }
+static int CvTime(sqlite3_vfs*, double* t) { return g_baseVfs->xCurrentTime(g_baseVfs, t); }
+static int CvLastError(sqlite3_vfs*, int n, char* msg) { return g_baseVfs->xGetLastError ? g_baseVfs->xGetLastError(g_baseVfs, n, msg) : 0; }
+
+static const char* RegisterCountingVfs() {
+    static sqlite3_vfs vfs;
+    if (!g_baseVfs) {
+        g_baseVfs = sqlite3_vfs_find(nullptr);
+        if (!g_baseVfs) return nullptr;
+        vfs.iVersion = 1;
+        vfs.szOsFile = (int)sizeof(CountingFile) + g_baseVfs->szOsFile;
+        vfs.mxPathname = g_baseVfs->mxPathname;
+        vfs.zName = "wpm-sync-count";
+        vfs.xOpen = CvOpen; vfs.xDelete = CvDelete; vfs.xAccess = CvAccess; vfs.xFullPathname = CvFullPath;
+        vfs.xDlOpen = CvDlOpen; vfs.xDlError = CvDlError; vfs.xDlSym = CvDlSym; vfs.xDlClose = CvDlClose;
+        vfs.xRandomness = CvRandom; vfs.xSleep = CvSleep; vfs.xCurrentTime = CvTime; vfs.xGetLastError = CvLastError;
+        sqlite3_vfs_register(&vfs, 0);
+    }
+    return vfs.zName;
+}
+
+static const char* kBenchSchema =
+    "CREATE TABLE apps (id INTEGER PRIMARY KEY AUTOINCREMENT, package_id TEXT UNIQUE NOT NULL, name TEXT, "
+    "version TEXT, publisher TEXT, description TEXT);"
+    "CREATE TABLE categories (id INTEGER PRIMARY KEY AUTOINCREMENT, category_name TEXT UNIQUE NOT NULL COLLATE NOCASE);"
+    "CREATE TABLE app_categories (app_id INTEGER, category_id INTEGER, PRIMARY KEY (app_id, category_id));"
+    "CREATE INDEX idx_package_id ON apps(package_id);";
+
+static const char* kBenchInsertApp =
+    "INSERT OR REPLACE INTO apps (package_id, name, version, publisher, description) VALUES (?, ?, ?, ?, ?);";
+
+struct BenchPackage { std::string id, name; std::vector<std::string> tags; };
+
+static void BindBenchApp(sqlite3_stmt* stmt, const BenchPackage& p) {
+    sqlite3_bind_text(stmt, 1, p.id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, p.name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, "1.2.3", -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, "Bench Publisher", -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, "A package used to time the updater's write path.", -1, SQLITE_STATIC);
+}
+
+// Former WinProgramUpdater::AddPackage/AddTag/GetPackageDbId/GetCategoryId.
+static void LegacyAddPackage(sqlite3* db, const BenchPackage& p) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, kBenchInsertApp, -1, &stmt, nullptr) == SQLITE_OK) {
+        BindBenchApp(stmt, p);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    for (const auto& tag : p.tags) {
+        int dbId = -1, categoryId = -1;
+        if (sqlite3_prepare_v2(db, "SELECT id FROM apps WHERE package_id = ? COLLATE NOCASE;", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, p.id.c_str(), -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) == SQLITE_ROW) dbId = sqlite3_column_int(stmt, 0);
+            sqlite3_finalize(stmt);
+        }
+        if (dbId <= 0) continue;
+        if (sqlite3_prepare_v2(db, "SELECT id FROM categories WHERE category_name = ? COLLATE NOCASE;", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, tag.c_str(), -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) == SQLITE_ROW) categoryId = sqlite3_column_int(stmt, 0);
+            sqlite3_finalize(stmt);
+        }
+        if (categoryId == -1 && sqlite3_prepare_v2(db, "INSERT INTO categories (category_name) VALUES (?);", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, tag.c_str(), -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) == SQLITE_DONE) categoryId = (int)sqlite3_last_insert_rowid(db);
+            sqlite3_finalize(stmt);
+        }
+        if (categoryId <= 0) continue;
+        if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO app_categories (app_id, category_id) VALUES (?, ?);", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_int(stmt, 1, dbId);
+            sqlite3_bind_int(stmt, 2, categoryId);
+            sqlite3_step(stmt);
+            sqlite3_finalize(stmt);
+        }
+    }
+}
+
+std::string BenchmarkUpdaterStore(const std::string& dir, int packages, int tagsPerPackage) {
+    const char* vfs = RegisterCountingVfs();
+    if (!vfs) return "no sqlite VFS";
+
+    std::vector<BenchPackage> input(packages);
+    unsigned seed = 12345;
+    for (int i = 0; i < packages; ++i) {
+        input[i].id = "Publisher" + std::to_string(i % 900) + ".Package" + std::to_string(i);
+        input[i].name = "Package " + std::to_string(i);
+        for (int t = 0; t < tagsPerPackage; ++t) {
+            seed = seed * 1103515245u + 12345u;
+            input[i].tags.push_back("tag" + std::to_string((seed >> 8) % 3000));
+        }
+    }
+
+    std::string report;
+    for (int pass = 0; pass < 2; ++pass) {
+        std::string path = dir + (pass == 0 ? "/bench_legacy.db" : "/bench_store.db");
+        std::remove(path.c_str());
+        std::remove((path + "-journal").c_str());
+        sqlite3* db = nullptr;
+        if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, vfs) != SQLITE_OK) {
+            sqlite3_close(db);
+            return "cannot create " + path;
+        }
+        sqlite3_exec(db, kBenchSchema, nullptr, nullptr, nullptr);
+
+        int syncsBefore = g_syncCount.load();
+        auto start = std::chrono::steady_clock::now();
+        int commits = 0;
+        if (pass == 0) {
+            for (const auto& p : input) LegacyAddPackage(db, p);
+        } else {
+            UpdaterStore store;
+            store.Attach(db);
+            store.BeginBatch();
+            for (const auto& p : input) {
+                sqlite3_stmt* stmt = store.Statement(kBenchInsertApp);
+                if (!stmt) break;
+                BindBenchApp(stmt, p);
+                if (sqlite3_step(stmt) == SQLITE_DONE) store.SetPackageId(p.id, (int)sqlite3_last_insert_rowid(db));
+                int appId = store.PackageId(p.id);
+                for (const auto& tag : p.tags) {
+                    int categoryId = store.CategoryId(tag);
+                    if (appId > 0 && categoryId > 0) store.AddCategoryLink(appId, categoryId);
+                }
+                store.Wrote();
+            }
+            store.EndBatch();
+            commits = store.Commits();
+            store.Detach();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        int syncs = g_syncCount.load() - syncsBefore;
+        sqlite3_close(db);
+        std::remove(path.c_str());
+
+        char line[200];
+        snprintf(line, sizeof(line), "%s%s: %d packages x %d tags in %.0f ms, %d syncs%s",
+                 pass == 0 ? "" : "; ", pass == 0 ? "per-statement" : "UpdaterStore",
+                 packages, tagsPerPackage, ms, syncs,
+                 pass == 0 ? "" : (" (" + std::to_string(commits) + " commits)").c_str());
+        report += line;
+    }
+    return report;
+}
@@ -0,0 +1,200 @@
+// UpdaterStore on the fixture database: batches commit every CommitSize()
+// writes and at EndBatch, a batch inside someone else's transaction joins it
+// instead of committing, and the package and category id maps agree with the
+// tables under their collations (package_id BINARY, category_name NOCASE).
+//
+// Usage: updater_store_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "updater_store.h"
+#include <sqlite3.h>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+const char* kInsertApp = "INSERT INTO apps (package_id, name) VALUES (?, ?);";
+
+std::string g_scratch;
+
+sqlite3* OpenFixture(const std::string& name, const CatalogFixture& fixture) {
+    std::string path = g_scratch + "/" + name;
+    std::remove(path.c_str());
+    std::remove((path + "-journal").c_str());
+    CHECK(WriteFixtureDatabase(fixture, path));
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    return db;
+}
+
+int QueryInt(sqlite3* db, const std::string& sql) {
+    sqlite3_stmt* stmt = nullptr;
+    int value = -1;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// Rows another connection sees, i.e. what has been committed
+int CommittedApps(const std::string& name) {
+    sqlite3* reader = nullptr;
+    int n = -1;
+    if (sqlite3_open_v2((g_scratch + "/" + name).c_str(), &reader, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK) {
+        n = QueryInt(reader, "SELECT COUNT(*) FROM apps;");
+    }
+    sqlite3_close(reader);
+    return n;
+}
+
+bool InsertApp(UpdaterStore& store, const std::string& packageId) {
+    sqlite3_stmt* stmt = store.Statement(kInsertApp);
+    if (!stmt) return false;
+    sqlite3_bind_text(stmt, 1, packageId.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, packageId.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_DONE) return false;
+    store.SetPackageId(packageId, (int)sqlite3_last_insert_rowid(store.Db()));
+    store.Wrote();
+    return true;
+}
+
+void TestCommitCadence(const CatalogFixture& fixture) {
+    const std::string name = "updater_store_cadence.db";
+    sqlite3* db = OpenFixture(name, fixture);
+    const int base = (int)fixture.apps.size();
+    UpdaterStore store;
+    store.Attach(db);
+    store.SetCommitSize(0);
+    CHECK_EQ(store.CommitSize(), 1);
+    store.SetCommitSize(10);
+
+    // Outside a batch every statement is its own transaction
+    CHECK(InsertApp(store, "Outside.Batch"));
+    CHECK_EQ(store.Commits(), 0);
+    CHECK_EQ(CommittedApps(name), base + 1);
+
+    store.BeginBatch();
+    CHECK(!sqlite3_get_autocommit(db));
+    for (int i = 0; i < 25; ++i) CHECK(InsertApp(store, "Cadence.App" + std::to_string(i)));
+    CHECK_EQ(store.Commits(), 2);
+    CHECK_EQ(CommittedApps(name), base + 1 + 20);
+    store.EndBatch();
+    CHECK_EQ(store.Commits(), 3);
+    CHECK(sqlite3_get_autocommit(db));
+    CHECK_EQ(CommittedApps(name), base + 1 + 25);
+
+    // Detach commits a batch left open
+    store.BeginBatch();
+    CHECK(InsertApp(store, "Left.Open"));
+    store.Detach();
+    CHECK_EQ(store.Commits(), 4);
+    CHECK(sqlite3_get_autocommit(db));
+    CHECK_EQ(CommittedApps(name), base + 1 + 25 + 1);
+    sqlite3_close(db);
+}
+
+void TestOuterTransaction(const CatalogFixture& fixture) {
+    const std::string name = "updater_store_outer.db";
+    sqlite3* db = OpenFixture(name, fixture);
+    const int base = (int)fixture.apps.size();
+    UpdaterStore store;
+    store.Attach(db);
+    store.SetCommitSize(10);
+    CHECK(sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) == SQLITE_OK);
+    store.BeginBatch();
+    for (int i = 0; i < 35; ++i) CHECK(InsertApp(store, "Outer.App" + std::to_string(i)));
+    store.EndBatch();
+    // Neither the cadence nor EndBatch committed the caller's transaction
+    CHECK_EQ(store.Commits(), 0);
+    CHECK(!sqlite3_get_autocommit(db));
+    CHECK_EQ(CommittedApps(name), base);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM apps;"), base + 35);
+    CHECK(sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr) == SQLITE_OK);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM apps;"), base);
+    store.Detach();
+    CHECK_EQ(store.Commits(), 0);
+    sqlite3_close(db);
+}
+
+void TestIdMaps(const CatalogFixture& fixture) {
+    sqlite3* db = OpenFixture("updater_store_ids.db", fixture);
+    UpdaterStore store;
+    store.Attach(db);
+
+    // Loaded from the table, by exact package id
+    for (const FixtureApp& app : fixture.apps) {
+        CHECK_EQ(store.PackageId(app.packageId),
+                 QueryInt(db, "SELECT id FROM apps WHERE package_id = '" + app.packageId + "';"));
+    }
+    const std::string known = fixture.apps[0].packageId;
+    const int knownId = store.PackageId(known);
+    CHECK(knownId > 0);
+    CHECK_EQ(store.PackageId("No.Such.Package"), -1);
+
+    // package_id is BINARY: a case variant is a row of its own
+    std::string variant = known;
+    for (auto& c : variant) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    CHECK(variant != known);
+    CHECK_EQ(store.PackageId(variant), -1);
+    CHECK(InsertApp(store, variant));
+    const int variantId = store.PackageId(variant);
+    CHECK(variantId > 0 && variantId != knownId);
+    CHECK_EQ(store.PackageId(known), knownId);
+    store.ForgetPackage(variant);
+    CHECK_EQ(store.PackageId(variant), -1);
+    CHECK_EQ(store.PackageId(known), knownId);
+
+    // category_name is NOCASE: any case finds the stored row, nothing is inserted
+    const int categories = QueryInt(db, "SELECT COUNT(*) FROM categories;");
+    const std::string& category = fixture.categories[0];
+    std::string upper = category;
+    for (auto& c : upper) if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+    const int categoryId = store.CategoryId(category);
+    CHECK_EQ(categoryId, QueryInt(db, "SELECT id FROM categories WHERE category_name = '" + category + "';"));
+    CHECK_EQ(store.CategoryId(upper), categoryId);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM categories;"), categories);
+
+    // A new category is inserted once, under the case it first came in
+    const int added = store.CategoryId("Store Test Category");
+    CHECK(added > 0);
+    CHECK_EQ(store.CategoryId("store test category"), added);
+    CHECK_EQ(store.CategoryId("STORE TEST CATEGORY"), added);
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM categories;"), categories + 1);
+    CHECK_EQ(QueryInt(db, "SELECT id FROM categories WHERE category_name = 'Store Test Category' COLLATE BINARY;"), added);
+
+    // Links
+    CHECK(!store.HasCategories(variantId));
+    CHECK(store.AddCategoryLink(variantId, added));
+    CHECK(store.AddCategoryLink(variantId, added));
+    CHECK(store.AddCategoryLink(variantId, categoryId));
+    CHECK(store.HasCategories(variantId));
+    CHECK_EQ(QueryInt(db, "SELECT COUNT(*) FROM app_categories WHERE app_id = " + std::to_string(variantId) + ";"), 2);
+    CHECK(store.ClearCategoryLinks(variantId));
+    CHECK(!store.HasCategories(variantId));
+
+    // Attach drops the maps; they are reloaded from the table
+    store.SetPackageId("Ghost.Package", 999999);
+    CHECK_EQ(store.PackageId("Ghost.Package"), 999999);
+    store.Attach(db);
+    CHECK_EQ(store.PackageId("Ghost.Package"), -1);
+    CHECK_EQ(store.PackageId(variant), variantId);
+    CHECK_EQ(store.CategoryId("store test category"), added);
+    store.Detach();
+    sqlite3_close(db);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    g_scratch = argv[1];
+    CatalogFixture fixture = MakeCatalogFixture(300, 31);
+    TestCommitCadence(fixture);
+    TestOuterTransaction(fixture);
+    TestIdMaps(fixture);
+    return TestResult("updater_store_test");
+}
@@ -0,0 +1,123 @@
+// WingetIndexReader::ForEachPackage on the fixture index in both schemas: one
+// record per package, ordered by id, with the name, moniker, latest version
+// and tags the fixture wrote. A hand-made catalog pins down which of a
+// schema 1.x package's manifests is the latest.
+//
+// Usage: winget_index_test <scratch dir>
+#include "check.h"
+#include "fixture_catalog.h"
+#include "version.h"
+#include "winget_index.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<WingetIndexRecord> ReadAll(const std::string& path, int schema, bool withTags = true) {
+    std::vector<WingetIndexRecord> records;
+    WingetIndexReader reader;
+    CHECK(reader.Open(path));
+    CHECK_EQ(reader.SchemaMajor(), schema);
+    int n = reader.ForEachPackage([&](const WingetIndexRecord& rec) { records.push_back(rec); return true; }, withTags);
+    CHECK_EQ(n, (int)records.size());
+    return records;
+}
+
+// The fixture's own view: every app once, by id, at its version (above the
+// 0.9 manifest schema 1.x also has) with its categories as tags
+void TestFixture(const std::string& scratch) {
+    CatalogFixture fixture = MakeCatalogFixture(500, 23);
+    std::map<std::string, const FixtureApp*> byId;
+    for (const FixtureApp& app : fixture.apps) byId[app.packageId] = &app;
+    CHECK_EQ(byId.size(), fixture.apps.size());
+
+    for (int schema : {1, 2}) {
+        std::string path = scratch + "/winget_index_test_v" + std::to_string(schema) + ".db";
+        CHECK(WriteFixtureWingetIndex(fixture, path, schema));
+        std::vector<WingetIndexRecord> records = ReadAll(path, schema);
+        CHECK_EQ(records.size(), byId.size());
+        auto expected = byId.begin();
+        size_t withMoniker = 0, withTags = 0;
+        for (const WingetIndexRecord& rec : records) {
+            if (expected == byId.end()) break;
+            const FixtureApp& app = *expected->second;
+            CHECK_EQ(rec.id, app.packageId);
+            CHECK_EQ(rec.name, app.name);
+            CHECK_EQ(rec.moniker, app.moniker);
+            CHECK_EQ(rec.version, app.version);
+            std::vector<std::string> tags;
+            for (int c : app.categories) tags.push_back(fixture.categories[c]);
+            std::vector<std::string> got = rec.tags;
+            std::sort(tags.begin(), tags.end());
+            std::sort(got.begin(), got.end());
+            CHECK(got == tags);
+            withMoniker += !rec.moniker.empty();
+            withTags += !rec.tags.empty();
+            ++expected;
+        }
+        // The fixture exercises both sides of every optional field
+        CHECK(withMoniker > 0 && withMoniker < records.size());
+        CHECK(withTags > 0);
+
+        for (const WingetIndexRecord& rec : ReadAll(path, schema, false)) CHECK(rec.tags.empty());
+
+        // Stopping early delivers exactly the records asked for
+        WingetIndexReader reader;
+        CHECK(reader.Open(path));
+        std::vector<std::string> first;
+        int n = reader.ForEachPackage([&](const WingetIndexRecord& rec) {
+            first.push_back(rec.id);
+            return first.size() < 3;
+        });
+        CHECK_EQ(n, 3);
+        CHECK_EQ(first.size(), 3u);
+        if (first.size() == 3) CHECK_EQ(first[2], records[2].id);
+    }
+}
+
+// Schema 1.x writes a 0.9 manifest and then one at the app's version; the
+// latest is picked by Version order, not by string order or row order
+void TestLatestVersion(const std::string& scratch) {
+    CatalogFixture fixture;
+    fixture.categories = {"utilities"};
+    const std::vector<std::pair<std::string, std::string>> versions = {
+        {"0.10", "0.10"},        // numerically above 0.9, below it as a string
+        {"0.8", "0.9"},          // written after the 0.9 manifest
+        {"0.9-rc1", "0.9"},      // a prerelease of 0.9
+        {"0.9", "0.9"},
+        {"1.0.0.1", "1.0.0.1"},
+    };
+    for (size_t i = 0; i < versions.size(); ++i) {
+        FixtureApp app;
+        app.packageId = "Vendor.App" + std::to_string(i);
+        app.name = "App " + std::to_string(i);
+        app.publisher = "Vendor";
+        app.version = versions[i].first;
+        app.categories = {0};
+        fixture.apps.push_back(app);
+    }
+    std::string path = scratch + "/winget_index_test_latest.db";
+    CHECK(WriteFixtureWingetIndex(fixture, path, 1));
+    std::vector<WingetIndexRecord> records = ReadAll(path, 1);
+    CHECK_EQ(records.size(), versions.size());
+    for (size_t i = 0; i < records.size() && i < versions.size(); ++i) {
+        CHECK_EQ(records[i].id, fixture.apps[i].packageId);
+        CHECK_EQ(records[i].version, versions[i].second);
+        CHECK(records[i].moniker.empty());
+        CHECK_EQ(records[i].tags.size(), 1u);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    TestFixture(argv[1]);
+    TestLatestVersion(argv[1]);
+    return TestResult("winget_index_test");
+}
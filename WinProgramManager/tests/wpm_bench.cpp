@@ -0,0 +1,121 @@
+// Benchmarks and checks of the updater and the main window's data paths.
+// Each prints one report; the fixtures they run on come from --make-fixtures
+// (see fixture_catalog.h) or from a copy of a real WinProgramManager.db.
+//
+// Usage: wpm_bench <flag> <arguments>, see Usage() below
+#include "fixture_catalog.h"
+#include "uninstall_index.h"
+#include "wpm_benchmarks.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int Usage(const char* self) {
+    std::cerr << "usage: " << self << " <flag> <arguments>\n"
+              << "  --make-fixtures <dir> [apps]            write the fixture catalog, indexes and Uninstall export\n"
+              << "  --bench-fetch <fake-winget> [packages]  `winget show` pool at 1, 4 and 8 workers\n"
+              << "  --bench-store [dir] [packages]          per-statement writes versus UpdaterStore\n"
+              << "  --bench-catalog <db>                    catalog load and category filters\n"
+              << "  --bench-facets <db>                     per-category counts, nested loops versus bitsets\n"
+              << "  --bench-app-list <db>                   category switch, item per app versus owner data\n"
+              << "  --bench-icons <db> [rows]               every icon decoded at startup versus the icon cache\n"
+              << "  --bench-icon-store <db>                 icons inline in apps versus the icons table\n"
+              << "  --bench-search <db>                     search index versus lowercase-and-find\n"
+              << "  --bench-uninstall <reg-export|-> <db>   Uninstall entries one by one versus the token index\n"
+              << "  --bench-correlate <index.db> <reg|->    product codes versus the substring rule\n"
+              << "  --bench-tags <db>                       regex per pattern versus the compiled automaton\n"
+              << "  --bench-tag-correlation <db>            Step 6, SQL per rule versus integer pairs\n"
+              << "  --bench-icon-fetch <homepages> [workers] favicons per package versus one shared fetcher\n"
+              << "  --check-query-plans <db>                no hot query scans, builds indexes or sorts\n"
+              << "  --check-refresh [packages]              only re-versioned packages are re-fetched\n";
+    return 2;
+}
+
+int Positive(const char* arg, int fallback) {
+    int value = arg ? std::atoi(arg) : fallback;
+    return value > 0 ? value : fallback;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) return Usage(argv[0]);
+    std::string flag = argv[1];
+    const char* arg2 = argc >= 3 ? argv[2] : nullptr;
+    const char* arg3 = argc >= 4 ? argv[3] : nullptr;
+
+    if (flag == "--make-fixtures" && arg2) {
+        std::string error = WriteFixtureFiles(arg2, Positive(arg3, 10800));
+        if (!error.empty()) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        std::cout << "fixtures written to " << arg2 << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-fetch" && arg2) {
+        std::cout << BenchmarkFetchPool(arg2, Positive(arg3, 40)) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-store") {
+        std::cout << BenchmarkUpdaterStore(arg2 ? arg2 : ".", Positive(arg3, 10800)) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-catalog" && arg2) {
+        std::cout << BenchmarkCatalog(arg2) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-facets" && arg2) {
+        std::cout << BenchmarkFacets(arg2) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-app-list" && arg2) {
+        std::cout << BenchmarkAppList(arg2) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-icons" && arg2) {
+        std::cout << BenchmarkIconCache(arg2, Positive(arg3, 40)) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-icon-store" && arg2) {
+        std::cout << BenchmarkIconStore(arg2) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-search" && arg2) {
+        std::cout << BenchmarkSearch(arg2) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-uninstall" && arg3) {
+        std::cout << BenchmarkUninstallIndex(arg2, arg3) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-correlate" && arg3) {
+        std::cout << BenchmarkCorrelation(arg2, arg3) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-tags" && arg2) {
+        std::cout << BenchmarkTagMatcher(arg2) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-tag-correlation" && arg2) {
+        std::cout << BenchmarkTagCorrelation(arg2) << std::endl;
+        return 0;
+    }
+    if (flag == "--bench-icon-fetch" && arg2) {
+        std::cout << BenchmarkIconFetcher(arg2, Positive(arg3, 4)) << std::endl;
+        return 0;
+    }
+    if (flag == "--check-query-plans" && arg2) {
+        bool ok = false;
+        std::cout << CheckQueryPlans(arg2, ok) << std::endl;
+        return ok ? 0 : 1;
+    }
+    if (flag == "--check-refresh") {
+        bool ok = false;
+        std::cout << CheckPackageRefresh(Positive(arg2, 10800), ok) << std::endl;
+        return ok ? 0 : 1;
+    }
+    return Usage(argv[0]);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+
+// Benchmarks and checks run by wpm_bench that live with the tests rather than
+// in the modules they time. Each returns a report, one line for benchmarks.
+
+// Time RunFetchPool with 1, 4 and 8 workers against a stand-in for winget:
+// `fakeWinget show <id>` is run for `packages` made-up ids per pass. Returns a
+// packages/minute report.
+std::string BenchmarkFetchPool(const std::string& fakeWinget, int packages = 40);
+
+// Insert `packages` packages with `tagsPerPackage` tags each into a fresh
+// database under `dir`, once the old way (prepare/finalize per statement, id
+// lookups per tag, no transaction) and once through UpdaterStore. Reports wall
+// time and the number of file syncs SQLite issued for each.
+std::string BenchmarkUpdaterStore(const std::string& dir, int packages = 10800, int tagsPerPackage = 6);
+
+// Load the catalog of the WinProgramManager database at `dbPath` the old way
+// (rows with per-app category strings, a category -> app id map and linear
+// searches for every link) and through AppCatalog, then run the category-list
+// filters of LoadTags on both. Reports time and resident memory for each.
+std::string BenchmarkCatalog(const std::string& dbPath);
+
+// Time the per-category counts LoadTags and ExecuteSearch need when a filter
+// changes (installed, a search, both, a refined search) through nested loops
+// with set lookups, as before, and through AppCatalog's bitsets.
+std::string BenchmarkFacets(const std::string& dbPath);
+
+// Time switching the app list between "All" and the largest categories: the
+// per-row AppInfo copies and ListView_InsertItem calls LoadApps made before,
+// versus a row index vector and one item count for the owner-data list (the
+// ListView part on Windows only).
+std::string BenchmarkAppList(const std::string& dbPath);
+
+// Fetch the icons of the homepages listed in `homepagesFile` (one URL per
+// line): one fresh fetcher per homepage on one thread, as every package used
+// to fetch on its own; one shared fetcher on `workers` threads; and again with the sources
+// the second pass left, as the next run would. Reports time, icons found,
+// requests and connections of each pass.
+std::string BenchmarkIconFetcher(const std::string& homepagesFile, int workers);
+
+// Copy the database at `dbPath`, scan and load the catalog with icons inline,
+// migrate the copy and do the same again. Reports file size and load times.
+std::string BenchmarkIconStore(const std::string& dbPath);
+
+// Decode every icon of the database up front, as startup used to, and then
+// only the first `visibleRows` apps by name through IconCache. Reports the
+// time and memory each approach needs before the list can be shown.
+std::string BenchmarkIconCache(const std::string& dbPath, int visibleRows = 40);
+
+// Load the catalog of the database at `dbPath`, build the index and time
+// typical 1-4 character queries through it and through the per-keystroke
+// lowercase-and-find loop LoadApps used before.
+std::string BenchmarkSearch(const std::string& dbPath);
+
+// Match every package id of the database at `dbPath` against the Uninstall
+// entries of the export at `regPath` ("-" for this machine's registry, on
+// Windows) entry by entry, as before, and through UninstallIndex.
+std::string BenchmarkUninstallIndex(const std::string& regPath, const std::string& dbPath);
+
+// Decide which packages of the winget index at `indexPath` are installed
+// according to the export at `regPath` ("-" for this registry), by the
+// substring rule alone and through InstalledCorrelator.
+std::string BenchmarkCorrelation(const std::string& indexPath, const std::string& regPath);
+
+// Tag every app of the database at `dbPath` with the regex loop the updater
+// used and with TagMatcher; reports both times and how many apps differ.
+std::string BenchmarkTagMatcher(const std::string& dbPath);
+
+// Run Step 6 on in-memory copies of the database at `dbPath`, once with the
+// per-app and per-rule SQL it used and once through InferCorrelatedCategories;
+// reports both times, the rows added, and whether the resulting
+// app_categories tables are identical.
+std::string BenchmarkTagCorrelation(const std::string& dbPath);
+
+// Copy the database at `dbPath` into memory, migrate the copy and run
+// EXPLAIN QUERY PLAN on every hot query. A query fails if it scans a table it
+// does not iterate by design, needs an automatic index or, except for one
+// app's categories, sorts in a temporary B-tree. Also times each query as it
+// was written before, on the unmigrated database, and as it is now. `ok` is
+// false if any query failed.
+std::string CheckQueryPlans(const std::string& dbPath, bool& ok);
+
+// Run the refresh on a fixture catalog of `packages` packages in memory:
+// build the database from one snapshot, list the next week's snapshot (new,
+// removed, re-versioned packages, versions only written differently, a
+// truncated version column), re-fetch what FindChangedPackages returns through
+// RefreshPackage, as the updater does, and check that exactly the re-versioned
+// packages were fetched, kept their apps.id, got the new fields, tags and
+// icons (or kept the stored icon), and that nothing else changed. `ok` is
+// false if any check failed.
+std::string CheckPackageRefresh(int packages, bool& ok);
@@ -0,0 +1,293 @@
+#include "uninstall_index.h"
+#include "catalog.h"
+#include "winget_index.h"
+#include <algorithm>
+#include <cwctype>
+#include <fstream>
+#include <iterator>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+// Sequences are over the 36 characters NormalizeForMatch keeps
+const size_t kGramCount = 36 * 36 * 36;
+
+int CharCode(char c) {
+    return c <= '9' ? c - '0' : c - 'a' + 10;
+}
+
+size_t GramKey(const char* p) {
+    return (size_t)(CharCode(p[0]) * 36 * 36 + CharCode(p[1]) * 36 + CharCode(p[2]));
+}
+
+// Parts of a package id that are matched: before and after the first '.'
+std::vector<std::string> PackageIdParts(const std::wstring& packageId) {
+    std::vector<std::string> parts;
+    size_t dotPos = packageId.find(L'.');
+    if (dotPos != std::wstring::npos) {
+        parts.push_back(NormalizeForMatch(std::wstring_view(packageId).substr(0, dotPos)));
+        parts.push_back(NormalizeForMatch(std::wstring_view(packageId).substr(dotPos + 1)));
+    } else {
+        parts.push_back(NormalizeForMatch(packageId));
+    }
+    return parts;
+}
+
+}  // namespace
+
+std::string NormalizeForMatch(std::wstring_view text) {
+    std::string result;
+    for (wchar_t c : text) {
+        wchar_t lower = (wchar_t)std::towlower(c);
+        if ((lower >= L'a' && lower <= L'z') || (lower >= L'0' && lower <= L'9')) {
+            result += (char)lower;
+        }
+    }
+    return result;
+}
+
+// --- Reading the registry ---------------------------------------------------
+
+#ifdef _WIN32
+static std::wstring ReadRegString(HKEY key, const wchar_t* name) {
+    DWORD type = 0, size = 0;
+    if (RegQueryValueExW(key, name, NULL, &type, NULL, &size) != ERROR_SUCCESS || size == 0) return L"";
+    if (type != REG_SZ && type != REG_EXPAND_SZ) return L"";
+    std::wstring value(size / sizeof(wchar_t) + 1, L'\0');
+    if (RegQueryValueExW(key, name, NULL, NULL, (LPBYTE)&value[0], &size) != ERROR_SUCCESS) return L"";
+    value.resize(value.find(L'\0'));
+    return value;
+}
+#endif
+
+std::vector<UninstallEntry> ReadUninstallEntries() {
+    std::vector<UninstallEntry> entries;
+#ifdef _WIN32
+    struct Hive {
+        HKEY root;
+        const wchar_t* path;
+    };
+    const Hive hives[] = {
+        {HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall"},
+        {HKEY_LOCAL_MACHINE, L"SOFTWARE\\WOW6432Node\\Microsoft\\Windows\\CurrentVersion\\Uninstall"},
+        {HKEY_CURRENT_USER, L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall"},
+    };
+    for (const Hive& hive : hives) {
+        HKEY hKey;
+        if (RegOpenKeyExW(hive.root, hive.path, 0, KEY_READ, &hKey) != ERROR_SUCCESS) continue;
+        DWORD index = 0;
+        wchar_t subKeyName[256];
+        DWORD subKeyLen = 256;
+        while (RegEnumKeyExW(hKey, index++, subKeyName, &subKeyLen, NULL, NULL, NULL, NULL) == ERROR_SUCCESS) {
+            HKEY hSubKey;
+            if (RegOpenKeyExW(hKey, subKeyName, 0, KEY_READ, &hSubKey) == ERROR_SUCCESS) {
+                UninstallEntry entry;
+                entry.keyName = subKeyName;
+                entry.displayName = ReadRegString(hSubKey, L"DisplayName");
+                entry.publisher = ReadRegString(hSubKey, L"Publisher");
+                entry.currentUser = hive.root == HKEY_CURRENT_USER;
+                entries.push_back(std::move(entry));
+                RegCloseKey(hSubKey);
+            }
+            subKeyLen = 256;
+        }
+        RegCloseKey(hKey);
+    }
+#endif
+    return entries;
+}
+
+// Quoted .reg string starting at text[pos] (the opening quote); `pos` ends up
+// after the closing quote.
+static std::wstring ParseRegQuoted(const std::wstring& text, size_t& pos) {
+    std::wstring value;
+    for (++pos; pos < text.size() && text[pos] != L'"'; ++pos) {
+        if (text[pos] == L'\\' && pos + 1 < text.size()) ++pos;
+        value += text[pos];
+    }
+    ++pos;
+    return value;
+}
+
+static std::wstring Lowercase(std::wstring text) {
+    for (auto& c : text) c = (wchar_t)std::towlower(c);
+    return text;
+}
+
+bool ReadUninstallExport(const std::string& path, std::vector<UninstallEntry>& entries) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // regedit writes UTF-16LE with a BOM; REGEDIT4 exports are ANSI
+    std::wstring text;
+    if (bytes.size() >= 2 && (unsigned char)bytes[0] == 0xFF && (unsigned char)bytes[1] == 0xFE) {
+        text.reserve(bytes.size() / 2);
+        for (size_t i = 2; i + 1 < bytes.size(); i += 2) {
+            text += (wchar_t)((unsigned char)bytes[i] | ((unsigned char)bytes[i + 1] << 8));
+        }
+    } else {
+        text = ColumnToWide(bytes.c_str());
+    }
+
+    const std::wstring uninstallKey = L"\\currentversion\\uninstall\\";
+    UninstallEntry* entry = nullptr;
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find(L'\n', lineStart);
+        if (lineEnd == std::wstring::npos) lineEnd = text.size();
+        std::wstring line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        if (!line.empty() && line.back() == L'\r') line.pop_back();
+
+        if (line.size() > 2 && line[0] == L'[' && line.back() == L']') {
+            // [HKEY_...\...\CurrentVersion\Uninstall\<key>] starts an entry;
+            // deleted keys ([-HKEY...]) and keys nested deeper do not
+            entry = nullptr;
+            std::wstring keyPath = line.substr(1, line.size() - 2);
+            size_t at = Lowercase(keyPath).find(uninstallKey);
+            if (keyPath[0] == L'-' || at == std::wstring::npos) continue;
+            std::wstring keyName = keyPath.substr(at + uninstallKey.size());
+            if (keyName.empty() || keyName.find(L'\\') != std::wstring::npos) continue;
+            entries.emplace_back();
+            entry = &entries.back();
+            entry->keyName = keyName;
+            entry->currentUser = keyPath.compare(0, 17, L"HKEY_CURRENT_USER") == 0;
+        } else if (entry && !line.empty() && line[0] == L'"') {
+            // "Name"="value"; other value types (dword:, hex(2):) are skipped
+            size_t pos = 0;
+            std::wstring name = Lowercase(ParseRegQuoted(line, pos));
+            if (pos + 1 >= line.size() || line[pos] != L'=' || line[pos + 1] != L'"') continue;
+            pos++;
+            std::wstring value = ParseRegQuoted(line, pos);
+            if (name == L"displayname") entry->displayName = value;
+            else if (name == L"publisher") entry->publisher = value;
+        }
+    }
+    return true;
+}
+
+// --- Index ------------------------------------------------------------------
+
+void UninstallIndex::Build(const std::vector<UninstallEntry>& entries) {
+    *this = UninstallIndex();
+    entryCount_ = entries.size();
+
+    // HKCU entries were only ever matched on their DisplayName
+    for (const auto& entry : entries) {
+        texts_.push_back(NormalizeForMatch(entry.displayName));
+        if (!entry.currentUser) texts_.push_back(NormalizeForMatch(entry.publisher));
+    }
+    texts_.erase(std::remove(texts_.begin(), texts_.end(), std::string()), texts_.end());
+    std::sort(texts_.begin(), texts_.end());
+    texts_.erase(std::unique(texts_.begin(), texts_.end()), texts_.end());
+
+    // Each text once per sequence: count, then fill in text order
+    std::vector<uint32_t> lastText(kGramCount, UINT32_MAX);
+    gramStart_.assign(kGramCount + 1, 0);
+    for (uint32_t t = 0; t < texts_.size(); ++t) {
+        for (size_t i = 0; i + 3 <= texts_[t].size(); ++i) {
+            size_t key = GramKey(texts_[t].data() + i);
+            if (lastText[key] == t) continue;
+            lastText[key] = t;
+            gramStart_[key + 1]++;
+        }
+    }
+    for (size_t key = 0; key < kGramCount; ++key) gramStart_[key + 1] += gramStart_[key];
+    postings_.resize(gramStart_[kGramCount]);
+    std::vector<uint32_t> fill(gramStart_.begin(), gramStart_.end() - 1);
+    std::fill(lastText.begin(), lastText.end(), UINT32_MAX);
+    for (uint32_t t = 0; t < texts_.size(); ++t) {
+        for (size_t i = 0; i + 3 <= texts_[t].size(); ++i) {
+            size_t key = GramKey(texts_[t].data() + i);
+            if (lastText[key] == t) continue;
+            lastText[key] = t;
+            postings_[fill[key]++] = t;
+        }
+    }
+}
+
+bool UninstallIndex::Contains(const std::string& part) const {
+    if (part.size() < 3) {
+        for (const auto& text : texts_) {
+            if (text.find(part) != std::string::npos) return true;
+        }
+        return false;
+    }
+
+    // Only texts containing the part's rarest sequence can contain the part
+    size_t rarest = GramKey(part.data());
+    for (size_t i = 1; i + 3 <= part.size(); ++i) {
+        size_t key = GramKey(part.data() + i);
+        if (gramStart_[key + 1] - gramStart_[key] < gramStart_[rarest + 1] - gramStart_[rarest]) rarest = key;
+    }
+    for (uint32_t p = gramStart_[rarest]; p < gramStart_[rarest + 1]; ++p) {
+        if (texts_[postings_[p]].find(part) != std::string::npos) return true;
+    }
+    return false;
+}
+
+bool UninstallIndex::Matches(const std::wstring& packageId) const {
+    for (const auto& part : PackageIdParts(packageId)) {
+        if (!part.empty() && Contains(part)) return true;
+    }
+    return false;
+}
+
+// --- Product codes ----------------------------------------------------------
+
+static std::string LowercaseAscii(std::string text) {
+    for (auto& c : text) {
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    }
+    return text;
+}
+
+void InstalledCorrelator::AddProductCode(const std::string& packageId, const std::string& productCode) {
+    if (productCode.empty()) return;
+    auto& packages = codePackages_[LowercaseAscii(productCode)];
+    if (std::find(packages.begin(), packages.end(), packageId) == packages.end()) packages.push_back(packageId);
+}
+
+void InstalledCorrelator::Build(const std::vector<UninstallEntry>& entries) {
+    exactPackages_.clear();
+    unclaimed_.clear();
+    std::vector<UninstallEntry> unclaimedNames;
+    for (const auto& entry : entries) {
+        std::string key;
+        for (wchar_t c : entry.keyName) key += c < 0x80 ? (char)c : '?';  // codes are ASCII
+        auto it = codePackages_.find(LowercaseAscii(key));
+        if (it != codePackages_.end()) {
+            exactPackages_.insert(it->second.begin(), it->second.end());
+            continue;
+        }
+        unclaimed_.emplace_back(NormalizeForMatch(entry.displayName), NormalizeForMatch(entry.publisher));
+        unclaimedNames.push_back({entry.keyName, entry.displayName, std::wstring(), true});
+    }
+    unclaimedNames_.Build(unclaimedNames);
+}
+
+bool InstalledCorrelator::IsInstalled(const std::string& packageId) const {
+    if (exactPackages_.count(packageId)) return true;
+
+    size_t dotPos = packageId.find('.');
+    std::string product = NormalizeForMatch(ColumnToWide(packageId.c_str() + (dotPos == std::string::npos ? 0 : dotPos + 1)));
+    if (product.empty() || !unclaimedNames_.Contains(product)) return false;
+    std::string publisher = dotPos == std::string::npos ? std::string() : NormalizeForMatch(ColumnToWide(packageId.substr(0, dotPos).c_str()));
+    for (const auto& entry : unclaimed_) {
+        if (entry.first.find(product) == std::string::npos) continue;
+        if (entry.first.find(publisher) != std::string::npos || entry.second.find(publisher) != std::string::npos) return true;
+    }
+    return false;
+}
+
+bool LoadProductCodes(const std::string& indexPath, InstalledCorrelator& correlator) {
+    WingetIndexReader index;
+    if (!index.Open(indexPath)) return false;
+    return index.ForEachProductCode([&](const std::string& id, const std::string& productCode) {
+        correlator.AddProductCode(id, productCode);
+        return true;
+    }) >= 0;
+}
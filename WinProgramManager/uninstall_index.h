@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// One Uninstall key (Programs and Features entry).
+struct UninstallEntry {
+    std::wstring keyName;      // subkey name, usually the installer's ProductCode
+    std::wstring displayName;
+    std::wstring publisher;
+    bool currentUser = false;  // from HKCU rather than HKLM
+};
+
+// The Uninstall entries of this machine: HKLM (64-bit and WOW6432Node) and
+// HKCU, each key opened once. Empty on other platforms.
+std::vector<UninstallEntry> ReadUninstallEntries();
+
+// Append the Uninstall entries of a regedit export (.reg, UTF-16 or ANSI) to
+// `entries`, so the matching can be run against another machine's registry.
+// Returns false if the file cannot be read.
+bool ReadUninstallExport(const std::string& path, std::vector<UninstallEntry>& entries);
+
+// Answers "does any Uninstall entry look like this package" by the installed
+// apps' original rule: the package id is split at its first '.',
+// and a part matches when it occurs in an entry's DisplayName (or, for HKLM
+// entries, Publisher), comparing lowercase ASCII letters and digits only.
+//
+// Names are normalized once, and every normalized name is listed under each
+// three-character sequence it contains, so a part is looked up through its
+// rarest sequence instead of being searched for in every entry.
+class UninstallIndex {
+public:
+    void Build(const std::vector<UninstallEntry>& entries);
+    bool Matches(const std::wstring& packageId) const;
+    size_t EntryCount() const { return entryCount_; }
+    // Whether a normalized `part` occurs in any indexed name or publisher.
+    bool Contains(const std::string& part) const;
+
+private:
+
+    size_t entryCount_ = 0;
+    std::vector<std::string> texts_;    // normalized DisplayNames and Publishers
+    std::vector<uint32_t> gramStart_;   // per sequence, offsets into postings_
+    std::vector<uint32_t> postings_;    // texts_ indexes, ascending per sequence
+};
+
+// Which catalog packages are installed, judged from the Uninstall entries.
+//
+// winget's index lists the ProductCode of each package's installers, and an
+// Uninstall key is normally named after it, so an entry whose key is a known
+// code belongs to exactly the packages declaring that code: one hash lookup,
+// no guessing. Other packages (no code known, or a version newer than the
+// index) are still found by name, but only in entries no code claims, and only
+// when one entry has the product half of the id in its DisplayName and the
+// publisher half in its DisplayName or Publisher (Microsoft.VisualStudioCode:
+// "Microsoft Visual Studio Code" by "Microsoft Corporation"). Either half
+// matching anywhere, the old rule, made every Microsoft.* package look
+// installed.
+class InstalledCorrelator {
+public:
+    // Register every product code (compared case-insensitively), then Build.
+    void AddProductCode(const std::string& packageId, const std::string& productCode);
+    void Build(const std::vector<UninstallEntry>& entries);
+
+    bool IsInstalled(const std::string& packageId) const;
+    bool IsInstalledByProductCode(const std::string& packageId) const { return exactPackages_.count(packageId) > 0; }
+
+    size_t ProductCodeCount() const { return codePackages_.size(); }
+    size_t ExactPackageCount() const { return exactPackages_.size(); }
+    size_t UnclaimedEntryCount() const { return unclaimed_.size(); }
+
+private:
+    std::unordered_map<std::string, std::vector<std::string>> codePackages_;  // lowercase code -> package ids
+    std::unordered_set<std::string> exactPackages_;
+    // Entries whose key is no known product code: normalized DisplayName and
+    // Publisher, and the DisplayNames indexed to rule out most packages at once
+    std::vector<std::pair<std::string, std::string>> unclaimed_;
+    UninstallIndex unclaimedNames_;
+};
+
+// Add the product codes of the winget source index at `indexPath` to
+// `correlator`. Returns false if the index cannot be read.
+bool LoadProductCodes(const std::string& indexPath, InstalledCorrelator& correlator);
+
+// Lowercase ASCII letters and digits of `text`.
+std::string NormalizeForMatch(std::wstring_view text);
@@ -0,0 +1,162 @@
+#include "updater_store.h"
+#include <sqlite3.h>
+
+// Category names are COLLATE NOCASE; package ids are compared as stored
+static std::string FoldKey(const std::string& s) {
+    std::string key = s;
+    for (auto& c : key) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    return key;
+}
+
+UpdaterStore::~UpdaterStore() {
+    Detach();
+}
+
+void UpdaterStore::Attach(sqlite3* db) {
+    Detach();
+    db_ = db;
+}
+
+void UpdaterStore::Detach() {
+    if (inBatch_) EndBatch();
+    for (auto& entry : statements_) sqlite3_finalize(entry.second);
+    statements_.clear();
+    packageIds_.clear();
+    categoryIds_.clear();
+    packageIdsLoaded_ = false;
+    categoryIdsLoaded_ = false;
+    db_ = nullptr;
+}
+
+bool UpdaterStore::Exec(const char* sql) {
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg);
+    if (errMsg) sqlite3_free(errMsg);
+    return rc == SQLITE_OK;
+}
+
+sqlite3_stmt* UpdaterStore::Statement(const char* sql) {
+    if (!db_) return nullptr;
+    auto it = statements_.find(sql);
+    if (it != statements_.end()) {
+        sqlite3_reset(it->second);
+        sqlite3_clear_bindings(it->second);
+        return it->second;
+    }
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db_, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    statements_.emplace(sql, stmt);
+    return stmt;
+}
+
+void UpdaterStore::BeginBatch() {
+    if (!db_ || inBatch_) return;
+    // Someone else's transaction is open: join it rather than nest
+    if (!sqlite3_get_autocommit(db_)) return;
+    inBatch_ = Exec("BEGIN TRANSACTION;");
+    pendingWrites_ = 0;
+}
+
+void UpdaterStore::Wrote(int writes) {
+    if (!inBatch_) return;
+    pendingWrites_ += writes;
+    if (pendingWrites_ >= commitSize_) {
+        if (Exec("COMMIT;")) commits_++;
+        pendingWrites_ = 0;
+        inBatch_ = Exec("BEGIN TRANSACTION;");
+    }
+}
+
+void UpdaterStore::EndBatch() {
+    if (!inBatch_) return;
+    if (Exec("COMMIT;")) commits_++;
+    inBatch_ = false;
+    pendingWrites_ = 0;
+}
+
+void UpdaterStore::LoadPackageIds() {
+    packageIdsLoaded_ = true;
+    sqlite3_stmt* stmt = Statement("SELECT package_id, id FROM apps;");
+    if (!stmt) return;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        if (text) packageIds_[reinterpret_cast<const char*>(text)] = sqlite3_column_int(stmt, 1);
+    }
+    sqlite3_reset(stmt);
+}
+
+void UpdaterStore::LoadCategoryIds() {
+    categoryIdsLoaded_ = true;
+    sqlite3_stmt* stmt = Statement("SELECT category_name, id FROM categories;");
+    if (!stmt) return;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        if (text) categoryIds_[FoldKey(reinterpret_cast<const char*>(text))] = sqlite3_column_int(stmt, 1);
+    }
+    sqlite3_reset(stmt);
+}
+
+int UpdaterStore::PackageId(const std::string& packageId) {
+    if (!packageIdsLoaded_) LoadPackageIds();
+    auto it = packageIds_.find(packageId);
+    return it != packageIds_.end() ? it->second : -1;
+}
+
+void UpdaterStore::SetPackageId(const std::string& packageId, int id) {
+    if (!packageIdsLoaded_) LoadPackageIds();
+    packageIds_[packageId] = id;
+}
+
+void UpdaterStore::ForgetPackage(const std::string& packageId) {
+    packageIds_.erase(packageId);
+}
+
+int UpdaterStore::CategoryId(const std::string& category) {
+    if (!categoryIdsLoaded_) LoadCategoryIds();
+    std::string key = FoldKey(category);
+    auto it = categoryIds_.find(key);
+    if (it != categoryIds_.end()) return it->second;
+
+    // Create if doesn't exist
+    sqlite3_stmt* stmt = Statement("INSERT INTO categories (category_name) VALUES (?);");
+    if (!stmt) return -1;
+    sqlite3_bind_text(stmt, 1, category.c_str(), -1, SQLITE_STATIC);
+    int id = -1;
+    if (sqlite3_step(stmt) == SQLITE_DONE) {
+        id = static_cast<int>(sqlite3_last_insert_rowid(db_));
+        categoryIds_[key] = id;
+    }
+    sqlite3_reset(stmt);
+    return id;
+}
+
+bool UpdaterStore::AddCategoryLink(int appId, int categoryId) {
+    sqlite3_stmt* stmt = Statement("INSERT OR IGNORE INTO app_categories (app_id, category_id) VALUES (?, ?);");
+    if (!stmt) return false;
+    sqlite3_bind_int(stmt, 1, appId);
+    sqlite3_bind_int(stmt, 2, categoryId);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+    return ok;
+}
+
+bool UpdaterStore::HasCategories(int appId) {
+    sqlite3_stmt* stmt = Statement("SELECT 1 FROM app_categories WHERE app_id = ? LIMIT 1;");
+    if (!stmt) return false;
+    sqlite3_bind_int(stmt, 1, appId);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_reset(stmt);
+    return found;
+}
+
+bool UpdaterStore::ClearCategoryLinks(int appId) {
+    sqlite3_stmt* stmt = Statement("DELETE FROM app_categories WHERE app_id = ?;");
+    if (!stmt) return false;
+    sqlite3_bind_int(stmt, 1, appId);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+    return ok;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+// Forward declarations for SQLite
+typedef struct sqlite3 sqlite3;
+typedef struct sqlite3_stmt sqlite3_stmt;
+
+// Write path of WinProgramUpdater on top of one SQLite connection:
+//
+//  - prepared statements are cached per SQL text instead of being prepared
+//    and finalized for every row;
+//  - apps.package_id -> apps.id and categories.category_name -> categories.id
+//    are loaded once into memory and kept current as rows are inserted. Keys
+//    follow the column collations: package ids are exact (package_id is
+//    BINARY, so "Foo.Bar" and "foo.bar" are two rows), category names are
+//    ASCII-folded (category_name is COLLATE NOCASE);
+//  - writes are grouped into explicit transactions that commit every
+//    CommitSize() writes, instead of one implicit transaction (and fsync) per
+//    statement.
+//
+// Not thread-safe: the updater's single writer thread owns it.
+class UpdaterStore {
+public:
+    UpdaterStore() = default;
+    ~UpdaterStore();
+    UpdaterStore(const UpdaterStore&) = delete;
+    UpdaterStore& operator=(const UpdaterStore&) = delete;
+
+    // Use `db` from now on; statements and id maps of a previous connection are dropped.
+    void Attach(sqlite3* db);
+    // Commit any open batch and finalize cached statements (before sqlite3_close).
+    void Detach();
+    sqlite3* Db() const { return db_; }
+
+    // Cached statement for `sql`, reset and with bindings cleared. Owned by the
+    // store; do not finalize. Returns nullptr if it does not compile.
+    sqlite3_stmt* Statement(const char* sql);
+
+    // Batches: writes between BeginBatch and EndBatch share a transaction that
+    // is committed (and reopened) every CommitSize() calls to Wrote().
+    void SetCommitSize(int writes) { commitSize_ = writes < 1 ? 1 : writes; }
+    int CommitSize() const { return commitSize_; }
+    void BeginBatch();
+    void Wrote(int writes = 1);
+    void EndBatch();
+    int Commits() const { return commits_; }
+
+    // apps.id for a package id, -1 if it is not in the database.
+    int PackageId(const std::string& packageId);
+    void SetPackageId(const std::string& packageId, int id);
+    void ForgetPackage(const std::string& packageId);
+    // categories.id, inserting the category when missing; -1 on error.
+    int CategoryId(const std::string& category);
+
+    bool AddCategoryLink(int appId, int categoryId);
+    bool HasCategories(int appId);
+    // Drop every category of the app, e.g. before its refreshed tags go in.
+    bool ClearCategoryLinks(int appId);
+
+private:
+    void LoadPackageIds();
+    void LoadCategoryIds();
+    bool Exec(const char* sql);
+
+    sqlite3* db_ = nullptr;
+    std::unordered_map<std::string, sqlite3_stmt*> statements_;
+    std::unordered_map<std::string, int> packageIds_;
+    std::unordered_map<std::string, int> categoryIds_;
+    bool packageIdsLoaded_ = false;
+    bool categoryIdsLoaded_ = false;
+    bool inBatch_ = false;
+    int pendingWrites_ = 0;
+    int commitSize_ = 256;
+    int commits_ = 0;
+};
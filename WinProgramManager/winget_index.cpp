@@ -0,0 +1,321 @@
+#include "winget_index.h"
+#include "version.h"
+#include <sqlite3.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+static std::string ColumnText(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? std::string(reinterpret_cast<const char*>(text)) : std::string();
+}
+
+// sqlite URI for a plain file path: '%', '?' and '#' must be escaped, Windows
+// separators become '/', and a drive letter needs a leading '/'.
+static std::string FileUri(const std::string& path) {
+    std::string uri = "file:";
+    if (path.size() >= 2 && path[1] == ':') uri += "///";
+    else if (!path.empty() && (path[0] == '/' || path[0] == '\\')) uri += "//";
+    static const char hex[] = "0123456789ABCDEF";
+    for (char c : path) {
+        if (c == '\\') uri += '/';
+        else if (c == '%' || c == '?' || c == '#') { uri += '%'; uri += hex[(unsigned char)c >> 4]; uri += hex[c & 15]; }
+        else uri += c;
+    }
+    return uri + "?immutable=1";
+}
+
+WingetIndexReader::~WingetIndexReader() {
+    Close();
+}
+
+bool WingetIndexReader::Open(const std::string& pathUtf8) {
+    Close();
+    int rc = sqlite3_open_v2(FileUri(pathUtf8).c_str(), &db_, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr);
+    if (rc != SQLITE_OK) {
+        lastError_ = db_ ? sqlite3_errmsg(db_) : "cannot open index";
+        Close();
+        return false;
+    }
+
+    // metadata(name, value) carries majorVersion; fall back to the table layout
+    schemaMajor_ = 0;
+    if (TableExists("metadata")) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db_, "SELECT value FROM metadata WHERE name = 'majorVersion';", -1, &stmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_step(stmt) == SQLITE_ROW) schemaMajor_ = sqlite3_column_int(stmt, 0);
+            sqlite3_finalize(stmt);
+        }
+    }
+    if (schemaMajor_ == 0) {
+        if (TableExists("packages")) schemaMajor_ = 2;
+        else if (TableExists("manifest")) schemaMajor_ = 1;
+    }
+    if (schemaMajor_ != 1 && schemaMajor_ != 2) {
+        lastError_ = "unrecognized index schema";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void WingetIndexReader::Close() {
+    if (db_) {
+        sqlite3_close(db_);
+        db_ = nullptr;
+    }
+}
+
+bool WingetIndexReader::TableExists(const char* name) {
+    sqlite3_stmt* stmt;
+    bool found = false;
+    if (sqlite3_prepare_v2(db_, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+        found = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+bool WingetIndexReader::ColumnExists(const char* table, const char* column) {
+    sqlite3_stmt* stmt;
+    bool found = false;
+    std::string sql = std::string("PRAGMA table_info(") + table + ");";
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        while (!found && sqlite3_step(stmt) == SQLITE_ROW) found = ColumnText(stmt, 1) == column;
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+bool WingetIndexReader::LoadTags(const char* mapTable, const char* keyColumn, const char* tagTable,
+                                 std::unordered_map<long long, std::vector<std::string>>& out) {
+    std::string sql = std::string("SELECT m.") + keyColumn + ", t.tag FROM " + mapTable + " m JOIN " +
+                      tagTable + " t ON t.rowid = m.tag;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        lastError_ = sqlite3_errmsg(db_);
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        out[sqlite3_column_int64(stmt, 0)].push_back(ColumnText(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+int WingetIndexReader::ForEachPackage(const std::function<bool(const WingetIndexRecord&)>& onRecord, bool withTags) {
+    if (!db_) return -1;
+    return schemaMajor_ == 1 ? ForEachV1(onRecord, withTags) : ForEachV2(onRecord, withTags);
+}
+
+// Schema 1.x: one manifest row per package version; keep the highest version
+// of each id. Rows arrive ordered by id, so records are emitted as soon as the
+// id changes.
+int WingetIndexReader::ForEachV1(const std::function<bool(const WingetIndexRecord&)>& onRecord, bool withTags) {
+    std::unordered_map<long long, std::vector<std::string>> tags;
+    if (withTags && TableExists("tags_map") && !LoadTags("tags_map", "manifest", "tags", tags)) return -1;
+
+    const char* sql =
+        "SELECT i.id, n.name, mo.moniker, v.version, m.rowid "
+        "FROM manifest m "
+        "JOIN ids i ON i.rowid = m.id "
+        "LEFT JOIN names n ON n.rowid = m.name "
+        "LEFT JOIN monikers mo ON mo.rowid = m.moniker "
+        "LEFT JOIN versions v ON v.rowid = m.version "
+        "ORDER BY i.id;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        lastError_ = sqlite3_errmsg(db_);
+        return -1;
+    }
+
+    int delivered = 0;
+    bool keepGoing = true;
+    bool have = false;
+    WingetIndexRecord best;
+    Version bestVersion;
+    long long bestManifest = 0;
+    auto emit = [&]() {
+        if (!have) return;
+        if (withTags) {
+            auto it = tags.find(bestManifest);
+            if (it != tags.end()) best.tags = std::move(it->second);
+        }
+        ++delivered;
+        keepGoing = onRecord(best);
+    };
+    while (keepGoing && sqlite3_step(stmt) == SQLITE_ROW) {
+        std::string id = ColumnText(stmt, 0);
+        std::string version = ColumnText(stmt, 3);
+        Version parsed(version);
+        if (have && id == best.id) {
+            if (!(bestVersion < parsed)) continue;
+        } else {
+            emit();
+            if (!keepGoing) break;
+            have = true;
+        }
+        best.id = std::move(id);
+        best.name = ColumnText(stmt, 1);
+        best.moniker = ColumnText(stmt, 2);
+        best.version = std::move(version);
+        best.tags.clear();
+        bestVersion = parsed;
+        bestManifest = sqlite3_column_int64(stmt, 4);
+    }
+    if (keepGoing) emit();
+    sqlite3_finalize(stmt);
+    return delivered;
+}
+
+// Schema 2.x: one row per package that already carries its latest version.
+int WingetIndexReader::ForEachV2(const std::function<bool(const WingetIndexRecord&)>& onRecord, bool withTags) {
+    std::unordered_map<long long, std::vector<std::string>> tags;
+    if (withTags) {
+        const char* mapTable = TableExists("tags2_map") ? "tags2_map" : TableExists("tags_map") ? "tags_map" : nullptr;
+        if (mapTable) {
+            const char* tagTable = mapTable[4] == '2' ? "tags2" : "tags";
+            const char* keyColumn = ColumnExists(mapTable, "package") ? "package" : "manifest";
+            if (!LoadTags(mapTable, keyColumn, tagTable, tags)) return -1;
+        }
+    }
+
+    std::string sql = "SELECT rowid, id, name, ";
+    sql += ColumnExists("packages", "moniker") ? "moniker, " : "NULL, ";
+    sql += ColumnExists("packages", "latest_version") ? "latest_version " : "NULL ";
+    sql += "FROM packages ORDER BY id;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        lastError_ = sqlite3_errmsg(db_);
+        return -1;
+    }
+
+    int delivered = 0;
+    WingetIndexRecord rec;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        rec.id = ColumnText(stmt, 1);
+        rec.name = ColumnText(stmt, 2);
+        rec.moniker = ColumnText(stmt, 3);
+        rec.version = ColumnText(stmt, 4);
+        rec.tags.clear();
+        if (withTags) {
+            auto it = tags.find(sqlite3_column_int64(stmt, 0));
+            if (it != tags.end()) rec.tags = std::move(it->second);
+        }
+        ++delivered;
+        if (!onRecord(rec)) break;
+    }
+    sqlite3_finalize(stmt);
+    return delivered;
+}
+
+int WingetIndexReader::ForEachProductCode(const std::function<bool(const std::string&, const std::string&)>& onCode) {
+    if (!db_) return -1;
+
+    // productcodes(_map) point at manifests in 1.x; productcodes2(_map) at packages in 2.x
+    std::string sql;
+    if (schemaMajor_ == 1) {
+        if (!TableExists("productcodes_map")) return 0;
+        sql = "SELECT i.id, p.productcode FROM productcodes_map pm "
+              "JOIN productcodes p ON p.rowid = pm.productcode "
+              "JOIN manifest m ON m.rowid = pm.manifest "
+              "JOIN ids i ON i.rowid = m.id;";
+    } else {
+        const char* mapTable = TableExists("productcodes2_map") ? "productcodes2_map" : TableExists("productcodes_map") ? "productcodes_map" : nullptr;
+        if (!mapTable) return 0;
+        const char* codeTable = mapTable[12] == '2' ? "productcodes2" : "productcodes";
+        const char* keyColumn = ColumnExists(mapTable, "package") ? "package" : "manifest";
+        sql = std::string("SELECT pk.id, p.productcode FROM ") + mapTable + " pm JOIN " + codeTable +
+              " p ON p.rowid = pm.productcode JOIN packages pk ON pk.rowid = pm." + keyColumn + ";";
+    }
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        lastError_ = sqlite3_errmsg(db_);
+        return -1;
+    }
+    int delivered = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ++delivered;
+        if (!onCode(ColumnText(stmt, 0), ColumnText(stmt, 1))) break;
+    }
+    sqlite3_finalize(stmt);
+    return delivered;
+}
+
+#ifdef _WIN32
+
+static std::string WideToUtf8(const std::wstring& w) {
+    if (w.empty()) return std::string();
+    int size = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+    std::string out(size > 0 ? size : 0, 0);
+    if (size > 0) WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), &out[0], size, nullptr, nullptr);
+    return out;
+}
+
+static bool FileExists(const std::wstring& path) {
+    DWORD attrs = GetFileAttributesW(path.c_str());
+    return attrs != INVALID_FILE_ATTRIBUTES && !(attrs & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+std::string WingetIndexReader::FindInstalledIndex() {
+    static const wchar_t kFamily[] = L"Microsoft.Winget.Source_8wekyb3d8bbwe";
+
+    // Ask the package manager where the source package lives (works without
+    // admin rights, unlike listing WindowsApps). Resolved at runtime so the
+    // binaries still start on systems without these exports.
+    typedef LONG (WINAPI *GetPackagesByPackageFamilyFn)(PCWSTR, UINT32*, PWSTR*, UINT32*, WCHAR*);
+    typedef LONG (WINAPI *GetPackagePathByFullNameFn)(PCWSTR, UINT32*, PWSTR);
+    HMODULE kernel = GetModuleHandleW(L"kernel32.dll");
+    auto getPackages = kernel ? (GetPackagesByPackageFamilyFn)(void*)GetProcAddress(kernel, "GetPackagesByPackageFamily") : nullptr;
+    auto getPath = kernel ? (GetPackagePathByFullNameFn)(void*)GetProcAddress(kernel, "GetPackagePathByFullName") : nullptr;
+    if (getPackages && getPath) {
+        UINT32 count = 0, bufferLength = 0;
+        if (getPackages(kFamily, &count, nullptr, &bufferLength, nullptr) == ERROR_INSUFFICIENT_BUFFER && count > 0) {
+            std::vector<PWSTR> fullNames(count);
+            std::vector<WCHAR> buffer(bufferLength);
+            if (getPackages(kFamily, &count, fullNames.data(), &bufferLength, buffer.data()) == ERROR_SUCCESS) {
+                for (UINT32 i = count; i-- > 0;) {
+                    UINT32 pathLength = 0;
+                    if (getPath(fullNames[i], &pathLength, nullptr) != ERROR_INSUFFICIENT_BUFFER) continue;
+                    std::wstring path(pathLength, L'\0');
+                    if (getPath(fullNames[i], &pathLength, &path[0]) != ERROR_SUCCESS) continue;
+                    path.resize(wcslen(path.c_str()));
+                    std::wstring index = path + L"\\Public\\index.db";
+                    if (FileExists(index)) return WideToUtf8(index);
+                }
+            }
+        }
+    }
+
+    // Fallback: scan WindowsApps directly (succeeds when elevated)
+    wchar_t programFiles[MAX_PATH];
+    DWORD len = GetEnvironmentVariableW(L"ProgramFiles", programFiles, MAX_PATH);
+    if (len == 0 || len >= MAX_PATH) return std::string();
+    std::wstring appsDir = std::wstring(programFiles) + L"\\WindowsApps\\";
+    std::wstring newest;
+    Version newestVersion;
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileW((appsDir + L"Microsoft.Winget.Source_*").c_str(), &fd);
+    if (hFind == INVALID_HANDLE_VALUE) return std::string();
+    do {
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+        std::wstring index = appsDir + fd.cFileName + L"\\Public\\index.db";
+        if (!FileExists(index)) continue;
+        // "Microsoft.Winget.Source_2024.1016.1722.345_neutral__8wekyb3d8bbwe": keep the newest
+        std::string folder = WideToUtf8(fd.cFileName);
+        size_t underscore = folder.find('_');
+        Version version(underscore == std::string::npos ? std::string_view() : std::string_view(folder).substr(underscore + 1));
+        if (newest.empty() || newestVersion < version) { newest = index; newestVersion = version; }
+    } while (FindNextFileW(hFind, &fd));
+    FindClose(hFind);
+    return WideToUtf8(newest);
+}
+
+#else
+
+std::string WingetIndexReader::FindInstalledIndex() {
+    return std::string();
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+// Forward declaration for SQLite
+typedef struct sqlite3 sqlite3;
+
+// One package from winget's source index (its latest version only).
+struct WingetIndexRecord {
+    std::string id;
+    std::string name;
+    std::string moniker;
+    std::string version;
+    std::vector<std::string> tags;
+};
+
+// Read-only reader for the SQLite index.db that ships inside winget's source
+// package (Microsoft.Winget.Source). Listing every package from it is a single
+// query instead of a multi-minute `winget search .` screen scrape, and ids are
+// never truncated by column widths.
+//
+// Both index layouts are understood:
+//   schema 1.x  manifest rows (one per package version) pointing into the
+//               ids/names/monikers/versions/tags tables
+//   schema 2.x  one `packages` row per package with its latest_version
+// The file is opened immutable, so winget updating its source concurrently is
+// never blocked. No Windows dependency except FindInstalledIndex().
+class WingetIndexReader {
+public:
+    WingetIndexReader() = default;
+    ~WingetIndexReader();
+    WingetIndexReader(const WingetIndexReader&) = delete;
+    WingetIndexReader& operator=(const WingetIndexReader&) = delete;
+
+    bool Open(const std::string& pathUtf8);
+    void Close();
+    bool IsOpen() const { return db_ != nullptr; }
+    int SchemaMajor() const { return schemaMajor_; }
+    const std::string& LastError() const { return lastError_; }
+
+    // Calls onRecord once per package id, ordered by id; return false from it
+    // to stop early. Tags are only read when withTags is set. Returns the number
+    // of records delivered, or -1 if the index could not be queried.
+    int ForEachPackage(const std::function<bool(const WingetIndexRecord&)>& onRecord, bool withTags = true);
+
+    // Calls onCode(id, productCode) for every ProductCode an installer of a
+    // package declares (all versions under schema 1.x). For MSI installers this
+    // is the {GUID} Uninstall key; for others winget records the Uninstall key
+    // name there too. Returns the number of pairs delivered, 0 when the index
+    // has no product code table, or -1 if it could not be queried.
+    int ForEachProductCode(const std::function<bool(const std::string& id, const std::string& productCode)>& onCode);
+
+    // Path of index.db in the installed winget source package, or empty when it
+    // cannot be located (always empty outside Windows).
+    static std::string FindInstalledIndex();
+
+private:
+    bool TableExists(const char* name);
+    bool ColumnExists(const char* table, const char* column);
+    bool LoadTags(const char* mapTable, const char* keyColumn, const char* tagTable,
+                  std::unordered_map<long long, std::vector<std::string>>& out);
+    int ForEachV1(const std::function<bool(const WingetIndexRecord&)>& onRecord, bool withTags);
+    int ForEachV2(const std::function<bool(const WingetIndexRecord&)>& onRecord, bool withTags);
+
+    sqlite3* db_ = nullptr;
+    int schemaMajor_ = 0;
+    std::string lastError_;
+};
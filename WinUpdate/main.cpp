@@ -14,6 +14,7 @@
 #include <filesystem>
 #include <unordered_map>
 #include <future>
+#include <functional>
 #include <unordered_set>
 #include <filesystem>
 #include "About.h"
@@ -26,6 +27,11 @@
 #include "hidden_scan.h"
 #include "system_tray.h"
 #include "ctrlw.h"
+#include "scan_runner.h"
+#include "process_runner.h"
+#include "winget_table.h"
+#include "parsing.h"
+#include "version.h"
 #include "src/install_dialog.h"
 #include "src/startup_manager.h"
 #include "src/exclude.h"
@@ -73,21 +79,13 @@ const wchar_t CLASS_NAME[] = L"WinUpdateClass";
 
 #define WM_REFRESH_ASYNC (WM_APP + 1)
 #define WM_REFRESH_DONE  (WM_APP + 2)
+#define WM_REFRESH_ROW   (WM_APP + 3)   // lParam: ScanRow* parsed while winget is still running
 #define WM_INSTALL_DONE  (WM_APP + 5)
 #define WM_SHOW_FROM_SECOND_INSTANCE (WM_APP + 10)
 
 // Forward declarations for functions defined later
-static std::pair<int,std::string> RunProcessCaptureExitCode(const std::wstring &cmd, int timeoutMs);
-static void ParseWingetTextForPackages(const std::string &text);
-static std::vector<std::pair<std::string,std::string>> ExtractIdsFromNameIdText(const std::string &text);
-static void ParseUpgradeFast(const std::string &text, std::set<std::pair<std::string,std::string>> &outSet);
-static void ExtractUpdatesFromText(const std::string &text, std::set<std::pair<std::string,std::string>> &outSet);
-static void ParseWingetUpgradeTableForUpdates(const std::string &text, std::set<std::pair<std::string,std::string>> &outSet);
-static std::unordered_map<std::string,std::string> MapAvailableVersions();
-static std::unordered_map<std::string,std::string> MapInstalledVersions();
-static std::vector<std::pair<std::string,std::string>> ParseRawWingetTextInMemory(const std::string &text);
-
-static std::unordered_map<std::string,std::string> MapInstalledVersions();
+static std::pair<int,std::string> RunProcessCaptureExitCode(const std::wstring &cmd, int timeoutMs,
+                                                            const std::function<void(const char*, size_t)> &onChunk = nullptr);
 
 
 // Globals (non-static for cross-file access - defined in src/globals.cpp)
@@ -142,13 +140,19 @@ static std::string ReadFileUtf8(const std::wstring &path);
 static std::wstring Utf8ToWide(const std::string &s);
 static std::string WideToUtf8(const std::wstring &w);
 
-// Return cached available versions if present, otherwise probe and cache result.
+// Return the snapshot of the last refresh. Every refresh replaces it; between
+// refreshes it is reused for kScanSnapshotMaxAgeMs, then winget runs again.
+static ScanSnapshot GetScanSnapshotCached() {
+    return CurrentScanSnapshot(kScanSnapshotMaxAgeMs);
+}
+
+// Return cached available versions if present, otherwise read them from the last snapshot.
 static std::unordered_map<std::string,std::string> GetAvailableVersionsCached() {
     {
         std::lock_guard<std::mutex> lk(g_versions_mutex);
         if (!g_last_avail_versions.empty()) return g_last_avail_versions;
     }
-    auto m = MapAvailableVersions();
+    auto m = GetScanSnapshotCached().AvailableMap();
     {
         std::lock_guard<std::mutex> lk(g_versions_mutex);
         g_last_avail_versions = m;
@@ -162,7 +166,7 @@ static std::unordered_map<std::string,std::string> GetInstalledVersionsCached()
         std::lock_guard<std::mutex> lk(g_versions_mutex);
         if (!g_last_inst_versions.empty()) return g_last_inst_versions;
     }
-    auto m = MapInstalledVersions();
+    auto m = GetScanSnapshotCached().InstalledMap();
     {
         std::lock_guard<std::mutex> lk(g_versions_mutex);
         g_last_inst_versions = m;
@@ -171,22 +175,6 @@ static std::unordered_map<std::string,std::string> GetInstalledVersionsCached()
     return m;
 }
 
-// Parse raw winget output in memory by trying multiple parsers (fast -> tolerant -> table)
-static std::vector<std::pair<std::string,std::string>> ParseRawWingetTextInMemory(const std::string &text) {
-    std::set<std::pair<std::string,std::string>> found;
-    if (text.empty()) return {};
-    ParseUpgradeFast(text, found);
-    if (found.empty()) ExtractUpdatesFromText(text, found);
-    if (found.empty()) {
-        std::set<std::pair<std::string,std::string>> tmp;
-        ParseWingetUpgradeTableForUpdates(text, tmp);
-        for (auto &p : tmp) found.insert(p);
-    }
-    std::vector<std::pair<std::string,std::string>> out;
-    for (auto &p : found) out.emplace_back(p.first, p.second);
-    return out;
-}
-
 // Load/Save per-locale skip config in locale/<locale>.ini with lines: skip=Id|Version
 static void LoadSkipConfig(const std::string &locale) {
     g_skipped_versions.clear();
@@ -233,237 +221,6 @@ static void SaveSkipConfig(const std::string &locale) {
     } catch(...) {}
 }
 
-static std::unordered_map<std::string,std::string> MapInstalledVersions() {
-    std::unordered_map<std::string,std::string> out;
-    try {
-        std::vector<int> attempts = {2400, 2400};
-        std::string txt;
-        for (int t : attempts) {
-            auto r = RunProcessCaptureExitCode(L"winget list --accept-source-agreements --accept-package-agreements --output json", t);
-            txt = r.second;
-            if (!txt.empty()) break;
-        }
-        if (!txt.empty()) {
-#if HAVE_NLOHMANN_JSON
-            try {
-                auto j = nlohmann::json::parse(txt);
-                std::function<void(const nlohmann::json&)> visit;
-                visit = [&](const nlohmann::json &node) {
-                    if (node.is_object()) {
-                        std::string id; std::string ver;
-                        if (node.contains("Id") && node["Id"].is_string()) id = node["Id"].get<std::string>();
-                        if (node.contains("InstalledVersion") && node["InstalledVersion"].is_string()) ver = node["InstalledVersion"].get<std::string>();
-                        if (node.contains("Version") && node["Version"].is_string()) ver = node["Version"].get<std::string>();
-                        if (!id.empty() && !ver.empty()) out[id] = ver;
-                        for (auto it = node.begin(); it != node.end(); ++it) visit(it.value());
-                    } else if (node.is_array()) {
-                        for (auto &el : node) visit(el);
-                    }
-                };
-                visit(j);
-                if (!out.empty()) return out;
-            } catch(...) { }
-#endif
-        }
-        // Try to parse aligned table output (header + separator) like:
-        // Name                                   Id                       Version
-        // ------------------------------------   ---------------------    --------
-        std::istringstream iss(txt);
-        std::vector<std::string> lines;
-        std::string ln;
-        while (std::getline(iss, ln)) {
-            while (!ln.empty() && (ln.back()=='\r' || ln.back()=='\n')) ln.pop_back();
-            lines.push_back(ln);
-        }
-        int headerIdx = -1, sepIdx = -1;
-        for (int i = 0; i < (int)lines.size(); ++i) {
-            if (lines[i].find("----") != std::string::npos) { sepIdx = i; break; }
-        }
-        if (sepIdx > 0) headerIdx = sepIdx - 1;
-        auto trim = [](std::string s){ while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); return s; };
-        if (headerIdx >= 0) {
-            std::string header = lines[headerIdx];
-            // find column starts for Name, Id, Version
-            std::vector<std::string> colNames = {"Name", "Id", "Version"};
-            std::vector<int> colStarts;
-            for (auto &cn : colNames) {
-                size_t p = header.find(cn);
-                if (p != std::string::npos) colStarts.push_back((int)p);
-            }
-            if (colStarts.size() >= 2) {
-                int ncols = (int)colStarts.size();
-                for (int i = sepIdx + 1; i < (int)lines.size(); ++i) {
-                    const std::string &sline = lines[i];
-                    if (trim(sline).empty()) continue;
-                    if (sline.find("upgraded") != std::string::npos) break;
-                    auto substrSafe = [&](const std::string &s, int a, int b)->std::string{
-                        int len = (int)s.size();
-                        if (a >= len) return std::string();
-                        int end = std::min(len, b);
-                        return s.substr(a, end - a);
-                    };
-                    std::vector<std::string> fields(ncols);
-                    for (int c = 0; c < ncols; ++c) {
-                        int a = colStarts[c];
-                        int b = (c+1 < ncols) ? colStarts[c+1] : (int)sline.size();
-                        fields[c] = trim(substrSafe(sline, a, b));
-                    }
-                    std::string id = (ncols > 1) ? fields[1] : std::string();
-                    std::string inst = (ncols > 2) ? fields[2] : std::string();
-                    if (!id.empty()) out[id] = inst;
-                }
-                return out;
-            }
-        }
-        // Fallback: token-based heuristic
-        std::istringstream iss2(txt);
-        while (std::getline(iss2, ln)) {
-            if (ln.find("----") != std::string::npos) continue;
-            if (ln.find("Name") != std::string::npos && ln.find("Id") != std::string::npos) continue;
-            // trim
-            auto trim2 = [](std::string &s){ while(!s.empty() && (s.back()=='\r' || s.back()=='\n')) s.pop_back(); while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); };
-            trim2(ln);
-            if (ln.empty()) continue;
-            std::istringstream ls(ln);
-            std::vector<std::string> toks;
-            std::string tok;
-            while (ls >> tok) toks.push_back(tok);
-            if (toks.size() < 2) continue;
-            std::unordered_set<std::string> knownIds;
-            {
-                std::lock_guard<std::mutex> lk(g_packages_mutex);
-                for (auto &p : g_packages) knownIds.insert(p.first);
-            }
-            std::string id;
-            for (auto &t : toks) {
-                if (knownIds.find(t) != knownIds.end()) { id = t; break; }
-            }
-            if (id.empty()) {
-                // assume last token is version, second-last is id
-                if (toks.size() >= 2) {
-                    id = toks[toks.size()-2];
-                } else id = toks.front();
-            }
-            std::string inst = toks.back();
-            out[id] = inst;
-        }
-    } catch(...) {}
-    return out;
-}
-
-// Map id -> available version by parsing `winget upgrade` table quickly
-static std::unordered_map<std::string,std::string> MapAvailableVersions() {
-    std::unordered_map<std::string,std::string> out;
-    try {
-        std::vector<int> attempts = {2400, 2400};
-        std::string txt;
-        for (int t : attempts) {
-            auto r = RunProcessCaptureExitCode(L"winget upgrade --accept-source-agreements --accept-package-agreements --output json", t);
-            txt = r.second;
-            if (!txt.empty()) break;
-        }
-        if (!txt.empty()) {
-#if HAVE_NLOHMANN_JSON
-            try {
-                auto j = nlohmann::json::parse(txt);
-                std::function<void(const nlohmann::json&)> visit;
-                visit = [&](const nlohmann::json &node) {
-                    if (node.is_object()) {
-                        std::string id; std::string ver;
-                        if (node.contains("Id") && node["Id"].is_string()) id = node["Id"].get<std::string>();
-                        if (node.contains("AvailableVersion") && node["AvailableVersion"].is_string()) ver = node["AvailableVersion"].get<std::string>();
-                        if (node.contains("Available") && node["Available"].is_string()) ver = node["Available"].get<std::string>();
-                        if (node.contains("Version") && node["Version"].is_string()) ver = node["Version"].get<std::string>();
-                        if (!id.empty() && !ver.empty()) out[id] = ver;
-                        for (auto it = node.begin(); it != node.end(); ++it) visit(it.value());
-                    } else if (node.is_array()) {
-                        for (auto &el : node) visit(el);
-                    }
-                };
-                visit(j);
-                if (!out.empty()) return out;
-            } catch(...) { }
-#endif
-        }
-        // Prefer parsing the aligned table output (header + separator)
-        std::istringstream iss(txt);
-        std::vector<std::string> lines;
-        std::string ln;
-        while (std::getline(iss, ln)) {
-            while (!ln.empty() && (ln.back()=='\r' || ln.back()=='\n')) ln.pop_back();
-            lines.push_back(ln);
-        }
-        int headerIdx = -1, sepIdx = -1;
-        for (int i = 0; i < (int)lines.size(); ++i) {
-            if (lines[i].find("----") != std::string::npos) { sepIdx = i; break; }
-        }
-        if (sepIdx > 0) headerIdx = sepIdx - 1;
-        auto trim = [](std::string s){ while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); return s; };
-        if (headerIdx >= 0) {
-            std::string header = lines[headerIdx];
-            std::vector<std::string> colNames = {"Name","Id","Version","Available"};
-            std::vector<int> colStarts;
-            for (auto &cn : colNames) {
-                size_t p = header.find(cn);
-                if (p != std::string::npos) colStarts.push_back((int)p);
-            }
-            if (colStarts.size() >= 2) {
-                int ncols = (int)colStarts.size();
-                for (int i = sepIdx + 1; i < (int)lines.size(); ++i) {
-                    const std::string &sline = lines[i];
-                    if (trim(sline).empty()) continue;
-                    if (sline.find("upgrades available") != std::string::npos) break;
-                    auto substrSafe = [&](const std::string &s, int a, int b)->std::string{
-                        int len = (int)s.size();
-                        if (a >= len) return std::string();
-                        int end = std::min(len, b);
-                        return s.substr(a, end - a);
-                    };
-                    std::vector<std::string> fields(ncols);
-                    for (int c = 0; c < ncols; ++c) {
-                        int a = colStarts[c];
-                        int b = (c+1 < ncols) ? colStarts[c+1] : (int)sline.size();
-                        fields[c] = trim(substrSafe(sline, a, b));
-                    }
-                    std::string id = (ncols > 1) ? fields[1] : std::string();
-                    std::string available = (ncols > 3) ? fields[3] : std::string();
-                    if (!id.empty()) out[id] = available;
-                }
-                return out;
-            }
-        }
-        // Fallback token-based parsing
-        std::istringstream iss2(txt);
-        while (std::getline(iss2, ln)) {
-            if (ln.find("----") != std::string::npos) continue;
-            if (ln.find("Name") != std::string::npos && ln.find("Id") != std::string::npos) continue;
-            auto trim2 = [](std::string &s){ while(!s.empty() && (s.back()=='\r' || s.back()=='\n')) s.pop_back(); while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); };
-            trim2(ln);
-            if (ln.empty()) continue;
-            std::istringstream ls(ln);
-            std::vector<std::string> toks;
-            std::string tok;
-            while (ls >> tok) toks.push_back(tok);
-            if (toks.empty()) continue;
-            std::unordered_set<std::string> knownIds;
-            {
-                std::lock_guard<std::mutex> lk(g_packages_mutex);
-                for (auto &p : g_packages) knownIds.insert(p.first);
-            }
-            std::string id;
-            for (auto &t : toks) {
-                if (knownIds.find(t) != knownIds.end()) { id = t; break; }
-            }
-            if (id.empty()) {
-                if (toks.size() >= 2) id = toks[toks.size()-2]; else id = toks.front();
-            }
-            std::string available = toks.back();
-            if (!id.empty()) out[id] = available;
-        }
-    } catch(...) {}
-    return out;
-}
-
 static void InitDefaultTranslations() {
     if (!g_i18n_default.empty()) return;
     g_i18n_default["app_window_title"] = "WinUpdate - winget GUI updater";
@@ -866,66 +623,23 @@ static LRESULT CALLBACK AnimSubclassProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
 }
 
 
-// Run a command, capture stdout/stderr to a temp file, return exit code and UTF-8 output.
-static std::pair<int,std::string> RunProcessCaptureExitCode(const std::wstring &cmd, int timeoutMs) {
-    // Launch the given command line and capture stdout+stderr via pipes (no temp files).
-    std::pair<int,std::string> result = {-1, std::string()};
-    SECURITY_ATTRIBUTES sa{}; sa.nLength = sizeof(sa); sa.bInheritHandle = TRUE; sa.lpSecurityDescriptor = NULL;
-    HANDLE hRead = NULL, hWrite = NULL;
-    if (!CreatePipe(&hRead, &hWrite, &sa, 0)) return result;
-    // ensure read handle is not inherited
-    SetHandleInformation(hRead, HANDLE_FLAG_INHERIT, 0);
-
-    STARTUPINFOW si{}; si.cb = sizeof(si);
-    si.dwFlags |= STARTF_USESTDHANDLES;
-    si.hStdOutput = hWrite;
-    si.hStdError = hWrite;
-    si.hStdInput = NULL;
-
-    PROCESS_INFORMATION pi{};
-    // copy command into writable buffer for CreateProcess
-    std::wstring cmdCopy = cmd;
-    BOOL ok = CreateProcessW(NULL, &cmdCopy[0], NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi);
-    // close write end in parent regardless
-    CloseHandle(hWrite);
-    if (!ok) {
-        CloseHandle(hRead);
-        return result;
-    }
-
-    DWORD wait = WaitForSingleObject(pi.hProcess, timeoutMs > 0 ? (DWORD)timeoutMs : INFINITE);
-    if (wait == WAIT_TIMEOUT) {
-        TerminateProcess(pi.hProcess, 1);
-        result.first = -2; // timeout sentinel
-    } else {
-        DWORD exitCode = 0; GetExitCodeProcess(pi.hProcess, &exitCode); result.first = (int)exitCode;
-    }
-
-    // read all available output from pipe
-    std::string output;
-    const DWORD bufSize = 4096;
-    char buffer[bufSize];
-    DWORD read = 0;
-    while (ReadFile(hRead, buffer, bufSize, &read, NULL) && read > 0) {
-        output.append(buffer, buffer + read);
-    }
-
-    CloseHandle(hRead);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
+// Run a command, capture stdout/stderr through a pipe, return exit code and UTF-8 output.
+// Thin wrapper over RunProcess (process_runner.h); `onChunk` (optional) sees
+// each piece of output as soon as it is read so callers can parse incrementally.
+static std::pair<int,std::string> RunProcessCaptureExitCode(const std::wstring &cmd, int timeoutMs,
+                                                            const std::function<void(const char*, size_t)> &onChunk) {
+    ProcessOptions opts;
+    opts.timeoutMs = timeoutMs;
+    opts.onChunk = onChunk;
+    ProcessResult r = RunProcess(cmd, opts);
 
     // append to run log for debugging
-    {
-        std::ostringstream oss;
-        oss << "--- CMD: " << WideToUtf8(cmd) << " ---\n";
-        oss << "Exit: " << result.first << "\n";
-        if (result.first == -2) oss << "(TIMEOUT)\n";
-        oss << "Output:\n" << output << "\n\n";
-        AppendLog(oss.str());
-    }
+    LOG_INFO("--- CMD: " << WideToUtf8(cmd) << " ---\n"
+             << "Exit: " << r.exitCode << (r.timedOut() ? " (TIMEOUT)" : "")
+             << " (first output " << r.firstByteMs << " ms, total " << r.totalMs << " ms)\n"
+             << "Output:\n" << r.output << "\n");
 
-    result.second = output;
-    return result;
+    return { r.exitCode, std::move(r.output) };
 }
 
 static std::string WideToUtf8(const std::wstring &w) {
@@ -1057,199 +771,6 @@ static void ParseWingetJsonForPackages(const std::string &jsonText) {
     ParseWingetTextForPackages(jsonText);
 }
 
-// Parse human-readable `winget upgrade` text output.
-// compare semantic-ish version strings: returns -1 if a<b, 0 if equal, 1 if a>b
-static int CompareVersions(const std::string &a, const std::string &b) {
-    if (a == b) return 0;
-    std::istringstream sa(a), sb(b);
-    std::string ta, tb;
-    while (true) {
-        if (!std::getline(sa, ta, '.')) ta.clear();
-        if (!std::getline(sb, tb, '.')) tb.clear();
-        if (ta.empty() && tb.empty()) break;
-        // try numeric compare
-        long va = 0, vb = 0;
-        try { va = std::stol(ta.empty()?"0":ta); } catch(...) { va = 0; }
-        try { vb = std::stol(tb.empty()?"0":tb); } catch(...) { vb = 0; }
-        if (va < vb) return -1;
-        if (va > vb) return 1;
-        // continue
-        if (!sa.good() && !sb.good()) break;
-    }
-    return 0;
-}
-
-// Parse text output and pick only entries where an available version is greater
-static void ParseWingetTextForUpdates(const std::string &text) {
-    g_packages.clear();
-    std::istringstream iss(text);
-    std::string line;
-    // match lines that end with: <installed-version> <available-version>
-    std::regex lineRe("^\\s*(.+?)\\s+([^\\s]+)\\s+(\\d+(?:\\.\\d+)*)\\s+(\\d+(?:\\.\\d+)*)\\s*$");
-    std::smatch m;
-    while (std::getline(iss, line)) {
-        while (!line.empty() && (line.back()=='\r' || line.back()=='\n')) line.pop_back();
-        if (line.empty()) continue;
-        if (std::regex_match(line, m, lineRe)) {
-            // m[1]=name, m[2]=id, m[3]=installed, m[4]=available
-            std::string name = m[1].str();
-            std::string id = m[2].str();
-            std::string installed = m[3].str();
-            std::string available = m[4].str();
-            if (CompareVersions(installed, available) < 0) {
-                g_packages.emplace_back(id, name);
-            }
-        }
-    }
-}
-
-// Very fast upgrade output parser: split each non-header line into tokens,
-// take the last tokens as id/installed/available and compare versions.
-static void ParseUpgradeFast(const std::string &text, std::set<std::pair<std::string,std::string>> &outSet) {
-    auto trim = [](std::string s){ while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); return s; };
-    std::istringstream iss(text);
-    std::string line;
-    bool seenHeader = false;
-    std::regex verRe(R"(^[0-9]+(\.[0-9]+)*$)");
-    while (std::getline(iss, line)) {
-        while (!line.empty() && (line.back()=='\r' || line.back()=='\n')) line.pop_back();
-        std::string t = trim(line);
-        if (t.empty()) continue;
-        if (!seenHeader) {
-            if (t.find("Name") != std::string::npos && t.find("Id") != std::string::npos) { seenHeader = true; continue; }
-            continue;
-        }
-        if (t.find("----") != std::string::npos) continue;
-        if (t.find("upgrades available") != std::string::npos) break;
-
-        std::istringstream ls(t);
-        std::vector<std::string> toks;
-        std::string tok;
-        while (ls >> tok) toks.push_back(tok);
-        if (toks.size() < 3) continue;
-
-        int n = (int)toks.size();
-        int verIdx2 = -1, verIdx1 = -1;
-        for (int i = n - 1; i >= 1; --i) {
-            if (std::regex_match(toks[i], verRe) && std::regex_match(toks[i-1], verRe)) { verIdx2 = i; verIdx1 = i-1; break; }
-        }
-        if (verIdx1 < 0) continue;
-        int idIdx = verIdx1 - 1;
-        if (idIdx < 0) continue;
-
-        std::string available = toks[verIdx2];
-        std::string installed = toks[verIdx1];
-
-        auto looks_like_id = [&](const std::string &s)->bool {
-            if (s.find('.') != std::string::npos) return true;
-            if (s.size() >= 4) return true;
-            for (char c : s) if (isupper((unsigned char)c)) return true;
-            return false;
-        };
-
-        std::string id = toks[idIdx];
-        if (!looks_like_id(id)) {
-            int better = -1;
-            for (int k = idIdx - 1; k >= 0; --k) { if (looks_like_id(toks[k])) { better = k; break; } }
-            if (better >= 0) idIdx = better;
-        }
-
-        std::string name;
-        for (int i = 0; i < idIdx; ++i) { if (i) name += " "; name += toks[i]; }
-        if (name.empty()) name = toks[idIdx];
-
-        id = toks[idIdx];
-        if (CompareVersions(installed, available) < 0) outSet.emplace(id, name);
-    }
-}
-
-// More tolerant extractor: find any occurrences of lines or fragments that contain
-// <name> <id> <installed-version> <available-version> and add when available>installed
-static void ExtractUpdatesFromText(const std::string &text, std::set<std::pair<std::string,std::string>> &outSet) {
-    // regex: capture name (greedy), id token (no spaces), installed(ver), available(ver)
-    std::regex anyRe("([\\S ]+?)\\s+([^\\s]+)\\s+(\\d+(?:\\.\\d+)*)\\s+(\\d+(?:\\.\\d+)*)");
-    std::smatch m;
-    std::string::const_iterator it = text.begin();
-    while (std::regex_search(it, text.cend(), m, anyRe)) {
-        std::string name = m[1].str();
-        std::string id = m[2].str();
-        std::string installed = m[3].str();
-        std::string available = m[4].str();
-        // trim name
-        auto trim = [](std::string s){ while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); return s; };
-        name = trim(name);
-        if (!id.empty() && CompareVersions(installed, available) < 0) outSet.emplace(id, name);
-        it = m.suffix().first;
-    }
-}
-
-// Build a map of Id->Name from a full winget listing (Name/Id table)
-// then scan the upgrade output for <name> <id> <installed> <available>
-// and add entries where available > installed and id exists in the map.
-static void FindUpdatesUsingKnownList(const std::string &listText, const std::string &upgradeText, std::set<std::pair<std::string,std::string>> &outSet) {
-    // populate g_packages from the listText
-    {
-        std::lock_guard<std::mutex> lk(g_packages_mutex);
-        ParseWingetTextForPackages(listText);
-        // copy into local map
-    }
-    std::unordered_map<std::string,std::string> pkgmap;
-    for (auto &p : g_packages) pkgmap[p.first] = p.second;
-    // if we didn't get a useful map from the provided list, try extracting Id/Name pairs from the upgrade text
-    if (pkgmap.empty() && !upgradeText.empty()) {
-        auto extra = ExtractIdsFromNameIdText(upgradeText);
-        for (auto &p : extra) pkgmap[p.first] = p.second;
-    }
-    // clear global helper list to avoid side-effects
-    {
-        std::lock_guard<std::mutex> lk(g_packages_mutex);
-        g_packages.clear();
-    }
-    if (pkgmap.empty()) return;
-
-    // regex to find fragments like: <name> <id> <installed> <available>
-    std::regex anyRe(R"(([\S ]+?)\s+([^\s]+)\s+(\d+(?:\.[0-9]+)*)\s+(\d+(?:\.[0-9]+)*))");
-    std::smatch m;
-    std::string::const_iterator it = upgradeText.begin();
-    while (std::regex_search(it, upgradeText.cend(), m, anyRe)) {
-        std::string id = m[2].str();
-        std::string installed = m[3].str();
-        std::string available = m[4].str();
-        if (!id.empty() && pkgmap.count(id) && CompareVersions(installed, available) < 0) {
-            outSet.emplace(id, pkgmap[id]);
-        }
-        it = m.suffix().first;
-    }
-}
-
-static std::vector<std::pair<std::string,std::string>> ExtractIdsFromNameIdText(const std::string &text) {
-    std::vector<std::pair<std::string,std::string>> ids;
-    std::istringstream iss(text);
-    std::string ln;
-    auto trim = [](std::string s){ while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); return s; };
-    while (std::getline(iss, ln)) {
-        std::string t = trim(ln);
-        if (t.empty()) continue;
-        // skip header/separator lines that contain dashes or 'Name' header
-        if (t.find("----") != std::string::npos) continue;
-        if (t.find("Name") != std::string::npos && t.find("Id") != std::string::npos) continue;
-        std::istringstream ls(t);
-        std::vector<std::string> toks;
-        std::string tok;
-        while (ls >> tok) toks.push_back(tok);
-        if (toks.size() >= 2) {
-            std::string id = toks.back();
-            std::string name;
-            for (size_t i = 0; i + 1 < toks.size(); ++i) {
-                if (i) name += " ";
-                name += toks[i];
-            }
-            ids.emplace_back(id, name);
-        }
-    }
-    return ids;
-}
-
 static void CheckIdsForUpdates(const std::vector<std::pair<std::string,std::string>> &candidates, std::set<std::pair<std::string,std::string>> &outFound, HWND hwnd) {
     // Probe all candidate ids in parallel with limited concurrency to keep it fast.
     unsigned int hw = std::thread::hardware_concurrency();
@@ -1296,196 +817,53 @@ static void CheckIdsForUpdates(const std::vector<std::pair<std::string,std::stri
     }
 }
 
-// Read the most recent raw winget output file matching prefix wup_winget_raw_*.txt
-static std::string ReadMostRecentRawWinget() {
-    namespace fs = std::filesystem;
-    std::string best;
-    std::filesystem::file_time_type bestTime = std::filesystem::file_time_type::min();
-    try {
-        for (auto &p : fs::directory_iterator(fs::current_path())) {
-            std::string name = p.path().filename().string();
-            if (name.rfind("wup_winget_raw_", 0) == 0 && p.path().extension() == ".txt") {
-                auto ftime = fs::last_write_time(p.path());
-                if (ftime > bestTime) {
-                    bestTime = ftime;
-                    best = p.path().string();
-                }
-            }
-        }
-        if (!best.empty()) {
-            // read file
-            std::ifstream ifs(best, std::ios::binary);
-            if (ifs) {
-                std::ostringstream ss; ss << ifs.rdbuf();
-                return ss.str();
-            }
-        }
-    } catch(...) {}
-    return std::string();
+// Persistent buffers for item texts so the ListView receives stable pointers
+static std::vector<std::wstring> g_itemNameBuf;
+static std::vector<std::wstring> g_itemCurBuf;
+static std::vector<std::wstring> g_itemAvailBuf;
+static std::vector<std::wstring> g_itemSkipBuf;
+static std::vector<std::wstring> g_itemExcludeBuf;
+
+// Insert row `i` (g_packages[i]) with its version, Skip and Exclude cells.
+// Rows must be inserted in order: `i` is both the item index and its lParam.
+static void InsertListViewRow(HWND hList, int i, const std::string &name, const std::string &curv, const std::string &availv) {
+    if ((int)g_itemNameBuf.size() <= i) {
+        g_itemNameBuf.resize(i + 1); g_itemCurBuf.resize(i + 1); g_itemAvailBuf.resize(i + 1); g_itemSkipBuf.resize(i + 1); g_itemExcludeBuf.resize(i + 1);
+    }
+    // store into persistent buffers to ensure pointers remain valid
+    g_itemNameBuf[i] = Utf8ToWide(name);
+    LVITEMW lvi{};
+    lvi.mask = LVIF_TEXT | LVIF_PARAM;
+    lvi.iItem = i;
+    lvi.iSubItem = 0;
+    lvi.pszText = (LPWSTR)g_itemNameBuf[i].c_str();
+    lvi.lParam = i;
+    SendMessageW(hList, LVM_INSERTITEMW, 0, (LPARAM)&lvi);
+    // Current version (subitem 1)
+    LVITEMW lviCur{}; lviCur.mask = LVIF_TEXT; lviCur.iItem = i; lviCur.iSubItem = 1;
+    g_itemCurBuf[i] = curv.empty() ? std::wstring() : Utf8ToWide(curv);
+    lviCur.pszText = (LPWSTR)g_itemCurBuf[i].c_str();
+    SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviCur);
+    // Available version (subitem 2)
+    LVITEMW lviAvail{}; lviAvail.mask = LVIF_TEXT; lviAvail.iItem = i; lviAvail.iSubItem = 2;
+    g_itemAvailBuf[i] = availv.empty() ? std::wstring() : Utf8ToWide(availv);
+    lviAvail.pszText = (LPWSTR)g_itemAvailBuf[i].c_str();
+    SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviAvail);
+    // Skip column (subitem 3): always show localized Skip label (clickable hyperlink);
+    // the actual skip state is stored separately
+    LVITEMW lviSkip{}; lviSkip.mask = LVIF_TEXT; lviSkip.iItem = i; lviSkip.iSubItem = 3;
+    g_itemSkipBuf[i] = t("skip_col");
+    lviSkip.pszText = (LPWSTR)g_itemSkipBuf[i].c_str();
+    SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviSkip);
+    // Exclude column (subitem 4): always show localized Exclude label (clickable hyperlink)
+    LVITEMW lviExclude{}; lviExclude.mask = LVIF_TEXT; lviExclude.iItem = i; lviExclude.iSubItem = 4;
+    g_itemExcludeBuf[i] = t("exclude_col");
+    lviExclude.pszText = (LPWSTR)g_itemExcludeBuf[i].c_str();
+    SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviExclude);
 }
 
-static void ParseWingetTextForPackages(const std::string &text) {
-    g_packages.clear();
-    std::istringstream iss(text);
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(iss, line)) {
-        // trim CR
-        while (!line.empty() && (line.back()=='\r' || line.back()=='\n')) line.pop_back();
-        // keep even empty lines (we'll skip later)
-        lines.push_back(line);
-    }
-    if (lines.empty()) return;
-
-    // find header line (contains Name and Id) and separator (----)
-    int headerIdx = -1;
-    int sepIdx = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (lines[i].find("----") != std::string::npos) {
-            sepIdx = i;
-            break;
-        }
-    }
-    if (sepIdx <= 0) return;
-    headerIdx = sepIdx - 1;
-    std::string header = lines[headerIdx];
-
-    auto trim = [](std::string s){ while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); return s; };
-
-    // determine column start positions from header
-    std::vector<int> colStarts;
-    std::vector<std::string> colNames = {"Name","Id","Version","Available","Source"};
-    for (auto &cn : colNames) {
-        size_t p = header.find(cn);
-        if (p != std::string::npos) colStarts.push_back((int)p);
-    }
-    if (colStarts.size() < 2) {
-        // fallback: whitespace token parsing
-        for (int i = sepIdx + 1, lastAdded = -1; i < (int)lines.size(); ++i) {
-            const std::string &ln = lines[i];
-            if (ln.find("upgrades available") != std::string::npos) break;
-            if (trim(ln).empty()) continue;
-            std::istringstream ls(ln);
-            std::vector<std::string> toks;
-            std::string tok;
-            while (ls >> tok) toks.push_back(tok);
-            if (toks.size() < 4) continue;
-                // Look for pattern: <name...> <id> <installed-version> <available-version>
-                std::regex verRe2(R"(^[0-9]+(\.[0-9]+)*$)");
-                size_t n = toks.size();
-                // require at least two trailing version-like tokens
-                if (n >= 3 && std::regex_match(toks[n-1], verRe2) && std::regex_match(toks[n-2], verRe2)) {
-                    std::string available = toks[n-1];
-                    std::string installed = toks[n-2];
-                    std::string id = toks[n-3];
-                    std::string name;
-                    for (size_t j = 0; j + 3 < toks.size(); ++j) {
-                        if (j) name += " ";
-                        name += toks[j];
-                    }
-                    if (name.empty()) name = id;
-                    if (CompareVersions(installed, available) < 0) {
-                        try { if (!IsSkipped(id, available)) g_packages.emplace_back(id, name); } catch(...) { g_packages.emplace_back(id, name); }
-                    }
-                } else {
-                    // fallback: if we can't detect versions, skip to avoid false positives
-                    continue;
-                }
-            lastAdded = (int)g_packages.size()-1;
-        }
-        return;
-    }
-
-    // add end position as line length sentinel per line when slicing
-    int lastAdded = -1;
-    for (int i = sepIdx + 1; i < (int)lines.size(); ++i) {
-        const std::string &ln = lines[i];
-        if (ln.find("upgrades available") != std::string::npos) break;
-        if (trim(ln).empty()) continue;
-        // if the line is shorter than second column start, treat as continuation
-        if ((int)ln.size() <= colStarts[1]) {
-            if (lastAdded >= 0) {
-                std::string cont = trim(ln);
-                if (!cont.empty()) {
-                    g_packages[lastAdded].second += " ";
-                    g_packages[lastAdded].second += cont;
-                }
-            }
-            continue;
-        }
-        auto substrSafe = [&](const std::string &s, int a, int b)->std::string{
-            int len = (int)s.size();
-            if (a >= len) return std::string();
-            int end = std::min(len, b);
-            return s.substr(a, end - a);
-        };
-
-        // compute per-column substrings using next column start or line end
-        int ncols = (int)colStarts.size();
-        std::vector<std::string> fields(ncols);
-        for (int c = 0; c < ncols; ++c) {
-            int a = colStarts[c];
-            int b = (c+1 < ncols) ? colStarts[c+1] : (int)ln.size();
-            fields[c] = trim(substrSafe(ln, a, b));
-        }
-        std::string name = fields[0];
-        std::string id = (ncols > 1) ? fields[1] : std::string();
-        if (id.empty()) {
-            // treat as continuation if id missing
-            if (lastAdded >= 0) {
-                std::string cont = trim(ln);
-                if (!cont.empty()) {
-                    g_packages[lastAdded].second += " ";
-                    g_packages[lastAdded].second += cont;
-                }
-            }
-            continue;
-        }
-        if (name.empty()) name = id;
-        try {
-            std::string availCol = (ncols > 3) ? fields[3] : std::string();
-            if (!IsSkipped(id, availCol)) g_packages.emplace_back(id, name);
-            else { /* skipped */ }
-        } catch(...) { g_packages.emplace_back(id, name); }
-        lastAdded = (int)g_packages.size()-1;
-    }
-
-    // Additional heuristic pass: look for tokens like <Id-with-dot> <version>
-    // to catch lines where wrapping confused column slicing.
-    std::set<std::string> seenIds;
-    for (auto &p : g_packages) seenIds.insert(p.first);
-    std::regex verRe(R"(^[0-9]+(\.[0-9]+)*$)");
-    for (const auto &ln : lines) {
-        std::istringstream ls(ln);
-        std::vector<std::string> toks;
-        std::string tok;
-        while (ls >> tok) toks.push_back(tok);
-        // look for pattern: ... <id> <installed> <available>
-        for (size_t j = 0; j + 2 < toks.size(); ++j) {
-            if (std::regex_match(toks[j+1], verRe) && std::regex_match(toks[j+2], verRe)) {
-                std::string id = toks[j];
-                if (seenIds.count(id)) break;
-                std::string installed = toks[j+1];
-                std::string available = toks[j+2];
-                if (CompareVersions(installed, available) < 0) {
-                    std::string name;
-                    for (size_t k = 0; k < j; ++k) {
-                        if (k) name += " ";
-                        name += toks[k];
-                    }
-                    if (name.empty()) name = id;
-                    try {
-                        if (!IsSkipped(id, available)) { g_packages.emplace_back(id, name); seenIds.insert(id); }
-                        else { /* skipped */ }
-                    } catch(...) { g_packages.emplace_back(id, name); seenIds.insert(id); }
-                }
-                break;
-            }
-        }
-    }
-    }
-
 static void PopulateListView(HWND hList) {
+    SkipBatch skipBatch;  // auto-unskips below are written to the INI once
     // Ensure any parsed-but-skipped packages are removed before inserting into the ListView
     try {
         AppendLog(std::string("RemoveSkippedFromPackages: start, count=") + std::to_string(g_packages.size()) + "\n");
@@ -1504,7 +882,7 @@ static void PopulateListView(HWND hList) {
                 }
                 if (IsSkipped(p.first, avail)) {
                     skip = true;
-                    try { AppendLog(std::string("RemoveSkippedFromPackages: skipping ") + p.first + " avail='" + avail + "' name='" + p.second + "'\n"); } catch(...) {}
+                    LOG_TRACE("RemoveSkippedFromPackages: skipping " << p.first << " avail='" << avail << "' name='" << p.second << "'");
                 }
             } catch(...) {}
             if (!skip) kept.push_back(p);
@@ -1526,34 +904,13 @@ static void PopulateListView(HWND hList) {
         }
     }
     ListView_DeleteAllItems(hList);
-    LVITEMW lvi{};
-    lvi.mask = LVIF_TEXT | LVIF_PARAM;
-    // Keep persistent buffers for item texts so ListView receives stable pointers
-    static std::vector<std::wstring> itemNameBuf;
-    static std::vector<std::wstring> itemCurBuf;
-    static std::vector<std::wstring> itemAvailBuf;
-    static std::vector<std::wstring> itemSkipBuf;
-    static std::vector<std::wstring> itemExcludeBuf;
-    itemNameBuf.clear(); itemCurBuf.clear(); itemAvailBuf.clear(); itemSkipBuf.clear(); itemExcludeBuf.clear();
-    itemNameBuf.resize(g_packages.size()); itemCurBuf.resize(g_packages.size()); itemAvailBuf.resize(g_packages.size()); itemSkipBuf.resize(g_packages.size()); itemExcludeBuf.resize(g_packages.size());
+    g_itemNameBuf.clear(); g_itemCurBuf.clear(); g_itemAvailBuf.clear(); g_itemSkipBuf.clear(); g_itemExcludeBuf.clear();
     // prepare maps for versions (prefer cached probes to avoid blocking UI twice)
     auto avail = GetAvailableVersionsCached();
     auto inst = GetInstalledVersionsCached();
     for (int i = 0; i < (int)g_packages.size(); ++i) {
         std::string name = g_packages[i].second;
         std::string id = g_packages[i].first;
-        std::wstring wname = Utf8ToWide(name);
-        std::wstring wid = Utf8ToWide(id);
-        // store into persistent buffers to ensure pointers remain valid
-        itemNameBuf[i] = wname;
-        lvi.iItem = i;
-        lvi.iSubItem = 0;
-        lvi.pszText = (LPWSTR)itemNameBuf[i].c_str();
-        lvi.lParam = i;
-        SendMessageW(hList, LVM_INSERTITEMW, 0, (LPARAM)&lvi);
-        // Current version (subitem 1)
-        LVITEMW lviCur{}; lviCur.mask = LVIF_TEXT; lviCur.iItem = i; lviCur.iSubItem = 1;
-        std::wstring wcur = L"";
         // resolve installed/available version robustly with normalization
         auto normalize = [&](const std::string &s)->std::string{
             std::string out;
@@ -1586,33 +943,7 @@ static void PopulateListView(HWND hList) {
             }
             return std::string();
         };
-        std::string curv = resolveVersion(inst);
-        if (!curv.empty()) wcur = Utf8ToWide(curv);
-        itemCurBuf[i] = wcur;
-        lviCur.pszText = (LPWSTR)itemCurBuf[i].c_str();
-        SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviCur);
-        // Available version (subitem 2)
-        LVITEMW lviAvail{}; lviAvail.mask = LVIF_TEXT; lviAvail.iItem = i; lviAvail.iSubItem = 2;
-        std::wstring wavail = L"";
-        std::string availv = resolveVersion(avail);
-        if (!availv.empty()) wavail = Utf8ToWide(availv);
-        itemAvailBuf[i] = wavail;
-        lviAvail.pszText = (LPWSTR)itemAvailBuf[i].c_str();
-        SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviAvail);
-        // Skip column (subitem 3): always show localized Skip label (clickable hyperlink)
-        LVITEMW lviSkip{}; lviSkip.mask = LVIF_TEXT; lviSkip.iItem = i; lviSkip.iSubItem = 3;
-        std::wstring skipText = L"";
-        // Always display the Skip label so the hyperlink can be shown; actual skip state is stored separately
-        skipText = t("skip_col");
-        itemSkipBuf[i] = skipText;
-        lviSkip.pszText = (LPWSTR)itemSkipBuf[i].c_str();
-        SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviSkip);
-        // Exclude column (subitem 4): always show localized Exclude label (clickable hyperlink)
-        LVITEMW lviExclude{}; lviExclude.mask = LVIF_TEXT; lviExclude.iItem = i; lviExclude.iSubItem = 4;
-        std::wstring excludeText = t("exclude_col");
-        itemExcludeBuf[i] = excludeText;
-        lviExclude.pszText = (LPWSTR)itemExcludeBuf[i].c_str();
-        SendMessageW(hList, LVM_SETITEMW, 0, (LPARAM)&lviExclude);
+        InsertListViewRow(hList, i, name, resolveVersion(inst), resolveVersion(avail));
     }
 }
 
@@ -1683,62 +1014,6 @@ static bool IsItemNotApplicable(int index) {
     return g_not_applicable_ids.find(id) != g_not_applicable_ids.end();
 }
 
-// Parse the standard `winget upgrade` table which has columns: Name | Id | Version | Available
-// Add entries where Available > Version.
-static void ParseWingetUpgradeTableForUpdates(const std::string &text, std::set<std::pair<std::string,std::string>> &outSet) {
-    std::istringstream iss(text);
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(iss, line)) {
-        while (!line.empty() && (line.back()=='\r' || line.back()=='\n')) line.pop_back();
-        lines.push_back(line);
-    }
-    if (lines.empty()) return;
-
-    int headerIdx = -1, sepIdx = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (lines[i].find("----") != std::string::npos) { sepIdx = i; break; }
-    }
-    if (sepIdx <= 0) return;
-    headerIdx = sepIdx - 1;
-    std::string header = lines[headerIdx];
-
-    auto trim = [](std::string s){ while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); return s; };
-    std::vector<std::string> colNames = {"Name","Id","Version","Available"};
-    std::vector<int> colStarts;
-    for (auto &cn : colNames) {
-        size_t p = header.find(cn);
-        if (p != std::string::npos) colStarts.push_back((int)p);
-    }
-    if (colStarts.size() < 3) return;
-
-    for (int i = sepIdx + 1; i < (int)lines.size(); ++i) {
-        const std::string &ln = lines[i];
-        if (trim(ln).empty()) continue;
-        // stop on summary line
-        if (ln.find("upgrades available") != std::string::npos) break;
-        int ncols = (int)colStarts.size();
-        auto substrSafe = [&](const std::string &s, int a, int b)->std::string{
-            int len = (int)s.size();
-            if (a >= len) return std::string();
-            int end = std::min(len, b);
-            return s.substr(a, end - a);
-        };
-        std::vector<std::string> fields(ncols);
-        for (int c = 0; c < ncols; ++c) {
-            int a = colStarts[c];
-            int b = (c+1 < ncols) ? colStarts[c+1] : (int)ln.size();
-            fields[c] = trim(substrSafe(ln, a, b));
-        }
-        std::string name = fields[0];
-        std::string id = (ncols > 1) ? fields[1] : std::string();
-        std::string installed = (ncols > 2) ? fields[2] : std::string();
-        std::string available = (ncols > 3) ? fields[3] : std::string();
-        if (id.empty()) continue;
-        if (CompareVersions(installed, available) < 0) outSet.emplace(id, name.empty()?id:name);
-    }
-}
-
 // Dump parsed packages and current ListView items to a temp file for debugging
 static std::wstring DumpPackagesAndListViewToTemp(HWND hList) {
     wchar_t curDir[MAX_PATH];
@@ -1814,113 +1089,28 @@ static void CheckAllItems(HWND hList, bool check) {
     }
 }
 
-// Parse raw winget upgrade output, update startup/live version maps and write logfile.
-static void CaptureStartupVersions(const std::string &rawOut,
-                                   const std::vector<std::pair<std::string,std::string>> &results,
-                                   const std::unordered_map<std::string,std::string> &avail,
-                                   const std::unordered_map<std::string,std::string> &inst,
-                                   bool forceOverwrite = false) {
+// Update startup/live version maps from the refresh snapshot.
+static void CaptureStartupVersions(const ScanSnapshot &snap, bool forceOverwrite = false) {
     try {
-        std::vector<std::tuple<std::string,std::string,std::string,std::string>> parsedRows;
-        std::string localRaw = rawOut;
-        // prefer existing raw file if present
-        try {
-            std::string fileTxt = ReadFileUtf8(std::wstring(L"logs\\wup_winget_raw.txt"));
-            if (!fileTxt.empty()) localRaw = fileTxt;
-        } catch(...) {}
-        if (localRaw.empty()) {
-            try {
-                auto fresh = RunProcessCaptureExitCode(L"winget upgrade --accept-source-agreements", 90000);
-                if (!fresh.second.empty()) localRaw = fresh.second;
-            } catch(...) {}
-        }
-        // Right-to-left token parsing (robust against variable name widths)
-        if (!localRaw.empty()) {
-            std::istringstream ois(localRaw);
-            std::string line;
-            std::vector<std::string> allLines;
-            while (std::getline(ois, line)) allLines.push_back(line);
-            size_t startIdx = (allLines.size() > 2) ? 2 : 0;
-            for (size_t i = startIdx; i < allLines.size(); ++i) {
-                std::string row = allLines[i];
-                auto trimRow = [](std::string &s){ while(!s.empty() && (s.back()=='\r' || s.back()=='\n')) s.pop_back(); while(!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin()); while(!s.empty() && isspace((unsigned char)s.back())) s.pop_back(); };
-                trimRow(row);
-                if (row.empty()) continue;
-                if (row.find("----") != std::string::npos) continue;
-                if (row.find("upgrades available") != std::string::npos) break;
-                std::istringstream ls(row);
-                std::vector<std::string> toks;
-                std::string tok;
-                while (ls >> tok) toks.push_back(tok);
-                if (toks.size() < 4) continue;
-                std::string source = toks.back(); toks.pop_back();
-                std::string available = toks.back(); toks.pop_back();
-                std::string installed = toks.back(); toks.pop_back();
-                std::string id = toks.back(); toks.pop_back();
-                std::string name;
-                for (size_t k = 0; k < toks.size(); ++k) { if (k) name += " "; name += toks[k]; }
-                if (name.empty()) name = id;
-                parsedRows.emplace_back(name, id, installed, available);
-            }
-        }
-
         // If parsed rows found, update startup maps and live caches
-        if (!parsedRows.empty()) {
+        if (!snap.rows.empty()) {
             try {
                 std::lock_guard<std::mutex> lk(g_startup_versions_mutex);
                 if (forceOverwrite || g_startup_avail_versions.empty() && g_startup_inst_versions.empty()) {
-                    for (auto &t : parsedRows) {
-                        const std::string &id = std::get<1>(t);
-                        const std::string &installed = std::get<2>(t);
-                        const std::string &available = std::get<3>(t);
-                        g_startup_inst_versions[id] = installed;
-                        g_startup_avail_versions[id] = available;
+                    for (auto &r : snap.rows) {
+                        g_startup_inst_versions[r.id] = r.installed;
+                        g_startup_avail_versions[r.id] = r.available;
                     }
                 }
             } catch(...) {}
             try {
                 std::lock_guard<std::mutex> vlk(g_versions_mutex);
-                for (auto &t : parsedRows) {
-                    const std::string &id = std::get<1>(t);
-                    const std::string &installed = std::get<2>(t);
-                    const std::string &available = std::get<3>(t);
-                    if (!installed.empty()) g_last_inst_versions[id] = installed;
-                    if (!available.empty()) g_last_avail_versions[id] = available;
-                }
-            } catch(...) {}
-        } else {
-            // fallback: use avail/inst maps and discovered results
-            try {
-                std::lock_guard<std::mutex> lk(g_startup_versions_mutex);
-                std::unordered_set<std::string> candidateIds;
-                for (auto &p : results) candidateIds.insert(p.first);
-                if (candidateIds.empty()) {
-                    for (auto &a : avail) {
-                        const std::string &id = a.first;
-                        auto itInst = inst.find(id);
-                        if (itInst == inst.end()) continue;
-                        try {
-                            if (CompareVersions(itInst->second, a.second) < 0) candidateIds.insert(id);
-                        } catch(...) {
-                            if (itInst->second != a.second) candidateIds.insert(id);
-                        }
-                    }
-                }
-                for (auto &id : candidateIds) {
-                    auto ait = avail.find(id);
-                    if (ait != avail.end()) g_startup_avail_versions[id] = ait->second;
-                    auto iit = inst.find(id);
-                    if (iit != inst.end()) g_startup_inst_versions[id] = iit->second;
-                    // also update live caches
-                    try {
-                        std::lock_guard<std::mutex> vlk(g_versions_mutex);
-                        if (iit != inst.end() && !iit->second.empty()) g_last_inst_versions[id] = iit->second;
-                        if (ait != avail.end() && !ait->second.empty()) g_last_avail_versions[id] = ait->second;
-                    } catch(...) {}
+                for (auto &r : snap.rows) {
+                    if (!r.installed.empty()) g_last_inst_versions[r.id] = r.installed;
+                    if (!r.available.empty()) g_last_avail_versions[r.id] = r.available;
                 }
             } catch(...) {}
         }
-
         // No logfile output requested: keep parsed startup data in memory only.
     } catch(...) {}
 }
@@ -1933,9 +1123,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     
     // Debug: Log if we receive message 1025 (WM_TRAYICON)
     if (uMsg == 1025) {
-        std::ofstream log("C:\\Users\\NalleBerg\\AppData\\Roaming\\WinUpdate\\tray_debug.txt", std::ios::app);
-        log << "WndProc received uMsg=1025 (WM_TRAYICON), wParam=" << wParam << ", lParam=0x" << std::hex << lParam << std::dec << "\n";
-        log.close();
+        TRAY_LOG(LogLevel::Trace, "WndProc received uMsg=1025 (WM_TRAYICON), wParam=" << wParam << ", lParam=0x"
+                                  << std::hex << lParam << std::dec);
     }
     
     static HWND hRadioShow, hRadioAll, hBtnRefresh, hList, hCheckAll, hBtnUpgrade;
@@ -2150,6 +1339,15 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
         if (hBtnRefresh) EnableWindow(hBtnRefresh, FALSE);
         if (hBtnUpgrade) EnableWindow(hBtnUpgrade, FALSE);
         ShowLoading(hwnd);
+        // Rows streamed by this refresh (WM_REFRESH_ROW) start from an empty list,
+        // not behind the previous refresh's packages
+        if (!g_install_block_destroy.load()) {
+            {
+                std::lock_guard<std::mutex> lk(g_packages_mutex);
+                g_packages.clear();
+            }
+            if (hList) ListView_DeleteAllItems(hList);
+        }
         
         // Update tray tooltip to show scanning status
         if (g_systemTray && g_systemTray->IsActive()) {
@@ -2159,20 +1357,23 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
         std::thread([hwnd, manual]() {
             std::vector<std::pair<std::string,std::string>> results;
 
-            // Run winget upgrade with increased timeout to ensure complete output capture
-            // Winget can take 50-60+ seconds when checking msstore source with agreements
-            // Using 90s/110s timeouts for background reliability
-            auto rup = RunProcessCaptureExitCode(L"winget upgrade --accept-source-agreements", 90000);
-            std::string out = rup.second;
-            bool timedOut = (rup.first == -2);
-            // If initial attempt timed out or returned empty, try once more with extended timeout
-            if (timedOut || out.empty()) {
-                auto rup2 = RunProcessCaptureExitCode(L"winget upgrade --accept-source-agreements", 110000);
-                if (!rup2.second.empty()) {
-                    out = rup2.second;
-                    timedOut = false;
+            // Parse the table while winget is still printing it and post every
+            // complete row to the UI; WM_REFRESH_DONE rebuilds the final list.
+            // Winget can take 50-60+ seconds when checking msstore source with
+            // agreements, so the first run gets 90s and the one retry 110s.
+            ULONGLONG scanStart = GetTickCount64();
+            bool firstRowLogged = false;
+            ScanSnapshot snap;
+            RefreshScanSnapshot(snap, [&](const ScanRow &r) {
+                if (!firstRowLogged) {
+                    firstRowLogged = true;
+                    try { AppendLog(std::string("WM_REFRESH_ASYNC: first row after ") + std::to_string((unsigned long long)(GetTickCount64() - scanStart)) + " ms\n"); } catch(...) {}
                 }
-            }
+                ScanRow *row = new ScanRow(r);
+                if (!PostMessageW(hwnd, WM_REFRESH_ROW, 0, (LPARAM)row)) delete row;
+            }, 90000, 110000);
+            const std::string &out = snap.raw;
+            try { AppendLog(std::string("WM_REFRESH_ASYNC: winget finished after ") + std::to_string((unsigned long long)(GetTickCount64() - scanStart)) + " ms\n"); } catch(...) {}
             
             // Store output in memory for AppendSkippedRaw to use
             if (!out.empty()) {
@@ -2204,36 +1405,27 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                     AppendLog(std::string("Total winget packages detected: ") + std::to_string(count) + "\n");
                 }
             }
-            if (!out.empty()) {
-                // Prefer the in-memory parser chain to extract Id/Name pairs
-                auto vec = ParseRawWingetTextInMemory(out);
-                std::set<std::pair<std::string,std::string>> found;
-                for (auto &p : vec) found.emplace(p.first, p.second);
-                for (auto &p : found) results.emplace_back(p.first, p.second);
+            // One `winget upgrade` run feeds everything: the candidate list, both
+            // version maps and the startup capture all read from this snapshot,
+            // which RefreshScanSnapshot has already published.
+            if (!snap.empty()) {
+                SkipBatch skipBatch;  // auto-unskips below are written to the INI once
+                results = snap.Candidates([](const ScanRow &r) {
+                    try { return !IsSkipped(r.id, r.availableVersion); } catch(...) { return true; }
+                });
             }
 
-            // Start background population of available/installed versions without blocking the initial scan.
             try {
-                // Run probes in parallel with per-call wait limits to reduce wall time
-                auto futAvail = std::async(std::launch::async, MapAvailableVersions);
-                auto futInst = std::async(std::launch::async, MapInstalledVersions);
-                std::unordered_map<std::string,std::string> avail;
-                std::unordered_map<std::string,std::string> inst;
-                auto perCallTimeout = std::chrono::milliseconds(5200);
-                if (futAvail.wait_for(perCallTimeout) == std::future_status::ready) {
-                    try { avail = futAvail.get(); } catch(...) {}
-                }
-                if (futInst.wait_for(perCallTimeout) == std::future_status::ready) {
-                    try { inst = futInst.get(); } catch(...) {}
-                }
+                auto avail = snap.AvailableMap();
+                auto inst = snap.InstalledMap();
                 {
                     std::lock_guard<std::mutex> lk(g_versions_mutex);
                     if (!avail.empty()) g_last_avail_versions = avail;
                     if (!inst.empty()) g_last_inst_versions = inst;
                 }
-                // Also capture a startup snapshot (write to logs for verification)
+                // Also capture a startup snapshot
                 try {
-                    CaptureStartupVersions(out, results, avail, inst, false);
+                    CaptureStartupVersions(snap, false);
                 } catch(...) {}
             } catch(...) {}
 
@@ -2245,6 +1437,44 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
         }).detach();
         break;
     }
+    case WM_REFRESH_ROW: {
+        // One upgrade row parsed while winget is still running. Show it right away;
+        // WM_REFRESH_DONE replaces the list with the complete result afterwards.
+        ScanRow *row = (ScanRow*)lParam;
+        if (!row) break;
+        if (g_refresh_in_progress.load() && !g_install_block_destroy.load() && hList) {
+            WaitForSingleObject(g_excluded_mutex, INFINITE);
+            bool excluded = (g_excluded_apps.find(row->id) != g_excluded_apps.end());
+            ReleaseMutex(g_excluded_mutex);
+            bool skipped = false;
+            try { skipped = IsSkipped(row->id, row->availableVersion); } catch(...) { skipped = false; }
+            if (!excluded && !skipped) {
+                {
+                    std::lock_guard<std::mutex> lk(g_versions_mutex);
+                    g_last_avail_versions[row->id] = row->available;
+                    g_last_inst_versions[row->id] = row->installed;
+                }
+                int index = -1;
+                {
+                    std::lock_guard<std::mutex> lk(g_packages_mutex);
+                    bool present = false;
+                    for (auto &p : g_packages) if (p.first == row->id) { present = true; break; }
+                    if (!present) { g_packages.emplace_back(row->id, row->name); index = (int)g_packages.size() - 1; }
+                }
+                if (index >= 0) {
+                    // Append just this row; rebuilding the whole list per row is O(n^2)
+                    InsertListViewRow(hList, index, row->name, row->installed, row->available);
+                    if (index == 0) {
+                        HideLoading();
+                        AdjustListColumns(hList);
+                        ShowWindow(hList, SW_SHOW);
+                    }
+                }
+            }
+        }
+        delete row;
+        break;
+    }
     case WM_REFRESH_DONE: {
         std::vector<std::pair<std::string,std::string>> *pv = (std::vector<std::pair<std::string,std::string>>*)lParam;
         if (pv) {
@@ -2424,14 +1654,24 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                 int foundIdx = -1;
                 // If g_packages is empty (UI may not have populated it yet), try to repopulate
                 try {
-                    std::lock_guard<std::mutex> lkchk(g_packages_mutex);
-                    if (g_packages.empty()) {
+                    bool empty;
+                    {
+                        std::lock_guard<std::mutex> lkchk(g_packages_mutex);
+                        empty = g_packages.empty();
+                    }
+                    // ParseWingetTextForPackages takes g_packages_mutex itself
+                    if (empty) {
                         AppendLog(std::string("WM_COPYDATA: g_packages empty, attempting to repopulate from recent raw winget\n"));
                         try {
                             std::string raw = ReadMostRecentRawWinget();
                             if (!raw.empty()) {
                                 ParseWingetTextForPackages(raw);
-                                AppendLog(std::string("WM_COPYDATA: ParseWingetTextForPackages populated g_packages size=") + std::to_string((int)g_packages.size()) + "\n");
+                                size_t count;
+                                {
+                                    std::lock_guard<std::mutex> lkchk(g_packages_mutex);
+                                    count = g_packages.size();
+                                }
+                                AppendLog(std::string("WM_COPYDATA: ParseWingetTextForPackages populated g_packages size=") + std::to_string((int)count) + "\n");
                             } else {
                                 AppendLog("WM_COPYDATA: ReadMostRecentRawWinget returned empty\n");
                             }
@@ -2732,7 +1972,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                         } else {
                             // determine available version for this id and add to skip config, confirm
                             try {
-                                auto avail = MapAvailableVersions();
+                                auto avail = GetAvailableVersionsCached();
                                 std::string ver = "";
                                 auto f = avail.find(id);
                                 if (f != avail.end()) ver = f->second;
@@ -3079,6 +2319,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                     }
                 }
                 // Terminate current process so the fresh instance can continue.
+                // ExitProcess skips atexit, so push queued log lines out first.
+                LogFlush();
                 ExitProcess(0);
             }
 
@@ -3409,6 +2651,17 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     LPWSTR cmdLineW = GetCommandLineW();
     // If invoked with --debug-parse, run winget (text) and print parsed entries to console then exit
     std::wstring cmdLine(cmdLineW ? cmdLineW : L"");
+    // --log-level=<error|warn|info|debug|trace>: runtime log level (default info)
+    {
+        size_t lp = cmdLine.find(L"--log-level=");
+        if (lp != std::wstring::npos) {
+            size_t vb = lp + wcslen(L"--log-level=");
+            size_t ve = cmdLine.find_first_of(L" \t\"", vb);
+            std::wstring w = cmdLine.substr(vb, ve == std::wstring::npos ? std::wstring::npos : ve - vb);
+            LogLevel lvl;
+            if (ParseLogLevel(std::string(w.begin(), w.end()), lvl)) SetLogLevel(lvl);
+        }
+    }
     if (cmdLine.find(L"--debug-parse") != std::wstring::npos) {
         // create a console to print results
         AllocConsole();
@@ -3452,7 +2705,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                             std::string id = m3[2].str();
                             std::string installed = m3[3].str();
                             std::string available = m3[4].str();
-                            try { if (CompareVersions(installed, available) < 0) localNA2.insert(id); } catch(...) {}
+                            try { if (Version(installed) < Version(available)) localNA2.insert(id); } catch(...) {}
                         }
                     }
                     if (!localNA2.empty()) {
@@ -3477,7 +2730,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                             std::string id = m2[2].str();
                             std::string installed = m2[3].str();
                             std::string available = m2[4].str();
-                            try { if (CompareVersions(installed, available) < 0) localNA.insert(id); } catch(...) {}
+                            try { if (Version(installed) < Version(available)) localNA.insert(id); } catch(...) {}
                         }
                     }
                     if (!localNA.empty()) {
@@ -3500,7 +2753,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                         std::string id = mm[2].str();
                         std::string installed = mm[3].str();
                         std::string available = mm[4].str();
-                        try { if (CompareVersions(installed, available) < 0) candidateIds.insert(id); } catch(...) {}
+                        try { if (Version(installed) < Version(available)) candidateIds.insert(id); } catch(...) {}
                     }
                 }
             }
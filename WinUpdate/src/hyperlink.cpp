@@ -361,7 +361,7 @@ static LRESULT CALLBACK Hyperlink_ListSubclassProc(HWND hwnd, UINT uMsg, WPARAM
                 std::wstring appname = buf[0] ? std::wstring(buf) : std::wstring();
                 std::wstring final = FormatTooltipTemplate(wtmpl, appname);
                 g_tooltip_texts[hwnd] = final;
-                AppendLog("[hyperlink] Updating custom tooltip text and showing\n");
+                LOG_DEBUG("[hyperlink] Updating custom tooltip text and showing");
                 HWND tip = EnsureTooltipForList(hwnd);
                 if (tip && IsWindow(tip)) {
                     // set text and size
@@ -393,14 +393,14 @@ static LRESULT CALLBACK Hyperlink_ListSubclassProc(HWND hwnd, UINT uMsg, WPARAM
                     // Do not force topmost; position above other windows but don't steal z-order
                     SetWindowPos(tip, HWND_TOP, tipX, tipY, w, h, SWP_NOACTIVATE | SWP_SHOWWINDOW);
                     InvalidateRect(tip, NULL, TRUE);
-                    AppendLog("[hyperlink] custom tooltip shown\n");
+                    LOG_DEBUG("[hyperlink] custom tooltip shown");
                 }
             }
             } else {
             // hide custom tooltip if present
             auto it = g_tooltips.find(hwnd);
             if (it != g_tooltips.end() && IsWindow(it->second)) {
-                AppendLog("[hyperlink] Hiding custom tooltip\n");
+                LOG_DEBUG("[hyperlink] Hiding custom tooltip");
                 ShowWindow(it->second, SW_HIDE);
             }
         }
@@ -409,7 +409,7 @@ static LRESULT CALLBACK Hyperlink_ListSubclassProc(HWND hwnd, UINT uMsg, WPARAM
     case WM_MOUSELEAVE: {
         auto it = g_tooltips.find(hwnd);
         if (it != g_tooltips.end() && IsWindow(it->second)) {
-            AppendLog("[hyperlink] WM_MOUSELEAVE - hiding custom tooltip\n");
+            LOG_DEBUG("[hyperlink] WM_MOUSELEAVE - hiding custom tooltip");
             ShowWindow(it->second, SW_HIDE);
         }
         break;
@@ -418,7 +418,7 @@ static LRESULT CALLBACK Hyperlink_ListSubclassProc(HWND hwnd, UINT uMsg, WPARAM
     case WM_CAPTURECHANGED: {
         auto it = g_tooltips.find(hwnd);
         if (it != g_tooltips.end() && IsWindow(it->second)) {
-            AppendLog("[hyperlink] focus/capture lost - hiding custom tooltip\n");
+            LOG_DEBUG("[hyperlink] focus/capture lost - hiding custom tooltip");
             ShowWindow(it->second, SW_HIDE);
         }
         break;
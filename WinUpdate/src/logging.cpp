@@ -1,16 +1,273 @@
 #include "logging.h"
-#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#include <shlobj.h>
+#endif
 
-std::atomic<bool> g_enable_logging{true};
+std::atomic<int> g_log_level{(int)LogLevel::Info};
 std::atomic<bool> g_restart_on_continue{true};
 
-void AppendLog(const std::string &s) {
-    if (!g_enable_logging.load()) return;
+namespace {
+
+// Ring capacity (power of two). Producers drop lines rather than block once
+// it is full; the drop count is reported in the run log.
+constexpr size_t kRingSize = 8192;
+constexpr size_t kRingMask = kRingSize - 1;
+// Writer wakes at least this often; producers also wake it when the ring is
+// half full.
+constexpr auto kFlushInterval = std::chrono::milliseconds(50);
+constexpr int kChannelCount = 3;
+
+enum class SlotKind : unsigned char { Line, Rotate };
+
+// Bounded MPSC queue (Vyukov): each slot carries a sequence number that tells
+// producers and the single consumer whose turn it is.
+struct LogSlot {
+    std::atomic<size_t> seq{0};
+    SlotKind kind = SlotKind::Line;
+    LogChannel chan = LogChannel::Run;
+    std::string text;
+};
+
+struct ChannelFile {
+    std::filesystem::path path;
+    uintmax_t maxBytes = 0;
+    FILE *fp = nullptr;
+    uintmax_t size = 0;
+    bool dirty = false;
+};
+
+class AsyncLogger {
+public:
+    AsyncLogger() {
+        for (size_t i = 0; i < kRingSize; ++i) ring_[i].seq.store(i, std::memory_order_relaxed);
+        files_[(int)LogChannel::Run].path = std::filesystem::path("logs") / "wup_run_log.txt";
+        files_[(int)LogChannel::Run].maxBytes = 8u * 1024 * 1024;
+        std::filesystem::path appDir = AppDataDir();
+        files_[(int)LogChannel::HiddenScan].path = appDir / "hidden_scan_debug.txt";
+        files_[(int)LogChannel::HiddenScan].maxBytes = 2u * 1024 * 1024;
+        files_[(int)LogChannel::Tray].path = appDir / "tray_debug.txt";
+        files_[(int)LogChannel::Tray].maxBytes = 1u * 1024 * 1024;
+        worker_ = std::thread([this]{ Run(); });
+        std::atexit([]{ Instance().Shutdown(); });
+    }
+
+    // Never destroyed: the atexit hook above joins the writer, and a static
+    // destructor would run before it and find the thread still joinable.
+    static AsyncLogger &Instance() {
+        static AsyncLogger *logger = new AsyncLogger();
+        return *logger;
+    }
+
+    bool Push(SlotKind kind, LogChannel chan, std::string &&text) {
+        if (stopped_.load(std::memory_order_acquire)) return false;
+        size_t pos = head_.load(std::memory_order_relaxed);
+        LogSlot *slot = nullptr;
+        for (int spins = 0;;) {
+            slot = &ring_[pos & kRingMask];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                // Full: give the writer a moment, then drop.
+                if (++spins > 4096) { dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+                wake_.notify_one();
+                std::this_thread::yield();
+                pos = head_.load(std::memory_order_relaxed);
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->kind = kind;
+        slot->chan = chan;
+        slot->text = std::move(text);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        if (pos - written_.load(std::memory_order_relaxed) >= kRingSize / 2) wake_.notify_one();
+        return true;
+    }
+
+    void Flush() {
+        size_t target = head_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lk(mtx_);
+        flushRequested_ = true;
+        wake_.notify_one();
+        // Bounded so a wedged disk cannot hang the UI thread.
+        flushed_.wait_for(lk, std::chrono::seconds(2), [&]{
+            return written_.load(std::memory_order_acquire) >= target || stopped_.load();
+        });
+    }
+
+    void Shutdown() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (stopped_.exchange(true)) return;
+        }
+        wake_.notify_one();
+        if (worker_.joinable()) worker_.join();
+    }
+
+private:
+    static std::filesystem::path AppDataDir() {
+#ifdef _WIN32
+        wchar_t appData[MAX_PATH];
+        if (SUCCEEDED(SHGetFolderPathW(NULL, CSIDL_APPDATA, NULL, 0, appData))) {
+            return std::filesystem::path(appData) / L"WinUpdate";
+        }
+#endif
+        return std::filesystem::path(".");
+    }
+
+    // Consumer side: only the writer thread calls these.
+    bool Pop(LogSlot &out) {
+        LogSlot &slot = ring_[tail_ & kRingMask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != tail_ + 1) return false;
+        out.kind = slot.kind;
+        out.chan = slot.chan;
+        out.text = std::move(slot.text);
+        slot.text.clear();
+        slot.seq.store(tail_ + kRingSize, std::memory_order_release);
+        ++tail_;
+        return true;
+    }
+
+    bool Open(ChannelFile &f) {
+        if (f.fp) return true;
+        std::error_code ec;
+        if (f.path.has_parent_path()) std::filesystem::create_directories(f.path.parent_path(), ec);
+#ifdef _WIN32
+        f.fp = _wfopen(f.path.c_str(), L"ab");
+#else
+        f.fp = std::fopen(f.path.c_str(), "ab");
+#endif
+        if (!f.fp) return false;
+        uintmax_t sz = std::filesystem::file_size(f.path, ec);
+        f.size = ec ? 0 : sz;
+        return true;
+    }
+
+    void Rotate(ChannelFile &f) {
+        if (f.fp) { std::fclose(f.fp); f.fp = nullptr; }
+        std::error_code ec;
+        if (!std::filesystem::exists(f.path, ec)) return;
+        std::filesystem::path backup = f.path;
+        backup += ".1";
+        std::filesystem::remove(backup, ec);
+        std::filesystem::rename(f.path, backup, ec);
+        f.size = 0;
+    }
+
+    void Write(ChannelFile &f, const std::string &text) {
+        if (f.size >= f.maxBytes) Rotate(f);
+        if (!Open(f)) return;
+        size_t n = std::fwrite(text.data(), 1, text.size(), f.fp);
+        f.size += n;
+        f.dirty = true;
+    }
+
+    void DrainOnce() {
+        LogSlot item;
+        bool any = false;
+        while (Pop(item)) {
+            ChannelFile &f = files_[(int)item.chan];
+            if (item.kind == SlotKind::Rotate) Rotate(f);
+            else Write(f, item.text);
+            any = true;
+        }
+        size_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped) {
+            Write(files_[(int)LogChannel::Run], "AsyncLogger: dropped " + std::to_string(dropped) + " lines (queue full)\n");
+            any = true;
+        }
+        if (any) {
+            for (auto &f : files_) if (f.dirty && f.fp) { std::fflush(f.fp); f.dirty = false; }
+        }
+        written_.store(tail_, std::memory_order_release);
+    }
+
+    void Run() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(mtx_);
+                wake_.wait_for(lk, kFlushInterval, [&]{
+                    return flushRequested_ || stopped_.load() || head_.load(std::memory_order_relaxed) - tail_ >= kRingSize / 2;
+                });
+                flushRequested_ = false;
+            }
+            DrainOnce();
+            { std::lock_guard<std::mutex> lk(mtx_); }  // no lost wakeup for Flush()
+            flushed_.notify_all();
+            if (stopped_.load(std::memory_order_acquire)) {
+                DrainOnce();  // producers that raced the stop flag
+                break;
+            }
+        }
+        for (auto &f : files_) if (f.fp) { std::fclose(f.fp); f.fp = nullptr; }
+        flushed_.notify_all();
+    }
+
+    LogSlot ring_[kRingSize];
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) size_t tail_ = 0;
+    std::atomic<size_t> written_{0};
+    std::atomic<size_t> dropped_{0};
+    std::atomic<bool> stopped_{false};
+    ChannelFile files_[kChannelCount];
+    std::mutex mtx_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    bool flushRequested_ = false;
+    std::thread worker_;
+};
+
+} // namespace
+
+void SetLogLevel(LogLevel lvl) {
+    g_log_level.store((int)lvl, std::memory_order_relaxed);
+}
+
+void SetLoggingEnabled(bool enabled) {
+    g_log_level.store(enabled ? (int)LogLevel::Info : -1, std::memory_order_relaxed);
+}
+
+bool ParseLogLevel(const std::string &name, LogLevel &out) {
+    static const struct { const char *name; LogLevel lvl; } kNames[] = {
+        {"error", LogLevel::Error}, {"warn", LogLevel::Warn}, {"info", LogLevel::Info},
+        {"debug", LogLevel::Debug}, {"trace", LogLevel::Trace},
+    };
+    for (const auto &n : kNames) {
+        if (name == n.name) { out = n.lvl; return true; }
+    }
+    return false;
+}
+
+void LogWrite(LogLevel lvl, LogChannel chan, std::string text) {
+    if (!LogEnabled(lvl)) return;
     try {
-        // ensure logs directory exists and write there so workspace can read logs reliably
-        try { std::filesystem::create_directories(std::filesystem::path("logs")); } catch(...) {}
-        std::ofstream ofs("logs/wup_run_log.txt", std::ios::app | std::ios::binary);
-        if (ofs) ofs << s;
+        if (text.empty() || text.back() != '\n') text.push_back('\n');
+        AsyncLogger::Instance().Push(SlotKind::Line, chan, std::move(text));
     } catch(...) {}
 }
+
+void LogRotate(LogChannel chan) {
+    try { AsyncLogger::Instance().Push(SlotKind::Rotate, chan, std::string()); } catch(...) {}
+}
+
+void LogFlush() {
+    try { AsyncLogger::Instance().Flush(); } catch(...) {}
+}
+
+void AppendLog(const std::string &s) {
+    if (!LogEnabled(LogLevel::Info)) return;
+    // Written verbatim: some callers build one line across several calls.
+    try { AsyncLogger::Instance().Push(SlotKind::Line, LogChannel::Run, std::string(s)); } catch(...) {}
+}
@@ -1,10 +1,67 @@
 #pragma once
 #include <string>
+#include <sstream>
 #include <atomic>
 
-// Enable/disable logging and restart behavior are exposed here.
-extern std::atomic<bool> g_enable_logging;
+// Log levels, most to least severe. A line is written when its level is at or
+// below both the compile-time ceiling and the runtime level.
+enum class LogLevel : int { Error = 0, Warn = 1, Info = 2, Debug = 3, Trace = 4 };
+
+// Destination files. Each channel rotates to "<file>.1" once it grows past its
+// size limit.
+enum class LogChannel : int {
+    Run = 0,         // logs/wup_run_log.txt
+    HiddenScan = 1,  // %APPDATA%\WinUpdate\hidden_scan_debug.txt
+    Tray = 2,        // %APPDATA%\WinUpdate\tray_debug.txt
+};
+
+// Compile-time ceiling: build with -DWUP_LOG_MAX_LEVEL=2 to drop Debug/Trace
+// call sites entirely.
+#ifndef WUP_LOG_MAX_LEVEL
+#define WUP_LOG_MAX_LEVEL 4
+#endif
+
+// Runtime level (as int); -1 when logging is disabled.
+extern std::atomic<int> g_log_level;
 extern std::atomic<bool> g_restart_on_continue;
 
-// Append text to the run log (no throw).
+inline bool LogEnabled(LogLevel lvl) {
+    return (int)lvl <= WUP_LOG_MAX_LEVEL && (int)lvl <= g_log_level.load(std::memory_order_relaxed);
+}
+
+void SetLogLevel(LogLevel lvl);
+void SetLoggingEnabled(bool enabled);
+// Accepts "error", "warn", "info", "debug" or "trace"; returns false otherwise.
+bool ParseLogLevel(const std::string &name, LogLevel &out);
+
+// Queue a line for the background writer (no throw, never blocks on disk).
+// A trailing newline is added when missing.
+void LogWrite(LogLevel lvl, LogChannel chan, std::string text);
+// Rotate a channel's file before the next line queued for it is written.
+void LogRotate(LogChannel chan);
+// Wait until every line queued so far is on disk.
+void LogFlush();
+
+// Append text to the run log at Info level (no throw).
 void AppendLog(const std::string &s);
+
+// Front end: the message is a stream expression, e.g.
+//   LOG_TRACE("IsSkipped: id='" << id << "'");
+// and is only evaluated when the level is enabled, so a disabled call site
+// costs a single branch.
+#define WUP_LOG(lvl, chan, expr) \
+    do { \
+        if (LogEnabled(lvl)) { \
+            try { std::ostringstream wup_log_os_; wup_log_os_ << expr; LogWrite((lvl), (chan), wup_log_os_.str()); } catch(...) {} \
+        } \
+    } while (0)
+
+#define LOG_ERROR(expr) WUP_LOG(LogLevel::Error, LogChannel::Run, expr)
+#define LOG_WARN(expr)  WUP_LOG(LogLevel::Warn,  LogChannel::Run, expr)
+#define LOG_INFO(expr)  WUP_LOG(LogLevel::Info,  LogChannel::Run, expr)
+#define LOG_DEBUG(expr) WUP_LOG(LogLevel::Debug, LogChannel::Run, expr)
+#define LOG_TRACE(expr) WUP_LOG(LogLevel::Trace, LogChannel::Run, expr)
+
+// Per-feature debug files.
+#define HIDDEN_LOG(lvl, expr) WUP_LOG(lvl, LogChannel::HiddenScan, expr)
+#define TRAY_LOG(lvl, expr)   WUP_LOG(lvl, LogChannel::Tray, expr)
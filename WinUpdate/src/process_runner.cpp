@@ -0,0 +1,281 @@
+#include "process_runner.h"
+#include <chrono>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <cwchar>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kPollMs = 50;
+const size_t kReadChunk = 16384;
+
+long long MsSince(Clock::time_point t0) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+}
+
+// State shared by both backends: output collection, timings and the
+// timeout/cancel/drain deadlines.
+struct RunState {
+    ProcessResult &res;
+    const ProcessOptions &opts;
+    Clock::time_point start = Clock::now();
+    Clock::time_point drainStart;
+    bool exited = false;      // process is gone (exited or killed)
+    int stopReason = 0;       // kProcessTimedOut / kProcessCancelled once killed
+
+    RunState(ProcessResult &r, const ProcessOptions &o) : res(r), opts(o) {}
+
+    void Deliver(const char *data, size_t n) {
+        if (n == 0) return;
+        if (res.firstByteMs < 0) res.firstByteMs = MsSince(start);
+        res.output.append(data, n);
+        if (opts.onChunk) opts.onChunk(data, n);
+    }
+    // Non-zero when the run must be stopped now.
+    int StopRequested() const {
+        if (opts.cancel && opts.cancel->load()) return kProcessCancelled;
+        if (opts.timeoutMs > 0 && MsSince(start) >= opts.timeoutMs) return kProcessTimedOut;
+        return 0;
+    }
+    void MarkExited() {
+        if (exited) return;
+        exited = true;
+        drainStart = Clock::now();
+    }
+    bool DrainExpired() const {
+        return exited && MsSince(drainStart) >= opts.drainAfterExitMs;
+    }
+};
+
+} // namespace
+
+#ifdef _WIN32
+
+static std::wstring Utf8ToWideRunner(const std::string &s) {
+    if (s.empty()) return std::wstring();
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), NULL, 0);
+    if (n <= 0) return std::wstring(s.begin(), s.end());
+    std::wstring out(n, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), &out[0], n);
+    return out;
+}
+
+ProcessResult RunProcess(const std::string &cmdUtf8, const ProcessOptions &opts) {
+    return RunProcess(Utf8ToWideRunner(cmdUtf8), opts);
+}
+
+ProcessResult RunProcess(const std::wstring &cmd, const ProcessOptions &opts) {
+    ProcessResult res;
+    RunState st(res, opts);
+
+    // Anonymous pipes cannot be read with OVERLAPPED, so use a uniquely named
+    // one-instance pipe: the read end is overlapped, the write end inherited.
+    static std::atomic<unsigned> s_pipeSerial{0};
+    wchar_t pipeName[96];
+    swprintf(pipeName, 96, L"\\\\.\\pipe\\WinUpdate.run.%lu.%u",
+             (unsigned long)GetCurrentProcessId(), s_pipeSerial.fetch_add(1));
+    HANDLE hRead = CreateNamedPipeW(pipeName, PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                    PIPE_TYPE_BYTE | PIPE_WAIT, 1, 0, 64 * 1024, 0, NULL);
+    if (hRead == INVALID_HANDLE_VALUE) return res;
+    SECURITY_ATTRIBUTES sa{}; sa.nLength = sizeof(sa); sa.bInheritHandle = TRUE; sa.lpSecurityDescriptor = NULL;
+    HANDLE hWrite = CreateFileW(pipeName, GENERIC_WRITE, 0, &sa, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hWrite == INVALID_HANDLE_VALUE) { CloseHandle(hRead); return res; }
+
+    // Everything the command starts lives in this job, so killing it (or
+    // closing it) also ends winget.exe when the command was "cmd /C winget ...".
+    HANDLE job = CreateJobObjectW(NULL, NULL);
+    if (job) {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION li{};
+        li.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+        SetInformationJobObject(job, JobObjectExtendedLimitInformation, &li, sizeof(li));
+    }
+
+    // Let the child inherit only its own pipe end. Without the handle list a
+    // process started concurrently from another thread would also inherit this
+    // write end and hold our pipe open until it exits.
+    SIZE_T attrSize = 0;
+    InitializeProcThreadAttributeList(NULL, 1, 0, &attrSize);
+    std::vector<char> attrBuf(attrSize);
+    LPPROC_THREAD_ATTRIBUTE_LIST attrs = attrSize ? (LPPROC_THREAD_ATTRIBUTE_LIST)attrBuf.data() : NULL;
+    bool haveHandleList = attrs && InitializeProcThreadAttributeList(attrs, 1, 0, &attrSize);
+    if (haveHandleList && !UpdateProcThreadAttribute(attrs, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, &hWrite, sizeof(hWrite), NULL, NULL)) {
+        DeleteProcThreadAttributeList(attrs);
+        haveHandleList = false;
+    }
+
+    STARTUPINFOEXW six{};
+    six.StartupInfo.cb = haveHandleList ? sizeof(six) : sizeof(STARTUPINFOW);
+    six.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+    six.StartupInfo.hStdOutput = hWrite;
+    six.StartupInfo.hStdError = hWrite;
+    six.StartupInfo.hStdInput = NULL;
+    six.lpAttributeList = haveHandleList ? attrs : NULL;
+    DWORD flags = CREATE_NO_WINDOW | CREATE_SUSPENDED | (haveHandleList ? EXTENDED_STARTUPINFO_PRESENT : 0);
+    PROCESS_INFORMATION pi{};
+    std::wstring cmdCopy = cmd;
+    BOOL ok = CreateProcessW(NULL, &cmdCopy[0], NULL, NULL, TRUE, flags, NULL, NULL, &six.StartupInfo, &pi);
+    if (haveHandleList) DeleteProcThreadAttributeList(attrs);
+    // close write end in parent regardless, so EOF arrives once the children close theirs
+    CloseHandle(hWrite);
+    if (!ok) {
+        CloseHandle(hRead);
+        if (job) CloseHandle(job);
+        return res;
+    }
+    if (job && !AssignProcessToJobObject(job, pi.hProcess)) { CloseHandle(job); job = NULL; }
+    ResumeThread(pi.hThread);
+
+    auto kill = [&](int reason) {
+        st.stopReason = reason;
+        if (job) TerminateJobObject(job, 1);
+        else TerminateProcess(pi.hProcess, 1);
+        st.MarkExited();
+    };
+
+    OVERLAPPED ov{};
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    char buf[kReadChunk];
+    bool pending = false;
+    while (ov.hEvent) {
+        if (!pending) {
+            DWORD n = 0;
+            ResetEvent(ov.hEvent);
+            if (ReadFile(hRead, buf, (DWORD)sizeof(buf), &n, &ov)) { st.Deliver(buf, n); continue; }
+            if (GetLastError() != ERROR_IO_PENDING) break;   // ERROR_BROKEN_PIPE: all writers gone
+            pending = true;
+        }
+        HANDLE waits[2] = { ov.hEvent, pi.hProcess };
+        DWORD w = WaitForMultipleObjects(st.exited ? 1 : 2, waits, FALSE, kPollMs);
+        if (w == WAIT_OBJECT_0) {
+            DWORD n = 0;
+            pending = false;
+            if (!GetOverlappedResult(hRead, &ov, &n, FALSE)) break;
+            st.Deliver(buf, n);
+            continue;
+        }
+        if (w == WAIT_OBJECT_0 + 1) st.MarkExited();
+        if (!st.exited) {
+            int reason = st.StopRequested();
+            if (reason) kill(reason);
+        } else if (st.DrainExpired()) {
+            break;
+        }
+    }
+    if (pending) {
+        DWORD n = 0;
+        CancelIoEx(hRead, &ov);
+        GetOverlappedResult(hRead, &ov, &n, TRUE);   // buf must outlive the read
+    }
+    if (ov.hEvent) CloseHandle(ov.hEvent);
+    CloseHandle(hRead);
+
+    // The output may close before the process exits; keep honouring the limits.
+    while (!st.stopReason && WaitForSingleObject(pi.hProcess, kPollMs) == WAIT_TIMEOUT) {
+        int reason = st.StopRequested();
+        if (reason) kill(reason);
+    }
+    if (st.stopReason) {
+        WaitForSingleObject(pi.hProcess, 5000);
+        res.exitCode = st.stopReason;
+    } else {
+        DWORD exitCode = 0;
+        GetExitCodeProcess(pi.hProcess, &exitCode);
+        res.exitCode = (int)exitCode;
+    }
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    if (job) CloseHandle(job);   // kills anything the command left behind
+    res.totalMs = MsSince(st.start);
+    return res;
+}
+
+#else  // POSIX
+
+ProcessResult RunProcess(const std::string &cmdUtf8, const ProcessOptions &opts) {
+    ProcessResult res;
+    RunState st(res, opts);
+
+    // Both ends close-on-exec, so commands started concurrently from other
+    // threads never inherit this pipe (dup2 clears the flag on 1 and 2).
+    int fds[2];
+#ifdef __linux__
+    if (pipe2(fds, O_CLOEXEC) != 0) return res;
+#else
+    if (pipe(fds) != 0) return res;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+    pid_t pid = fork();
+    if (pid < 0) { close(fds[0]); close(fds[1]); return res; }
+    if (pid == 0) {
+        // Own process group, so a kill reaches the whole tree.
+        setpgid(0, 0);
+        int devnull = open("/dev/null", O_RDONLY);
+        if (devnull >= 0) { dup2(devnull, 0); close(devnull); }
+        dup2(fds[1], 1);
+        dup2(fds[1], 2);
+        close(fds[0]);
+        close(fds[1]);
+        execl("/bin/sh", "sh", "-c", cmdUtf8.c_str(), (char *)nullptr);
+        _exit(127);
+    }
+    setpgid(pid, pid);   // also in the parent, whichever runs first
+    close(fds[1]);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    int status = 0;
+    bool reaped = false;
+    auto kill = [&](int reason) {
+        st.stopReason = reason;
+        ::kill(-pid, SIGKILL);
+        st.MarkExited();
+    };
+
+    char buf[kReadChunk];
+    for (;;) {
+        pollfd p{fds[0], POLLIN, 0};
+        int pr = poll(&p, 1, kPollMs);
+        if (pr > 0) {
+            ssize_t n = read(fds[0], buf, sizeof(buf));
+            if (n > 0) { st.Deliver(buf, (size_t)n); continue; }
+            if (n == 0) break;   // EOF: all writers gone
+            if (errno != EAGAIN && errno != EINTR) break;
+        }
+        if (!reaped && waitpid(pid, &status, WNOHANG) == pid) { reaped = true; st.MarkExited(); }
+        if (!st.exited) {
+            int reason = st.StopRequested();
+            if (reason) kill(reason);
+        } else if (st.DrainExpired()) {
+            break;
+        }
+    }
+    close(fds[0]);
+
+    while (!reaped && !st.stopReason) {
+        if (waitpid(pid, &status, WNOHANG) == pid) { reaped = true; break; }
+        int reason = st.StopRequested();
+        if (reason) { kill(reason); break; }
+        usleep(kPollMs * 1000);
+    }
+    if (!reaped) { waitpid(pid, &status, 0); reaped = true; }
+    ::kill(-pid, SIGKILL);   // anything the command left behind (ESRCH if none)
+
+    if (st.stopReason) res.exitCode = st.stopReason;
+    else if (WIFEXITED(status)) res.exitCode = WEXITSTATUS(status);
+    else if (WIFSIGNALED(status)) res.exitCode = 128 + WTERMSIG(status);
+    res.totalMs = MsSince(st.start);
+    return res;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <functional>
+
+// Runs a command line and captures its stdout+stderr while it runs.
+//
+// The pipe is drained concurrently with the wait (overlapped reads on
+// Windows, poll() on POSIX), so a child that prints more than the pipe buffer
+// never stalls until the timeout. The child and everything it starts (cmd.exe
+// -> winget.exe, sh -> winget script) run in one job / process group, so a
+// timeout or cancellation kills the whole tree and the pipe reaches EOF.
+//
+// Windows runs the command line with CreateProcessW; POSIX runs it with
+// `/bin/sh -c`. The POSIX backend exists so the runner can be exercised on
+// Linux against a fake winget script.
+
+// ProcessResult::exitCode values that are not real exit codes.
+const int kProcessLaunchFailed = -1;
+const int kProcessTimedOut = -2;     // same value as WingetErrors::TIMEOUT
+const int kProcessCancelled = -3;
+
+struct ProcessOptions {
+    int timeoutMs = 0;                            // 0 = no limit
+    const std::atomic<bool> *cancel = nullptr;    // polled every ~50 ms
+    // Called on the calling thread with each piece of output as it is read.
+    std::function<void(const char *data, size_t len)> onChunk;
+    // Output still arriving after the process exited (from children that
+    // inherited the pipe) is read for at most this long.
+    int drainAfterExitMs = 2000;
+};
+
+struct ProcessResult {
+    int exitCode = kProcessLaunchFailed;
+    std::string output;
+    long long firstByteMs = -1;                   // -1 if nothing was printed
+    long long totalMs = 0;
+    bool started() const { return exitCode != kProcessLaunchFailed; }
+    bool timedOut() const { return exitCode == kProcessTimedOut; }
+    bool cancelled() const { return exitCode == kProcessCancelled; }
+};
+
+// `cmdUtf8` is a full command line (UTF-8).
+ProcessResult RunProcess(const std::string &cmdUtf8, const ProcessOptions &opts = ProcessOptions());
+#ifdef _WIN32
+ProcessResult RunProcess(const std::wstring &cmd, const ProcessOptions &opts = ProcessOptions());
+#endif
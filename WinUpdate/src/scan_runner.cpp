@@ -2,83 +2,175 @@
 // logic lives in one compilation unit as requested.
 
 // Simple scanner: run `winget upgrade` and parse the aligned table by columns.
+//
+// No Windows dependency: winget runs through process_runner, so the scan can
+// be exercised off Windows with the runner stubbed (tests/scan_runner_test.cpp).
 #include "scan_runner.h"
 #include "winget_errors.h"
-#include <windows.h>
+#include "logging.h"
+#include "process_runner.h"
 #include <string>
-#include <sstream>
 #include <vector>
-#include <fstream>
+#include <mutex>
 #include <algorithm>
-#include <regex>
-#include <filesystem>
-#include "winget_versions.h"
-
-static inline std::string trim(const std::string &s) {
-    size_t a = 0, b = s.size();
-    while (a < b && (unsigned char)isspace((unsigned char)s[a])) ++a;
-    while (b > a && (unsigned char)isspace((unsigned char)s[b-1])) --b;
-    return s.substr(a, b-a);
+#include <chrono>
+
+static std::pair<int,std::string> RunProcessCaptureExitCodeLocal(const std::string &cmd, int timeoutMs = 5000,
+                                                                 const std::function<void(const char*, size_t)> &onChunk = nullptr) {
+    ProcessOptions opts;
+    opts.timeoutMs = timeoutMs;
+    opts.onChunk = onChunk;
+    ProcessResult r = RunProcess(cmd, opts);
+    if (r.timedOut()) {
+        LOG_WARN("Scan timeout: winget process exceeded time limit");
+    } else if (r.started()) {
+        DWORD exitCode = (DWORD)r.exitCode;
+        // Log non-success exit codes
+        if (exitCode != WingetErrors::SUCCESS && exitCode != WingetErrors::UPDATE_NOT_APPLICABLE) {
+            LOG_WARN("Scan exit code: " << r.exitCode
+                     << (WingetErrors::IsFailure(exitCode) ? " (error)" : WingetErrors::IsSkipped(exitCode) ? " (skipped)" : ""));
+        }
+    }
+    LOG_DEBUG("Scan timing: first output " << r.firstByteMs << " ms, total " << r.totalMs << " ms");
+    return { r.exitCode, std::move(r.output) };
+}
+
+const char *const kWingetUpgradeCommand = "winget upgrade --accept-source-agreements";
+
+// Most recent snapshot, published by whoever ran winget last.
+static ScanSnapshot g_last_snapshot;
+static bool g_have_snapshot = false;
+static std::chrono::steady_clock::time_point g_snapshot_time;
+static std::mutex g_snapshot_mutex;
+
+std::unordered_map<std::string,std::string> ScanSnapshot::AvailableMap() const {
+    std::unordered_map<std::string,std::string> out;
+    out.reserve(rows.size());
+    for (auto &r : rows) if (!r.available.empty()) out[r.id] = r.available;
+    return out;
 }
 
-static std::string WideToUtf8_local(const std::wstring &w) {
-    if (w.empty()) return {};
-    int size = WideCharToMultiByte(CP_UTF8, 0, w.data(), (int)w.size(), NULL, 0, NULL, NULL);
-    if (size <= 0) return std::string();
-    std::string out(size, 0);
-    WideCharToMultiByte(CP_UTF8, 0, w.data(), (int)w.size(), &out[0], size, NULL, NULL);
+std::unordered_map<std::string,std::string> ScanSnapshot::InstalledMap() const {
+    std::unordered_map<std::string,std::string> out;
+    out.reserve(rows.size());
+    for (auto &r : rows) if (!r.installed.empty()) out[r.id] = r.installed;
     return out;
 }
 
-static std::pair<int,std::string> RunProcessCaptureExitCodeLocal(const std::wstring &cmd, int timeoutMs = 5000) {
-    std::pair<int,std::string> res = {-1, std::string()};
-    SECURITY_ATTRIBUTES sa{}; sa.nLength = sizeof(sa); sa.bInheritHandle = TRUE; sa.lpSecurityDescriptor = NULL;
-    HANDLE hRead = NULL, hWrite = NULL;
-    if (!CreatePipe(&hRead, &hWrite, &sa, 0)) return res;
-    SetHandleInformation(hRead, HANDLE_FLAG_INHERIT, 0);
-    STARTUPINFOW si{}; si.cb = sizeof(si);
-    si.dwFlags |= STARTF_USESTDHANDLES; si.hStdOutput = hWrite; si.hStdError = hWrite; si.hStdInput = NULL;
-    PROCESS_INFORMATION pi{};
-    std::wstring cmdCopy = cmd;
-    if (!CreateProcessW(NULL, &cmdCopy[0], NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) { CloseHandle(hWrite); CloseHandle(hRead); return res; }
-    CloseHandle(hWrite);
-    DWORD wait = WaitForSingleObject(pi.hProcess, timeoutMs > 0 ? (DWORD)timeoutMs : INFINITE);
-    if (wait == WAIT_TIMEOUT) { 
-        TerminateProcess(pi.hProcess, 1); 
-        res.first = (int)WingetErrors::TIMEOUT;
-        try { AppendLog("Scan timeout: winget process exceeded time limit\n"); } catch(...) {}
+std::vector<std::pair<std::string,std::string>> ScanSnapshot::Candidates(
+        const std::function<bool(const ScanRow &)> &keep) const {
+    std::vector<std::pair<std::string,std::string>> out;
+    out.reserve(rows.size());
+    for (auto &r : rows) {
+        if (r.installedVersion < r.availableVersion && (!keep || keep(r))) out.emplace_back(r.id, r.name);
     }
-    else { 
-        DWORD exitCode = 0; 
-        GetExitCodeProcess(pi.hProcess, &exitCode); 
-        res.first = (int)exitCode;
-        
-        // Log non-success exit codes
-        if (exitCode != WingetErrors::SUCCESS && exitCode != WingetErrors::UPDATE_NOT_APPLICABLE) {
-            try { 
-                std::string logMsg = "Scan exit code: " + std::to_string((int)exitCode);
-                if (WingetErrors::IsFailure(exitCode)) {
-                    logMsg += " (error)";
-                } else if (WingetErrors::IsSkipped(exitCode)) {
-                    logMsg += " (skipped)";
-                }
-                logMsg += "\n";
-                AppendLog(logMsg); 
-            } catch(...) {}
-        }
+    return out;
+}
+
+bool MakeScanRow(const WingetTableRow &r, ScanRow &out) {
+    // The "require explicit targeting" table that may follow the first one
+    // cannot be upgraded in bulk and is left out.
+    if (r.table > 0) return false;
+    if (r.available().empty() || r.IsTruncated(WCOL_ID)) return false;
+    out.id.assign(r.id());
+    out.name.assign(r.name().empty() ? r.id() : r.name());
+    out.installed.assign(r.version());
+    out.available.assign(r.available());
+    out.source.assign(r.source());
+    out.installedVersion = Version(r.version());
+    out.availableVersion = Version(r.available());
+    return true;
+}
+
+ScanSnapshot ParseScanSnapshot(const std::string &raw) {
+    ScanSnapshot snap;
+    snap.raw = raw;
+    ForEachWingetRow(snap.raw, [&](const WingetTableRow &r) {
+        if (r.table > 0) return false;
+        ScanRow row;
+        if (MakeScanRow(r, row)) snap.rows.push_back(std::move(row));
+        return true;
+    });
+    return snap;
+}
+
+bool TakeScanSnapshot(ScanSnapshot &out, int timeoutMs) {
+    auto r = RunProcessCaptureExitCodeLocal(kWingetUpgradeCommand, timeoutMs);
+    out = ParseScanSnapshot(r.second);
+    out.exitCode = r.first;
+    try {
+        AppendLog(std::string("TakeScanSnapshot: exit=") + std::to_string(r.first) +
+                  " bytes=" + std::to_string((int)r.second.size()) +
+                  " rows=" + std::to_string((int)out.rows.size()) + "\n");
+    } catch(...) {}
+    return !r.second.empty();
+}
+
+bool RefreshScanSnapshot(ScanSnapshot &out, const std::function<void(const ScanRow &)> &onRow,
+                         int timeoutMs, int retryTimeoutMs) {
+    auto runStreaming = [&](int ms) {
+        // Rows go to `onRow` as soon as their line is complete, long before winget exits
+        WingetTableStream stream([&](const WingetTableRow &r) {
+            if (r.table > 0) return false;
+            ScanRow row;
+            if (MakeScanRow(r, row) && onRow) onRow(row);
+            return true;
+        });
+        auto res = RunProcessCaptureExitCodeLocal(kWingetUpgradeCommand, ms,
+            [&](const char *data, size_t len) { stream.Push(std::string_view(data, len)); });
+        stream.Finish();
+        return res;
+    };
+    auto r = runStreaming(timeoutMs);
+    // A run that timed out or printed nothing gets one more try with the longer timeout
+    if (r.first == kProcessTimedOut || r.second.empty()) {
+        auto retry = runStreaming(retryTimeoutMs);
+        if (!retry.second.empty()) r = std::move(retry);
+    }
+    out = ParseScanSnapshot(r.second);
+    out.exitCode = r.first;
+    SetLastScanSnapshot(out);
+    try {
+        AppendLog(std::string("RefreshScanSnapshot: exit=") + std::to_string(r.first) +
+                  " bytes=" + std::to_string((int)r.second.size()) +
+                  " rows=" + std::to_string((int)out.rows.size()) + "\n");
+    } catch(...) {}
+    return !r.second.empty();
+}
+
+void SetLastScanSnapshot(const ScanSnapshot &snap) {
+    std::lock_guard<std::mutex> lk(g_snapshot_mutex);
+    g_last_snapshot = snap;
+    g_have_snapshot = true;
+    g_snapshot_time = std::chrono::steady_clock::now();
+}
+
+bool GetLastScanSnapshot(ScanSnapshot &out, int maxAgeMs) {
+    std::lock_guard<std::mutex> lk(g_snapshot_mutex);
+    if (!g_have_snapshot) return false;
+    if (maxAgeMs >= 0 && std::chrono::steady_clock::now() - g_snapshot_time > std::chrono::milliseconds(maxAgeMs)) {
+        return false;
+    }
+    out = g_last_snapshot;
+    return true;
+}
+
+ScanSnapshot CurrentScanSnapshot(int maxAgeMs) {
+    ScanSnapshot snap;
+    if (!GetLastScanSnapshot(snap, maxAgeMs)) {
+        TakeScanSnapshot(snap);
+        SetLastScanSnapshot(snap);
     }
-    std::string out; const DWORD bufSize = 4096; char buf[bufSize]; DWORD read = 0;
-    while (ReadFile(hRead, buf, bufSize, &read, NULL) && read > 0) out.append(buf, buf + read);
-    CloseHandle(hRead); CloseHandle(pi.hProcess); CloseHandle(pi.hThread);
-    res.second = out; return res;
+    return snap;
 }
 
 bool ScanAndPopulateMaps(std::unordered_map<std::string,std::string> &avail, std::unordered_map<std::string,std::string> &inst) {
     avail.clear(); inst.clear();
     try {
-        // Use centralized, normalized parsing implemented in winget_versions.cpp
-        avail = MapAvailableVersions();
-        inst = MapInstalledVersions();
+        // Reuse the snapshot of the current refresh; only spawn winget if there is none or it is stale
+        ScanSnapshot snap = CurrentScanSnapshot();
+        avail = snap.AvailableMap();
+        inst = snap.InstalledMap();
         try { 
             std::string logMsg = "ScanAndPopulateMaps: avail count=" + std::to_string((int)avail.size()) + 
                                 " inst count=" + std::to_string((int)inst.size());
@@ -104,16 +196,19 @@ bool RunFullScan(std::vector<std::pair<std::string,std::string>> &outResults,
                  int timeoutMs) {
     outResults.clear(); avail.clear(); inst.clear();
     try {
-        avail = MapAvailableVersions();
-        inst = MapInstalledVersions();
+        // One winget invocation feeds the candidate list and both version maps
+        ScanSnapshot snap;
+        TakeScanSnapshot(snap, timeoutMs);
+        SetLastScanSnapshot(snap);
+        avail = snap.AvailableMap();
+        inst = snap.InstalledMap();
         if (avail.empty() || inst.empty()) {
             try { 
                 AppendLog("RunFullScan: Failed - one or both maps empty after scan\n");
             } catch(...) {}
             return false;
         }
-        // Build outResults using normalized ids as keys; display name uses id (can be improved later)
-        for (auto &p : avail) outResults.emplace_back(p.first, p.first);
+        outResults = snap.Candidates();
         try { 
             AppendLog(std::string("RunFullScan: avail count=") + std::to_string((int)avail.size()) + 
                      " inst count=" + std::to_string((int)inst.size()) + 
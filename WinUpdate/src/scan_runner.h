@@ -1,15 +1,78 @@
 #pragma once
 #include <unordered_map>
+#include <functional>
 #include <string>
 #include <vector>
 #include <utility>
+#include "winget_table.h"
+#include "version.h"
+
+// One row of the `winget upgrade` table.
+struct ScanRow {
+    std::string id;
+    std::string name;
+    std::string installed;
+    std::string available;
+    std::string source;
+    Version installedVersion;   // parsed once from `installed` / `available`
+    Version availableVersion;
+};
+
+// Result of a single `winget upgrade` invocation. Every consumer of a refresh
+// (candidate list, installed/available maps, startup capture, hidden scan)
+// reads from one snapshot instead of spawning winget again.
+struct ScanSnapshot {
+    std::vector<ScanRow> rows;
+    std::string raw;        // unparsed winget output
+    int exitCode = -1;
+
+    bool empty() const { return rows.empty(); }
+    std::unordered_map<std::string,std::string> AvailableMap() const;
+    std::unordered_map<std::string,std::string> InstalledMap() const;
+    // Candidate list (id, name) for rows whose available version is newer,
+    // in table order; `keep`, if given, drops the rows it returns false for.
+    std::vector<std::pair<std::string,std::string>> Candidates(
+        const std::function<bool(const ScanRow &)> &keep = nullptr) const;
+};
+
+// The one `winget upgrade` command line every scan runs.
+extern const char *const kWingetUpgradeCommand;
+// How long the last snapshot may stand in for a new `winget upgrade` run when
+// a module asks for versions between refreshes.
+const int kScanSnapshotMaxAgeMs = 5 * 60 * 1000;
+
+// Convert one parsed table row. Returns false for rows that cannot be
+// upgraded (no Available version, truncated Id, later tables).
+bool MakeScanRow(const WingetTableRow &r, ScanRow &out);
+// Parse raw `winget upgrade` output into a snapshot (no process is started).
+ScanSnapshot ParseScanSnapshot(const std::string &raw);
+// Run `winget upgrade` once and parse its output. Returns true when the
+// command produced output (the table itself may still be empty).
+bool TakeScanSnapshot(ScanSnapshot &out, int timeoutMs = 110000);
+// The main window's refresh: run `winget upgrade` once, passing each upgradable
+// row of the first table to `onRow` (on the calling thread) while winget is
+// still printing, then parse the whole output into `out` and publish it as the
+// last snapshot. A run that times out or prints nothing is retried once with
+// `retryTimeoutMs`. Returns true when winget produced output.
+bool RefreshScanSnapshot(ScanSnapshot &out, const std::function<void(const ScanRow &)> &onRow,
+                         int timeoutMs = 90000, int retryTimeoutMs = 110000);
+// Process-wide most recent snapshot, shared by the GUI and helper modules.
+// Every refresh (RefreshScanSnapshot, RunFullScan) replaces it.
+void SetLastScanSnapshot(const ScanSnapshot &snap);
+// Copy the most recent snapshot into `out`. Returns false if none was taken
+// yet, or if `maxAgeMs` >= 0 and it was published longer ago than that.
+bool GetLastScanSnapshot(ScanSnapshot &out, int maxAgeMs = -1);
+// The last snapshot if it is at most `maxAgeMs` old; otherwise run
+// `winget upgrade` once and publish the result.
+ScanSnapshot CurrentScanSnapshot(int maxAgeMs = kScanSnapshotMaxAgeMs);
 
 // Run the scanning/parsing steps and return the available/installed maps.
 // Returns true on success (maps populated), false otherwise.
 bool ScanAndPopulateMaps(std::unordered_map<std::string,std::string> &avail, std::unordered_map<std::string,std::string> &inst);
 // Run the full scan: produce candidate list (id,name) and available/installed maps.
-// This blocks until winget output is parsed and maps are ready.
+// This blocks until winget output is parsed and maps are ready. winget needs
+// 50-110 s with the msstore source enabled, hence the default timeout.
 bool RunFullScan(std::vector<std::pair<std::string,std::string>> &outResults,
 				 std::unordered_map<std::string,std::string> &avail,
 				 std::unordered_map<std::string,std::string> &inst,
-				 int timeoutMs = 12000);
+				 int timeoutMs = 110000);
@@ -1,8 +1,15 @@
 #include "skip_update.h"
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/stat.h>
+#include <cstdlib>
+#include <filesystem>
+#endif
 #include <string>
 #include "logging.h"
 #include "parsing.h"
+#include "version.h"
 #include <map>
 #include <fstream>
 #include <sstream>
@@ -11,12 +18,15 @@
 #include <thread>
 #include <chrono>
 #include <mutex>
+#include <unordered_map>
+#include <cstdio>
 
 // Global map to store ID -> display name in memory
 static std::map<std::string, std::string> g_id_to_displayname;
 static std::mutex g_id_displayname_mutex;
 
 static std::string GetIniPath() {
+#ifdef _WIN32
     char buf[MAX_PATH];
     DWORD len = GetEnvironmentVariableA("APPDATA", buf, MAX_PATH);
     std::string path;
@@ -30,6 +40,13 @@ static std::string GetIniPath() {
         CreateDirectoryW(wb.data(), NULL);
     }
     return path + "\\wup_settings.ini";
+#else
+    const char *appData = std::getenv("APPDATA");
+    std::string path = (appData && *appData) ? std::string(appData) + "/WinUpdate" : std::string(".");
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    return path + "/wup_settings.ini";
+#endif
 }
 
 static std::map<std::string,std::string> ParseSkippedSection(const std::string &sectionText) {
@@ -53,9 +70,9 @@ static std::map<std::string,std::string> ParseSkippedSection(const std::string &
     return out;
 }
 
-std::map<std::string,std::string> LoadSkippedMap() {
+// Read the [skipped] section straight from the INI (no caching).
+static std::map<std::string,std::string> ReadSkippedFile(const std::string &ini) {
     std::map<std::string,std::string> out;
-    std::string ini = GetIniPath();
     std::ifstream ifs(ini, std::ios::binary);
     if (!ifs) {
         AppendLog(std::string("LoadSkippedMap: failed to open ini: ") + ini + "\n");
@@ -78,17 +95,12 @@ std::map<std::string,std::string> LoadSkippedMap() {
         if (inSkipped) ss << line << "\n";
     }
     if (ss.str().size() > 0) out = ParseSkippedSection(ss.str());
-    // Log loaded skipped map for diagnostics
-    try {
-        for (auto &kv : out) {
-            AppendLog(std::string("LoadSkippedMap: entry '") + kv.first + "' -> '" + kv.second + "'\n");
-        }
-    } catch(...) {}
     return out;
 }
 
-bool SaveSkippedMap(const std::map<std::string,std::string> &m) {
-    std::string ini = GetIniPath();
+// Rewrite the INI with `m` as its [skipped] section: write <ini>.tmp, then
+// MoveFileEx it over the original so readers never see a half-written file.
+static bool WriteSkippedFile(const std::string &ini, const std::map<std::string,std::string> &m) {
     AppendLog(std::string("SaveSkippedMap: ini=") + ini + "\n");
     // Read entire file and replace [skipped] section
     std::ifstream ifs(ini, std::ios::binary);
@@ -121,6 +133,7 @@ bool SaveSkippedMap(const std::map<std::string,std::string> &m) {
     ofs << "\n";
     if (!post.empty()) ofs << post;
     ofs.close();
+#ifdef _WIN32
     // Try to atomically replace the target file. Prefer MoveFileEx with REPLACE_EXISTING
     BOOL moved = FALSE;
     DWORD lastErr = 0;
@@ -155,22 +168,134 @@ bool SaveSkippedMap(const std::map<std::string,std::string> &m) {
     } else {
         AppendLog(std::string("SaveSkippedMap: MoveFileEx succeeded: ") + ini + "\n");
     }
+#else
+    bool moved = std::rename(tmp.c_str(), ini.c_str()) == 0;
+    if (!moved) AppendLog(std::string("SaveSkippedMap: rename failed: ") + tmp + "\n");
+#endif
     return moved != 0;
 }
 
-static bool VersionGreater(const std::string &a, const std::string &b) {
-    // split by '.' and compare numeric components
-    auto split = [](const std::string &s){ std::vector<std::string> out; std::string cur; for (char c : s) { if (c=='.' || c=='-' || c=='_') { if (!cur.empty()) { out.push_back(cur); cur.clear(); } } else cur.push_back(c); } if (!cur.empty()) out.push_back(cur); return out; };
-    auto A = split(a); auto B = split(b);
-    size_t n = std::max(A.size(), B.size());
-    for (size_t i = 0; i < n; ++i) {
-        long ai = 0, bi = 0;
-        if (i < A.size()) try { ai = std::stol(A[i]); } catch(...) { ai = 0; }
-        if (i < B.size()) try { bi = std::stol(B[i]); } catch(...) { bi = 0; }
-        if (ai > bi) return true;
-        if (ai < bi) return false;
+// ---------------------------------------------------------------------------
+// SkipStore: process-wide cache of the [skipped] section.
+//
+// The parsers and PopulateListView call IsSkipped once per row, so reading the
+// INI per call meant hundreds of file reads per refresh. The store keeps the
+// entries in memory with a hash index on the sanitized id (holding the parsed
+// skipped version, so lookups never re-parse it) and only re-reads
+// the file when its size or last-write time changes (checked at most every
+// kStatIntervalMs). Changes are written back through WriteSkippedFile; inside
+// a SkipBatch they are collected and written once when the batch closes.
+// ---------------------------------------------------------------------------
+struct SkipIndexEntry {
+    std::string key;     // key in `entries`
+    Version version;     // parsed stored version
+};
+struct SkipStore {
+    std::mutex mtx;
+    std::map<std::string,std::string> entries;                 // key as written in the INI -> version
+    std::unordered_map<std::string,SkipIndexEntry> bySanitized;   // sanitized key -> entry
+    std::string ini;
+    bool loaded = false;
+    bool dirty = false;          // changed in memory, not yet written (open batch)
+    int batchDepth = 0;
+    unsigned long long stampTime = 0, stampSize = 0;
+    bool stampExists = false;
+    unsigned long long lastStatTick = 0;
+};
+static SkipStore g_skip_store;
+static const unsigned long long kStatIntervalMs = 250;
+
+static unsigned long long SkipStoreTickMs() {
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// remove all whitespace/control characters (same rule the INI keys were always matched with)
+static std::string SanitizeSkipKey(const std::string &s) {
+    std::string out; out.reserve(s.size());
+    for (unsigned char c : s) if (!isspace(c) && c >= 32) out.push_back((char)c);
+    return out;
+}
+
+static bool StatSkipIni(const std::string &ini, unsigned long long &mtime, unsigned long long &size) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExA(ini.c_str(), GetFileExInfoStandard, &fad)) { mtime = 0; size = 0; return false; }
+    mtime = ((unsigned long long)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+    size = ((unsigned long long)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+    return true;
+#else
+    struct stat sb;
+    if (stat(ini.c_str(), &sb) != 0) { mtime = 0; size = 0; return false; }
+    mtime = (unsigned long long)sb.st_mtim.tv_sec * 1000000000ull + (unsigned long long)sb.st_mtim.tv_nsec;
+    size = (unsigned long long)sb.st_size;
+    return true;
+#endif
+}
+
+// Caller holds g_skip_store.mtx.
+static void RebuildSkipIndex() {
+    g_skip_store.bySanitized.clear();
+    g_skip_store.bySanitized.reserve(g_skip_store.entries.size());
+    for (auto &kv : g_skip_store.entries) {
+        g_skip_store.bySanitized.emplace(SanitizeSkipKey(kv.first), SkipIndexEntry{kv.first, Version(SanitizeSkipKey(kv.second))});
     }
-    return false;
+}
+
+// Caller holds g_skip_store.mtx. Reload from disk if the INI changed behind our back.
+static void EnsureSkipStoreFresh() {
+    SkipStore &st = g_skip_store;
+    if (st.ini.empty()) st.ini = GetIniPath();
+    if (st.loaded && st.dirty) return;   // unsaved batch changes are authoritative
+    unsigned long long now = SkipStoreTickMs();
+    if (st.loaded && now - st.lastStatTick < kStatIntervalMs) return;
+    st.lastStatTick = now;
+    unsigned long long mtime = 0, size = 0;
+    bool exists = StatSkipIni(st.ini, mtime, size);
+    if (st.loaded && exists == st.stampExists && mtime == st.stampTime && size == st.stampSize) return;
+    st.entries = exists ? ReadSkippedFile(st.ini) : std::map<std::string,std::string>();
+    RebuildSkipIndex();
+    st.loaded = true;
+    st.stampExists = exists; st.stampTime = mtime; st.stampSize = size;
+    try { AppendLog(std::string("SkipStore: loaded ") + std::to_string((int)st.entries.size()) + " skipped entries from " + st.ini + "\n"); } catch(...) {}
+}
+
+// Caller holds g_skip_store.mtx. Persist the in-memory entries, or defer while a batch is open.
+static bool CommitSkipStore() {
+    SkipStore &st = g_skip_store;
+    RebuildSkipIndex();
+    if (st.batchDepth > 0) { st.dirty = true; return true; }
+    bool ok = WriteSkippedFile(st.ini, st.entries);
+    st.dirty = false;
+    st.stampExists = StatSkipIni(st.ini, st.stampTime, st.stampSize);
+    st.lastStatTick = SkipStoreTickMs();
+    return ok;
+}
+
+SkipBatch::SkipBatch() {
+    std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+    g_skip_store.batchDepth++;
+}
+
+SkipBatch::~SkipBatch() {
+    try {
+        std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+        if (--g_skip_store.batchDepth == 0 && g_skip_store.dirty) CommitSkipStore();
+    } catch(...) {}
+}
+
+std::map<std::string,std::string> LoadSkippedMap() {
+    std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+    EnsureSkipStoreFresh();
+    return g_skip_store.entries;
+}
+
+bool SaveSkippedMap(const std::map<std::string,std::string> &m) {
+    std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+    if (g_skip_store.ini.empty()) g_skip_store.ini = GetIniPath();
+    g_skip_store.entries = m;
+    g_skip_store.loaded = true;
+    return CommitSkipStore();
 }
 
 bool AddSkippedEntry(const std::string &id, const std::string &version, const std::string &displayName) {
@@ -180,9 +305,10 @@ bool AddSkippedEntry(const std::string &id, const std::string &version, const st
         g_id_to_displayname[id] = displayName;
         AppendLog(std::string("AddSkippedEntry: stored display name '") + displayName + "' for id '" + id + "'\n");
     }
-    auto m = LoadSkippedMap();
-    m[id] = version;
-    return SaveSkippedMap(m);
+    std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+    EnsureSkipStoreFresh();
+    g_skip_store.entries[id] = version;
+    return CommitSkipStore();
 }
 
 std::string GetDisplayNameForId(const std::string &id) {
@@ -195,303 +321,259 @@ std::string GetDisplayNameForId(const std::string &id) {
 }
 
 bool RemoveSkippedEntry(const std::string &id) {
-    auto m = LoadSkippedMap();
-    auto it = m.find(id);
-    if (it == m.end()) return false;
-    m.erase(it);
-    return SaveSkippedMap(m);
+    std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+    EnsureSkipStoreFresh();
+    auto it = g_skip_store.entries.find(id);
+    if (it == g_skip_store.entries.end()) return false;
+    g_skip_store.entries.erase(it);
+    return CommitSkipStore();
 }
 
 bool IsSkipped(const std::string &id, const std::string &availableVersion) {
     try {
-        auto m = LoadSkippedMap();
-        // sanitize helper: remove all whitespace/control characters
-        auto sanitize = [](const std::string &s)->std::string {
-            std::string out; out.reserve(s.size());
-            for (unsigned char c : s) if (!isspace(c) && c >= 32) out.push_back((char)c);
-            return out;
-        };
-        std::string sid = sanitize(id);
-        std::string savail = sanitize(availableVersion);
-        try { AppendLog(std::string("IsSkipped: checking id='") + sid + "' avail='" + savail + "' map_size=" + std::to_string((int)m.size()) + "\n"); } catch(...) {}
-        // find matching entry in map by sanitizing keys
-        for (auto &kv : m) {
-            std::string key_s = sanitize(kv.first);
-            std::string stored = kv.second;
-            std::string stored_s = sanitize(stored);
-            if (key_s != sid) continue;
-            try { AppendLog(std::string("IsSkipped: found stored='") + stored_s + "' for id='" + key_s + "'\n"); } catch(...) {}
-            if (stored_s == savail) {
-                try { AppendLog(std::string("IsSkipped: match -> skipping id='") + key_s + "'\n"); } catch(...) {}
-                return true;
-            }
-            if (VersionGreater(savail, stored_s)) {
-                try { AppendLog(std::string("IsSkipped: available>") + stored_s + " -> unskipping id='" + key_s + "'\n"); } catch(...) {}
-                // remove original key from map and persist
-                m.erase(kv.first);
-                SaveSkippedMap(m);
-                return false;
-            }
-            try { AppendLog(std::string("IsSkipped: available<stored -> still skip id='") + key_s + "'\n"); } catch(...) {}
+        return IsSkipped(id, Version(SanitizeSkipKey(availableVersion)));
+    } catch(...) { return false; }
+}
+
+bool IsSkipped(const std::string &id, const Version &available) {
+    try {
+        std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+        EnsureSkipStoreFresh();
+        std::string sid = SanitizeSkipKey(id);
+        auto hit = g_skip_store.bySanitized.find(sid);
+        if (hit == g_skip_store.bySanitized.end()) return false;
+        auto kv = g_skip_store.entries.find(hit->second.key);
+        if (kv == g_skip_store.entries.end()) return false;
+        int cmp = available.Compare(hit->second.version);
+        if (cmp == 0) {
+            LOG_TRACE("IsSkipped: match -> skipping id='" << sid << "'");
             return true;
         }
-        try { AppendLog(std::string("IsSkipped: id not found in skipped map: '") + sid + "'\n"); } catch(...) {}
-        return false;
+        if (cmp > 0) {
+            LOG_INFO("IsSkipped: available>" << kv->second << " -> unskipping id='" << sid << "'");
+            // remove original key from the store and persist
+            g_skip_store.entries.erase(kv);
+            CommitSkipStore();
+            return false;
+        }
+        LOG_TRACE("IsSkipped: available<stored -> still skip id='" << sid << "'");
+        return true;
     } catch(...) { return false; }
 }
 
 void PurgeObsoleteSkips(const std::map<std::string,std::string> &currentAvail) {
-    auto m = LoadSkippedMap();
+    std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+    EnsureSkipStoreFresh();
+    auto &m = g_skip_store.entries;
     bool changed = false;
     for (auto it = m.begin(); it != m.end(); ) {
         auto cit = currentAvail.find(it->first);
         if (cit != currentAvail.end()) {
-            if (VersionGreater(cit->second, it->second)) { it = m.erase(it); changed = true; continue; }
+            if (Version(cit->second) > Version(it->second)) { it = m.erase(it); changed = true; continue; }
         }
         ++it;
     }
-    if (changed) SaveSkippedMap(m);
+    if (changed) CommitSkipStore();
 }
-    bool AppendSkippedRaw(const std::string &identifier, const std::string &version) {
-        std::string ini = GetIniPath();
-        // read file into lines
-        std::ifstream ifs(ini, std::ios::binary);
-        std::vector<std::string> lines;
-        std::string line;
-        if (ifs) {
-            while (std::getline(ifs, line)) lines.push_back(line);
-            ifs.close();
-        } else {
-            // create minimal ini
-            lines.push_back("[language]");
-            lines.push_back("en");
-            lines.push_back("");
-            lines.push_back("[skipped]");
-        }
-        // find [skipped] section
-        int idx = -1;
-        for (int i = 0; i < (int)lines.size(); ++i) {
-            std::string t = lines[i];
-            // trim
-            auto trim = [](std::string &s){ size_t a = s.find_first_not_of(" \t\r\n"); if (a==std::string::npos) { s.clear(); return; } size_t b = s.find_last_not_of(" \t\r\n"); s = s.substr(a, b-a+1); };
-            trim(t);
-            if (t == "[skipped]") { idx = i; break; }
-        }
-        if (idx == -1) {
-            // append at end
-            lines.push_back("");
-            lines.push_back("[skipped]");
-            idx = (int)lines.size() - 1;
-        }
-        // find insertion point after last non-empty skipped entry
-        int insertAt = idx + 1;
-        while (insertAt < (int)lines.size()) {
-            std::string t = lines[insertAt];
-            auto trim = [](std::string &s){ size_t a = s.find_first_not_of(" \t\r\n"); if (a==std::string::npos) { s.clear(); return; } size_t b = s.find_last_not_of(" \t\r\n"); s = s.substr(a, b-a+1); };
-            std::string tt = t; trim(tt);
-            if (tt.empty() || tt.front() == '[') break;
-            ++insertAt;
-        }
-        // Attempt to resolve identifier (display name) to package id (no whitespace)
-        std::string writeId = identifier;
-        try {
-            // If identifier contains whitespace, it's likely a display name — try to resolve
-            bool needsResolve = (identifier.find_first_of(" \t") != std::string::npos);
-            if (needsResolve) {
-                AppendLog(std::string("AppendSkippedRaw: attempting id resolution for '") + identifier + "'\n");
-                
-                // If g_packages is empty, parse from in-memory winget output
+
+bool AppendSkippedRaw(const std::string &identifier, const std::string &version) {
+    // Attempt to resolve identifier (display name) to package id (no whitespace)
+    std::string writeId = identifier;
+    try {
+        // If identifier contains whitespace, it's likely a display name — try to resolve
+        bool needsResolve = (identifier.find_first_of(" \t") != std::string::npos);
+        if (needsResolve) {
+            AppendLog(std::string("AppendSkippedRaw: attempting id resolution for '") + identifier + "'\n");
+            
+            // If g_packages is empty, parse from in-memory winget output
+            {
+                std::lock_guard<std::mutex> lk(g_packages_mutex);
+                if (g_packages.empty()) {
+                    AppendLog("AppendSkippedRaw: g_packages empty, using in-memory winget output\n");
+                }
+            }
+            
+            try {
+                // Get in-memory winget output
+                std::string raw;
                 {
-                    std::lock_guard<std::mutex> lk(g_packages_mutex);
-                    if (g_packages.empty()) {
-                        AppendLog("AppendSkippedRaw: g_packages empty, using in-memory winget output\n");
-                    }
+                    std::lock_guard<std::mutex> lk2(g_last_winget_raw_mutex);
+                    raw = g_last_winget_raw;
                 }
                 
-                try {
-                    // Get in-memory winget output
-                    std::string raw;
-                    {
-                        std::lock_guard<std::mutex> lk2(g_last_winget_raw_mutex);
-                        raw = g_last_winget_raw;
-                    }
-                    
-                    if (!raw.empty()) {
-                        ParseWingetTextForPackages(raw);
-                        AppendLog(std::string("AppendSkippedRaw: ParseWingetTextForPackages populated g_packages size=") + std::to_string((int)g_packages.size()) + "\n");
-                    } else {
-                        AppendLog("AppendSkippedRaw: ERROR - g_last_winget_raw is empty!\n");
-                    }
-                } catch(...) { AppendLog("AppendSkippedRaw: in-memory parse threw\n"); }
+                if (!raw.empty()) {
+                    ParseWingetTextForPackages(raw);
+                    AppendLog(std::string("AppendSkippedRaw: ParseWingetTextForPackages populated g_packages size=") + std::to_string((int)g_packages.size()) + "\n");
+                } else {
+                    AppendLog("AppendSkippedRaw: ERROR - g_last_winget_raw is empty!\n");
+                }
+            } catch(...) { AppendLog("AppendSkippedRaw: in-memory parse threw\n"); }
 
-                // search g_packages for matching display name (exact or case-insensitive/substring)
-                try {
-                    std::string idFound;
-                    // quick canonical map for known display names -> ids
-                    auto GetCanonicalIdForName = [](const std::string &name)->std::string {
-                        std::string nl = name; for (auto &c : nl) c = (char)tolower((unsigned char)c);
-                        // entries: substring match -> id
-                        const std::vector<std::pair<std::string,std::string>> canon = {
-                            {"vulkan sdk", "KhronosGroup.VulkanSDK"},
-                            {"khronos vulkan", "KhronosGroup.VulkanSDK"}
-                        };
-                        for (auto &p : canon) if (nl.find(p.first) != std::string::npos) return p.second;
-                        return std::string();
+            // search g_packages for matching display name (exact or case-insensitive/substring)
+            try {
+                std::string idFound;
+                // quick canonical map for known display names -> ids
+                auto GetCanonicalIdForName = [](const std::string &name)->std::string {
+                    std::string nl = name; for (auto &c : nl) c = (char)tolower((unsigned char)c);
+                    // entries: substring match -> id
+                    const std::vector<std::pair<std::string,std::string>> canon = {
+                        {"vulkan sdk", "KhronosGroup.VulkanSDK"},
+                        {"khronos vulkan", "KhronosGroup.VulkanSDK"}
                     };
+                    for (auto &p : canon) if (nl.find(p.first) != std::string::npos) return p.second;
+                    return std::string();
+                };
 
-                    // normalize: remove trailing version-like tokens from identifier (e.g. "Vulkan SDK 1.4.328.1" -> "Vulkan SDK")
-                    auto toLower = [](const std::string &s){ std::string r = s; for (auto &c : r) c = (char)tolower((unsigned char)c); return r; };
-                    auto isVersionToken = [](const std::string &t){ if (t.empty()) return false; for (char c : t) { if (!(isdigit((unsigned char)c) || c=='.' || c=='-' || c=='_')) return false; } return true; };
-                    auto stripTrailingVersionTokens = [&](std::string s){ // remove trailing space-separated tokens that look like versions
-                        // trim
-                        auto trim_inplace = [](std::string &x){ size_t a = x.find_first_not_of(" \t\r\n"); if (a==std::string::npos) { x.clear(); return; } size_t b = x.find_last_not_of(" \t\r\n"); x = x.substr(a, b-a+1); };
-                        trim_inplace(s);
-                        while (true) {
-                            size_t p = s.find_last_of(" \t");
-                            if (p==std::string::npos) break;
-                            std::string last = s.substr(p+1);
-                            if (isVersionToken(last)) {
-                                s = s.substr(0, p);
-                                trim_inplace(s);
-                                continue;
-                            }
-                            break;
+                // normalize: remove trailing version-like tokens from identifier (e.g. "Vulkan SDK 1.4.328.1" -> "Vulkan SDK")
+                auto toLower = [](const std::string &s){ std::string r = s; for (auto &c : r) c = (char)tolower((unsigned char)c); return r; };
+                auto isVersionToken = [](const std::string &t){ if (t.empty()) return false; for (char c : t) { if (!(isdigit((unsigned char)c) || c=='.' || c=='-' || c=='_')) return false; } return true; };
+                auto stripTrailingVersionTokens = [&](std::string s){ // remove trailing space-separated tokens that look like versions
+                    // trim
+                    auto trim_inplace = [](std::string &x){ size_t a = x.find_first_not_of(" \t\r\n"); if (a==std::string::npos) { x.clear(); return; } size_t b = x.find_last_not_of(" \t\r\n"); x = x.substr(a, b-a+1); };
+                    trim_inplace(s);
+                    while (true) {
+                        size_t p = s.find_last_of(" \t");
+                        if (p==std::string::npos) break;
+                        std::string last = s.substr(p+1);
+                        if (isVersionToken(last)) {
+                            s = s.substr(0, p);
+                            trim_inplace(s);
+                            continue;
                         }
-                        return s;
-                    };
-                    auto tokenize = [](const std::string &x){ std::vector<std::string> out; std::string cur; for (char c : x) { if (isalnum((unsigned char)c)) cur.push_back((char)tolower((unsigned char)c)); else { if (!cur.empty()) { out.push_back(cur); cur.clear(); } } } if (!cur.empty()) out.push_back(cur); return out; };
+                        break;
+                    }
+                    return s;
+                };
+                auto tokenize = [](const std::string &x){ std::vector<std::string> out; std::string cur; for (char c : x) { if (isalnum((unsigned char)c)) cur.push_back((char)tolower((unsigned char)c)); else { if (!cur.empty()) { out.push_back(cur); cur.clear(); } } } if (!cur.empty()) out.push_back(cur); return out; };
 
-                    std::string ident_stripped = stripTrailingVersionTokens(identifier);
-                    // check canonical map first
-                    try {
-                        std::string canon = GetCanonicalIdForName(ident_stripped);
-                        if (!canon.empty()) idFound = canon;
-                    } catch(...) {}
-                    std::string name_l = toLower(ident_stripped);
-                    auto tokens = tokenize(name_l);
-                    {
-                        std::lock_guard<std::mutex> lk(g_packages_mutex);
-                        // 1) exact name match
+                std::string ident_stripped = stripTrailingVersionTokens(identifier);
+                // check canonical map first
+                try {
+                    std::string canon = GetCanonicalIdForName(ident_stripped);
+                    if (!canon.empty()) idFound = canon;
+                } catch(...) {}
+                std::string name_l = toLower(ident_stripped);
+                auto tokens = tokenize(name_l);
+                {
+                    std::lock_guard<std::mutex> lk(g_packages_mutex);
+                    // 1) exact name match
+                    for (auto &p : g_packages) {
+                        if (p.second == ident_stripped) { idFound = p.first; break; }
+                    }
+                    // 2) case-insensitive substring/equality
+                    if (idFound.empty()) {
                         for (auto &p : g_packages) {
-                            if (p.second == ident_stripped) { idFound = p.first; break; }
-                        }
-                        // 2) case-insensitive substring/equality
-                        if (idFound.empty()) {
-                            for (auto &p : g_packages) {
-                                std::string nm = p.second; std::string nm_l = toLower(nm);
-                                if (nm_l == name_l || nm_l.find(name_l) != std::string::npos || name_l.find(nm_l) != std::string::npos) { idFound = p.first; break; }
-                            }
-                        }
-                        // 3) token-subset match against package name
-                        if (idFound.empty() && !tokens.empty()) {
-                            for (auto &p : g_packages) {
-                                std::string nm = p.second; std::string nm_l = toLower(nm);
-                                bool all = true;
-                                for (auto &t : tokens) if (nm_l.find(t) == std::string::npos) { all = false; break; }
-                                if (all) { idFound = p.first; break; }
-                            }
+                            std::string nm = p.second; std::string nm_l = toLower(nm);
+                            if (nm_l == name_l || nm_l.find(name_l) != std::string::npos || name_l.find(nm_l) != std::string::npos) { idFound = p.first; break; }
                         }
-                        // 4) token-subset match against package id
-                        if (idFound.empty() && !tokens.empty()) {
-                            for (auto &p : g_packages) {
-                                std::string idl = toLower(p.first);
-                                bool all = true;
-                                for (auto &t : tokens) if (idl.find(t) == std::string::npos) { all = false; break; }
-                                if (all) { idFound = p.first; break; }
-                            }
+                    }
+                    // 3) token-subset match against package name
+                    if (idFound.empty() && !tokens.empty()) {
+                        for (auto &p : g_packages) {
+                            std::string nm = p.second; std::string nm_l = toLower(nm);
+                            bool all = true;
+                            for (auto &t : tokens) if (nm_l.find(t) == std::string::npos) { all = false; break; }
+                            if (all) { idFound = p.first; break; }
                         }
                     }
-                    if (!idFound.empty()) {
-                        AppendLog(std::string("AppendSkippedRaw: resolved '") + identifier + "' -> id='" + idFound + "'\n");
-                        writeId = idFound;
-                    } else {
-                        AppendLog(std::string("AppendSkippedRaw: FAILED to resolve id for '") + identifier + "' from in-memory data\n");
-                        // Log what we have in g_packages for debugging
-                        std::lock_guard<std::mutex> lk(g_packages_mutex);
-                        AppendLog(std::string("AppendSkippedRaw: g_packages size=") + std::to_string((int)g_packages.size()) + "\n");
-                        for (size_t i = 0; i < std::min((size_t)10, g_packages.size()); ++i) {
-                            AppendLog(std::string("  [") + std::to_string((int)i) + "] id='" + g_packages[i].first + "' name='" + g_packages[i].second + "'\n");
+                    // 4) token-subset match against package id
+                    if (idFound.empty() && !tokens.empty()) {
+                        for (auto &p : g_packages) {
+                            std::string idl = toLower(p.first);
+                            bool all = true;
+                            for (auto &t : tokens) if (idl.find(t) == std::string::npos) { all = false; break; }
+                            if (all) { idFound = p.first; break; }
                         }
                     }
-                } catch(...) { AppendLog("AppendSkippedRaw: id search threw\n"); }
-            }
-        } catch(...) { AppendLog("AppendSkippedRaw: id resolution outer try threw\n"); }
-
-        // Before writing, strip any trailing installed-version tokens from the identifier
-        auto trim_inplace = [](std::string &x){ size_t a = x.find_first_not_of(" \t\r\n"); if (a==std::string::npos) { x.clear(); return; } size_t b = x.find_last_not_of(" \t\r\n"); x = x.substr(a, b-a+1); };
-        auto isVersionToken = [](const std::string &t){ if (t.empty()) return false; for (char c : t) { if (!(isdigit((unsigned char)c) || c=='.' || c=='-' || c=='_')) return false; } return true; };
-        // operate on a local copy so we don't alter writeId used elsewhere
-        std::string writeIdForFile = writeId;
-        trim_inplace(writeIdForFile);
-        while (true) {
-            size_t p = writeIdForFile.find_last_of(" \t");
-            if (p == std::string::npos) break;
-            std::string last = writeIdForFile.substr(p+1);
-            if (isVersionToken(last)) {
-                writeIdForFile = writeIdForFile.substr(0, p);
-                trim_inplace(writeIdForFile);
-                continue;
-            }
-            break;
-        }
-        // Validate: block writes if ID contains spaces (indicates resolution failed)
-        if (writeIdForFile.find(' ') != std::string::npos) {
-            AppendLog(std::string("AppendSkippedRaw: BLOCKED write - ID contains spaces: '") + writeIdForFile + "'\n");
-            // Build detailed error message showing what we found
-            std::string msg = "Failed to skip package.\n\n";
-            msg += "Searching for: " + identifier + "\n";
-            msg += "Found ID: " + writeIdForFile + "\n\n";
-            
-            // Show what's in g_packages
-            {
-                std::lock_guard<std::mutex> lk(g_packages_mutex);
-                msg += "Available packages in memory (" + std::to_string((int)g_packages.size()) + "):\n";
-                for (size_t i = 0; i < std::min((size_t)5, g_packages.size()); ++i) {
-                    msg += "  " + g_packages[i].first + " - " + g_packages[i].second + "\n";
                 }
-                if (g_packages.size() > 5) {
-                    msg += "  ... and " + std::to_string((int)g_packages.size() - 5) + " more\n";
-                }
-                if (g_packages.empty()) {
-                    msg += "  (empty - list not yet loaded)\n";
+                if (!idFound.empty()) {
+                    AppendLog(std::string("AppendSkippedRaw: resolved '") + identifier + "' -> id='" + idFound + "'\n");
+                    writeId = idFound;
+                } else {
+                    AppendLog(std::string("AppendSkippedRaw: FAILED to resolve id for '") + identifier + "' from in-memory data\n");
+                    // Log what we have in g_packages for debugging
+                    std::lock_guard<std::mutex> lk(g_packages_mutex);
+                    AppendLog(std::string("AppendSkippedRaw: g_packages size=") + std::to_string((int)g_packages.size()) + "\n");
+                    for (size_t i = 0; i < std::min((size_t)10, g_packages.size()); ++i) {
+                        AppendLog(std::string("  [") + std::to_string((int)i) + "] id='" + g_packages[i].first + "' name='" + g_packages[i].second + "'\n");
+                    }
                 }
-            }
-            
-            msg += "\nPlease refresh the list and try again.";
-            MessageBoxA(NULL, msg.c_str(), "WinUpdate - Skip Failed", MB_OK | MB_ICONWARNING);
-            return false;
+            } catch(...) { AppendLog("AppendSkippedRaw: id search threw\n"); }
         }
-        // prepare new line with a tab between (use resolved id when available)
-        std::string newLine = writeIdForFile + "\t" + version;
-        lines.insert(lines.begin() + insertAt, newLine);
-        // write to tmp and move
-        std::string tmp = ini + ".tmp";
-        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
-        if (!ofs) {
-            AppendLog(std::string("AppendSkippedRaw: failed to open tmp file: ") + tmp + "\n");
-            return false;
-        }
-        for (auto &ln : lines) ofs << ln << "\n";
-        ofs.close();
-        BOOL del = DeleteFileA(ini.c_str());
-        if (!del) {
-            DWORD err = GetLastError();
-            AppendLog(std::string("AppendSkippedRaw: DeleteFileA returned error ") + std::to_string(err) + "\n");
+    } catch(...) { AppendLog("AppendSkippedRaw: id resolution outer try threw\n"); }
+
+    // Before writing, strip any trailing installed-version tokens from the identifier
+    auto trim_inplace = [](std::string &x){ size_t a = x.find_first_not_of(" \t\r\n"); if (a==std::string::npos) { x.clear(); return; } size_t b = x.find_last_not_of(" \t\r\n"); x = x.substr(a, b-a+1); };
+    auto isVersionToken = [](const std::string &t){ if (t.empty()) return false; for (char c : t) { if (!(isdigit((unsigned char)c) || c=='.' || c=='-' || c=='_')) return false; } return true; };
+    // operate on a local copy so we don't alter writeId used elsewhere
+    std::string writeIdForFile = writeId;
+    trim_inplace(writeIdForFile);
+    while (true) {
+        size_t p = writeIdForFile.find_last_of(" \t");
+        if (p == std::string::npos) break;
+        std::string last = writeIdForFile.substr(p+1);
+        if (isVersionToken(last)) {
+            writeIdForFile = writeIdForFile.substr(0, p);
+            trim_inplace(writeIdForFile);
+            continue;
         }
-        BOOL mv = MoveFileA(tmp.c_str(), ini.c_str());
-            if (!mv) {
-                DWORD err = GetLastError();
-                AppendLog(std::string("AppendSkippedRaw: MoveFileA failed err=") + std::to_string(err) + "\n");
-            } else {
-                AppendLog(std::string("AppendSkippedRaw: appended skipped entry: ") + identifier + "\t" + version + " to " + ini + "\n");
-                // Notify main window to refresh so the UI rescans the updated INI
-                try {
-                    HWND hMain = FindWindowW(L"WinUpdateClass", NULL);
-                    if (hMain) {
-                        PostMessageW(hMain, WM_APP + 1, 1, 0);
-                        AppendLog(std::string("AppendSkippedRaw: posted WM_REFRESH_ASYNC to main window\n"));
-                    }
-                } catch(...) {}
+        break;
+    }
+    // Validate: block writes if ID contains spaces (indicates resolution failed)
+    if (writeIdForFile.find(' ') != std::string::npos) {
+        AppendLog(std::string("AppendSkippedRaw: BLOCKED write - ID contains spaces: '") + writeIdForFile + "'\n");
+        // Build detailed error message showing what we found
+        std::string msg = "Failed to skip package.\n\n";
+        msg += "Searching for: " + identifier + "\n";
+        msg += "Found ID: " + writeIdForFile + "\n\n";
+        
+        // Show what's in g_packages
+        {
+            std::lock_guard<std::mutex> lk(g_packages_mutex);
+            msg += "Available packages in memory (" + std::to_string((int)g_packages.size()) + "):\n";
+            for (size_t i = 0; i < std::min((size_t)5, g_packages.size()); ++i) {
+                msg += "  " + g_packages[i].first + " - " + g_packages[i].second + "\n";
+            }
+            if (g_packages.size() > 5) {
+                msg += "  ... and " + std::to_string((int)g_packages.size() - 5) + " more\n";
+            }
+            if (g_packages.empty()) {
+                msg += "  (empty - list not yet loaded)\n";
             }
-            return mv != 0;
+        }
+        
+        msg += "\nPlease refresh the list and try again.";
+#ifdef _WIN32
+        MessageBoxA(NULL, msg.c_str(), "WinUpdate - Skip Failed", MB_OK | MB_ICONWARNING);
+#endif
+        return false;
+    }
+    // Through the SkipStore like AddSkippedEntry: inside an open SkipBatch the
+    // entry joins the batch, whose commit would otherwise overwrite a line
+    // written to the INI behind the store's back
+    bool ok;
+    std::string ini;
+    {
+        std::lock_guard<std::mutex> lk(g_skip_store.mtx);
+        EnsureSkipStoreFresh();
+        ini = g_skip_store.ini;
+        g_skip_store.entries[writeIdForFile] = version;
+        ok = CommitSkipStore();
     }
+    if (!ok) {
+        AppendLog(std::string("AppendSkippedRaw: failed to save skipped entry: ") + writeIdForFile + "\t" + version + " to " + ini + "\n");
+        return false;
+    }
+    AppendLog(std::string("AppendSkippedRaw: appended skipped entry: ") + identifier + "\t" + version + " to " + ini + "\n");
+#ifdef _WIN32
+    // Notify main window to refresh so the UI rescans the updated INI
+    try {
+        HWND hMain = FindWindowW(L"WinUpdateClass", NULL);
+        if (hMain) {
+            PostMessageW(hMain, WM_APP + 1, 1, 0);
+            AppendLog(std::string("AppendSkippedRaw: posted WM_REFRESH_ASYNC to main window\n"));
+        }
+    } catch(...) {}
+#endif
+    return true;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <map>
+#include "version.h"
 
 // Add a skipped entry (id -> version). Returns true on success.
 // displayName is stored in memory for display purposes (not saved to .ini)
@@ -12,10 +13,12 @@ std::string GetDisplayNameForId(const std::string &id);
 // Remove a skipped entry by id. Returns true if removed.
 bool RemoveSkippedEntry(const std::string &id);
 
-// Load skipped map from per-user INI (id -> version)
+// Load skipped map from per-user INI (id -> version).
+// Served from the in-memory SkipStore; the INI is re-read only when its size
+// or last-write time changed.
 std::map<std::string,std::string> LoadSkippedMap();
 
-// Save skipped map to INI
+// Replace all skipped entries and save them to the INI (tmp file + MoveFileEx).
 bool SaveSkippedMap(const std::map<std::string,std::string> &m);
 
 // Check whether a given availableVersion should be skipped according to stored skips.
@@ -23,6 +26,8 @@ bool SaveSkippedMap(const std::map<std::string,std::string> &m);
 // If storedVersion < availableVersion -> remove skip and return false.
 // If storedVersion > availableVersion -> return true.
 bool IsSkipped(const std::string &id, const std::string &availableVersion);
+// Same, for callers that already hold the parsed available version.
+bool IsSkipped(const std::string &id, const Version &available);
 
 // Purge obsolete skipped entries using currentAvailable map (id->availableVersion)
 void PurgeObsoleteSkips(const std::map<std::string,std::string> &currentAvail);
@@ -34,3 +39,15 @@ bool AppendSkippedRaw(const std::string &identifier, const std::string &version)
 // Attempt to migrate any skipped entries that use display-names into ID-based entries.
 // Returns true if any entries were migrated and saved.
 bool MigrateSkippedEntries();
+
+// Collect skip changes made while the batch is alive (IsSkipped auto-unskips,
+// Add/Remove, PurgeObsoleteSkips) and write the INI once when the outermost
+// batch goes out of scope.
+class SkipBatch {
+public:
+    SkipBatch();
+    ~SkipBatch();
+    SkipBatch(const SkipBatch &) = delete;
+    SkipBatch &operator=(const SkipBatch &) = delete;
+};
+
@@ -1,10 +1,10 @@
 #include "system_tray.h"
 #include "scan_runner.h"
 #include "Config.h"
+#include "logging.h"
 #include <shellapi.h>
 #include <sstream>
 #include <iomanip>
-#include <fstream>
 #include <atomic>
 
 // Define notification messages if not already defined (for older SDKs)
@@ -66,23 +66,21 @@ bool SystemTray::AddToTray() {
     if (m_active) return true;
     
     // Debug: Log tray icon setup
-    std::ofstream log("C:\\Users\\NalleBerg\\AppData\\Roaming\\WinUpdate\\tray_debug.txt", std::ios::app);
-    log << "AddToTray called\n";
-    log << "  hwnd=" << m_nid.hWnd << "\n";
-    log << "  uID=" << m_nid.uID << "\n";
-    log << "  uFlags=0x" << std::hex << m_nid.uFlags << std::dec << "\n";
-    log << "  uCallbackMessage=" << m_nid.uCallbackMessage << " (WM_TRAYICON=" << WM_TRAYICON << ")\n";
-    log << "  hIcon=" << m_nid.hIcon << "\n";
+    TRAY_LOG(LogLevel::Debug, "AddToTray called\n"
+             << "  hwnd=" << m_nid.hWnd << "\n"
+             << "  uID=" << m_nid.uID << "\n"
+             << "  uFlags=0x" << std::hex << m_nid.uFlags << std::dec << "\n"
+             << "  uCallbackMessage=" << m_nid.uCallbackMessage << " (WM_TRAYICON=" << WM_TRAYICON << ")\n"
+             << "  hIcon=" << m_nid.hIcon);
     
     if (Shell_NotifyIconW(NIM_ADD, &m_nid)) {
-        log << "NIM_ADD succeeded\n";
+        TRAY_LOG(LogLevel::Info, "NIM_ADD succeeded");
         m_active = true;
-        log.close();
         
         return true;
     }
-    log << "NIM_ADD failed! Error: " << GetLastError() << "\n";
-    log.close();
+    DWORD err = GetLastError();
+    TRAY_LOG(LogLevel::Error, "NIM_ADD failed! Error: " << err);
     return false;
 }
 
@@ -106,28 +104,27 @@ bool SystemTray::UpdateTooltip(const std::wstring& text) {
     m_nid.uFlags = NIF_TIP;
     
     // Debug logging
-    std::ofstream log("C:\\Users\\NalleBerg\\AppData\\Roaming\\WinUpdate\\tray_debug.txt", std::ios::app);
-    log << "UpdateTooltip called with text: " << std::string(text.begin(), text.end()) << "\n";
+    TRAY_LOG(LogLevel::Debug, "UpdateTooltip called with text: " << std::string(text.begin(), text.end()));
     BOOL result = Shell_NotifyIconW(NIM_MODIFY, &m_nid);
-    log << "Shell_NotifyIconW result: " << result << "\n";
+    TRAY_LOG(LogLevel::Debug, "Shell_NotifyIconW result: " << result);
     
     // If modify failed, the icon may have been lost (e.g., after Windows update/restart)
     // Try to re-add it
     if (!result) {
-        log << "UpdateTooltip failed, attempting to re-add icon\n";
+        TRAY_LOG(LogLevel::Warn, "UpdateTooltip failed, attempting to re-add icon");
         m_active = false;  // Reset active flag so AddToTray will work
         m_nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;  // Restore full flags for add
         
         if (Shell_NotifyIconW(NIM_ADD, &m_nid)) {
-            log << "Re-add succeeded\n";
+            TRAY_LOG(LogLevel::Info, "Re-add succeeded");
             m_active = true;
             result = TRUE;
         } else {
-            log << "Re-add failed! Error: " << GetLastError() << "\n";
+            DWORD err = GetLastError();
+            TRAY_LOG(LogLevel::Error, "Re-add failed! Error: " << err);
         }
     }
     
-    log.close();
     
     return result != FALSE;
 }
@@ -145,19 +142,18 @@ bool SystemTray::ShowBalloon(const std::wstring& title, const std::wstring& text
     
     // If modify failed, try to re-add the icon
     if (!result) {
-        std::ofstream log("C:\\Users\\NalleBerg\\AppData\\Roaming\\WinUpdate\\tray_debug.txt", std::ios::app);
-        log << "ShowBalloon failed, attempting to re-add icon\n";
+        TRAY_LOG(LogLevel::Warn, "ShowBalloon failed, attempting to re-add icon");
         m_active = false;
         m_nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP | NIF_INFO;
         
         if (Shell_NotifyIconW(NIM_ADD, &m_nid)) {
-            log << "Re-add succeeded\n";
+            TRAY_LOG(LogLevel::Info, "Re-add succeeded");
             m_active = true;
             result = true;
         } else {
-            log << "Re-add failed! Error: " << GetLastError() << "\n";
+            DWORD err = GetLastError();
+            TRAY_LOG(LogLevel::Error, "Re-add failed! Error: " << err);
         }
-        log.close();
     }
     
     // Reset flags
@@ -265,9 +261,7 @@ void SystemTray::UpdateNextScanTime(const std::wstring& statusLine) {
     }
     
     // Debug logging
-    std::ofstream log("C:\\Users\\NalleBerg\\AppData\\Roaming\\WinUpdate\\tray_debug.txt", std::ios::app);
-    log << "UpdateNextScanTime: tooltip = " << std::string(tooltip.begin(), tooltip.end()) << "\n";
-    log.close();
+    TRAY_LOG(LogLevel::Debug, "UpdateNextScanTime: tooltip = " << std::string(tooltip.begin(), tooltip.end()));
     
     UpdateTooltip(tooltip);
 }
@@ -301,13 +295,9 @@ LRESULT SystemTray::HandleTrayMessage(HWND hwnd, WPARAM wParam, LPARAM lParam) {
     UINT iconId = (UINT)wParam;
     UINT uMsg = (UINT)lParam;
     
-    // Debug logging - write to file what message we received
-    {
-        std::ofstream log("C:\\Users\\NalleBerg\\AppData\\Roaming\\WinUpdate\\tray_debug.txt", std::ios::app);
-        log << "Tray message: wParam=" << wParam << ", lParam=" << lParam 
-            << " (iconId=" << iconId << ", uMsg=" << uMsg << ")\n";
-        log.close();
-    }
+    // Debug logging - every mouse move over the icon lands here, so Trace only
+    TRAY_LOG(LogLevel::Trace, "Tray message: wParam=" << wParam << ", lParam=" << lParam
+             << " (iconId=" << iconId << ", uMsg=" << uMsg << ")");
     
     // Check if this is for our icon
     if (iconId != 1) return 0;
@@ -322,7 +322,7 @@ bool ShowUnexcludeDialog(HWND parent, const std::string &locale) {
                 }
                 if (!name.empty() && !id.empty()) {
                     idToName[id] = name;
-                    AppendLog(std::string("[unexclude] In-memory: id='") + id + "' name='" + name + "'\n");
+                    LOG_TRACE("[unexclude] In-memory: id='" << id << "' name='" << name << "'");
                 }
             }
         }
@@ -344,7 +344,7 @@ bool ShowUnexcludeDialog(HWND parent, const std::string &locale) {
             auto it = idToName.find(e.id);
             if (it != idToName.end()) {
                 e.name = it->second;
-                AppendLog(std::string("[unexclude] Using in-memory name='") + e.name + "' for id='" + e.id + "'\n");
+                LOG_TRACE("[unexclude] Using in-memory name='" << e.name << "' for id='" << e.id << "'");
             }
         }
         // If still same as id, try g_packages
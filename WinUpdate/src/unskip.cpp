@@ -49,29 +49,6 @@ static std::wstring Utf8ToWide(const std::string &s) {
     return out;
 }
 
-// Helper to run a process and capture output
-static std::pair<int,std::string> RunProcessCaptureExitCodeLocal(const std::wstring &cmd, int timeoutMs = 5000) {
-    std::pair<int,std::string> res = {-1, std::string()};
-    SECURITY_ATTRIBUTES sa{}; sa.nLength = sizeof(sa); sa.bInheritHandle = TRUE; sa.lpSecurityDescriptor = NULL;
-    HANDLE hRead = NULL, hWrite = NULL;
-    if (!CreatePipe(&hRead, &hWrite, &sa, 0)) return res;
-    SetHandleInformation(hRead, HANDLE_FLAG_INHERIT, 0);
-    STARTUPINFOW si{}; si.cb = sizeof(si);
-    si.dwFlags |= STARTF_USESTDHANDLES; si.hStdOutput = hWrite; si.hStdError = hWrite; si.hStdInput = NULL;
-    PROCESS_INFORMATION pi{};
-    std::wstring cmdCopy = cmd;
-    if (!CreateProcessW(NULL, &cmdCopy[0], NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) { CloseHandle(hWrite); CloseHandle(hRead); return res; }
-    CloseHandle(hWrite);
-    DWORD wait = WaitForSingleObject(pi.hProcess, timeoutMs > 0 ? (DWORD)timeoutMs : INFINITE);
-    if (wait == WAIT_TIMEOUT) { TerminateProcess(pi.hProcess, 1); res.first = -2; }
-    else { DWORD exitCode = 0; GetExitCodeProcess(pi.hProcess, &exitCode); res.first = (int)exitCode; }
-    std::string out; const DWORD bufSize = 4096; char buf[bufSize]; DWORD read = 0;
-    while (ReadFile(hRead, buf, bufSize, &read, NULL) && read > 0) out.append(buf, buf + read);
-    CloseHandle(hRead); CloseHandle(pi.hProcess); CloseHandle(pi.hThread);
-    res.second = out; return res;
-}
-
-
 // Modal dialog implemented with a simple window and listbox
 
 // Entry type used by the dialog
@@ -382,7 +359,7 @@ bool ShowUnskipDialog(HWND parent) {
                 }
                 if (!name.empty() && !id.empty()) {
                     idToName[id] = name;
-                    AppendLog(std::string("[unskip] In-memory: id='") + id + "' name='" + name + "'\n");
+                    LOG_TRACE("[unskip] In-memory: id='" << id << "' name='" << name << "'");
                 }
             }
         }
@@ -403,7 +380,7 @@ bool ShowUnskipDialog(HWND parent) {
             auto it = idToName.find(e.id);
             if (it != idToName.end()) {
                 e.name = it->second;
-                AppendLog(std::string("[unskip] Using in-memory name='") + e.name + "' for id='" + e.id + "'\n");
+                LOG_TRACE("[unskip] Using in-memory name='" << e.name << "' for id='" << e.id << "'");
             }
         }
         // If still same as id, try g_packages
@@ -0,0 +1,70 @@
+#include "version.h"
+
+static const uint64_t kNumericBit = 1ull << 63;
+static const uint64_t kMaxNumeric = kNumericBit - 1;
+
+static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+static bool IsLetter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+Version::Version() {
+    for (int i = 0; i < kMaxSegments; ++i) seg_[i] = kNumericBit;
+}
+
+Version::Version(std::string_view s) : Version() {
+    size_t i = 0, n = s.size();
+    while (i < n && (s[i] == ' ' || s[i] == '\t')) ++i;
+    while (n > i && (s[n-1] == ' ' || s[n-1] == '\t' || s[n-1] == '\r' || s[n-1] == '\n')) --n;
+    if (i < n && (s[i] == '<' || s[i] == '>')) {
+        bound_ = s[i] == '<' ? -1 : 1;
+        ++i;
+        while (i < n && (s[i] == ' ' || s[i] == '\t')) ++i;
+    }
+    if (i < n && (s[i] == 'v' || s[i] == 'V') && i + 1 < n && IsDigit(s[i+1])) ++i;
+
+    int count = 0;
+    while (i < n && count < kMaxSegments) {
+        char c = s[i];
+        if (IsDigit(c)) {
+            uint64_t v = 0;
+            for (; i < n && IsDigit(s[i]); ++i) {
+                uint64_t d = (uint64_t)(s[i] - '0');
+                // Saturate before multiplying: 20 digits would wrap uint64
+                if (v > (kMaxNumeric - d) / 10) v = kMaxNumeric;
+                else v = v * 10 + d;
+            }
+            seg_[count++] = kNumericBit | v;
+        } else if (IsLetter(c)) {
+            uint64_t v = 0;
+            int letters = 0;
+            for (; i < n && IsLetter(s[i]); ++i) {
+                if (letters < 7) {
+                    char lc = (s[i] >= 'A' && s[i] <= 'Z') ? (char)(s[i] - 'A' + 'a') : s[i];
+                    v |= (uint64_t)(unsigned char)lc << (8 * (6 - letters));
+                    ++letters;
+                }
+            }
+            seg_[count++] = v;
+        } else {
+            ++i;  // '.', '-', '_', '+' and anything else separate segments
+        }
+    }
+    known_ = count > 0;
+    // A lone word such as "Unknown" carries no version information.
+    if (count == 1 && !(seg_[0] & kNumericBit)) known_ = false;
+    if (!known_) {
+        for (int k = 0; k < kMaxSegments; ++k) seg_[k] = kNumericBit;
+        bound_ = 0;
+    }
+}
+
+int Version::Compare(const Version &o) const {
+    if (known_ != o.known_) return known_ ? 1 : -1;
+    for (int i = 0; i < kMaxSegments; ++i) {
+        if (seg_[i] != o.seg_[i]) return seg_[i] < o.seg_[i] ? -1 : 1;
+    }
+    return (bound_ > o.bound_) - (bound_ < o.bound_);
+}
+
+int CompareVersionStrings(std::string_view a, std::string_view b) {
+    return Version(a).Compare(Version(b));
+}
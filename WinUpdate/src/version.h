@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Package version parsed once into a fixed array of comparable segments.
+//
+// "1.2.3-beta2" becomes [1, 2, 3, "beta", 2]: segments split on '.', '-', '_',
+// '+' and on every digit/letter boundary. Each segment is packed into one
+// 64-bit key (numbers with the top bit set, up to 7 lower-cased letters
+// without it) so that comparing two versions is a plain integer compare per
+// segment, with no allocation or exceptions. Missing segments count as 0 and
+// letters sort below numbers, so "1.0" == "1.0.0" and "1.0-rc1" < "1.0".
+//
+// winget forms:
+//   "Unknown" (or empty)  sorts below every known version
+//   "< 1.2" / "> 3.0"     sort just below / above "1.2" / "3.0"
+//   "v2.1"                the leading 'v' is ignored
+// Segments past kMaxSegments and letters past the 7th of a word are ignored.
+// No Windows dependency, so it can be shared with WinProgramManager.
+class Version {
+public:
+    static const int kMaxSegments = 8;
+
+    Version();
+    explicit Version(std::string_view text);
+
+    bool IsKnown() const { return known_; }
+    // -1, 0 or 1.
+    int Compare(const Version &o) const;
+
+    bool operator<(const Version &o) const { return Compare(o) < 0; }
+    bool operator>(const Version &o) const { return Compare(o) > 0; }
+    bool operator<=(const Version &o) const { return Compare(o) <= 0; }
+    bool operator>=(const Version &o) const { return Compare(o) >= 0; }
+    bool operator==(const Version &o) const { return Compare(o) == 0; }
+    bool operator!=(const Version &o) const { return Compare(o) != 0; }
+
+private:
+    uint64_t seg_[kMaxSegments];
+    int8_t bound_ = 0;     // -1 for "< x", +1 for "> x"
+    bool known_ = false;
+};
+
+// Parse both sides and compare (-1, 0, 1). Prefer caching Version values when
+// the same strings are compared more than once.
+int CompareVersionStrings(std::string_view a, std::string_view b);
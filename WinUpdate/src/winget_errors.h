@@ -1,5 +1,11 @@
 #pragma once
 #include <string>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdint>
+typedef uint32_t DWORD;   // the portable scanner reads exit codes off Windows too
+#endif
 
 // Winget exit codes and error handling utilities
 // Based on official Microsoft documentation:
@@ -0,0 +1,286 @@
+#include "winget_table.h"
+#include <cstdint>
+#include <cstring>
+
+// Decode one UTF-8 code point starting at s[i]. Invalid or truncated
+// sequences consume a single byte so non-UTF-8 (OEM code page) output still
+// advances one cell per byte.
+static uint32_t DecodeUtf8(std::string_view s, size_t i, size_t &len) {
+    unsigned char c = (unsigned char)s[i];
+    if (c < 0x80) { len = 1; return c; }
+    size_t need = 0;
+    uint32_t cp = 0;
+    if ((c & 0xE0) == 0xC0) { need = 1; cp = c & 0x1F; }
+    else if ((c & 0xF0) == 0xE0) { need = 2; cp = c & 0x0F; }
+    else if ((c & 0xF8) == 0xF0) { need = 3; cp = c & 0x07; }
+    else { len = 1; return c; }
+    if (i + need >= s.size()) { len = 1; return c; }
+    for (size_t k = 1; k <= need; ++k) {
+        unsigned char cc = (unsigned char)s[i + k];
+        if ((cc & 0xC0) != 0x80) { len = 1; return c; }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    len = need + 1;
+    return cp;
+}
+
+// Terminal cells used by a code point: 2 for East Asian Wide/Fullwidth,
+// 0 for combining marks and zero-width characters, 1 otherwise.
+static int CellWidth(uint32_t cp) {
+    if (cp < 0x300) return 1;
+    if ((cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x200B && cp <= 0x200F) || cp == 0xFEFF) return 0;
+    if ((cp >= 0x1100 && cp <= 0x115F) ||
+        (cp >= 0x2E80 && cp <= 0x303E) ||
+        (cp >= 0x3041 && cp <= 0x33FF) ||
+        (cp >= 0x3400 && cp <= 0x4DBF) ||
+        (cp >= 0x4E00 && cp <= 0x9FFF) ||
+        (cp >= 0xA000 && cp <= 0xA4CF) ||
+        (cp >= 0xAC00 && cp <= 0xD7A3) ||
+        (cp >= 0xF900 && cp <= 0xFAFF) ||
+        (cp >= 0xFE30 && cp <= 0xFE4F) ||
+        (cp >= 0xFF00 && cp <= 0xFF60) ||
+        (cp >= 0xFFE0 && cp <= 0xFFE6) ||
+        (cp >= 0x1F300 && cp <= 0x1F64F) ||
+        (cp >= 0x1F900 && cp <= 0x1F9FF) ||
+        (cp >= 0x20000 && cp <= 0x3FFFD)) return 2;
+    return 1;
+}
+
+size_t DisplayWidth(std::string_view s) {
+    size_t cells = 0;
+    for (size_t i = 0; i < s.size();) {
+        size_t len = 1;
+        cells += CellWidth(DecodeUtf8(s, i, len));
+        i += len;
+    }
+    return cells;
+}
+
+std::string_view TrimView(std::string_view s) {
+    size_t a = 0, b = s.size();
+    while (a < b && (s[a] == ' ' || s[a] == '\t' || s[a] == '\r' || s[a] == '\n')) ++a;
+    while (b > a && (s[b-1] == ' ' || s[b-1] == '\t' || s[b-1] == '\r' || s[b-1] == '\n')) --b;
+    return s.substr(a, b - a);
+}
+
+bool IsNumericVersion(std::string_view s) {
+    if (s.empty()) return false;
+    bool needDigit = true;
+    for (char c : s) {
+        if (c >= '0' && c <= '9') { needDigit = false; continue; }
+        if (c == '.' && !needDigit) { needDigit = true; continue; }
+        return false;
+    }
+    return !needDigit;
+}
+
+size_t SplitWhitespace(std::string_view line, std::string_view *out, size_t maxTokens) {
+    size_t count = 0;
+    size_t i = 0, n = line.size();
+    while (i < n) {
+        while (i < n && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r' || line[i] == '\n')) ++i;
+        if (i >= n) break;
+        size_t start = i;
+        while (i < n && line[i] != ' ' && line[i] != '\t' && line[i] != '\r' && line[i] != '\n') ++i;
+        if (count < maxTokens) out[count] = line.substr(start, i - start);
+        ++count;
+    }
+    return count;
+}
+
+std::string_view JoinTokenSpan(const std::string_view *tokens, size_t first, size_t last) {
+    const char *a = tokens[first].data();
+    const char *b = tokens[last].data() + tokens[last].size();
+    return std::string_view(a, (size_t)(b - a));
+}
+
+static bool EndsWithEllipsis(std::string_view s) {
+    return s.size() >= 3 && std::memcmp(s.data() + s.size() - 3, "\xE2\x80\xA6", 3) == 0;
+}
+
+static bool IsSeparatorLine(std::string_view t) {
+    if (t.size() < 3) return false;
+    for (char c : t) if (c != '-') return false;
+    return true;
+}
+
+static int ColumnKindFromHeader(std::string_view word) {
+    if (word == "Name") return WCOL_NAME;
+    if (word == "Id") return WCOL_ID;
+    if (word == "Version") return WCOL_VERSION;
+    if (word == "Available") return WCOL_AVAILABLE;
+    if (word == "Source") return WCOL_SOURCE;
+    if (word == "Match") return WCOL_MATCH;
+    return -1;
+}
+
+// Read column starts from the header. Each header word begins a column;
+// unrecognised (localised) headers fall back to winget's fixed column order.
+static bool BuildLayout(std::string_view header, WingetTableLayout &layout) {
+    layout.count = 0;
+    size_t cell = 0;
+    bool prevSpace = true;
+    size_t wordStart = 0;
+    size_t wordBytes[WingetTableLayout::kMaxCols] = {};
+    size_t wordLens[WingetTableLayout::kMaxCols] = {};
+    for (size_t i = 0; i < header.size();) {
+        size_t len = 1;
+        uint32_t cp = DecodeUtf8(header, i, len);
+        bool space = (cp == ' ' || cp == '\t');
+        if (!space && prevSpace) {
+            if (layout.count >= WingetTableLayout::kMaxCols) return false;
+            layout.start[layout.count] = cell;
+            wordBytes[layout.count] = i;
+            wordStart = i;
+            layout.count++;
+        }
+        if (space && !prevSpace && layout.count > 0) wordLens[layout.count - 1] = i - wordStart;
+        prevSpace = space;
+        cell += CellWidth(cp);
+        i += len;
+    }
+    if (!prevSpace && layout.count > 0) wordLens[layout.count - 1] = header.size() - wordStart;
+    if (layout.count < 2) return false;
+
+    bool anyKnown = false;
+    for (int c = 0; c < layout.count; ++c) {
+        layout.kind[c] = ColumnKindFromHeader(header.substr(wordBytes[c], wordLens[c]));
+        if (layout.kind[c] >= 0) anyKnown = true;
+    }
+    if (!anyKnown) {
+        // Localised header: Name, Id, Version, [Available], ..., Source
+        static const int order5[] = { WCOL_NAME, WCOL_ID, WCOL_VERSION, WCOL_AVAILABLE, WCOL_SOURCE };
+        for (int c = 0; c < layout.count; ++c) layout.kind[c] = -1;
+        for (int c = 0; c < layout.count && c < 3; ++c) layout.kind[c] = order5[c];
+        if (layout.count == 4) layout.kind[3] = WCOL_SOURCE;
+        else if (layout.count >= 5) { layout.kind[3] = WCOL_AVAILABLE; layout.kind[layout.count - 1] = WCOL_SOURCE; }
+    }
+    for (int c = 0; c < layout.count; ++c) if (layout.kind[c] == WCOL_ID) return true;
+    return false;
+}
+
+// Slice one data line by the layout. Returns false when the line does not
+// line up with the header (footers, prose, wrapped output).
+static bool SliceRow(std::string_view line, const WingetTableLayout &layout, WingetTableRow &row) {
+    for (int f = 0; f < WCOL_COUNT; ++f) row.field[f] = std::string_view();
+    row.truncated = 0;
+
+    size_t bytePos[WingetTableLayout::kMaxCols + 1];
+    size_t cell = 0, i = 0;
+    int c = 0;
+    while (c < layout.count) {
+        while (i < line.size() && cell < layout.start[c]) {
+            if ((unsigned char)line[i] < 0x80) { ++cell; ++i; continue; }  // ASCII fast path
+            size_t len = 1;
+            cell += CellWidth(DecodeUtf8(line, i, len));
+            i += len;
+        }
+        if (i >= line.size() && cell < layout.start[c]) break;  // line ends before this column
+        // Columns are separated by at least one space; a wide glyph spilling
+        // over the boundary or text in the gap means this is not a table row.
+        if (cell != layout.start[c]) return false;
+        if (c > 0 && i > 0 && line[i-1] != ' ') return false;
+        bytePos[c] = i;
+        ++c;
+    }
+    int present = c;
+    for (int k = 0; k < present; ++k) {
+        size_t a = bytePos[k];
+        size_t b = (k + 1 < present) ? bytePos[k + 1] : line.size();
+        int kind = layout.kind[k];
+        if (kind < 0) continue;
+        std::string_view v = TrimView(line.substr(a, b - a));
+        row.field[kind] = v;
+        if (EndsWithEllipsis(v)) row.truncated |= (1u << kind);
+    }
+    std::string_view id = row.field[WCOL_ID];
+    if (id.empty() || id.find(' ') != std::string_view::npos) return false;
+    for (int k = 0; k < layout.count; ++k) {
+        if (layout.kind[k] == WCOL_VERSION && row.field[WCOL_VERSION].empty()) return false;
+    }
+    return true;
+}
+
+bool NextWingetLine(std::string_view text, size_t &pos, std::string_view &line) {
+    if (pos >= text.size()) return false;
+    size_t nl = text.find('\n', pos);
+    size_t end = (nl == std::string_view::npos) ? text.size() : nl;
+    line = text.substr(pos, end - pos);
+    pos = (nl == std::string_view::npos) ? text.size() : nl + 1;
+    while (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    // Progress spinners rewrite the line with '\r'; only the final state is visible.
+    size_t cr = line.rfind('\r');
+    if (cr != std::string_view::npos) line.remove_prefix(cr + 1);
+    return true;
+}
+
+WingetTableStream::WingetTableStream(WingetRowCallback onRow) : onRow_(std::move(onRow)) {}
+
+void WingetTableStream::Line(std::string_view line) {
+    ++lineNo_;
+    while (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    // Progress spinners rewrite the line with '\r'; only the final state is visible.
+    size_t cr = line.rfind('\r');
+    if (cr != std::string_view::npos) line.remove_prefix(cr + 1);
+    std::string_view t = TrimView(line);
+    if (IsSeparatorLine(t)) {
+        inTable_ = BuildLayout(header_, layout_);
+        if (inTable_) ++table_;
+        header_.clear();
+        return;
+    }
+    if (t.empty()) {
+        inTable_ = false;
+        return;
+    }
+    if (!inTable_) {
+        // Remember the latest non-empty line; it becomes the header when a separator follows.
+        header_.assign(line.data(), line.size());
+        return;
+    }
+    WingetTableRow row;
+    if (SliceRow(line, layout_, row)) {
+        row.table = table_;
+        row.line = lineNo_;
+        ++delivered_;
+        if (!onRow_(row)) stopped_ = true;
+    }
+}
+
+void WingetTableStream::Push(std::string_view chunk) {
+    size_t i = 0;
+    while (!stopped_) {
+        size_t nl = chunk.find('\n', i);
+        if (nl == std::string_view::npos) break;
+        if (partial_.empty()) {
+            Line(chunk.substr(i, nl - i));   // whole line inside this chunk: no copy
+        } else {
+            partial_.append(chunk.data() + i, nl - i);
+            Line(partial_);
+            partial_.clear();
+        }
+        i = nl + 1;
+    }
+    if (stopped_ || i >= chunk.size()) return;
+    partial_.append(chunk.data() + i, chunk.size() - i);
+    // Collapse spinner redraws in the unfinished line so it cannot grow without
+    // bound. A trailing '\r' may be the first half of "\r\n", so keep it.
+    size_t cr = partial_.rfind('\r');
+    if (cr != std::string::npos && cr + 1 < partial_.size()) partial_.erase(0, cr + 1);
+}
+
+void WingetTableStream::Finish() {
+    if (!stopped_ && !partial_.empty()) {
+        std::string last;
+        last.swap(partial_);
+        Line(last);
+    }
+    partial_.clear();
+}
+
+size_t ForEachWingetRow(std::string_view text, const WingetRowCallback &onRow) {
+    WingetTableStream stream(onRow);
+    stream.Push(text);
+    stream.Finish();
+    return stream.rows();
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstddef>
+
+// Column-offset parser for the fixed-width tables printed by `winget upgrade`,
+// `winget list` and `winget search`.
+//
+// Column start offsets are taken from the header line that precedes the
+// `----` separator, measured in terminal cells (CJK wide/fullwidth characters
+// count as two cells, exactly as winget lays them out). Every data row is then
+// sliced into std::string_view fields pointing into the caller's buffer, so no
+// memory is allocated per line. This file has no Windows dependency so it can
+// be shared with WinProgramManager and built on any platform.
+
+enum WingetColumn {
+    WCOL_NAME = 0,
+    WCOL_ID,
+    WCOL_VERSION,
+    WCOL_AVAILABLE,
+    WCOL_SOURCE,
+    WCOL_MATCH,
+    WCOL_COUNT
+};
+
+struct WingetTableRow {
+    std::string_view field[WCOL_COUNT];  // trimmed cells; empty if column absent
+    unsigned truncated = 0;              // bit (1 << column) set when the cell ends with "…"
+    int table = 0;                       // 0 = first table in the text, 1 = second, ...
+    int line = 0;                        // 1-based line number in the input
+
+    std::string_view name() const { return field[WCOL_NAME]; }
+    std::string_view id() const { return field[WCOL_ID]; }
+    std::string_view version() const { return field[WCOL_VERSION]; }
+    std::string_view available() const { return field[WCOL_AVAILABLE]; }
+    std::string_view source() const { return field[WCOL_SOURCE]; }
+    bool IsTruncated(WingetColumn c) const { return (truncated & (1u << c)) != 0; }
+};
+
+// Return false from the callback to stop parsing early.
+using WingetRowCallback = std::function<bool(const WingetTableRow &row)>;
+
+// Parse every table found in `text` and invoke `onRow` for each data row.
+// Spinner overwrites (`\r`) are collapsed per line and a blank line ends the
+// current table. Footers such as "3 upgrades available." never line up with
+// the column gaps and are dropped. Returns the number of rows delivered.
+size_t ForEachWingetRow(std::string_view text, const WingetRowCallback &onRow);
+
+// Column layout read from one header line (cell offsets, not bytes).
+struct WingetTableLayout {
+    static const int kMaxCols = 8;
+    size_t start[kMaxCols] = {};   // first cell of each column
+    int kind[kMaxCols] = {};       // WingetColumn or -1 for unknown columns
+    int count = 0;
+};
+
+// Push-style parser for output that is still arriving through a pipe. Feed
+// chunks as they are read; each row is delivered as soon as its line ends,
+// so the first package is known long before winget exits. Bare '\r' spinner
+// redraws are collapsed the same way the install dialog does.
+class WingetTableStream {
+public:
+    explicit WingetTableStream(WingetRowCallback onRow);
+    void Push(std::string_view chunk);
+    // Parse a final line that was not terminated by '\n'.
+    void Finish();
+    size_t rows() const { return delivered_; }
+    bool stopped() const { return stopped_; }
+
+private:
+    void Line(std::string_view line);
+
+    WingetRowCallback onRow_;
+    std::string partial_;          // unfinished line carried between chunks
+    std::string header_;           // last non-empty line outside a table
+    WingetTableLayout layout_;
+    bool inTable_ = false;
+    bool stopped_ = false;
+    int table_ = -1;
+    int lineNo_ = 0;
+    size_t delivered_ = 0;
+};
+
+// Small helpers shared by the token based fallbacks in parsing.cpp/main.cpp.
+// Fetch the next line starting at `pos` (advanced past the newline). Trailing
+// '\r' is dropped and spinner overwrites are collapsed. Returns false at end.
+bool NextWingetLine(std::string_view text, size_t &pos, std::string_view &line);
+std::string_view TrimView(std::string_view s);
+// True for plain numeric versions such as "1", "2.10" or "10.0.19041.1".
+bool IsNumericVersion(std::string_view s);
+// Split on runs of spaces/tabs. Returns the number of tokens in the line;
+// only the first `maxTokens` of them are stored in `out`.
+size_t SplitWhitespace(std::string_view line, std::string_view *out, size_t maxTokens);
+// View spanning tokens[first..last] (inclusive) of the same line, spaces included.
+std::string_view JoinTokenSpan(const std::string_view *tokens, size_t first, size_t last);
+// Number of terminal cells `s` occupies (UTF-8, wide characters count as 2).
+size_t DisplayWidth(std::string_view s);
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal assertion helpers for the test executables. A failed CHECK prints
+// where it failed and is counted; main() returns TestResult() so CTest sees a
+// non-zero exit code if anything failed.
+
+inline int &TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++TestFailures(); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        if (!((a) == (b))) { \
+            std::ostringstream check_os_; \
+            check_os_ << (a) << " != " << (b); \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%s)\n", __FILE__, __LINE__, #a, #b, \
+                         check_os_.str().c_str()); \
+            ++TestFailures(); \
+        } \
+    } while (0)
+
+inline int TestResult(const char *name) {
+    if (TestFailures() == 0) {
+        std::printf("%s: all checks passed\n", name);
+        return 0;
+    }
+    std::printf("%s: %d check(s) failed\n", name, TestFailures());
+    return 1;
+}
+
+// Whole file as bytes; empty if it cannot be read.
+inline std::string ReadFixture(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// Tab-separated lines of a fixture, '#' comments skipped.
+inline std::vector<std::vector<std::string>> ReadFixtureTable(const std::string &path) {
+    std::vector<std::vector<std::string>> rows;
+    std::istringstream in(ReadFixture(path));
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        std::vector<std::string> cells;
+        size_t start = 0;
+        for (;;) {
+            size_t tab = line.find('\t', start);
+            cells.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+            if (tab == std::string::npos) break;
+            start = tab + 1;
+        }
+        rows.push_back(cells);
+    }
+    return rows;
+}
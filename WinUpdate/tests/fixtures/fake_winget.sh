@@ -0,0 +1,35 @@
+#!/bin/sh
+# Stands in for winget in process_runner_test. Run as `sh fake_winget.sh <mode> ...`:
+#   print <file> <times>   print the file <times> times, then exit 0
+#   exit <code>            print winget's "nothing to do" line and exit <code>
+#   slow <seconds>         print nothing for <seconds>, then one line
+#   hang <pid file>        print a spinner frame, start a child that records its
+#                          pid, and wait for it (30 s)
+#   linger                 leave a background child holding the output open
+#                          after exiting
+case "$1" in
+print)
+    i=0
+    while [ "$i" -lt "$3" ]; do
+        cat "$2"
+        i=$((i + 1))
+    done
+    ;;
+exit)
+    echo "No installed package found matching input criteria."
+    exit "$2"
+    ;;
+slow)
+    sleep "$2"
+    echo "Name   Id   Version"
+    ;;
+hang)
+    printf '   - \r'
+    sh -c 'echo $$ > "$1"; exec sleep 30' sh "$2" &
+    wait
+    ;;
+linger)
+    (sleep 30; echo late) &
+    echo "done"
+    ;;
+esac
@@ -0,0 +1,195 @@
+// The background logger: level filtering, explicit and size rotation, lines
+// dropped when the ring overflows (each one either written or counted in the
+// "dropped" report), and the lines still queued when the process exits.
+//
+// Usage: logging_test <scratch dir>
+#include "check.h"
+#include "logging.h"
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const int kExitLines = 2000;
+
+std::vector<std::string> Lines(const fs::path &path) {
+    std::vector<std::string> lines;
+    std::istringstream in(ReadFixture(path.string()));
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+bool Contains(const std::vector<std::string> &lines, const std::string &line) {
+    for (const auto &l : lines) if (l == line) return true;
+    return false;
+}
+
+// Run in a child process: queue lines and return from main without flushing
+int ExitChild() {
+    SetLogLevel(LogLevel::Info);
+    for (int i = 0; i < kExitLines; ++i) LOG_INFO("exit " << i);
+    return 0;
+}
+
+void TestFlushOnExit(const fs::path &self, const fs::path &dir) {
+    fs::create_directories(dir);
+    fs::current_path(dir);
+    std::string cmd = "\"" + self.string() + "\" --exit-child";
+    CHECK_EQ(std::system(cmd.c_str()), 0);
+    std::vector<std::string> lines = Lines(dir / "logs" / "wup_run_log.txt");
+    CHECK_EQ(lines.size(), (size_t)kExitLines);
+    if (!lines.empty()) CHECK_EQ(lines.back(), "exit " + std::to_string(kExitLines - 1));
+}
+
+void TestLevels() {
+    SetLogLevel(LogLevel::Warn);
+    LOG_INFO("level info");
+    LOG_WARN("level warn");
+    AppendLog("level append\n");
+    SetLogLevel(LogLevel::Trace);
+    LOG_TRACE("level trace");
+    AppendLog("level ");
+    AppendLog("joined\n");
+    SetLoggingEnabled(false);
+    LOG_ERROR("level disabled");
+    AppendLog("level disabled append\n");
+    SetLoggingEnabled(true);
+    LogFlush();
+    std::vector<std::string> lines = Lines(fs::path("logs") / "wup_run_log.txt");
+    CHECK_EQ(lines.size(), 3u);
+    CHECK(Contains(lines, "level warn"));
+    CHECK(Contains(lines, "level trace"));
+    CHECK(Contains(lines, "level joined"));
+}
+
+// LogRotate moves what was written so far to "<file>.1" between two lines
+void TestRotate() {
+    HIDDEN_LOG(LogLevel::Info, "before rotate");
+    LogRotate(LogChannel::HiddenScan);
+    HIDDEN_LOG(LogLevel::Info, "after rotate");
+    TRAY_LOG(LogLevel::Info, "tray");
+    LogFlush();
+    CHECK_EQ(ReadFixture("hidden_scan_debug.txt.1"), std::string("before rotate\n"));
+    CHECK_EQ(ReadFixture("hidden_scan_debug.txt"), std::string("after rotate\n"));
+    CHECK_EQ(ReadFixture("tray_debug.txt"), std::string("tray\n"));
+}
+
+// Producers racing the writer: 9.6 MB from eight threads rotates the 8 MB run
+// log once. Every line is either on disk, in each thread's order, or counted
+// in a "dropped" report
+void TestOverflow() {
+    const int threads = 8, perThread = 10000;
+    const std::string pad(100, 'x');
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&, t] {
+            for (int i = 0; i < perThread; ++i) LOG_INFO("burst " << t << " " << i << " " << pad);
+        });
+    }
+    for (auto &p : producers) p.join();
+    // Drained after every producer returned, so it also reports the last drops
+    LOG_INFO("burst end");
+    LogFlush();
+
+    std::vector<std::string> lines = Lines(fs::path("logs") / "wup_run_log.txt.1");
+    std::vector<std::string> current = Lines(fs::path("logs") / "wup_run_log.txt");
+    CHECK(!lines.empty());
+    CHECK(fs::file_size(fs::path("logs") / "wup_run_log.txt") < 8u * 1024 * 1024);
+    lines.insert(lines.end(), current.begin(), current.end());
+    size_t written = 0, dropped = 0;
+    std::vector<int> next(threads, 0);
+    bool ordered = true;
+    for (const auto &l : lines) {
+        int t = 0, i = 0;
+        size_t n = 0;
+        if (std::sscanf(l.c_str(), "burst %d %d", &t, &i) == 2 && t >= 0 && t < threads) {
+            if (i < next[t]) ordered = false;
+            next[t] = i + 1;
+            ++written;
+        } else if (std::sscanf(l.c_str(), "AsyncLogger: dropped %zu", &n) == 1) {
+            dropped += n;
+        }
+    }
+    std::printf("overflow: %zu lines written, %zu dropped\n", written, dropped);
+    CHECK(ordered);
+    CHECK_EQ(written + dropped, (size_t)threads * perThread);
+    CHECK(Contains(current, "burst end"));
+}
+
+#ifndef _WIN32
+// A writer stuck on its file: the run log is a FIFO nobody reads yet, so the
+// writer blocks opening it and the ring fills. Lines past its capacity are
+// dropped, not waited for, and reported once the writer gets going again
+void TestStalledWriter() {
+    LogRotate(LogChannel::Run);
+    LogFlush();
+    fs::path fifo = fs::path("logs") / "wup_run_log.txt";
+    CHECK(mkfifo(fifo.c_str(), 0600) == 0);
+    const int threads = 8, perThread = 8192 / threads + 64;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&, t] {
+            for (int i = 0; i < perThread; ++i) LOG_INFO("stall " << t << " " << i);
+        });
+    }
+    for (auto &p : producers) p.join();
+    std::string out;
+    std::thread reader([&] { out = ReadFixture(fifo.string()); });
+    LOG_INFO("stall end");
+    LogRotate(LogChannel::Run);   // closes the FIFO: the reader sees its end
+    LogFlush();
+    reader.join();
+    // The drop report follows the lines drained with it, after the rotation
+    out += ReadFixture(fifo.string());
+
+    std::istringstream in(out);
+    std::string line;
+    size_t written = 0, dropped = 0, n = 0;
+    bool end = false;
+    while (std::getline(in, line)) {
+        int t = 0, i = 0;
+        if (std::sscanf(line.c_str(), "stall %d %d", &t, &i) == 2) ++written;
+        else if (std::sscanf(line.c_str(), "AsyncLogger: dropped %zu", &n) == 1) dropped += n;
+        else if (line == "stall end") end = true;
+    }
+    std::printf("stalled writer: %zu lines written, %zu dropped\n", written, dropped);
+    CHECK(dropped > 0);
+    CHECK(written <= 8192 + 1);   // the ring and the line the writer is stuck on
+    CHECK_EQ(written + dropped, (size_t)threads * perThread);
+    CHECK(end);
+}
+#endif
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && std::string(argv[1]) == "--exit-child") return ExitChild();
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    fs::path self = fs::absolute(argv[0]);
+    fs::path dir = fs::absolute(argv[1]) / "logging_test";
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    TestFlushOnExit(self, dir / "exit");
+    // The logger opens its files relative to the working directory at first use
+    fs::create_directories(dir / "run");
+    fs::current_path(dir / "run");
+    TestLevels();
+    TestRotate();
+    TestOverflow();
+#ifndef _WIN32
+    TestStalledWriter();
+#endif
+    return TestResult("logging_test");
+}
@@ -0,0 +1,82 @@
+// Benchmark of the upgrade-table parser with logging at Info and at Trace.
+//
+// Usage: parse_logging_bench <scratch dir> [rows] [passes]
+//   Parses a synthetic `rows`-row upgrade table (default 5000) `passes` times
+//   (default 20) with ParseUpgradeFast, first at Info, where the per-row
+//   LOG_TRACE call sites cost a branch, then at Trace, where every row is
+//   queued for the background writer, and reports how long the writer takes
+//   to drain. The logs and the skip list go to the scratch dir. Exits 1 if
+//   either pass misses a row; the times are reported, not checked.
+#include "check.h"
+#include "logging.h"
+#include "parsing.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string UpgradeTable(int rows) {
+    std::string text = "Name                 Id                        Version   Available Source\n";
+    text += std::string(76, '-') + "\n";
+    char line[128];
+    for (int i = 0; i < rows; ++i) {
+        std::snprintf(line, sizeof(line), "Bench App %-10d Bench.Package%-12d 1.%-7d 2.%-7d winget\n", i, i, i % 1000, i % 1000);
+        text += line;
+    }
+    return text;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir> [rows] [passes]\n", argv[0]);
+        return 2;
+    }
+    int rows = argc >= 3 ? atoi(argv[2]) : 5000;
+    int passes = argc >= 4 ? atoi(argv[3]) : 20;
+    if (rows <= 0) rows = 5000;
+    if (passes <= 0) passes = 20;
+    std::filesystem::path dir = std::filesystem::path(argv[1]) / "parse_logging_bench";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir);
+    std::filesystem::current_path(dir);
+    setenv("APPDATA", dir.string().c_str(), 1);
+
+    std::string text = UpgradeTable(rows);
+    auto timePasses = [&](LogLevel lvl, size_t &found) {
+        SetLogLevel(lvl);
+        auto start = std::chrono::steady_clock::now();
+        for (int p = 0; p < passes; ++p) {
+            std::set<std::pair<std::string,std::string>> out;
+            ParseUpgradeFast(text, out);
+            found = out.size();
+        }
+        return MillisecondsSince(start);
+    };
+    size_t foundInfo = 0, foundTrace = 0;
+    timePasses(LogLevel::Info, foundInfo);  // warm the SkipStore and caches
+    double msInfo = timePasses(LogLevel::Info, foundInfo);
+    double msTrace = timePasses(LogLevel::Trace, foundTrace);
+    SetLogLevel(LogLevel::Info);
+    auto flushStart = std::chrono::steady_clock::now();
+    LogFlush();
+    double msFlush = MillisecondsSince(flushStart);
+    double total = (double)rows * passes;
+    std::printf("%d rows x %d passes: INFO %.2f ms (%.0f rows/s, %zu found), TRACE %.2f ms (%.0f rows/s, %zu found), "
+                "writer drain %.2f ms\n",
+                rows, passes, msInfo, total * 1000.0 / (msInfo > 0 ? msInfo : 1), foundInfo,
+                msTrace, total * 1000.0 / (msTrace > 0 ? msTrace : 1), foundTrace, msFlush);
+    CHECK_EQ(foundInfo, (size_t)rows);
+    CHECK_EQ(foundTrace, (size_t)rows);
+    return TestResult("parse_logging_bench");
+}
@@ -0,0 +1,150 @@
+// The process runner's POSIX backend against fixtures/fake_winget.sh: output
+// larger than the pipe buffer, the timeout and cancellation killing the
+// whole process group, exit codes, time to first byte and the drain window
+// for children that outlive the command.
+//
+// Usage: process_runner_test <fixtures dir> <scratch dir>
+#include "check.h"
+#include "process_runner.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+
+std::string g_script;    // "sh '<fixtures>/fake_winget.sh'"
+std::string g_fixtures;
+std::string g_scratch;
+
+std::string FakeWinget(const std::string &args) { return g_script + " " + args; }
+
+// The process recorded in `pidFile` is gone (killed with its group). It was
+// reparented when the shell died, so it may linger as a zombie until init
+// reaps it; on Linux that counts as gone.
+bool ProcessGone(const std::string &pidFile) {
+    int pid = atoi(ReadFixture(pidFile).c_str());
+    if (pid <= 0) return false;
+    for (int i = 0; i < 100; ++i) {
+        if (::kill(pid, 0) != 0 && errno == ESRCH) return true;
+        std::string stat = ReadFixture("/proc/" + std::to_string(pid) + "/stat");
+        size_t paren = stat.rfind(')');
+        if (paren != std::string::npos && paren + 2 < stat.size() && stat[paren + 2] == 'Z') return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// 200 copies of the capture, far past the 64 KB pipe buffer: read fully
+// while the command runs, and streamed to onChunk piece by piece
+void TestLargeOutput() {
+    std::string capture = ReadFixture(g_fixtures + "/winget_upgrade.txt");
+    CHECK(!capture.empty());
+    std::string expected;
+    for (int i = 0; i < 200; ++i) expected += capture;
+    CHECK(expected.size() > 64 * 1024);
+    std::string streamed;
+    size_t chunks = 0;
+    ProcessOptions opts;
+    opts.timeoutMs = 10000;
+    opts.onChunk = [&](const char *data, size_t len) { streamed.append(data, len); ++chunks; };
+    ProcessResult r = RunProcess(FakeWinget("print '" + g_fixtures + "/winget_upgrade.txt' 200"), opts);
+    CHECK_EQ(r.exitCode, 0);
+    CHECK_EQ(r.output.size(), expected.size());
+    CHECK(r.output == expected);
+    CHECK(streamed == r.output);
+    CHECK(chunks > 1);
+    CHECK(r.firstByteMs >= 0);
+    CHECK(r.firstByteMs <= r.totalMs);
+    CHECK(r.totalMs < opts.timeoutMs);
+}
+
+void TestExitCode() {
+    ProcessResult r = RunProcess(FakeWinget("exit 3"));
+    CHECK(r.started());
+    CHECK_EQ(r.exitCode, 3);
+    CHECK_EQ(r.output, std::string("No installed package found matching input criteria.\n"));
+    CHECK_EQ(RunProcess(FakeWinget("exit 0")).exitCode, 0);
+    CHECK_EQ(RunProcess("exit 0").firstByteMs, -1LL);
+}
+
+// First byte after the fake winget's 300 ms of silence, not at exit or start
+void TestFirstByte() {
+    ProcessResult r = RunProcess(FakeWinget("slow 0.3"));
+    CHECK_EQ(r.exitCode, 0);
+    CHECK_EQ(r.output, std::string("Name   Id   Version\n"));
+    CHECK(r.firstByteMs >= 250);
+    CHECK(r.firstByteMs <= r.totalMs);
+}
+
+// The timeout kills the shell and the child it waits for; the spinner frame
+// printed before is kept
+void TestTimeout() {
+    std::string pidFile = g_scratch + "/timeout.pid";
+    ProcessOptions opts;
+    opts.timeoutMs = 300;
+    ProcessResult r = RunProcess(FakeWinget("hang '" + pidFile + "'"), opts);
+    CHECK(r.timedOut());
+    CHECK_EQ(r.exitCode, kProcessTimedOut);
+    CHECK(r.totalMs >= 300);
+    CHECK(r.totalMs < 5000);
+    CHECK_EQ(r.output, std::string("   - \r"));
+    CHECK(ProcessGone(pidFile));
+}
+
+void TestCancel() {
+    std::string pidFile = g_scratch + "/cancel.pid";
+    std::atomic<bool> cancel{false};
+    std::thread canceller([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        cancel = true;
+    });
+    ProcessOptions opts;
+    opts.timeoutMs = 20000;
+    opts.cancel = &cancel;
+    ProcessResult r = RunProcess(FakeWinget("hang '" + pidFile + "'"), opts);
+    canceller.join();
+    CHECK(r.cancelled());
+    CHECK_EQ(r.exitCode, kProcessCancelled);
+    CHECK(r.totalMs >= 200);
+    CHECK(r.totalMs < 5000);
+    CHECK(ProcessGone(pidFile));
+}
+
+// A background child holding the pipe is read for drainAfterExitMs, not 30 s
+void TestLingeringChild() {
+    ProcessOptions opts;
+    opts.drainAfterExitMs = 200;
+    ProcessResult r = RunProcess(FakeWinget("linger"), opts);
+    CHECK_EQ(r.exitCode, 0);
+    CHECK_EQ(r.output, std::string("done\n"));
+    CHECK(r.totalMs < 5000);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <fixtures dir> <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    g_fixtures = argv[1];
+    g_scratch = std::string(argv[2]) + "/process_runner_test";
+    std::error_code ec;
+    std::filesystem::remove_all(g_scratch, ec);
+    std::filesystem::create_directories(g_scratch);
+    g_script = "sh '" + g_fixtures + "/fake_winget.sh'";
+    TestLargeOutput();
+    TestExitCode();
+    TestFirstByte();
+    TestTimeout();
+    TestCancel();
+    TestLingeringChild();
+    return TestResult("process_runner_test");
+}
@@ -0,0 +1,192 @@
+// One refresh spawns winget once: the recorded `winget upgrade` capture is
+// fed through the scan entry points with the process runner stubbed, and
+// every consumer of the refresh (candidate list, both version maps) is then
+// asked for its data.
+//
+// Usage: scan_runner_test <fixtures dir>
+#include "check.h"
+#include "process_runner.h"
+#include "scan_runner.h"
+#include "skip_update.h"
+#include "winget_versions.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --- Stubs --------------------------------------------------------------------
+
+namespace {
+
+struct FakeWinget {
+    std::vector<std::string> outputs;   // printed by successive spawns; the last one repeats
+    size_t chunk = 255;                 // pipe reads are at most this long
+    int spawns = 0;
+    std::vector<std::string> commands;
+};
+
+FakeWinget g_winget;
+
+}  // namespace
+
+ProcessResult RunProcess(const std::string &cmdUtf8, const ProcessOptions &opts) {
+    ProcessResult r;
+    size_t n = (size_t)g_winget.spawns++;
+    g_winget.commands.push_back(cmdUtf8);
+    const std::string &out = g_winget.outputs.empty() ? std::string()
+                           : g_winget.outputs[n < g_winget.outputs.size() ? n : g_winget.outputs.size() - 1];
+    for (size_t i = 0; i < out.size(); i += g_winget.chunk) {
+        size_t len = std::min(g_winget.chunk, out.size() - i);
+        if (opts.onChunk) opts.onChunk(out.data() + i, len);
+    }
+    r.exitCode = 0;
+    r.output = out;
+    r.firstByteMs = out.empty() ? -1 : 0;
+    return r;
+}
+
+// parsing.cpp consults the skip list; nothing is skipped here
+bool IsSkipped(const std::string &, const std::string &) { return false; }
+bool IsSkipped(const std::string &, const Version &) { return false; }
+SkipBatch::SkipBatch() {}
+SkipBatch::~SkipBatch() {}
+
+// --- Tests --------------------------------------------------------------------
+
+namespace {
+
+void Reset(const std::vector<std::string> &outputs) {
+    g_winget = FakeWinget();
+    g_winget.outputs = outputs;
+}
+
+// Every consumer the refresh feeds, as main.cpp and the hidden scan ask for them
+void ConsumeRefresh(size_t expectedRows) {
+    std::unordered_map<std::string,std::string> avail, inst;
+    CHECK(ScanAndPopulateMaps(avail, inst));
+    CHECK_EQ(avail.size(), expectedRows);
+    CHECK_EQ(inst.size(), expectedRows);
+    CHECK_EQ(MapAvailableVersions().size(), expectedRows);
+    CHECK_EQ(MapInstalledVersions().size(), expectedRows);
+    ScanSnapshot last;
+    CHECK(GetLastScanSnapshot(last));
+    CHECK_EQ(last.rows.size(), expectedRows);
+}
+
+// The main window's refresh: rows streamed while winget runs are the rows of
+// the published snapshot, and nothing spawns winget a second time
+void TestRefreshSpawnsOnce(const std::string &capture, size_t expectedRows) {
+    for (size_t chunk : { 1, 7, 255, 4096 }) {
+        Reset({ capture });
+        g_winget.chunk = chunk;
+        std::vector<ScanRow> streamed;
+        ScanSnapshot snap;
+        CHECK(RefreshScanSnapshot(snap, [&](const ScanRow &r) { streamed.push_back(r); }));
+        CHECK_EQ(snap.rows.size(), expectedRows);
+        CHECK_EQ(streamed.size(), snap.rows.size());
+        for (size_t i = 0; i < streamed.size() && i < snap.rows.size(); ++i) {
+            CHECK_EQ(streamed[i].id, snap.rows[i].id);
+            CHECK_EQ(streamed[i].available, snap.rows[i].available);
+        }
+        CHECK(!snap.Candidates().empty());
+        ConsumeRefresh(expectedRows);
+        CHECK_EQ(g_winget.spawns, 1);
+        CHECK_EQ(g_winget.commands[0], std::string(kWingetUpgradeCommand));
+    }
+}
+
+// The tray's scheduled scan
+void TestFullScanSpawnsOnce(const std::string &capture, size_t expectedRows) {
+    Reset({ capture });
+    std::vector<std::pair<std::string,std::string>> results;
+    std::unordered_map<std::string,std::string> avail, inst;
+    CHECK(RunFullScan(results, avail, inst));
+    CHECK_EQ(avail.size(), expectedRows);
+    CHECK(!results.empty());
+    CHECK_EQ(g_winget.spawns, 1);
+    ScanSnapshot snap;
+    CHECK(GetLastScanSnapshot(snap));
+    CHECK_EQ(results.size(), snap.Candidates().size());
+    ConsumeRefresh(expectedRows);
+    CHECK_EQ(g_winget.spawns, 1);
+    CHECK_EQ(g_winget.commands[0], std::string(kWingetUpgradeCommand));
+}
+
+// The candidate list the main window shows: newer rows in table order, less
+// the ones the filter (the skip list there) drops
+void TestCandidates(const std::string &capture) {
+    ScanSnapshot snap = ParseScanSnapshot(capture);
+    auto all = snap.Candidates();
+    CHECK(all.size() > 1);
+    size_t newer = 0;
+    for (const ScanRow &r : snap.rows) {
+        if (!(r.installedVersion < r.availableVersion)) continue;
+        if (newer < all.size()) CHECK_EQ(all[newer].first, r.id);
+        ++newer;
+    }
+    CHECK_EQ(all.size(), newer);
+    if (all.empty()) return;
+    std::string dropped = all[0].first;
+    auto kept = snap.Candidates([&](const ScanRow &r) { return r.id != dropped; });
+    CHECK_EQ(kept.size(), all.size() - 1);
+    for (const auto &c : kept) CHECK(c.first != dropped);
+}
+
+// Between refreshes the last snapshot stands in for a new run until it is
+// older than the bound asked for
+void TestSnapshotAge(const std::string &capture) {
+    Reset({ capture });
+    ScanSnapshot snap;
+    CHECK(RefreshScanSnapshot(snap, nullptr));
+    CHECK_EQ(CurrentScanSnapshot().rows.size(), snap.rows.size());
+    CHECK_EQ(g_winget.spawns, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ScanSnapshot last;
+    CHECK(GetLastScanSnapshot(last));
+    CHECK(!GetLastScanSnapshot(last, 10));
+    CHECK_EQ(CurrentScanSnapshot(10).rows.size(), snap.rows.size());
+    CHECK_EQ(g_winget.spawns, 2);
+    CHECK(GetLastScanSnapshot(last, 10000));
+}
+
+// A run that prints nothing is retried exactly once
+void TestEmptyRunRetriedOnce(const std::string &capture, size_t expectedRows) {
+    Reset({ std::string(), capture });
+    size_t streamed = 0;
+    ScanSnapshot snap;
+    CHECK(RefreshScanSnapshot(snap, [&](const ScanRow &) { ++streamed; }));
+    CHECK_EQ(g_winget.spawns, 2);
+    CHECK_EQ(snap.rows.size(), expectedRows);
+    CHECK_EQ(streamed, expectedRows);
+
+    Reset({ std::string() });
+    CHECK(!RefreshScanSnapshot(snap, nullptr));
+    CHECK_EQ(g_winget.spawns, 2);
+    CHECK(snap.rows.empty());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <fixtures dir>\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+    std::string capture = ReadFixture(dir + "/winget_upgrade.txt");
+    CHECK(!capture.empty());
+    // Rows of the first table of the capture; the second table (explicit
+    // targeting) is not upgradable in bulk
+    size_t expectedRows = 0;
+    for (const auto &e : ReadFixtureTable(dir + "/winget_upgrade.expected")) {
+        if (e.size() >= 7 && e[0] == "0" && !e[4].empty() && e[6].find("id") == std::string::npos) ++expectedRows;
+    }
+    CHECK(expectedRows > 0);
+    TestRefreshSpawnsOnce(capture, expectedRows);
+    TestFullScanSpawnsOnce(capture, expectedRows);
+    TestCandidates(capture);
+    TestSnapshotAge(capture);
+    TestEmptyRunRetriedOnce(capture, expectedRows);
+    return TestResult("scan_runner_test");
+}
@@ -0,0 +1,85 @@
+// Benchmark of skip-list lookups against a scratch INI.
+//
+// Usage: skip_update_bench <scratch dir> [lookups]
+//   Saves 50 skipped entries, then times `lookups` lookups (default 10000),
+//   one of every 51 for an id that is not skipped, the way IsSkipped worked
+//   before the SkipStore (read and scan the INI for every call) and through
+//   IsSkipped. Every probe asks for the stored version, so nothing is
+//   unskipped. Exits 1 if the two disagree on the hits; the times are
+//   reported, not checked.
+#include "check.h"
+#include "skip_update.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::string Sanitize(const std::string &s) {
+    std::string out;
+    for (unsigned char c : s) if (!isspace(c) && c >= 32) out.push_back((char)c);
+    return out;
+}
+
+// Before: the [skipped] section read from the INI on every call
+bool LegacyIsSkipped(const std::string &ini, const std::string &id) {
+    std::istringstream in(ReadFixture(ini));
+    std::string line, sid = Sanitize(id);
+    bool inSkipped = false;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (line[0] == '[') { inSkipped = line == "[skipped]"; continue; }
+        if (!inSkipped) continue;
+        std::istringstream fields(line);
+        std::string key;
+        if (fields >> key && Sanitize(key) == sid) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir> [lookups]\n", argv[0]);
+        return 2;
+    }
+    int lookups = argc >= 3 ? atoi(argv[2]) : 10000;
+    if (lookups <= 0) lookups = 10000;
+    std::filesystem::path dir = std::filesystem::path(argv[1]) / "skip_update_bench";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir);
+    setenv("APPDATA", dir.string().c_str(), 1);
+    std::string ini = (dir / "WinUpdate" / "wup_settings.ini").string();
+
+    std::map<std::string,std::string> skipped;
+    for (int i = 0; i < 50; ++i) skipped["Bench.Package" + std::to_string(i)] = "1." + std::to_string(i);
+    CHECK(SaveSkippedMap(skipped));
+    std::vector<std::pair<std::string,std::string>> probes(skipped.begin(), skipped.end());
+    probes.emplace_back("Bench.NotSkipped", "1.0");
+
+    size_t hitsUncached = 0, hitsCached = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        if (LegacyIsSkipped(ini, probes[(size_t)i % probes.size()].first)) ++hitsUncached;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        const auto &p = probes[(size_t)i % probes.size()];
+        if (IsSkipped(p.first, p.second)) ++hitsCached;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    double msUncached = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double msCached = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    std::printf("%d lookups, %zu entries: INI per call %.2f ms (%zu hits), SkipStore %.2f ms (%zu hits)\n",
+                lookups, skipped.size(), msUncached, hitsUncached, msCached, hitsCached);
+    CHECK_EQ(hitsUncached, hitsCached);
+    CHECK(hitsCached > 0);
+    CHECK_EQ(LoadSkippedMap().size(), skipped.size());
+    return TestResult("skip_update_bench");
+}
@@ -0,0 +1,102 @@
+// The skip list against a scratch INI: add/remove, the auto-unskip in
+// IsSkipped, and writes made while a SkipBatch is open, which must all reach
+// the file when the batch closes.
+//
+// Usage: skip_update_test <scratch dir>
+#include "check.h"
+#include "skip_update.h"
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace {
+
+std::string g_ini;
+
+// The [skipped] section as it is on disk
+std::map<std::string,std::string> OnDisk() {
+    std::map<std::string,std::string> m;
+    std::istringstream in(ReadFixture(g_ini));
+    std::string line;
+    bool inSkipped = false;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (line[0] == '[') { inSkipped = line == "[skipped]"; continue; }
+        if (!inSkipped) continue;
+        std::istringstream fields(line);
+        std::string id, version;
+        if (fields >> id >> version) m[id] = version;
+    }
+    return m;
+}
+
+void TestAddRemove() {
+    CHECK(SaveSkippedMap({}));
+    CHECK(AddSkippedEntry("Vendor.App", "2.0"));
+    CHECK(IsSkipped("Vendor.App", "2.0"));
+    CHECK(IsSkipped(" Vendor.App\t", "1.5"));
+    CHECK(!IsSkipped("Vendor.Other", "2.0"));
+    CHECK_EQ(OnDisk().count("Vendor.App"), 1u);
+    CHECK(RemoveSkippedEntry("Vendor.App"));
+    CHECK(!RemoveSkippedEntry("Vendor.App"));
+    CHECK(!IsSkipped("Vendor.App", "2.0"));
+    CHECK(OnDisk().empty());
+}
+
+// A newer available version drops the skip, on disk as well
+void TestAutoUnskip() {
+    CHECK(SaveSkippedMap({ { "Vendor.App", "2.0" } }));
+    CHECK(!IsSkipped("Vendor.App", "2.1"));
+    CHECK(LoadSkippedMap().empty());
+    CHECK(OnDisk().empty());
+}
+
+// AppendSkippedRaw inside an open batch joins the batch: the batch commit
+// used to rewrite the INI from the store and drop the line written behind it
+void TestAppendRawInBatch() {
+    CHECK(SaveSkippedMap({ { "Vendor.Old", "1.0" } }));
+    {
+        SkipBatch batch;
+        CHECK(AddSkippedEntry("Vendor.Batched", "3.0"));
+        CHECK(AppendSkippedRaw("Vendor.Raw", "4.0"));
+        CHECK(!IsSkipped("Vendor.Old", "1.1"));   // auto-unskip, deferred too
+        CHECK(OnDisk().count("Vendor.Old"));
+        CHECK(!OnDisk().count("Vendor.Raw"));
+    }
+    auto disk = OnDisk();
+    CHECK_EQ(disk.size(), 2u);
+    CHECK_EQ(disk["Vendor.Batched"], std::string("3.0"));
+    CHECK_EQ(disk["Vendor.Raw"], std::string("4.0"));
+    CHECK(IsSkipped("Vendor.Raw", "4.0"));
+}
+
+// Trailing version tokens are stripped from the id; ids that still hold
+// spaces are refused
+void TestAppendRawIds() {
+    CHECK(SaveSkippedMap({}));
+    CHECK(AppendSkippedRaw("Vendor.Tool 4.9", "5.0"));
+    CHECK_EQ(LoadSkippedMap().count("Vendor.Tool"), 1u);
+    CHECK(!AppendSkippedRaw("Some Display Name", "1.0"));
+    CHECK_EQ(LoadSkippedMap().size(), 1u);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    std::filesystem::path dir = std::filesystem::path(argv[1]) / "skip_update_test";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir);
+    setenv("APPDATA", dir.string().c_str(), 1);
+    g_ini = (dir / "WinUpdate" / "wup_settings.ini").string();
+    TestAddRemove();
+    TestAutoUnskip();
+    TestAppendRawInBatch();
+    TestAppendRawIds();
+    return TestResult("skip_update_test");
+}
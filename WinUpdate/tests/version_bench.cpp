@@ -0,0 +1,124 @@
+// Benchmark of Version against the comparators it replaced.
+//
+// Usage: version_bench [rounds]
+//   Compares every pair of a corpus of winget version strings `rounds` times
+//   (default 200) with the former istringstream/stol comparators, with
+//   CompareVersionStrings and with cached Version values. Exits 1 if Version
+//   and the dotted comparator disagree on a pair of plain dotted numbers,
+//   the one form every comparator understood; the times are reported, not
+//   checked.
+#include "check.h"
+#include "version.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Former parsing.cpp CompareVersions: whitespace tokens, so "1.2.3" is one token.
+int LegacyCompareWhitespace(const std::string &a, const std::string &b) {
+    std::istringstream sa(a);
+    std::istringstream sb(b);
+    while (sa.good() || sb.good()) {
+        std::string ta, tb;
+        if (!(sa >> ta)) ta.clear();
+        if (!(sb >> tb)) tb.clear();
+        long va = 0, vb = 0;
+        try { va = std::stol(ta.empty()?"0":ta); } catch(...) { va = 0; }
+        try { vb = std::stol(tb.empty()?"0":tb); } catch(...) { vb = 0; }
+        if (va < vb) return -1;
+        if (va > vb) return 1;
+        if (!sa.good() && !sb.good()) break;
+    }
+    return 0;
+}
+
+// Former main.cpp/scan_runner.cpp CompareVersions: '.' split with getline.
+int LegacyCompareDotted(const std::string &a, const std::string &b) {
+    if (a == b) return 0;
+    std::istringstream sa(a), sb(b);
+    std::string ta, tb;
+    while (true) {
+        if (!std::getline(sa, ta, '.')) ta.clear();
+        if (!std::getline(sb, tb, '.')) tb.clear();
+        if (ta.empty() && tb.empty()) break;
+        long va = 0, vb = 0;
+        try { va = std::stol(ta.empty()?"0":ta); } catch(...) { va = 0; }
+        try { vb = std::stol(tb.empty()?"0":tb); } catch(...) { vb = 0; }
+        if (va < vb) return -1;
+        if (va > vb) return 1;
+        if (!sa.good() && !sb.good()) break;
+    }
+    return 0;
+}
+
+// Former skip_update.cpp VersionGreater.
+bool LegacyVersionGreater(const std::string &a, const std::string &b) {
+    auto split = [](const std::string &s){ std::vector<std::string> out; std::string cur; for (char c : s) { if (c=='.' || c=='-' || c=='_') { if (!cur.empty()) { out.push_back(cur); cur.clear(); } } else cur.push_back(c); } if (!cur.empty()) out.push_back(cur); return out; };
+    auto A = split(a); auto B = split(b);
+    size_t n = std::max(A.size(), B.size());
+    for (size_t i = 0; i < n; ++i) {
+        long ai = 0, bi = 0;
+        if (i < A.size()) try { ai = std::stol(A[i]); } catch(...) { ai = 0; }
+        if (i < B.size()) try { bi = std::stol(B[i]); } catch(...) { bi = 0; }
+        if (ai > bi) return true;
+        if (ai < bi) return false;
+    }
+    return false;
+}
+
+// Version strings as printed by `winget upgrade` / `winget list`.
+const char *const kVersionCorpus[] = {
+    "10.0.19041.1", "10.0.22621.2506", "124.0.6367.91", "125.0.6422.60", "3.0.20", "3.0.21",
+    "1.86.2", "1.89.1", "2.44.0.windows.1", "2.45.1", "8.6.5", "8.6.7", "23.01", "24.05",
+    "14.38.33135.0", "14.40.33810.0", "7.4.2", "7.4.3", "1.2.3-beta2", "1.2.3", "2024.1.1",
+    "2024.2.0.1", "0.9.11", "1.0.0-rc1", "1.0.0", "< 1.2", "1.2", "> 3.0", "3.0", "Unknown",
+    "6.2.1.2", "v2.5.0", "2.5.1", "5.1.4.26", "0.107.0", "0.108.0", "1.0.3296", "17.9.34622.214",
+    "17.10.34916.146", "4.9.2", "11.0.21+9", "11.0.23+9", "22.3.24231.1", "3.12.2150.0",
+    "3.12.3150.0", "1.7.0.36", "2.28.2", "115.11.0", "115.12.0", "0.3.4.1", "2023.3.4",
+};
+
+bool PlainDotted(const std::string &s) {
+    return !s.empty() && s.find_first_not_of("0123456789.") == std::string::npos;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    int rounds = argc >= 2 ? atoi(argv[1]) : 200;
+    if (rounds <= 0) rounds = 200;
+    std::vector<std::string> corpus(std::begin(kVersionCorpus), std::end(kVersionCorpus));
+    size_t n = corpus.size();
+    std::vector<Version> parsed;
+    parsed.reserve(n);
+    for (auto &s : corpus) parsed.emplace_back(s);
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (PlainDotted(corpus[i]) && PlainDotted(corpus[j])) {
+                CHECK_EQ(CompareVersionStrings(corpus[i], corpus[j]), LegacyCompareDotted(corpus[i], corpus[j]));
+            }
+        }
+    }
+
+    long long sink = 0;
+    auto time = [&](auto &&body) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (size_t i = 0; i < n; ++i)
+                for (size_t j = 0; j < n; ++j) sink += body(i, j);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    };
+    double msWs = time([&](size_t i, size_t j) { return LegacyCompareWhitespace(corpus[i], corpus[j]); });
+    double msDot = time([&](size_t i, size_t j) { return LegacyCompareDotted(corpus[i], corpus[j]); });
+    double msGt = time([&](size_t i, size_t j) { return (int)LegacyVersionGreater(corpus[i], corpus[j]); });
+    double msParse = time([&](size_t i, size_t j) { return CompareVersionStrings(corpus[i], corpus[j]); });
+    double msCached = time([&](size_t i, size_t j) { return parsed[i].Compare(parsed[j]); });
+    std::printf("%zu pairs x %d rounds: CompareVersions(ws) %.2f ms, CompareVersions(dot) %.2f ms, VersionGreater %.2f ms, "
+                "CompareVersionStrings %.2f ms, cached Version %.2f ms (sink %lld)\n",
+                n * n, rounds, msWs, msDot, msGt, msParse, msCached, sink);
+    return TestResult("version_bench");
+}
@@ -0,0 +1,116 @@
+// Version ordering: the winget forms ("< 1.2", "> 3.0", "Unknown"),
+// prerelease suffixes, differing segment counts and letter against number
+// segments.
+//
+// Usage: version_test
+#include "check.h"
+#include "version.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+int Cmp(const char *a, const char *b) { return CompareVersionStrings(a, b); }
+
+void TestBounds() {
+    CHECK_EQ(Cmp("< 1.2", "1.2"), -1);
+    CHECK_EQ(Cmp("< 1.2", "1.1.9"), 1);
+    CHECK_EQ(Cmp("< 1.2", "<1.2"), 0);
+    CHECK_EQ(Cmp("> 3.0", "3.0"), 1);
+    CHECK_EQ(Cmp("> 3.0", "3.0.1"), -1);
+    CHECK_EQ(Cmp("> 3.0", "< 3.0"), 1);
+    CHECK(Version("< 1.2").IsKnown());
+}
+
+void TestUnknown() {
+    CHECK(!Version("Unknown").IsKnown());
+    CHECK(!Version("").IsKnown());
+    CHECK(!Version("  ").IsKnown());
+    CHECK(!Version().IsKnown());
+    CHECK_EQ(Cmp("Unknown", ""), 0);
+    CHECK(Version("Unknown") == Version());
+    CHECK_EQ(Cmp("Unknown", "0"), -1);
+    CHECK_EQ(Cmp("Unknown", "< 0.1"), -1);
+    CHECK_EQ(Cmp("2.0", "unknown"), 1);
+    // A word with a number is a version
+    CHECK(Version("beta2").IsKnown());
+}
+
+void TestPrerelease() {
+    CHECK_EQ(Cmp("1.0-rc1", "1.0"), -1);
+    CHECK_EQ(Cmp("1.2.3-beta2", "1.2.3"), -1);
+    CHECK_EQ(Cmp("1.2.3-beta2", "1.2.2"), 1);
+    CHECK_EQ(Cmp("1.0-alpha", "1.0-beta"), -1);
+    CHECK_EQ(Cmp("1.0-beta", "1.0-rc"), -1);
+    CHECK_EQ(Cmp("1.0-beta2", "1.0-beta10"), -1);
+    CHECK_EQ(Cmp("1.0-RC1", "1.0-rc1"), 0);
+    CHECK_EQ(Cmp("1.0.0rc1", "1.0.0-rc1"), 0);   // digit/letter boundaries split too
+    CHECK_EQ(Cmp("11.0.21+9", "11.0.23+9"), -1);
+}
+
+void TestSegmentCounts() {
+    CHECK_EQ(Cmp("1.0", "1.0.0"), 0);
+    CHECK_EQ(Cmp("1", "1.0.0.0"), 0);
+    CHECK_EQ(Cmp("1.0.1", "1.0"), 1);
+    CHECK_EQ(Cmp("1.2", "1.10"), -1);
+    CHECK_EQ(Cmp("10.0.22621.2506", "10.0.19041.1"), 1);
+    CHECK_EQ(Cmp("2024.2.0.1", "2024.1.1"), 1);
+    CHECK_EQ(Cmp("v2.5.0", "2.5"), 0);
+    CHECK_EQ(Cmp(" 2.5.1\r\n", "2.5.1"), 0);
+    // Huge numeric segments saturate instead of wrapping
+    CHECK_EQ(Cmp("1.20000000000000000000", "1.3000000000000000000"), 1);
+    CHECK_EQ(Cmp("1.99999999999999999999999", "1.20000000000000000000"), 0);
+    CHECK_EQ(Cmp("1.20000000000000000000", "2"), -1);
+    // Segments past kMaxSegments are ignored
+    CHECK_EQ(Cmp("1.2.3.4.5.6.7.8.9", "1.2.3.4.5.6.7.8.10"), 0);
+    CHECK_EQ(Cmp("1.2.3.4.5.6.7.8", "1.2.3.4.5.6.7.9"), -1);
+}
+
+// Letters sort below numbers, including the 0 a missing segment stands for
+void TestLettersAgainstNumbers() {
+    CHECK_EQ(Cmp("2.44.0.windows.1", "2.44.0.1"), -1);
+    CHECK_EQ(Cmp("2.44.0.windows.1", "2.44.0"), -1);
+    CHECK_EQ(Cmp("2.44.0.windows.1", "2.43.9"), 1);
+    CHECK_EQ(Cmp("1.0.a", "1.0.0"), -1);
+    CHECK_EQ(Cmp("1.0.z", "1.0.0"), -1);
+    CHECK_EQ(Cmp("1.0.a", "1.0.b"), -1);
+    // Only the first 7 letters of a word count
+    CHECK_EQ(Cmp("1.0-preview", "1.0-previewx"), 0);
+    CHECK_EQ(Cmp("1.0-previe", "1.0-preview"), -1);
+}
+
+// Compare is a total order on the strings winget prints
+void TestOrderConsistency() {
+    const std::vector<std::string> corpus = {
+        "Unknown", "< 0.9", "0.9", "1.0-alpha", "1.0-beta2", "1.0-beta10", "1.0-rc1", "1.0",
+        "1.0.1", "< 1.2", "1.2", "1.2.3-beta2", "1.2.3", "1.10", "2.44.0.windows.1", "2.44.0",
+        "3.0", "> 3.0", "3.0.1", "10.0.19041.1", "124.0.6367.91",
+    };
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        Version a(corpus[i]);
+        CHECK_EQ(a.Compare(a), 0);
+        for (size_t j = 0; j < corpus.size(); ++j) {
+            Version b(corpus[j]);
+            int expected = (i > j) - (i < j);
+            if (a.Compare(b) != expected) {
+                std::fprintf(stderr, "'%s' vs '%s'\n", corpus[i].c_str(), corpus[j].c_str());
+            }
+            CHECK_EQ(a.Compare(b), expected);
+            CHECK_EQ(a < b, expected < 0);
+            CHECK_EQ(a > b, expected > 0);
+            CHECK_EQ(a == b, expected == 0);
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestBounds();
+    TestUnknown();
+    TestPrerelease();
+    TestSegmentCounts();
+    TestLettersAgainstNumbers();
+    TestOrderConsistency();
+    return TestResult("version_test");
+}
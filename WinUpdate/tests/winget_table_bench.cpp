@@ -0,0 +1,274 @@
+// Benchmarks of the column-offset winget table parser.
+//
+// Usage: winget_table_bench --throughput <fixtures dir> [rows]
+//   Builds a `winget search` dump of `rows` rows (default 10000) from the
+//   recorded winget_search.txt and extracts the package ids with the regex
+//   chain WinProgramUpdater::GetWingetPackages used before the table parser
+//   and with ForEachWingetRow. Exits 1 if they disagree; the speed-up is
+//   reported, not checked, since wall-clock ratios vary with machine load.
+//
+// Usage: winget_table_bench --replay <fixtures dir> [bytes/s] [spinner ms]
+//   Replays the recorded winget_upgrade.txt into a WingetTableStream the way
+//   the pipe delivers it: the leading spinner frames `spinner ms` apart
+//   (default 100), then reads of at most 255 bytes at `bytes/s` (default
+//   2000). Reports when the first row reached the UI callback and when the
+//   output ended, which is when the list appeared before rows were streamed.
+//   Exits 1 if the streamed rows differ from a whole-output parse or the first
+//   row was not delivered by the read that completed its line. That is
+//   checked on byte offsets, not on the clock; the times are only reported.
+#include "check.h"
+#include "winget_table.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// --- Dump -------------------------------------------------------------------
+
+std::string Pad(std::string text, size_t cells) {
+    size_t width = DisplayWidth(text);
+    if (width < cells) text.append(cells - width, ' ');
+    return text;
+}
+
+// `rows` rows laid out like the recorded search table, cycling through its
+// rows with a numbered id so every package is distinct
+std::string SearchDump(const std::string &recorded, int rows) {
+    struct Cells { std::string name, id, version, match, source; };
+    std::vector<Cells> templates;
+    ForEachWingetRow(recorded, [&](const WingetTableRow &r) {
+        templates.push_back({ std::string(r.name()), std::string(r.id()), std::string(r.version()),
+                              std::string(r.field[WCOL_MATCH]), std::string(r.source()) });
+        return true;
+    });
+    if (templates.empty()) return std::string();
+    const size_t name = 44, id = 50, version = 20, match = 20;
+    std::string dump = "\r   - \r   \\ \r                                                  \r";
+    dump += Pad("Name", name) + Pad("Id", id) + Pad("Version", version) + Pad("Match", match) + "Source\r\n";
+    dump += std::string(name + id + version + match + 6, '-') + "\r\n";
+    for (int i = 0; i < rows; ++i) {
+        const Cells &t = templates[i % templates.size()];
+        std::string packageId = t.id;
+        // Keep truncated ids truncated: "Microsoft.VCRedist.2015+.x64…" stays cut off
+        size_t cut = packageId.rfind("\xE2\x80\xA6");
+        std::string suffix = "." + std::to_string(i);
+        if (cut == std::string::npos) packageId += suffix;
+        else packageId.insert(cut, suffix);
+        dump += Pad(t.name, name) + Pad(packageId, id) + Pad(t.version, version) + Pad(t.match, match) + t.source + "\r\n";
+    }
+    return dump;
+}
+
+// --- Before: GetWingetPackages as it split rows with regexes -----------------
+
+std::string Trim(const std::string &s) {
+    size_t a = s.find_first_not_of(" \t\r\n");
+    if (a == std::string::npos) return std::string();
+    size_t b = s.find_last_not_of(" \t\r\n");
+    return s.substr(a, b - a + 1);
+}
+
+std::vector<std::string> LegacySearchIds(const std::string &output) {
+    std::vector<std::string> packages;
+    std::istringstream stream(output);
+    std::string line;
+    bool inResults = false;
+    std::regex splitRegex("\\s{2,}");
+    std::regex idRegex("^[A-Za-z0-9][\\w.+_-]*\\.[\\w.+_-]+$");
+    while (std::getline(stream, line)) {
+        if (line.length() <= 2) continue;
+        if (line.find("---") != std::string::npos && line.length() > 10) {
+            inResults = true;
+            continue;
+        }
+        if (!inResults) continue;
+        if (line.empty() || line.length() < 10) continue;
+        if (line.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+        std::vector<std::string> columns;
+        std::sregex_token_iterator iter(line.begin(), line.end(), splitRegex, -1);
+        std::sregex_token_iterator end;
+        for (; iter != end; ++iter) {
+            std::string col = Trim(iter->str());
+            if (!col.empty()) columns.push_back(col);
+        }
+        if (columns.size() >= 2) {
+            std::string packageId = columns[1];
+            if (std::regex_match(packageId, idRegex) && packageId.find_first_not_of("0123456789.-") != std::string::npos) {
+                packages.push_back(packageId);
+            }
+        }
+    }
+    return packages;
+}
+
+// --- After: the column-offset parser ------------------------------------------
+
+std::vector<std::string> TableSearchIds(const std::string &output) {
+    std::vector<std::string> packages;
+    ForEachWingetRow(output, [&](const WingetTableRow &row) {
+        if (!row.IsTruncated(WCOL_ID)) packages.emplace_back(row.id());
+        return true;
+    });
+    return packages;
+}
+
+// Best of `passes` runs, in milliseconds
+template <typename F>
+double BestOf(int passes, F &&run) {
+    double best = 0;
+    for (int i = 0; i < passes; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double ms = MillisecondsSince(start);
+        if (i == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+int Throughput(const std::string &dir, int rows) {
+    std::string dump = SearchDump(ReadFixture(dir + "/winget_search.txt"), rows);
+    if (dump.empty()) {
+        std::fprintf(stderr, "cannot read %s/winget_search.txt\n", dir.c_str());
+        return 2;
+    }
+    std::vector<std::string> legacy, table;
+    double legacyMs = BestOf(3, [&] { legacy = LegacySearchIds(dump); });
+    double tableMs = BestOf(10, [&] { table = TableSearchIds(dump); });
+    double ratio = tableMs > 0 ? legacyMs / tableMs : 0;
+    double mb = dump.size() / (1024.0 * 1024.0);
+    std::printf("%d rows, %.1f MB: regex chain %.1f ms (%.0f rows/s), table parser %.2f ms (%.0f rows/s); %.1fx; ids %s\n",
+                rows, mb, legacyMs, rows * 1000.0 / legacyMs, tableMs, rows * 1000.0 / tableMs, ratio,
+                legacy == table ? "identical" : "DIFFER");
+    CHECK(legacy == table);
+    return TestResult("winget_table_bench --throughput");
+}
+
+// --- Replay -------------------------------------------------------------------
+
+struct TimedChunk {
+    size_t offset, length;
+    double dueMs;   // when the read returns, from the start of the process
+};
+
+// Pipe reads of `capture`: each spinner frame ('\r'-terminated, before the
+// first line ends) on its own, then reads of at most 255 bytes
+std::vector<TimedChunk> ReplaySchedule(const std::string &capture, double bytesPerSecond, double spinnerMs) {
+    std::vector<TimedChunk> chunks;
+    size_t firstLine = capture.find('\n');
+    size_t pos = 0;
+    double due = 0;
+    for (;;) {
+        size_t cr = capture.find('\r', pos);
+        if (cr == std::string::npos || firstLine == std::string::npos || cr >= firstLine) break;
+        if (cr + 1 < capture.size() && capture[cr + 1] == '\n') break;
+        due += spinnerMs;
+        chunks.push_back({ pos, cr + 1 - pos, due });
+        pos = cr + 1;
+    }
+    while (pos < capture.size()) {
+        size_t len = std::min<size_t>(255, capture.size() - pos);
+        due += len * 1000.0 / bytesPerSecond;
+        chunks.push_back({ pos, len, due });
+        pos += len;
+    }
+    return chunks;
+}
+
+// Offset of the byte whose arrival delivers the first row
+size_t FirstRowOffset(const std::string &capture) {
+    size_t pushed = 0, at = 0;
+    bool seen = false;
+    WingetTableStream stream([&](const WingetTableRow &) {
+        if (!seen) { seen = true; at = pushed; }
+        return true;
+    });
+    for (; pushed < capture.size() && !seen; ) stream.Push(std::string_view(capture).substr(pushed++, 1));
+    return seen ? at : capture.size();
+}
+
+int Replay(const std::string &dir, double bytesPerSecond, double spinnerMs) {
+    std::string capture = ReadFixture(dir + "/winget_upgrade.txt");
+    if (capture.empty()) {
+        std::fprintf(stderr, "cannot read %s/winget_upgrade.txt\n", dir.c_str());
+        return 2;
+    }
+    std::vector<TimedChunk> chunks = ReplaySchedule(capture, bytesPerSecond, spinnerMs);
+    // The read that carries that byte is the one that has to deliver the row
+    size_t firstRowByte = FirstRowOffset(capture);
+    double firstRowDue = 0;
+    size_t firstRowReadEnd = capture.size();
+    for (const TimedChunk &c : chunks) {
+        if (c.offset + c.length > firstRowByte) {
+            firstRowDue = c.dueMs;
+            firstRowReadEnd = c.offset + c.length;
+            break;
+        }
+    }
+
+    std::vector<std::string> streamed;
+    double firstRowMs = -1;
+    size_t pushedEnd = 0, firstRowPushedEnd = 0;
+    auto start = std::chrono::steady_clock::now();
+    WingetTableStream stream([&](const WingetTableRow &r) {
+        if (firstRowMs < 0) {
+            firstRowMs = MillisecondsSince(start);
+            firstRowPushedEnd = pushedEnd;
+        }
+        streamed.emplace_back(r.id());
+        return true;
+    });
+    for (const TimedChunk &c : chunks) {
+        std::this_thread::sleep_until(start + std::chrono::duration<double, std::milli>(c.dueMs));
+        pushedEnd = c.offset + c.length;
+        stream.Push(std::string_view(capture).substr(c.offset, c.length));
+    }
+    stream.Finish();
+    double exitMs = MillisecondsSince(start);
+
+    // Before streaming, rows were parsed once the whole output had been read
+    std::vector<std::string> whole;
+    auto parseStart = std::chrono::steady_clock::now();
+    ForEachWingetRow(capture, [&](const WingetTableRow &r) { whole.emplace_back(r.id()); return true; });
+    double afterExitMs = exitMs + MillisecondsSince(parseStart);
+
+    std::printf("%zu bytes in %zu reads at %.0f B/s (%.0f ms spinner frames): first row %.1f ms (line read at %.1f ms), "
+                "output ended %.1f ms, first row after exit %.1f ms; first row with byte %zu of %zu "
+                "(its line ends in the read up to byte %zu); %zu rows %s\n",
+                capture.size(), chunks.size(), bytesPerSecond, spinnerMs, firstRowMs, firstRowDue, exitMs,
+                afterExitMs, firstRowPushedEnd, capture.size(), firstRowReadEnd, streamed.size(),
+                streamed == whole ? "identical" : "DIFFER");
+    CHECK(streamed == whole);
+    CHECK(!streamed.empty());
+    // Delivered by the read that completed its line, long before the output ended
+    CHECK_EQ(firstRowPushedEnd, firstRowReadEnd);
+    CHECK(firstRowReadEnd < capture.size());
+    return TestResult("winget_table_bench --replay");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    std::string mode = argc >= 2 ? argv[1] : "";
+    if (mode == "--throughput" && argc >= 3) {
+        int rows = argc >= 4 ? atoi(argv[3]) : 10000;
+        return Throughput(argv[2], rows > 0 ? rows : 10000);
+    }
+    if (mode == "--replay" && argc >= 3) {
+        double rate = argc >= 4 ? atof(argv[3]) : 2000;
+        double spinner = argc >= 5 ? atof(argv[4]) : 100;
+        return Replay(argv[2], rate > 0 ? rate : 2000, spinner >= 0 ? spinner : 100);
+    }
+    std::fprintf(stderr, "usage: %s --throughput <fixtures dir> [rows]\n"
+                         "       %s --replay <fixtures dir> [bytes/s] [spinner ms]\n", argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,195 @@
+// Tests of the column-offset winget table parser against recorded output.
+//
+// Usage: winget_table_test <fixtures dir>
+#include "check.h"
+#include "winget_table.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ParsedRow {
+    int table;
+    std::string id, name, version, available, source, truncated;
+};
+
+std::string TruncatedColumns(const WingetTableRow &r) {
+    static const char *names[] = { "name", "id", "version", "available", "source" };
+    std::string out;
+    for (int c = WCOL_NAME; c <= WCOL_SOURCE; ++c) {
+        if (!r.IsTruncated((WingetColumn)c)) continue;
+        if (!out.empty()) out += ",";
+        out += names[c];
+    }
+    return out.empty() ? "-" : out;
+}
+
+ParsedRow ToParsed(const WingetTableRow &r) {
+    return { r.table, std::string(r.id()), std::string(r.name()), std::string(r.version()),
+             std::string(r.available()), std::string(r.source()), TruncatedColumns(r) };
+}
+
+std::vector<ParsedRow> ParseWhole(const std::string &text) {
+    std::vector<ParsedRow> rows;
+    ForEachWingetRow(text, [&](const WingetTableRow &r) { rows.push_back(ToParsed(r)); return true; });
+    return rows;
+}
+
+std::vector<ParsedRow> ParseInChunks(const std::string &text, size_t chunk) {
+    std::vector<ParsedRow> rows;
+    WingetTableStream stream([&](const WingetTableRow &r) { rows.push_back(ToParsed(r)); return true; });
+    for (size_t i = 0; i < text.size(); i += chunk) stream.Push(std::string_view(text).substr(i, chunk));
+    stream.Finish();
+    return rows;
+}
+
+bool SameRows(const std::vector<ParsedRow> &a, const std::vector<ParsedRow> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].table != b[i].table || a[i].id != b[i].id || a[i].name != b[i].name ||
+            a[i].version != b[i].version || a[i].available != b[i].available ||
+            a[i].source != b[i].source || a[i].truncated != b[i].truncated) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rows of a recorded capture match its .expected file, cell by cell
+void TestRecordedCapture(const std::string &dir, const std::string &name) {
+    std::string text = ReadFixture(dir + "/" + name + ".txt");
+    auto expected = ReadFixtureTable(dir + "/" + name + ".expected");
+    CHECK(!text.empty());
+    CHECK(!expected.empty());
+    auto rows = ParseWhole(text);
+    CHECK_EQ(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size() && i < expected.size(); ++i) {
+        const auto &e = expected[i];
+        if (e.size() < 7) {
+            CHECK(e.size() >= 7);
+            continue;
+        }
+        CHECK_EQ(std::to_string(rows[i].table), e[0]);
+        CHECK_EQ(rows[i].id, e[1]);
+        CHECK_EQ(rows[i].name, e[2]);
+        CHECK_EQ(rows[i].version, e[3]);
+        CHECK_EQ(rows[i].available, e[4]);
+        CHECK_EQ(rows[i].source, e[5]);
+        CHECK_EQ(rows[i].truncated, e[6]);
+    }
+
+    // Pipe reads split the text anywhere, including inside "\r\n", inside a
+    // UTF-8 sequence and inside a spinner redraw
+    for (size_t chunk : { 1, 2, 3, 7, 64, 255, 4096 }) {
+        if (!SameRows(ParseInChunks(text, chunk), rows)) {
+            std::fprintf(stderr, "%s: rows differ when pushed in %zu-byte chunks\n", name.c_str(), chunk);
+            CHECK(false);
+        }
+    }
+}
+
+void TestDisplayWidth() {
+    CHECK_EQ(DisplayWidth("Git"), 3u);
+    CHECK_EQ(DisplayWidth("\xE5\xBE\xAE\xE4\xBF\xA1"), 4u);                 // 微信
+    CHECK_EQ(DisplayWidth("\xEB\x84\xA4\xEC\x9D\xB4\xEB\xB2\x84"), 6u);     // 네이버
+    CHECK_EQ(DisplayWidth("Redistrib\xE2\x80\xA6"), 10u);                   // … is one cell
+    CHECK_EQ(DisplayWidth("e\xCC\x81"), 1u);                                // combining accent
+    CHECK_EQ(DisplayWidth("\xEF\xBC\xA1"), 2u);                             // fullwidth A
+}
+
+// A wide name is padded by cells, not bytes: the Id column starts at the same
+// cell as on ASCII rows although it starts at a different byte
+void TestWideNames() {
+    std::string text =
+        "Name        Id              Version  Available  Source\r\n"
+        "------------------------------------------------------\r\n"
+        "\xE5\xBE\xAE\xE4\xBF\xA1        Tencent.WeChat  3.9.10   3.9.12     winget\r\n"
+        "Git         Git.Git         2.44.0   2.46.2     winget\r\n"
+        "\xEF\xBC\xA1\xEF\xBC\xA2\xEF\xBC\xA3\xEF\xBC\xA4\xEF\xBC\xA5 \xEF\xBC\xA6Wide.Spill  1.0      1.1        winget\r\n"
+        "\xEF\xBC\xA1\xEF\xBC\xA2\xEF\xBC\xA3\xEF\xBC\xA4\xEF\xBC\xA5\xEF\xBC\xA6Wide.Gap    1.0      1.1        winget\r\n";
+    auto rows = ParseWhole(text);
+    // The last two rows' fullwidth names straddle or touch the Id column: the
+    // first puts a wide glyph across the column start, the second leaves no
+    // gap before it. Neither is a table row.
+    CHECK_EQ(rows.size(), 2u);
+    if (rows.size() < 2) return;
+    CHECK_EQ(rows[0].name, "\xE5\xBE\xAE\xE4\xBF\xA1");
+    CHECK_EQ(rows[0].id, "Tencent.WeChat");
+    CHECK_EQ(rows[0].available, "3.9.12");
+    CHECK_EQ(rows[1].id, "Git.Git");
+}
+
+void TestTruncatedCells() {
+    std::string text =
+        "Name                  Id                    Version       Source\n"
+        "----------------------------------------------------------------\n"
+        "Microsoft Visual C\xE2\x80\xA6   Microsoft.VCRedist\xE2\x80\xA6   14.40.33810.0 winget\n"
+        "Long Version App      Vendor.LongVersion    2024.10.17\xE2\x80\xA6   winget\n";
+    auto rows = ParseWhole(text);
+    CHECK_EQ(rows.size(), 2u);
+    if (rows.size() < 2) return;
+    CHECK_EQ(rows[0].truncated, "name,id");
+    CHECK_EQ(rows[0].id, "Microsoft.VCRedist\xE2\x80\xA6");
+    CHECK_EQ(rows[1].truncated, "version");
+    CHECK_EQ(rows[1].version, "2024.10.17\xE2\x80\xA6");
+}
+
+// Spinner frames redraw the line with bare '\r'; only what is left after the
+// last one is part of the line
+void TestSpinnerOverwrites() {
+    std::string text =
+        "\r   - \r   \\ \r   | \r   / \r                              \r"
+        "Name   Id         Version  Available  Source\r\n"
+        "\r   - \r   \\ \r--------------------------------------------\r\n"
+        "Git    Git.Git    2.44.0   2.46.2     winget\r\n"
+        "\r   | \r   / \rZoom   Zoom.Zoom  6.2.0    6.2.3      winget\r\n";
+    auto whole = ParseWhole(text);
+    CHECK_EQ(whole.size(), 2u);
+    if (whole.size() == 2) {
+        CHECK_EQ(whole[0].id, "Git.Git");
+        CHECK_EQ(whole[1].name, "Zoom");
+        CHECK_EQ(whole[1].available, "6.2.3");
+    }
+
+    // Frames arriving one at a time, with no newline for a long while, are
+    // collapsed as they come and do not change what is parsed
+    std::vector<ParsedRow> rows;
+    WingetTableStream stream([&](const WingetTableRow &r) { rows.push_back(ToParsed(r)); return true; });
+    for (int i = 0; i < 100000; ++i) stream.Push("\r   - ");
+    stream.Push("\r");
+    stream.Push(text);
+    stream.Finish();
+    CHECK(SameRows(rows, whole));
+}
+
+// The callback can stop the parse; later rows are not delivered
+void TestStopEarly() {
+    std::string text =
+        "Name  Id     Version  Source\n"
+        "----------------------------\n"
+        "A     A.A    1.0      winget\n"
+        "B     B.B    1.0      winget\n"
+        "C     C.C    1.0      winget\n";
+    size_t seen = 0;
+    size_t delivered = ForEachWingetRow(text, [&](const WingetTableRow &) { return ++seen < 2; });
+    CHECK_EQ(seen, 2u);
+    CHECK_EQ(delivered, 2u);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <fixtures dir>\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+    TestRecordedCapture(dir, "winget_upgrade");
+    TestRecordedCapture(dir, "winget_search");
+    TestDisplayWidth();
+    TestWideNames();
+    TestTruncatedCells();
+    TestSpinnerOverwrites();
+    TestStopEarly();
+    return TestResult("winget_table_test");
+}